@@ -0,0 +1,278 @@
+/*
+ * TF 卡格式化配置对比：用主机端编译的 FatFs 在镜像文件上按 tfcard_task 的方式持续追加写
+ * （log_writer 的 1 KB 块、按 CONFIG_TFCARD_SYNC_BYTES 做 f_sync 检查点），
+ * 统计写入扇区中有多少是文件数据、多少是 FAT/目录/位图等元数据开销，
+ * 并按简单的卡延迟模型估算各配置的持续写入速度。
+ *
+ *   bench_fatfs [选项] 镜像文件
+ *     -g GB        镜像（卡）容量，默认 8，按稀疏文件创建
+ *     -m MB        每个配置写入的数据量，默认 64
+ *     -c 字节      每次 f_write 的大小，默认 1024（LOG_WRITER_BUF_SIZE）
+ *     -y 字节      每写多少字节 f_sync 一次，默认 16384，0 表示只在关闭文件时同步
+ *     -f MB        单个日志文件大小上限，超过后换新文件，默认 0（不换）
+ *     -p 名称      只跑指定的配置
+ *   卡延迟模型：每条写命令 “固定开销 + 每 KB 耗时”，写入位置换到另一个擦除单元（AU）时另加开销
+ *     -e KB        擦除单元大小，默认 4096，同时作为 GET_BLOCK_SIZE 返回给 f_mkfs
+ *     -l 微秒      每条写命令的固定开销，默认 250
+ *     -k 微秒      每 KB 的传输/编程耗时，默认 200（40 MHz SPI 约 5 MB/s）
+ *     -a 微秒      切换 AU 的额外开销，默认 2000
+ *
+ * FatFs 源码不随仓库提供，配置 host 构建时用 -DFATFS_DIR 指向 FatFs 的 source 目录
+ * （ESP-IDF 的 components/fatfs/src 亦可），配置见 host/fatfs/ffconf.h。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "ff.h"
+#include "diskio.h"
+#include "mock_clock.h"
+
+#define SECTOR_SIZE 512
+
+typedef struct {
+    const char *name;
+    BYTE fmt;
+    BYTE n_fat;
+    UINT align;     // 数据区对齐（扇区），0 表示按 GET_BLOCK_SIZE（AU）对齐
+    DWORD au_size;  // 簇大小
+} profile_t;
+
+static const profile_t profiles[] = {
+    {"default-16k", FM_ANY, 2, 0, 16 * 1024},  // 设备端当前的 mount_config
+    {"log-32k", FM_FAT32, 2, 0, 32 * 1024},
+    {"log-64k", FM_FAT32, 2, 0, 64 * 1024},
+    {"log-64k-1fat", FM_FAT32, 1, 0, 64 * 1024},
+    {"log-64k-noalign", FM_FAT32, 2, 1, 64 * 1024},
+#if FF_FS_EXFAT
+    {"exfat-64k", FM_EXFAT, 1, 0, 64 * 1024},
+#endif
+};
+
+// 镜像文件上的 diskio，顺带统计写入并累计模型耗时
+static struct {
+    int fd;
+    LBA_t sectors;
+    DWORD au_sectors;
+    LBA_t data_start;       // 挂载后为 fs.database，之前的扇区属于 FAT/目录区
+    uint64_t written_sectors;
+    uint64_t fat_region_sectors;
+    uint32_t write_cmds;
+    uint32_t au_switches;
+    int64_t last_au;
+    double cost_us;
+    uint32_t cmd_us, per_kb_us, au_switch_us;
+} disk;
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+    return 0;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+    return 0;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+    ssize_t len = (ssize_t)count * SECTOR_SIZE;
+    return (pread(disk.fd, buff, len, (off_t)sector * SECTOR_SIZE) == len) ? RES_OK : RES_ERROR;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    ssize_t len = (ssize_t)count * SECTOR_SIZE;
+    if (pwrite(disk.fd, buff, len, (off_t)sector * SECTOR_SIZE) != len) {
+        return RES_ERROR;
+    }
+    int64_t au = sector / disk.au_sectors;
+    disk.write_cmds++;
+    disk.written_sectors += count;
+    if (sector < disk.data_start) {
+        disk.fat_region_sectors += count;
+    }
+    disk.cost_us += disk.cmd_us + (double)disk.per_kb_us * count * SECTOR_SIZE / 1024;
+    if (au != disk.last_au) {
+        disk.au_switches++;
+        disk.cost_us += disk.au_switch_us;
+        disk.last_au = au;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+    switch (cmd) {
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *(LBA_t *)buff = disk.sectors;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = SECTOR_SIZE;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = disk.au_sectors;
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+static void disk_reset_stats(void)
+{
+    disk.written_sectors = 0;
+    disk.fat_region_sectors = 0;
+    disk.write_cmds = 0;
+    disk.au_switches = 0;
+    disk.last_au = -1;
+    disk.cost_us = 0;
+}
+
+static const char *fs_name(BYTE type)
+{
+    switch (type) {
+    case FS_FAT12: return "FAT12";
+    case FS_FAT16: return "FAT16";
+    case FS_FAT32: return "FAT32";
+#if FF_FS_EXFAT
+    case FS_EXFAT: return "exFAT";
+#endif
+    default: return "?";
+    }
+}
+
+static int run_profile(const profile_t *p, const char *image, uint64_t size, uint64_t total, uint32_t chunk,
+                       uint32_t sync_bytes, uint64_t file_max)
+{
+    static BYTE work[SECTOR_SIZE * 64];
+    static FATFS fs;
+    static FIL fil;
+    MKFS_PARM opt = {p->fmt, p->n_fat, p->align, 0, p->au_size};
+    FRESULT fr;
+
+    // 每个配置都从空白镜像开始
+    disk.fd = open(image, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (disk.fd < 0 || ftruncate(disk.fd, size) != 0) {
+        perror(image);
+        return -1;
+    }
+    disk.data_start = 0;
+    if ((fr = f_mkfs("0:", &opt, work, sizeof(work))) != FR_OK || (fr = f_mount(&fs, "0:", 1)) != FR_OK) {
+        printf("%-16s format failed (FRESULT %d)\n", p->name, fr);
+        close(disk.fd);
+        return 0;
+    }
+    disk.data_start = fs.database;
+    disk_reset_stats();
+
+    char *buf = malloc(chunk);
+    for (uint32_t i = 0; i < chunk; i++) {
+        buf[i] = (i % 64 == 63) ? '\n' : 'a' + i % 26;
+    }
+
+    uint64_t start_us = mock_now_us();
+    uint64_t done = 0, in_file = 0, since_sync = 0;
+    uint32_t files = 0;
+    int ret = 0;
+    while (done < total && ret == 0) {
+        if (files == 0 || (file_max != 0 && in_file >= file_max)) {
+            char path[32];
+            if (files != 0) {
+                f_close(&fil);
+            }
+            snprintf(path, sizeof(path), "0:/log%05u.txt", files++);
+            if (f_open(&fil, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+                ret = -1;
+                break;
+            }
+            in_file = 0;
+        }
+        UINT bw;
+        if (f_write(&fil, buf, chunk, &bw) != FR_OK || bw != chunk) {
+            printf("%-16s write failed after %llu bytes (card full?)\n", p->name, (unsigned long long)done);
+            ret = -1;
+            break;
+        }
+        done += chunk;
+        in_file += chunk;
+        since_sync += chunk;
+        if (sync_bytes != 0 && since_sync >= sync_bytes) {
+            f_sync(&fil);
+            since_sync = 0;
+        }
+    }
+    f_close(&fil);
+    double wall_s = (mock_now_us() - start_us) / 1e6;
+
+    uint64_t payload_sectors = done / SECTOR_SIZE;
+    uint64_t overhead = disk.written_sectors > payload_sectors ? disk.written_sectors - payload_sectors : 0;
+    printf("%-16s %-5s %3lu KB  data@%8lu  %6.2f%% overhead (%5.2f%% FAT/dir region)  %7u cmds  %6u AU switches"
+           "  model %6.2f MB/s  host %6.1f MB/s\n",
+           p->name, fs_name(fs.fs_type), (unsigned long)(fs.csize * SECTOR_SIZE / 1024), (unsigned long)fs.database,
+           100.0 * overhead / payload_sectors, 100.0 * disk.fat_region_sectors / payload_sectors, disk.write_cmds,
+           disk.au_switches, done / 1048576.0 / (disk.cost_us / 1e6), done / 1048576.0 / wall_s);
+
+    f_mount(NULL, "0:", 0);
+    free(buf);
+    close(disk.fd);
+    return ret;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-g GB] [-m MB] [-c chunk] [-y sync_bytes] [-f file_MB] [-p profile]\n"
+                    "          [-e au_KB] [-l cmd_us] [-k us_per_KB] [-a au_switch_us] image\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t size_gb = 8, total_mb = 64, chunk = 1024, sync_bytes = 16384, file_mb = 0, au_kb = 4096;
+    const char *only = NULL;
+    int opt;
+
+    disk.cmd_us = 250;
+    disk.per_kb_us = 200;
+    disk.au_switch_us = 2000;
+    while ((opt = getopt(argc, argv, "g:m:c:y:f:p:e:l:k:a:h")) != -1) {
+        switch (opt) {
+        case 'g': size_gb = strtoul(optarg, NULL, 0); break;
+        case 'm': total_mb = strtoul(optarg, NULL, 0); break;
+        case 'c': chunk = strtoul(optarg, NULL, 0); break;
+        case 'y': sync_bytes = strtoul(optarg, NULL, 0); break;
+        case 'f': file_mb = strtoul(optarg, NULL, 0); break;
+        case 'p': only = optarg; break;
+        case 'e': au_kb = strtoul(optarg, NULL, 0); break;
+        case 'l': disk.cmd_us = strtoul(optarg, NULL, 0); break;
+        case 'k': disk.per_kb_us = strtoul(optarg, NULL, 0); break;
+        case 'a': disk.au_switch_us = strtoul(optarg, NULL, 0); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind >= argc || chunk == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *image = argv[optind];
+    uint64_t size = (uint64_t)size_gb << 30;
+    disk.sectors = size / SECTOR_SIZE;
+    disk.au_sectors = au_kb * 1024 / SECTOR_SIZE;
+
+    printf("%u GB image, %u MB per profile in %u-byte writes, f_sync every %u bytes, AU %u KB\n",
+           size_gb, total_mb, chunk, sync_bytes, au_kb);
+    printf("model: %u us/cmd + %u us/KB + %u us per AU switch\n", disk.cmd_us, disk.per_kb_us, disk.au_switch_us);
+    int fail = 0;
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+        if (only != NULL && strcmp(only, profiles[i].name) != 0) {
+            continue;
+        }
+        if (run_profile(&profiles[i], image, size, (uint64_t)total_mb << 20, chunk, sync_bytes,
+                        (uint64_t)file_mb << 20) != 0) {
+            fail = 1;
+        }
+    }
+    unlink(image);
+    return fail;
+}
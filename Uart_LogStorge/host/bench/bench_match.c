@@ -0,0 +1,295 @@
+/*
+ * log_match / log_search 主机端基准：
+ * 生成与 uart_task 输出格式一致的合成日志，对比 Aho-Corasick 扫描与逐行 strstr 的吞吐量，
+ * 并验证会话时间索引在按时间范围查询时跳过的数据量与结果一致性，以及实时流过滤器的输出。
+ *
+ *   bench_match [日志大小MB] [日志文件]
+ * 指定日志文件时使用真实日志，否则生成合成数据。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_match.h"
+#include "log_search.h"
+#include "log_filter.h"
+
+#define BLOCK_SIZE 4096 // 与设备端按块读卡一致
+
+static const char *tags[] = {"wifi", "main", "sensor", "mqtt", "BLE_GATT", "spi_master", "adc", "app"};
+static const char *msgs[] = {
+    "connected to AP, rssi=-%d",
+    "publish topic /dev/%d/state ok",
+    "temperature sample %d.%d C",
+    "heap free %d bytes, min %d",
+    "retry %d of 5, waiting",
+    "ERROR: sensor timeout after %d ms",
+    "assert failed: queue.c:%d (pxQueue)",
+    "Guru Meditation Error: Core  0 panic'ed (%d)",
+};
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *gen_log(size_t size, size_t *out_len)
+{
+    char *buf = malloc(size + 2048);
+    size_t len = 0;
+    uint32_t ms = 1000;
+    unsigned seed = 12345;
+
+    while (len < size) {
+        seed = seed * 1103515245 + 12345;
+        ms += (seed >> 16) % 40;
+        // 与 uart_task 一致的时间戳前缀
+        len += sprintf(buf + len, "[%02u:%02u:%02u.%03u] ", ms / 3600000, ms / 60000 % 60, ms / 1000 % 60, ms % 1000);
+        int lines = 1 + (seed >> 8) % 3; // 一个 UART 块里可能有多行，只有第一行带前缀
+        for (int l = 0; l < lines; l++) {
+            seed = seed * 1103515245 + 12345;
+            int m = (seed >> 16) % 100;
+            int mi = m < 90 ? m % 5 : (m < 97 ? 5 : (m < 99 ? 6 : 7));
+            char level = mi >= 5 ? 'E' : (m % 7 == 0 ? 'W' : 'I');
+            len += sprintf(buf + len, "%c (%u) %s: ", level, ms, tags[(seed >> 4) % 8]);
+            len += sprintf(buf + len, msgs[mi], (int)(seed % 1000), (int)(seed % 10));
+            buf[len++] = '\n';
+        }
+    }
+    *out_len = len;
+    return buf;
+}
+
+static bool count_cb(void *ctx, uint32_t offset, uint32_t ts, const char *line, size_t len)
+{
+    (*(uint32_t *)ctx)++;
+    return true;
+}
+
+// 按设备端方式分块喂入，返回耗时
+static double run_search(const char *log, size_t log_len, const log_match_t *m, uint32_t t0, uint32_t t1,
+                         log_index_t *index, log_search_t *s, uint32_t *hits)
+{
+    *hits = 0;
+    log_search_init(s, m, t0, t1, index, count_cb, hits);
+    double start = now_sec();
+    uint32_t off = 0;
+    while (off < log_len) {
+        uint32_t blk = off & ~(BLOCK_SIZE - 1);
+        size_t n = (blk + BLOCK_SIZE < log_len ? blk + BLOCK_SIZE : log_len) - off;
+        off = log_search_feed(s, off, (const uint8_t *)log + off, n);
+    }
+    log_search_finish(s);
+    return now_sec() - start;
+}
+
+// 对照组：逐行 strstr
+static uint32_t naive_search(char *log, size_t log_len, const char *const *pats, int npat, double *elapsed)
+{
+    uint32_t hits = 0;
+    double start = now_sec();
+    char *p = log, *end = log + log_len;
+    while (p < end) {
+        char *nl = memchr(p, '\n', end - p);
+        if (nl == NULL) {
+            nl = end;
+        }
+        char saved = *nl;
+        *nl = '\0';
+        for (int i = 0; i < npat; i++) {
+            if (strstr(p, pats[i]) != NULL) {
+                hits++;
+                break;
+            }
+        }
+        *nl = saved;
+        p = nl + 1;
+    }
+    *elapsed = now_sec() - start;
+    return hits;
+}
+
+static int bench_patterns(char *log, size_t log_len, const char *const *pats, int npat, uint8_t flags)
+{
+    static log_match_t m;
+    static log_search_t s;
+    uint32_t hits, naive_hits;
+    double t_ac, t_naive;
+
+    log_match_init(&m, flags);
+    for (int i = 0; i < npat; i++) {
+        if (log_match_add(&m, pats[i], strlen(pats[i])) < 0) {
+            printf("pattern '%s' rejected\n", pats[i]);
+            return 1;
+        }
+    }
+    log_match_compile(&m);
+
+    t_ac = run_search(log, log_len, &m, 0, LOG_SEARCH_TS_NONE, NULL, &s, &hits);
+    printf("  %d pattern(s)%s: %8u lines, %7.1f MB/s (%u states, %u classes)",
+           npat, (flags & LOG_MATCH_FLAG_NOCASE) ? " nocase" : "", hits, log_len / t_ac / 1e6,
+           m.num_states, m.num_classes);
+    if (flags == 0 && pats[0][0] != '^') {
+        naive_hits = naive_search(log, log_len, pats, npat, &t_naive);
+        printf(" | strstr %7.1f MB/s%s", log_len / t_naive / 1e6, naive_hits == hits ? "" : " MISMATCH");
+        if (naive_hits != hits) {
+            printf(" (%u)\n", naive_hits);
+            return 1;
+        }
+    }
+    printf("\n");
+    return 0;
+}
+
+// 对照组：逐行判定，与 log_filter 规则一致（行内容为时间戳之后的部分）
+static bool naive_filter_line(const char *line, size_t len, uint8_t level_mask,
+                              const char *const *inc, int ninc, const char *const *exc, int nexc)
+{
+    char buf[LOG_FILTER_LINE_MAX + 1];
+    uint32_t ts;
+    size_t prefix = log_search_parse_ts(line, len, &ts);
+    len -= prefix;
+    memcpy(buf, line + prefix, len);
+    buf[len] = '\0';
+
+    uint8_t level = log_filter_line_level(buf, len);
+    bool pass = level_mask == 0 || (level & level_mask) != 0;
+    bool any = ninc == 0;
+    for (int i = 0; i < ninc; i++) {
+        any = any || strstr(buf, inc[i]) != NULL;
+    }
+    for (int i = 0; i < nexc; i++) {
+        pass = pass && strstr(buf, exc[i]) == NULL;
+    }
+    return pass && any;
+}
+
+// 按 uart_task 的读取粒度（不按行对齐）切块喂入过滤器，输出应与逐行判定完全一致
+static int bench_filter(const char *log, size_t log_len)
+{
+    static log_filter_t f;
+    static const char *inc[] = {"ERROR", "assert", "Guru"};
+    static const char *exc[] = {"timeout"};
+    const uint8_t level_mask = LOG_FILTER_LEVEL_E | LOG_FILTER_LEVEL_W;
+    static char out[2048];
+    char *expect = malloc(log_len);
+    char *got = malloc(log_len);
+    size_t expect_len = 0, got_len = 0;
+
+    const char *p = log, *end = log + log_len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', end - p);
+        size_t n = nl - p;
+        if (naive_filter_line(p, n, level_mask, inc, 3, exc, 1)) {
+            memcpy(expect + expect_len, p, n + 1);
+            expect_len += n + 1;
+        }
+        p = nl + 1;
+    }
+
+    log_filter_init(&f, 0, level_mask);
+    for (int i = 0; i < 3; i++) {
+        log_filter_add_include(&f, inc[i], strlen(inc[i]));
+    }
+    log_filter_add_exclude(&f, exc[0], strlen(exc[0]));
+    log_filter_compile(&f);
+
+    unsigned seed = 777;
+    double start = now_sec();
+    for (size_t off = 0; off < log_len;) {
+        seed = seed * 1103515245 + 12345;
+        size_t n = 1 + (seed >> 16) % 1024;
+        if (n > log_len - off) {
+            n = log_len - off;
+        }
+        size_t o = log_filter_feed(&f, log + off, n, out, sizeof(out));
+        memcpy(got + got_len, out, o);
+        got_len += o;
+        off += n;
+    }
+    double elapsed = now_sec() - start;
+
+    int fail = got_len != expect_len || memcmp(got, expect, got_len) != 0 || f.bytes_dropped != 0;
+    printf("stream filter (E|W, 3 include, 1 exclude): %u/%u lines, %.1f%% of bytes forwarded, %.1f MB/s%s\n",
+           f.lines_out, f.lines_in, 100.0 * f.bytes_out / f.bytes_in, log_len / elapsed / 1e6,
+           fail ? " MISMATCH" : "");
+    printf("  level E %u W %u I %u | include %u %u %u | exclude %u\n",
+           f.level_hits[0], f.level_hits[1], f.level_hits[2],
+           f.include_hits[0], f.include_hits[1], f.include_hits[2], f.exclude_hits[0]);
+    free(expect);
+    free(got);
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    size_t size_mb = argc > 1 ? (size_t)atoi(argv[1]) : 16;
+    size_t log_len;
+    char *log;
+
+    if (argc > 2) {
+        FILE *f = fopen(argv[2], "rb");
+        if (f == NULL) {
+            perror(argv[2]);
+            return 1;
+        }
+        fseek(f, 0, SEEK_END);
+        log_len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        log = malloc(log_len + 1);
+        if (fread(log, 1, log_len, f) != log_len) {
+            fclose(f);
+            return 1;
+        }
+        fclose(f);
+    } else {
+        log = gen_log(size_mb * 1024 * 1024, &log_len);
+    }
+    printf("log size %.1f MB, block %d\n", log_len / 1e6, BLOCK_SIZE);
+
+    int fail = 0;
+    static const char *p1[] = {"Guru Meditation"};
+    static const char *p3[] = {"Guru Meditation", "assert failed", "ERROR"};
+    static const char *p8[] = {"Guru", "assert", "ERROR", "timeout", "panic", "rssi=-9", "heap free 1", "retry 4"};
+    static const char *pa[] = {"^E (", "^W ("};
+    static const char *pn[] = {"error", "guru meditation"};
+    fail |= bench_patterns(log, log_len, p1, 1, 0);
+    fail |= bench_patterns(log, log_len, p3, 3, 0);
+    fail |= bench_patterns(log, log_len, p8, 8, 0);
+    fail |= bench_patterns(log, log_len, pa, 2, 0);
+    fail |= bench_patterns(log, log_len, pn, 2, LOG_MATCH_FLAG_NOCASE);
+
+    // 时间索引：首次查询建立索引，后续同类查询跳过无关分块
+    static log_match_t m;
+    static log_search_t s;
+    static log_index_t index;
+    uint32_t t0, t1, hits_plain, hits_build, hits_indexed;
+    log_match_init(&m, 0);
+    log_match_add(&m, "ERROR", 5);
+    log_match_compile(&m);
+
+    t0 = 60 * 1000;
+    t1 = 120 * 1000;
+    log_index_reset(&index);
+
+    double t_plain = run_search(log, log_len, &m, t0, t1, NULL, &s, &hits_plain);
+    double t_build = run_search(log, log_len, &m, t0, t1, &index, &s, &hits_build);
+    double t_idx = run_search(log, log_len, &m, t0, t1, &index, &s, &hits_indexed);
+    printf("time range [%u, %u] ms 'ERROR':\n", t0, t1);
+    printf("  no index     %8u lines, %8.2f ms\n", hits_plain, t_plain * 1e3);
+    printf("  build index  %8u lines, %8.2f ms (%u entries x %u bytes)\n", hits_build, t_build * 1e3,
+           index.count, index.granule);
+    printf("  with index   %8u lines, %8.2f ms, skipped %.1f%% of the file\n", hits_indexed, t_idx * 1e3,
+           100.0 * s.bytes_skipped / log_len);
+    if (hits_plain != hits_build || hits_plain != hits_indexed) {
+        printf("  index MISMATCH\n");
+        fail = 1;
+    }
+
+    fail |= bench_filter(log, log_len);
+
+    free(log);
+    return fail;
+}
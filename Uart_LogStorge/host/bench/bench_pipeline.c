@@ -0,0 +1,640 @@
+/*
+ * 采集管线主机端回放基准：
+ * 用文件回放的 UART 和文件模拟的 TF 卡替换硬件，按设备端 uart_task / tfcard_task 的结构
+ * （成帧 log_frame、环形缓冲区 log_ring、合并写 log_writer）跑完整条落卡路径，
+ * 报告吞吐量、各环节丢弃量、缓冲区水位以及 “UART 接收 -> 落卡” 的延迟分布。
+ *
+ *   bench_pipeline [选项] [录制文件]
+ *     -r 字节/秒   回放速率，默认 11520（115200 8N1），0 表示尽快回放
+ *     -n 次数      录制文件回放次数，默认 1
+ *     -s KB        未指定录制文件时生成的合成日志大小，默认 64
+ *     -c 字节      TF 卡环形缓冲区大小（2 的幂），默认 8192，对应 BUFFER_SIZE
+ *     -u 字节      UART 驱动接收缓冲区大小（2 的幂），默认 8192
+ *     -i 毫秒      tfcard_task 写入周期，默认 500，对应运行配置的 flush_ms
+ *     -l 微秒      模拟卡每次写入的固定开销，默认 0
+ *     -k 微秒      模拟卡每 KB 的写入耗时，默认 0
+ *     -o 文件      模拟卡的输出文件，默认 /dev/null
+ *     -p tty       从 tty（如 pty 从端）实时读取，代替文件回放，对端关闭后结束，
+ *                  配合 pytest/uart_gen.py 做丢数检测
+ *     -x 次数      每隔多少次写卡注入一次卡顿，默认 0（不注入）
+ *     -y 微秒      每次卡顿的额外耗时，默认 300000
+ *     -S KB        片内 Flash 溢出分区大小，默认 0（不启用），对应 CONFIG_TFCARD_SPILL_ENABLE
+ *     -w 百分比    环形缓冲区超过该水位后转入溢出分区，默认 75
+ *     -E 微秒      模拟 Flash 每扇区擦除耗时，默认 30000
+ *     -P 微秒      模拟 Flash 每页（256 字节）编程耗时，默认 400
+ *     -R MB        按裸扇区循环日志写入（CONFIG_TFCARD_STORAGE_RAW），-o 指定的文件作为该大小的卡镜像，
+ *                  每个写入周期提交一次，可用 pytest/rawlog_export.py 导出后校验
+ *     -G KB        裸扇区日志的段大小，默认 64，对应 CONFIG_TFCARD_RAW_SEGMENT_KB
+ *     -T 模式      触发式采集（CONFIG_LOG_TRIGGER_ENABLE），多个模式用 '|' 分隔，只有命中前后窗口内的数据写卡
+ *     -W 毫秒      触发前/后窗口，默认 10000
+ *     -F 行数      合成日志中每隔多少行插入一次 “Guru Meditation Error”，默认 0（不插入）
+ *     -M 行数      每次插入故障行后，再插入多少行只有 tick 不同的重复错误行，默认 0
+ *     -D 毫秒      成帧前折叠连续重复的行（CONFIG_LOG_DEDUP_ENABLE），参数为汇总间隔，忽略 tick 比较
+ *     -A 毫秒      按接收速率调整读取长度和超时（log_rxsize），参数对应 CONFIG_UART_READ_TARGET_MS；
+ *                  不指定时按固定 256 字节 / 10 ms 读取
+ * 设备端 TF 卡环形缓冲区为 CONFIG_TFCARD_RING_KB（默认 30 KB），这里的环形缓冲区须为 2 的幂，用 -c 指定。
+ * uart 一行的 cpu 为接收线程的 CPU 时间（读取、成帧、入队）按字节平均，对比不同速率下的单字节开销：
+ *   for r in 2000 11520 46080 92160; do bench_pipeline -r $r -s 512; bench_pipeline -r $r -s 512 -A 20; done
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "log_frame.h"
+#include "log_ring.h"
+#include "log_writer.h"
+#include "log_stats.h"
+#include "log_spill.h"
+#include "log_raw.h"
+#include "log_trigger.h"
+#include "log_dedup.h"
+#include "log_rxsize.h"
+#include <time.h>
+#include "mock_clock.h"
+#include "mock_uart.h"
+#include "mock_sd.h"
+#include "mock_flash.h"
+
+#define UART_READ_LEN    256 // 不自适应时的固定读取长度和超时
+#define UART_READ_TMO_MS 10
+#define UART_READ_MIN    128 // 自适应范围，与 uart_task 一致
+#define UART_READ_MAX    1024
+#define UART_READ_TMO_MAX_MS 50
+#define CARD_WAIT_US     100000 // tfcard_write_to_buffer 等待空间时的轮询间隔
+#define SPILL_SECTOR     4096
+#define SPILL_DRAIN_MAX  4096   // tfcard_task 每次从溢出分区读回的字节数
+#define TRIGGER_RING_SIZE (32 * 1024) // 对应 CONFIG_LOG_TRIGGER_RING_KB 默认值
+
+typedef struct {
+    uint64_t off;    // 该数据块入队后 card_in_bytes 的值
+    uint64_t t_us;   // UART 接收时刻
+} lat_mark_t;
+
+typedef struct {
+    uint32_t *v;
+    size_t n, cap;
+} samples_t;
+
+static struct {
+    mock_uart_t uart;
+    mock_sd_t sd;
+    log_ring_t card_ring;
+    log_writer_t writer;
+    uint32_t interval_us;
+
+    // 片内 Flash 溢出分区
+    bool spill_on;
+    mock_flash_t flash;
+    log_spill_t spill;
+    uint32_t spill_mark;     // 环形缓冲区水位（字节）
+    uint64_t spilled_bytes;
+    uint32_t spill_waits;
+
+    // 裸扇区循环日志
+    bool raw_on;
+    log_raw_t raw;
+    uint32_t raw_commits;
+
+    // 触发式采集
+    bool trigger_on;
+    log_trigger_t trigger;
+    uint8_t trigger_buf[TRIGGER_RING_SIZE];
+
+    // 重复行折叠
+    bool dedup_on;
+    log_dedup_t dedup;
+
+    // 自适应读取
+    bool rxsize_on;
+    log_rxsize_t rxsize;
+    uint64_t uart_cpu_ns;    // 接收线程的 CPU 时间
+
+    uint64_t start_us;
+    bool uart_done;
+
+    // 延迟标记：uart 线程登记，card 线程结算
+    pthread_mutex_t mark_lock;
+    lat_mark_t *marks;
+    size_t mark_head, mark_tail, mark_cap;
+    uint64_t card_in_bytes;
+    uint64_t flushed_off;
+    uint32_t enq_waits;
+
+    samples_t lat_card;
+    samples_t lat_ingest;
+} bench;
+
+static void samples_add(samples_t *s, uint32_t v)
+{
+    if (s->n == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 1024;
+        s->v = realloc(s->v, s->cap * sizeof(uint32_t));
+    }
+    s->v[s->n++] = v;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void samples_report(const char *name, samples_t *s)
+{
+    if (s->n == 0) {
+        printf("  %-22s no samples\n", name);
+        return;
+    }
+    qsort(s->v, s->n, sizeof(uint32_t), cmp_u32);
+    printf("  %-22s n=%zu p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n", name, s->n,
+           s->v[s->n / 2] / 1000.0, s->v[s->n * 9 / 10] / 1000.0, s->v[s->n * 99 / 100] / 1000.0,
+           s->v[s->n - 1] / 1000.0);
+}
+
+static void mark_add(uint64_t off, uint64_t t_us)
+{
+    pthread_mutex_lock(&bench.mark_lock);
+    if (bench.mark_head - bench.mark_tail == bench.mark_cap) {
+        size_t cap = bench.mark_cap ? bench.mark_cap * 2 : 1024;
+        lat_mark_t *m = malloc(cap * sizeof(lat_mark_t));
+        for (size_t i = bench.mark_tail; i < bench.mark_head; i++) {
+            m[i - bench.mark_tail] = bench.marks[i % bench.mark_cap];
+        }
+        free(bench.marks);
+        bench.marks = m;
+        bench.mark_head -= bench.mark_tail;
+        bench.mark_tail = 0;
+        bench.mark_cap = cap;
+    }
+    bench.marks[bench.mark_head % bench.mark_cap] = (lat_mark_t){off, t_us};
+    bench.mark_head++;
+    pthread_mutex_unlock(&bench.mark_lock);
+}
+
+static void mark_done(uint64_t off, uint64_t now_us)
+{
+    pthread_mutex_lock(&bench.mark_lock);
+    while (bench.mark_tail != bench.mark_head && bench.marks[bench.mark_tail % bench.mark_cap].off <= off) {
+        samples_add(&bench.lat_card, now_us - bench.marks[bench.mark_tail % bench.mark_cap].t_us);
+        bench.mark_tail++;
+    }
+    pthread_mutex_unlock(&bench.mark_lock);
+}
+
+// log_writer 的 sink：写模拟卡并结算延迟，对应 s_write_file / s_write_raw + card_write_done
+static int card_sink(void *ctx, const char *data, size_t len)
+{
+    uint64_t start_us = mock_now_us();
+    int ret = bench.raw_on ? log_raw_append(&bench.raw, data, len, start_us) : mock_sd_write(ctx, data, len);
+    uint64_t now_us = mock_now_us();
+    if (ret == 0) {
+        log_stats.card_written_bytes += len;
+        log_hist_add(log_stats.card_write_lat, now_us - start_us);
+    } else {
+        log_stats.card_write_errors++;
+        log_stats.card_fail_bytes += len;
+    }
+    bench.flushed_off += len;
+    mark_done(bench.flushed_off, now_us);
+    return ret;
+}
+
+// 超过水位或溢出分区里还有数据时写入溢出分区，保证读回顺序与写入顺序一致
+static bool spill_enqueue(const char *data, size_t len)
+{
+    if (log_spill_used(&bench.spill) == 0 && log_ring_used(&bench.card_ring) + len <= bench.spill_mark) {
+        return false;
+    }
+    if (!log_spill_write(&bench.spill, data, len)) {
+        bench.spill_waits++;
+        while (!log_spill_write(&bench.spill, data, len)) {
+            if (bench.spill.failed) {
+                fprintf(stderr, "spill flash error\n");
+                exit(1);
+            }
+            mock_sleep_us(CARD_WAIT_US);
+        }
+    }
+    bench.spilled_bytes += len;
+    return true;
+}
+
+// 对应 tfcard_write_to_buffer：空间不足时轮询等待，不丢数据
+static void card_enqueue(const char *data, size_t len, uint64_t origin_us)
+{
+    if (bench.spill_on && spill_enqueue(data, len)) {
+        bench.card_in_bytes += len;
+        log_stats.card_in_bytes += len;
+        mark_add(bench.card_in_bytes, origin_us);
+        return;
+    }
+    if (log_ring_free(&bench.card_ring) < len) {
+        bench.enq_waits++;
+        while (log_ring_free(&bench.card_ring) < len) {
+            mock_sleep_us(CARD_WAIT_US);
+        }
+    }
+    log_ring_write(&bench.card_ring, data, len);
+    bench.card_in_bytes += len;
+    log_stats.card_in_bytes += len;
+    mark_add(bench.card_in_bytes, origin_us);
+    log_stats_update_hwm(&log_stats.card_ring_hwm, log_ring_used(&bench.card_ring));
+}
+
+static void trigger_emit(void *ctx, const char *data, size_t len)
+{
+    card_enqueue(data, len, *(uint64_t *)ctx);
+}
+
+// 成帧后交给触发或直接写卡
+static void uart_store(const uint8_t *raw, size_t raw_len, const uint8_t *src, size_t len, uint64_t origin_us)
+{
+    char framed[LOG_DEDUP_OUT_MAX(UART_READ_MAX) + LOG_FRAME_PREFIX_MAX];
+    size_t copied, n = 0;
+    uint32_t ts_ms = (origin_us - bench.start_us) / 1000;
+
+    if (len > 0) {
+        n = log_frame_chunk(framed, sizeof(framed), ts_ms, src, len, &copied);
+    }
+    if (bench.trigger_on) {
+        log_trigger_feed(&bench.trigger, raw, raw_len, framed, n, ts_ms, log_ring_free(&bench.card_ring),
+                         trigger_emit, &origin_us);
+    } else if (n > 0) {
+        card_enqueue(framed, n, origin_us);
+    }
+}
+
+static uint64_t thread_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void *uart_task(void *arg)
+{
+    uint8_t data[UART_READ_MAX];
+    static char folded[LOG_DEDUP_OUT_MAX(UART_READ_MAX)];
+    uint64_t cpu_start = thread_cpu_ns();
+
+    while (!mock_uart_drained(&bench.uart)) {
+        size_t want = bench.rxsize_on ? bench.rxsize.len : UART_READ_LEN;
+        uint32_t tmo_ms = bench.rxsize_on ? bench.rxsize.tmo_ms : UART_READ_TMO_MS;
+        int len = mock_uart_read_bytes(&bench.uart, data, want, tmo_ms);
+        if (bench.rxsize_on) {
+            log_rxsize_update(&bench.rxsize, (len > 0) ? len : 0, (mock_now_us() - bench.start_us) / 1000);
+        }
+        if (len <= 0) {
+            uint64_t now_us = mock_now_us();
+            if (bench.trigger_on) {
+                log_trigger_drain(&bench.trigger, log_ring_free(&bench.card_ring), trigger_emit, &now_us);
+            }
+            if (bench.dedup_on && log_dedup_pending(&bench.dedup)) {
+                size_t n = log_dedup_flush(&bench.dedup, (now_us - bench.start_us) / 1000, folded, sizeof(folded));
+                uart_store(NULL, 0, (const uint8_t *)folded, n, now_us);
+            }
+            continue;
+        }
+        uint64_t origin_us = mock_now_us();
+        log_stats.uart_rx_bytes += len;
+        log_stats.uart_rx_chunks++;
+
+        if (bench.dedup_on) {
+            size_t n = log_dedup_feed(&bench.dedup, (const char *)data, len, (origin_us - bench.start_us) / 1000,
+                                      folded, sizeof(folded));
+            uart_store(data, len, (const uint8_t *)folded, n, origin_us);
+        } else {
+            uart_store(data, len, data, len, origin_us);
+        }
+        samples_add(&bench.lat_ingest, mock_now_us() - origin_us);
+    }
+    if (bench.dedup_on) {
+        size_t n = log_dedup_flush(&bench.dedup, UINT32_MAX / 2, folded, sizeof(folded));
+        uart_store(NULL, 0, (const uint8_t *)folded, n, mock_now_us());
+    }
+    bench.uart_cpu_ns = thread_cpu_ns() - cpu_start;
+    __atomic_store_n(&bench.uart_done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// 环形缓冲区写空后才读回溢出分区：先看到溢出数据再检查环形缓冲区，
+// 生产者写溢出分区之前写入环形缓冲区的数据一定可见，不会乱序
+static bool spill_drain(void)
+{
+    static char buf[SPILL_DRAIN_MAX];
+    if (!bench.spill_on || log_spill_used(&bench.spill) == 0 || log_ring_used(&bench.card_ring) != 0) {
+        return false;
+    }
+    uint32_t n = log_spill_read(&bench.spill, buf, sizeof(buf));
+    log_writer_push(&bench.writer, buf, n);
+    return n > 0;
+}
+
+// 对应 tfcard_task：每个周期取一段连续数据交给 log_writer，写出剩余数据后休眠；
+// 溢出分区有数据时不休眠，尽快读回
+static void *card_task(void *arg)
+{
+    while (1) {
+        bool uart_done = __atomic_load_n(&bench.uart_done, __ATOMIC_ACQUIRE);
+        const uint8_t *p;
+        uint32_t n = log_ring_peek(&bench.card_ring, &p);
+        if (n > 0) {
+            log_writer_push(&bench.writer, (const char *)p, n);
+            log_ring_consume(&bench.card_ring, n);
+        }
+        bool drained = spill_drain();
+        log_writer_flush(&bench.writer);
+        if (bench.raw_on && bench.raw.cur.len != bench.raw.committed) {
+            log_raw_commit(&bench.raw);
+            bench.raw_commits++;
+        }
+        if (uart_done && log_ring_used(&bench.card_ring) == 0 && (!bench.spill_on || log_spill_used(&bench.spill) == 0)) {
+            break;
+        }
+        if (!drained) {
+            mock_sleep_us(bench.interval_us);
+        }
+    }
+    return NULL;
+}
+
+// 合成设备串口输出（不带时间戳，时间戳由 uart_task 添加）
+static uint8_t *gen_capture(size_t size, uint32_t fault_every, uint32_t fault_repeat, size_t *out_len)
+{
+    static const char *tags[] = {"wifi", "main", "sensor", "mqtt", "app"};
+    uint8_t *buf = malloc(size + 256 + (size_t)fault_repeat * 64);
+    size_t len = 0;
+    unsigned seed = 12345;
+    uint32_t ms = 1000, lines = 0;
+
+    while (len < size) {
+        if (fault_every != 0 && ++lines % fault_every == 0) {
+            len += sprintf((char *)buf + len, "Guru Meditation Error: Core  0 panic'ed (LoadProhibited)\n");
+            for (uint32_t i = 0; i < fault_repeat && len < size; i++) {
+                len += sprintf((char *)buf + len, "E (%u) wifi: esp_wifi_connect failed: 0x3007\n", ms++);
+            }
+            continue;
+        }
+        seed = seed * 1103515245 + 12345;
+        ms += (seed >> 16) % 40;
+        char level = (seed >> 8) % 10 == 0 ? 'W' : 'I';
+        len += sprintf((char *)buf + len, "%c (%u) %s: sample %u value=%u\n", level, ms,
+                       tags[(seed >> 4) % 5], seed % 1000, (seed >> 12) % 65536);
+    }
+    *out_len = len;
+    return buf;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-r rate] [-n loops] [-s KB] [-c card_ring] [-u uart_rx] [-i interval_ms]\n"
+                    "          [-l sd_fixed_us] [-k sd_us_per_kb] [-x spike_every] [-y spike_us]\n"
+                    "          [-S spill_KB] [-w watermark_pct] [-E erase_us] [-P page_us] [-R raw_MB] [-G seg_KB]\n"
+                    "          [-T patterns] [-W window_ms] [-F fault_every] [-M fault_repeat]\n"
+                    "          [-D dedup_ms] [-A read_target_ms] [-o out] [-p tty | capture]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rate = 11520, loops = 1, synth_kb = 64;
+    uint32_t card_size = 8192, uart_size = 8192, interval_ms = 500;
+    uint32_t sd_fixed_us = 0, sd_per_kb_us = 0, spike_every = 0, spike_us = 300000;
+    uint32_t spill_kb = 0, spill_pct = 75, erase_us = 30000, page_us = 400;
+    uint32_t raw_mb = 0, seg_kb = 64;
+    uint32_t window_ms = 10000, fault_every = 0, fault_repeat = 0, dedup_ms = 0, read_target_ms = 0;
+    const char *patterns = NULL;
+    const char *out = "/dev/null";
+    const char *tty = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:n:s:c:u:i:l:k:x:y:S:w:E:P:R:G:T:W:F:M:D:A:o:p:h")) != -1) {
+        switch (opt) {
+        case 'r': rate = strtoul(optarg, NULL, 0); break;
+        case 'n': loops = strtoul(optarg, NULL, 0); break;
+        case 's': synth_kb = strtoul(optarg, NULL, 0); break;
+        case 'c': card_size = strtoul(optarg, NULL, 0); break;
+        case 'u': uart_size = strtoul(optarg, NULL, 0); break;
+        case 'i': interval_ms = strtoul(optarg, NULL, 0); break;
+        case 'l': sd_fixed_us = strtoul(optarg, NULL, 0); break;
+        case 'k': sd_per_kb_us = strtoul(optarg, NULL, 0); break;
+        case 'x': spike_every = strtoul(optarg, NULL, 0); break;
+        case 'y': spike_us = strtoul(optarg, NULL, 0); break;
+        case 'S': spill_kb = strtoul(optarg, NULL, 0); break;
+        case 'w': spill_pct = strtoul(optarg, NULL, 0); break;
+        case 'E': erase_us = strtoul(optarg, NULL, 0); break;
+        case 'P': page_us = strtoul(optarg, NULL, 0); break;
+        case 'R': raw_mb = strtoul(optarg, NULL, 0); break;
+        case 'G': seg_kb = strtoul(optarg, NULL, 0); break;
+        case 'T': patterns = optarg; break;
+        case 'W': window_ms = strtoul(optarg, NULL, 0); break;
+        case 'F': fault_every = strtoul(optarg, NULL, 0); break;
+        case 'M': fault_repeat = strtoul(optarg, NULL, 0); break;
+        case 'D': dedup_ms = strtoul(optarg, NULL, 0); break;
+        case 'A': read_target_ms = strtoul(optarg, NULL, 0); break;
+        case 'o': out = optarg; break;
+        case 'p': tty = optarg; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    const char *capture = (optind < argc) ? argv[optind] : NULL;
+    int ret;
+    if (tty != NULL) {
+        ret = mock_uart_open_tty(&bench.uart, tty, uart_size);
+    } else {
+        if (capture == NULL) {
+            bench.uart.data = gen_capture((size_t)synth_kb * 1024, fault_every, fault_repeat, &bench.uart.len);
+        }
+        ret = mock_uart_open(&bench.uart, capture, rate, loops, uart_size);
+    }
+    if (ret != 0) {
+        return 1;
+    }
+    uint8_t *card_buf = malloc(card_size);
+    if (!log_ring_init(&bench.card_ring, card_buf, card_size)) {
+        fprintf(stderr, "card ring size %u is not a power of two\n", card_size);
+        return 1;
+    }
+    if (raw_mb != 0) {
+        // 每次运行都重新格式化镜像，对应设备端 CONFIG_TFCARD_RAW_FORMAT_CARD
+        log_raw_dev_t dev = {
+            .read = mock_sd_read_sectors,
+            .write = mock_sd_write_sectors,
+            .ctx = &bench.sd,
+            .sectors = raw_mb * (1048576 / MOCK_SD_SECTOR),
+        };
+        if (mock_sd_open_raw(&bench.sd, out, dev.sectors, sd_fixed_us, sd_per_kb_us) != 0 ||
+            log_raw_format(&bench.raw, &dev, seg_kb * 1024 / LOG_RAW_SECTOR, (uint32_t)mock_now_us()) != 0 ||
+            log_raw_begin(&bench.raw, mock_now_us()) != 0) {
+            fprintf(stderr, "cannot create a raw log with %u KB segments on %u MB\n", seg_kb, raw_mb);
+            return 1;
+        }
+        bench.raw_on = true;
+        bench.sd.written_bytes = 0;
+    } else if (mock_sd_open(&bench.sd, out, sd_fixed_us, sd_per_kb_us) != 0) {
+        return 1;
+    }
+    mock_sd_set_spikes(&bench.sd, spike_every, spike_us);
+    log_writer_init(&bench.writer, card_sink, &bench.sd);
+    if (spill_kb != 0) {
+        log_spill_flash_t flash = {
+            .read = mock_flash_read,
+            .write = mock_flash_write,
+            .erase = mock_flash_erase,
+            .ctx = &bench.flash,
+            .size = spill_kb * 1024,
+            .sector_size = SPILL_SECTOR,
+        };
+        if (mock_flash_init(&bench.flash, flash.size, SPILL_SECTOR, erase_us, page_us) != 0 ||
+            !log_spill_init(&bench.spill, &flash)) {
+            fprintf(stderr, "spill partition of %u KB is too small\n", spill_kb);
+            return 1;
+        }
+        bench.spill_on = true;
+        bench.spill_mark = (uint64_t)card_size * spill_pct / 100;
+    }
+    if (patterns != NULL) {
+        // 与设备端 uart_trigger_init 相同的 '|' 分隔写法
+        log_trigger_init(&bench.trigger, bench.trigger_buf, sizeof(bench.trigger_buf), window_ms, window_ms, 0);
+        for (const char *p = patterns; *p != '\0';) {
+            size_t n = strcspn(p, "|");
+            if (n > 0 && log_trigger_add(&bench.trigger, p, n) < 0) {
+                fprintf(stderr, "trigger pattern '%.*s' does not fit\n", (int)n, p);
+                return 1;
+            }
+            p += n + (p[n] == '|');
+        }
+        log_trigger_compile(&bench.trigger);
+        bench.trigger_on = true;
+    }
+    if (dedup_ms != 0) {
+        log_dedup_init(&bench.dedup, LOG_DEDUP_FLAG_SKIP_TICKS, dedup_ms);
+        bench.dedup_on = true;
+    }
+    log_stats.card_ring_size = card_size;
+    bench.interval_us = interval_ms * 1000;
+    pthread_mutex_init(&bench.mark_lock, NULL);
+
+    if (tty != NULL) {
+        printf("reading %s", tty);
+    } else {
+        char rate_str[16] = "max";
+        if (rate != 0) {
+            snprintf(rate_str, sizeof(rate_str), "%u", rate);
+        }
+        printf("replay %llu bytes at %s B/s", (unsigned long long)bench.uart.len * bench.uart.loops, rate_str);
+    }
+    printf(", card ring %u, uart rx %u, interval %u ms, sd %u us + %u us/KB",
+           card_size, uart_size, interval_ms, sd_fixed_us, sd_per_kb_us);
+    if (spike_every != 0) {
+        printf(", %u us spike every %u writes", spike_us, spike_every);
+    }
+    if (bench.spill_on) {
+        printf(", spill %u KB above %u%%", spill_kb, spill_pct);
+    }
+    if (bench.raw_on) {
+        printf(", raw log %u x %u KB segments", bench.raw.seg_count, seg_kb);
+    }
+    if (bench.trigger_on) {
+        printf(", trigger '%s' +-%u ms", patterns, window_ms);
+    }
+    if (bench.dedup_on) {
+        printf(", dedup every %u ms", dedup_ms);
+    }
+    if (read_target_ms != 0) {
+        printf(", adaptive reads (%u ms)", read_target_ms);
+    } else {
+        printf(", reads %u B / %u ms", UART_READ_LEN, UART_READ_TMO_MS);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    pthread_t uart_thread, card_thread;
+    bench.start_us = mock_now_us();
+    if (read_target_ms != 0) {
+        log_rxsize_init(&bench.rxsize, UART_READ_MIN, UART_READ_MAX, UART_READ_TMO_MS, UART_READ_TMO_MAX_MS,
+                        read_target_ms, 0);
+        bench.rxsize_on = true;
+    }
+    mock_uart_start(&bench.uart);
+    pthread_create(&uart_thread, NULL, uart_task, NULL);
+    pthread_create(&card_thread, NULL, card_task, NULL);
+    pthread_join(uart_thread, NULL);
+    pthread_join(card_thread, NULL);
+    double elapsed = (mock_now_us() - bench.start_us) / 1e6;
+    mock_uart_close(&bench.uart);
+    uint64_t input = bench.uart.fed_bytes;
+
+    printf("elapsed %.2f s\n", elapsed);
+    printf("uart:   rx %u bytes in %u chunks, fifo overflow %u, dropped %llu bytes (%.2f%%)\n",
+           log_stats.uart_rx_bytes, log_stats.uart_rx_chunks, bench.uart.fifo_ovf,
+           (unsigned long long)bench.uart.dropped_bytes, input ? 100.0 * bench.uart.dropped_bytes / input : 0.0);
+    printf("        %.0f B per chunk, cpu %.1f ns/byte", log_stats.uart_rx_chunks ?
+           (double)log_stats.uart_rx_bytes / log_stats.uart_rx_chunks : 0.0,
+           log_stats.uart_rx_bytes ? (double)bench.uart_cpu_ns / log_stats.uart_rx_bytes : 0.0);
+    if (bench.rxsize_on) {
+        printf(", final read %u B / %u ms at %u B/s, %u changes", bench.rxsize.len, bench.rxsize.tmo_ms,
+               bench.rxsize.rate, bench.rxsize.changes);
+    }
+    printf("\n");
+    printf("card:   enqueued %u bytes, ring hwm %u/%u, enqueue waits %u\n",
+           log_stats.card_in_bytes, log_stats.card_ring_hwm, card_size, bench.enq_waits);
+    if (bench.spill_on) {
+        uint32_t sectors = bench.spill.size / SPILL_SECTOR, wear_min = UINT32_MAX, wear_max = 0;
+        for (uint32_t i = 0; i < sectors; i++) {
+            wear_min = bench.flash.erase_count[i] < wear_min ? bench.flash.erase_count[i] : wear_min;
+            wear_max = bench.flash.erase_count[i] > wear_max ? bench.flash.erase_count[i] : wear_max;
+        }
+        printf("spill:  %llu bytes via flash, hwm %u/%u, full waits %u, %u erases (per sector %u..%u), "
+               "dirty writes %u, errors %u\n",
+               (unsigned long long)bench.spilled_bytes, bench.spill.hwm, bench.spill.capacity, bench.spill_waits,
+               bench.flash.erases, wear_min, wear_max, bench.flash.dirty_writes, bench.spill.errors);
+    }
+    if (bench.trigger_on) {
+        printf("trigger: %u captures, %u bytes promoted, %u bytes skipped (%.1f%% of framed data kept)\n",
+               bench.trigger.captures, bench.trigger.promoted_bytes, bench.trigger.skipped_bytes,
+               100.0 * bench.trigger.promoted_bytes /
+                   ((uint64_t)bench.trigger.promoted_bytes + bench.trigger.skipped_bytes + log_ring_used(&bench.trigger.pre)));
+    }
+    if (bench.dedup_on) {
+        printf("dedup:  %u of %u lines folded, %u bytes, %u summaries, %u bytes lost\n", bench.dedup.lines_folded,
+               bench.dedup.lines_in, bench.dedup.bytes_folded, bench.dedup.summaries, bench.dedup.bytes_lost);
+    }
+    printf("writer: %u sink calls, %llu bytes written, %u errors, %u spikes, sd busy %.1f%%\n",
+           bench.writer.sink_calls, (unsigned long long)bench.sd.written_bytes, bench.sd.errors, bench.sd.spikes,
+           100.0 * bench.sd.busy_us / 1e6 / elapsed);
+    if (bench.raw_on) {
+        printf("raw:    %u commits, ended in segment %u seq %u, %.2f%% sector overhead, errors %u\n",
+               bench.raw_commits, bench.raw.seg, bench.raw.cur.seq,
+               log_stats.card_written_bytes ? 100.0 * bench.sd.written_bytes / log_stats.card_written_bytes - 100 : 0.0,
+               bench.raw.errors);
+    }
+    printf("throughput: %.1f KB/s payload in, %.1f KB/s written\n",
+           log_stats.uart_rx_bytes / 1024.0 / elapsed, bench.sd.written_bytes / 1024.0 / elapsed);
+    printf("latency:\n");
+    samples_report("uart read -> fan-out", &bench.lat_ingest);
+    samples_report("uart read -> on card", &bench.lat_card);
+
+    // 所有接收到的数据都应写到卡上，输入字节要么被接收要么计入丢弃
+    int fail = 0;
+    if (log_stats.uart_rx_bytes + bench.uart.dropped_bytes != input) {
+        printf("MISMATCH: rx %u + dropped %llu != input %llu\n", log_stats.uart_rx_bytes,
+               (unsigned long long)bench.uart.dropped_bytes, (unsigned long long)input);
+        fail = 1;
+    }
+    if (log_stats.card_written_bytes + log_stats.card_fail_bytes != log_stats.card_in_bytes) {
+        printf("MISMATCH: written %u != enqueued %u\n", log_stats.card_written_bytes, log_stats.card_in_bytes);
+        fail = 1;
+    }
+    if (bench.spill_on) {
+        if (bench.flash.dirty_writes != 0 || bench.spill.errors != 0) {
+            printf("MISMATCH: spill flash errors\n");
+            fail = 1;
+        }
+        mock_flash_free(&bench.flash);
+    }
+    mock_sd_close(&bench.sd);
+    free(card_buf);
+    return fail;
+}
@@ -0,0 +1,54 @@
+#ifndef __HOST_FFCONF_H__
+#define __HOST_FFCONF_H__
+
+/*
+ * bench_fatfs 使用的 FatFs 配置：与设备端 SD 卡一致（512 字节扇区、长文件名），
+ * 另外打开 f_mkfs 和 exFAT。修订号跟随所用 FatFs 源码的 ff.h，R0.14 及之后的版本均可使用。
+ */
+#define FFCONF_DEF FF_DEFINED
+
+#define FF_FS_READONLY   0
+#define FF_FS_MINIMIZE   0
+#define FF_USE_FIND      0
+#define FF_USE_MKFS      1
+#define FF_USE_FASTSEEK  0
+#define FF_USE_EXPAND    0
+#define FF_USE_CHMOD     0
+#define FF_USE_LABEL     0
+#define FF_USE_FORWARD   0
+#define FF_USE_STRFUNC   0
+#define FF_PRINT_LLI     0
+#define FF_PRINT_FLOAT   0
+#define FF_STRF_ENCODE   0
+
+#define FF_CODE_PAGE     437
+#define FF_USE_LFN       1 // exFAT 需要长文件名，缓冲区放在 BSS
+#define FF_MAX_LFN       255
+#define FF_LFN_UNICODE   0
+#define FF_LFN_BUF       255
+#define FF_SFN_BUF       12
+#define FF_FS_RPATH      0
+
+#define FF_VOLUMES       1
+#define FF_STR_VOLUME_ID 0
+#define FF_VOLUME_STRS   "SD"
+#define FF_MULTI_PARTITION 0
+#define FF_MIN_SS        512
+#define FF_MAX_SS        512
+#define FF_LBA64         0
+#define FF_MIN_GPT       0x10000000
+#define FF_USE_TRIM      0
+
+#define FF_FS_TINY       0
+#define FF_FS_EXFAT      1
+#define FF_FS_NORTC      1
+#define FF_NORTC_MON     1
+#define FF_NORTC_MDAY    1
+#define FF_NORTC_YEAR    2025
+#define FF_FS_CRTIME     0
+#define FF_FS_NOFSINFO   0
+#define FF_FS_LOCK       0
+#define FF_FS_REENTRANT  0
+#define FF_FS_TIMEOUT    1000
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __MOCK_CLOCK_H__
+#define __MOCK_CLOCK_H__
+
+#include <stdint.h>
+#include <time.h>
+
+// 主机端替代 esp_timer_get_time / vTaskDelay
+static inline uint64_t mock_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline void mock_sleep_us(uint64_t us)
+{
+    struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mock_flash.h"
+#include "mock_clock.h"
+
+#define FLASH_PAGE_SIZE 256
+
+int mock_flash_init(mock_flash_t *f, uint32_t size, uint32_t sector_size, uint32_t erase_us, uint32_t page_us)
+{
+    f->mem = malloc(size);
+    f->erase_count = calloc(size / sector_size, sizeof(uint32_t));
+    if (f->mem == NULL || f->erase_count == NULL) {
+        return -1;
+    }
+    memset(f->mem, 0x00, size); // 出厂状态未知，使用前必须先擦除
+    f->size = size;
+    f->sector_size = sector_size;
+    f->erase_us = erase_us;
+    f->page_us = page_us;
+    f->erases = 0;
+    f->dirty_writes = 0;
+    return 0;
+}
+
+void mock_flash_free(mock_flash_t *f)
+{
+    free(f->mem);
+    free(f->erase_count);
+}
+
+int mock_flash_read(void *ctx, uint32_t addr, void *buf, size_t len)
+{
+    mock_flash_t *f = ctx;
+    if (addr + len > f->size) {
+        return -1;
+    }
+    memcpy(buf, f->mem + addr, len);
+    return 0;
+}
+
+int mock_flash_write(void *ctx, uint32_t addr, const void *buf, size_t len)
+{
+    mock_flash_t *f = ctx;
+    const uint8_t *src = buf;
+    if (addr + len > f->size) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (f->mem[addr + i] != 0xFF) {
+            f->dirty_writes++;
+            return -1;
+        }
+        f->mem[addr + i] = src[i];
+    }
+    uint32_t pages = (addr % FLASH_PAGE_SIZE + len + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
+    mock_sleep_us((uint64_t)pages * f->page_us);
+    return 0;
+}
+
+int mock_flash_erase(void *ctx, uint32_t addr, size_t len)
+{
+    mock_flash_t *f = ctx;
+    if (addr % f->sector_size != 0 || len % f->sector_size != 0 || addr + len > f->size) {
+        return -1;
+    }
+    memset(f->mem + addr, 0xFF, len);
+    for (uint32_t s = addr / f->sector_size; s < (addr + len) / f->sector_size; s++) {
+        f->erase_count[s]++;
+        f->erases++;
+        mock_sleep_us(f->erase_us);
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef __MOCK_FLASH_H__
+#define __MOCK_FLASH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 内存模拟的 NOR Flash 分区，供 log_spill 使用：擦除把扇区置 0xFF，写入只能把 1 改成 0，
+ * 写到未擦除的位置按错误处理（真实芯片上会得到新旧数据的按位与），
+ * 并按 “每扇区擦除耗时 + 每 256 字节页编程耗时” 模拟延迟。
+ */
+
+typedef struct {
+    uint8_t *mem;
+    uint32_t size;
+    uint32_t sector_size;
+    uint32_t erase_us;      // 每扇区擦除耗时
+    uint32_t page_us;       // 每 256 字节编程耗时
+    uint32_t erases;
+    uint32_t dirty_writes;  // 写入未擦除区域的次数，应始终为 0
+    uint32_t *erase_count;  // 每个扇区的擦除次数，用于检查磨损是否均匀
+} mock_flash_t;
+
+int mock_flash_init(mock_flash_t *f, uint32_t size, uint32_t sector_size, uint32_t erase_us, uint32_t page_us);
+void mock_flash_free(mock_flash_t *f);
+
+// log_spill_flash_t 回调，ctx 为 mock_flash_t
+int mock_flash_read(void *ctx, uint32_t addr, void *buf, size_t len);
+int mock_flash_write(void *ctx, uint32_t addr, const void *buf, size_t len);
+int mock_flash_erase(void *ctx, uint32_t addr, size_t len);
+
+#endif
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <unistd.h>
+#include "mock_sd.h"
+#include "mock_clock.h"
+
+int mock_sd_open(mock_sd_t *sd, const char *path, uint32_t fixed_us, uint32_t per_kb_us)
+{
+    // 截断旧文件，之后按追加方式写入
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    fclose(f);
+    sd->path = path;
+    sd->fixed_us = fixed_us;
+    sd->per_kb_us = per_kb_us;
+    sd->spike_every = 0;
+    sd->spike_us = 0;
+    sd->spikes = 0;
+    sd->written_bytes = 0;
+    sd->writes = 0;
+    sd->errors = 0;
+    sd->busy_us = 0;
+    sd->img = NULL;
+    sd->sectors = 0;
+    return 0;
+}
+
+void mock_sd_set_spikes(mock_sd_t *sd, uint32_t every, uint32_t spike_us)
+{
+    sd->spike_every = every;
+    sd->spike_us = spike_us;
+}
+
+static uint64_t sd_write_cost(mock_sd_t *sd, size_t len)
+{
+    uint64_t cost_us = sd->fixed_us + (uint64_t)sd->per_kb_us * len / 1024;
+    if (sd->spike_every != 0 && (sd->writes + 1) % sd->spike_every == 0) {
+        cost_us += sd->spike_us;
+        sd->spikes++;
+    }
+    return cost_us;
+}
+
+static void sd_write_wait(mock_sd_t *sd, uint64_t start_us, uint64_t cost_us)
+{
+    uint64_t spent = mock_now_us() - start_us;
+    if (spent < cost_us) {
+        mock_sleep_us(cost_us - spent);
+    }
+    sd->busy_us += mock_now_us() - start_us;
+}
+
+int mock_sd_write(void *ctx, const char *data, size_t len)
+{
+    mock_sd_t *sd = ctx;
+    uint64_t start_us = mock_now_us();
+    uint64_t cost_us = sd_write_cost(sd, len);
+    int ret = 0;
+
+    FILE *f = fopen(sd->path, "ab");
+    if (f == NULL || fwrite(data, 1, len, f) != len) {
+        sd->errors++;
+        ret = -1;
+    } else {
+        sd->written_bytes += len;
+    }
+    if (f != NULL) {
+        fclose(f);
+    }
+    sd->writes++;
+    sd_write_wait(sd, start_us, cost_us);
+    return ret;
+}
+
+int mock_sd_open_raw(mock_sd_t *sd, const char *path, uint32_t sectors, uint32_t fixed_us, uint32_t per_kb_us)
+{
+    if (mock_sd_open(sd, path, fixed_us, per_kb_us) != 0) {
+        return -1;
+    }
+    sd->img = fopen(path, "r+b");
+    if (sd->img == NULL || ftruncate(fileno(sd->img), (off_t)sectors * MOCK_SD_SECTOR) != 0) {
+        perror(path);
+        return -1;
+    }
+    sd->sectors = sectors;
+    return 0;
+}
+
+void mock_sd_close(mock_sd_t *sd)
+{
+    if (sd->img != NULL) {
+        fclose(sd->img);
+        sd->img = NULL;
+    }
+}
+
+int mock_sd_read_sectors(void *ctx, uint32_t lba, void *buf, uint32_t count)
+{
+    mock_sd_t *sd = ctx;
+    if (lba + count > sd->sectors || fseeko(sd->img, (off_t)lba * MOCK_SD_SECTOR, SEEK_SET) != 0 ||
+        fread(buf, MOCK_SD_SECTOR, count, sd->img) != count) {
+        return -1;
+    }
+    return 0;
+}
+
+int mock_sd_write_sectors(void *ctx, uint32_t lba, const void *buf, uint32_t count)
+{
+    mock_sd_t *sd = ctx;
+    size_t len = (size_t)count * MOCK_SD_SECTOR;
+    uint64_t start_us = mock_now_us();
+    uint64_t cost_us = sd_write_cost(sd, len);
+    int ret = 0;
+
+    if (lba + count > sd->sectors || fseeko(sd->img, (off_t)lba * MOCK_SD_SECTOR, SEEK_SET) != 0 ||
+        fwrite(buf, MOCK_SD_SECTOR, count, sd->img) != count) {
+        sd->errors++;
+        ret = -1;
+    } else {
+        sd->written_bytes += len;
+    }
+    sd->writes++;
+    sd_write_wait(sd, start_us, cost_us);
+    return ret;
+}
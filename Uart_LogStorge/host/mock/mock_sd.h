@@ -0,0 +1,45 @@
+#ifndef __MOCK_SD_H__
+#define __MOCK_SD_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define MOCK_SD_SECTOR 512
+
+/*
+ * 文件模拟的 TF 卡，作为 log_writer 的 sink：与 s_write_file 一样每次追加写都打开/关闭文件，
+ * 另外按 “固定开销 + 每 KB 耗时” 模拟卡的写入延迟（FAT 更新、SPI 传输），
+ * 并可每隔若干次写入注入一次长延迟，模拟卡内部垃圾回收造成的卡顿。
+ * mock_sd_open_raw 打开的卡按扇区读写镜像文件（对应 sdmmc_read/write_sectors），供裸扇区日志 log_raw 使用，
+ * 写入延迟模型相同。
+ */
+
+typedef struct {
+    const char *path;
+    uint32_t fixed_us;      // 每次写入的固定开销
+    uint32_t per_kb_us;     // 每 KB 数据的传输耗时
+    uint32_t spike_every;   // 每隔多少次写入卡顿一次，0 表示不卡顿
+    uint32_t spike_us;      // 卡顿时额外的耗时
+    uint32_t spikes;
+    uint64_t written_bytes;
+    uint32_t writes;
+    uint32_t errors;
+    uint64_t busy_us;       // 累计写入耗时
+    FILE *img;              // 扇区模式的镜像文件
+    uint32_t sectors;
+} mock_sd_t;
+
+int mock_sd_open(mock_sd_t *sd, const char *path, uint32_t fixed_us, uint32_t per_kb_us);
+void mock_sd_set_spikes(mock_sd_t *sd, uint32_t every, uint32_t spike_us);
+// log_writer_sink_t
+int mock_sd_write(void *ctx, const char *data, size_t len);
+
+// 扇区模式：镜像文件截断为 sectors 个扇区（稀疏文件）
+int mock_sd_open_raw(mock_sd_t *sd, const char *path, uint32_t sectors, uint32_t fixed_us, uint32_t per_kb_us);
+void mock_sd_close(mock_sd_t *sd);
+// log_raw_dev_t 的回调，written_bytes 统计写入的扇区字节数
+int mock_sd_read_sectors(void *ctx, uint32_t lba, void *buf, uint32_t count);
+int mock_sd_write_sectors(void *ctx, uint32_t lba, const void *buf, uint32_t count);
+
+#endif
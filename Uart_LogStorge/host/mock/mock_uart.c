@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include "mock_uart.h"
+#include "mock_clock.h"
+
+#define FEED_TICK_US 1000 // 回放线程每 1 ms 推送一次，近似驱动的接收中断
+
+static int uart_init_rx(mock_uart_t *u, uint32_t rx_size)
+{
+    u->rx_buf = malloc(rx_size);
+    if (!log_ring_init(&u->rx, u->rx_buf, rx_size)) {
+        fprintf(stderr, "mock_uart: rx size %u is not a power of two\n", rx_size);
+        return -1;
+    }
+    u->fed_bytes = 0;
+    u->dropped_bytes = 0;
+    u->fifo_ovf = 0;
+    u->done = false;
+    u->stop = false;
+    pthread_mutex_init(&u->lock, NULL);
+    pthread_cond_init(&u->cond, NULL);
+    return 0;
+}
+
+int mock_uart_open(mock_uart_t *u, const char *path, uint32_t rate, uint32_t loops, uint32_t rx_size)
+{
+    u->tty_fd = -1;
+    if (path != NULL) {
+        FILE *f = fopen(path, "rb");
+        if (f == NULL) {
+            perror(path);
+            return -1;
+        }
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        u->data = malloc(size > 0 ? size : 1);
+        u->len = fread(u->data, 1, size, f);
+        fclose(f);
+    }
+    if (u->len == 0) {
+        fprintf(stderr, "mock_uart: empty capture\n");
+        return -1;
+    }
+    u->rate = rate;
+    u->loops = loops ? loops : 1;
+    return uart_init_rx(u, rx_size);
+}
+
+int mock_uart_open_tty(mock_uart_t *u, const char *tty, uint32_t rx_size)
+{
+    u->data = NULL;
+    u->len = 0;
+    u->rate = 0;
+    u->loops = 0;
+    u->tty_fd = open(tty, O_RDONLY | O_NOCTTY);
+    if (u->tty_fd < 0) {
+        perror(tty);
+        return -1;
+    }
+    // 原始模式：不回显、不做换行转换、不按行缓冲
+    struct termios tio;
+    if (tcgetattr(u->tty_fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(u->tty_fd, TCSANOW, &tio);
+    }
+    return uart_init_rx(u, rx_size);
+}
+
+static void uart_notify(mock_uart_t *u)
+{
+    pthread_mutex_lock(&u->lock);
+    pthread_cond_broadcast(&u->cond);
+    pthread_mutex_unlock(&u->lock);
+}
+
+static void *uart_feed_thread(void *arg)
+{
+    mock_uart_t *u = arg;
+    uint64_t total = (uint64_t)u->len * u->loops;
+    uint64_t start_us = mock_now_us();
+
+    while (!__atomic_load_n(&u->stop, __ATOMIC_ACQUIRE) && u->fed_bytes < total) {
+        uint64_t target = total;
+        if (u->rate != 0) {
+            target = (mock_now_us() - start_us) * u->rate / 1000000;
+            if (target > total) {
+                target = total;
+            }
+        }
+        bool overflow = false;
+        while (u->fed_bytes < target) {
+            size_t pos = u->fed_bytes % u->len;
+            uint32_t n = (target - u->fed_bytes < u->len - pos) ? target - u->fed_bytes : u->len - pos;
+            uint32_t space = log_ring_free(&u->rx);
+            if (n > space) {
+                if (u->rate == 0) {
+                    n = space; // 尽快回放时不丢数据，等接收端读走
+                    if (n == 0) {
+                        break;
+                    }
+                } else {
+                    u->dropped_bytes += n - space;
+                    u->fed_bytes += n - space;
+                    n = space;
+                    overflow = true;
+                }
+            }
+            log_ring_write(&u->rx, u->data + pos, n);
+            u->fed_bytes += n;
+        }
+        if (overflow) {
+            u->fifo_ovf++;
+        }
+        uart_notify(u);
+        mock_sleep_us(FEED_TICK_US);
+    }
+    __atomic_store_n(&u->done, true, __ATOMIC_RELEASE);
+    uart_notify(u);
+    return NULL;
+}
+
+// 实时模式：读到的数据按到达顺序推入接收缓冲区，放不下的部分丢弃，与硬件 FIFO 溢出一致
+static void *uart_tty_thread(void *arg)
+{
+    mock_uart_t *u = arg;
+    uint8_t buf[512];
+
+    while (!__atomic_load_n(&u->stop, __ATOMIC_ACQUIRE)) {
+        struct pollfd pfd = {u->tty_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t n = read(u->tty_fd, buf, sizeof(buf));
+        if (n <= 0) {
+            break; // pty 主端关闭时读到 EIO
+        }
+        u->fed_bytes += n;
+        uint32_t space = log_ring_free(&u->rx);
+        if ((uint32_t)n > space) {
+            u->dropped_bytes += n - space;
+            u->fifo_ovf++;
+            n = space;
+        }
+        log_ring_write(&u->rx, buf, n);
+        uart_notify(u);
+    }
+    __atomic_store_n(&u->done, true, __ATOMIC_RELEASE);
+    uart_notify(u);
+    return NULL;
+}
+
+int mock_uart_start(mock_uart_t *u)
+{
+    return pthread_create(&u->thread, NULL, (u->tty_fd >= 0) ? uart_tty_thread : uart_feed_thread, u);
+}
+
+void mock_uart_close(mock_uart_t *u)
+{
+    __atomic_store_n(&u->stop, true, __ATOMIC_RELEASE);
+    pthread_join(u->thread, NULL);
+    pthread_cond_destroy(&u->cond);
+    pthread_mutex_destroy(&u->lock);
+    free(u->rx_buf);
+    free(u->data);
+    if (u->tty_fd >= 0) {
+        close(u->tty_fd);
+    }
+}
+
+int mock_uart_read_bytes(mock_uart_t *u, uint8_t *buf, size_t len, uint32_t timeout_ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    deadline.tv_sec += timeout_ms / 1000 + deadline.tv_nsec / 1000000000;
+    deadline.tv_nsec %= 1000000000;
+
+    pthread_mutex_lock(&u->lock);
+    while (log_ring_used(&u->rx) < len && !__atomic_load_n(&u->done, __ATOMIC_ACQUIRE)) {
+        if (pthread_cond_timedwait(&u->cond, &u->lock, &deadline) != 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&u->lock);
+    return log_ring_read(&u->rx, buf, len);
+}
+
+bool mock_uart_drained(mock_uart_t *u)
+{
+    return __atomic_load_n(&u->done, __ATOMIC_ACQUIRE) && log_ring_used(&u->rx) == 0;
+}
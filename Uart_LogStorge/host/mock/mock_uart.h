@@ -0,0 +1,45 @@
+#ifndef __MOCK_UART_H__
+#define __MOCK_UART_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "log_ring.h"
+
+/*
+ * 文件回放的 UART：后台线程按设定速率把录制的原始串口数据推入接收缓冲区，
+ * 缓冲区满时按硬件 FIFO 溢出处理（丢弃放不下的部分并计数）；
+ * 也可以从 tty（通常是 pty 从端）实时读取，由外部程序按实际波特率发送数据。
+ * mock_uart_read_bytes 的语义与 uart_read_bytes 一致：凑够 len 字节或超时后返回。
+ */
+
+typedef struct {
+    uint8_t *data;          // 回放数据
+    size_t len;
+    uint32_t rate;          // 字节/秒，0 表示尽快回放（缓冲区满时等待，不丢数据）
+    uint32_t loops;         // 回放次数
+    int tty_fd;             // 实时模式下的 tty，回放模式为 -1
+    log_ring_t rx;          // 模拟驱动接收缓冲区
+    uint8_t *rx_buf;
+    uint64_t fed_bytes;     // 已到达“线路”的字节数（含丢弃）
+    uint64_t dropped_bytes;
+    uint32_t fifo_ovf;
+    bool done;              // 回放结束
+    bool stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} mock_uart_t;
+
+// 读入录制文件；path 为 NULL 时使用调用方通过 data/len 预先填好的数据
+int mock_uart_open(mock_uart_t *u, const char *path, uint32_t rate, uint32_t loops, uint32_t rx_size);
+// 实时模式：从 tty 读取，对端关闭（读到 EOF/EIO）时视为结束
+int mock_uart_open_tty(mock_uart_t *u, const char *tty, uint32_t rx_size);
+int mock_uart_start(mock_uart_t *u);
+void mock_uart_close(mock_uart_t *u);
+int mock_uart_read_bytes(mock_uart_t *u, uint8_t *buf, size_t len, uint32_t timeout_ms);
+// 回放已结束且接收缓冲区已读空
+bool mock_uart_drained(mock_uart_t *u);
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * log_linefmt 主机端测试：把合成日志（或随机二进制数据）按某种帧格式编码成位流，
+ * 再用软件 UART 接收器按每个候选格式解码，统计帧错误/校验错误后评分，检查选中的格式与发送格式一致。
+ * 位流中帧之间插入 0~max_idle 位空闲，max_idle 为 0 时帧紧挨着发送（最难区分的情况）。
+ *
+ *   test_linefmt        失败时返回非 0，由 ctest 运行
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "log_linefmt.h"
+
+#define SAMPLE_BYTES 2048
+#define MAX_BITS     (SAMPLE_BYTES * 16)
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void)
+{
+    rng_state = rng_state * 1103515245 + 12345;
+    return rng_state >> 16;
+}
+
+static int parity_bit(uint8_t v, int bits, char parity)
+{
+    int ones = 0;
+    for (int i = 0; i < bits; i++) {
+        ones += (v >> i) & 1;
+    }
+    return (parity == 'E') ? (ones & 1) : !(ones & 1);
+}
+
+// 按 fmt 编码，返回位数；line 中 1 为空闲（高电平）
+static size_t encode(const log_linefmt_t *fmt, const uint8_t *data, size_t len, int max_idle, uint8_t *line)
+{
+    size_t n = 0;
+    for (int i = 0; i < 4; i++) {
+        line[n++] = 1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        line[n++] = 0;
+        for (int b = 0; b < fmt->data_bits; b++) {
+            line[n++] = (data[i] >> b) & 1;
+        }
+        if (fmt->parity != 'N') {
+            line[n++] = parity_bit(data[i], fmt->data_bits, fmt->parity);
+        }
+        for (int s = 0; s < fmt->stop_bits; s++) {
+            line[n++] = 1;
+        }
+        int idle = max_idle ? (int)(rng() % (max_idle + 1)) : 0;
+        while (idle-- > 0) {
+            line[n++] = 1;
+        }
+    }
+    return n;
+}
+
+// 软件 UART 接收器：在下降沿后按位取样，停止位为 0 记帧错误并等待线路回到高电平，校验不符记校验错误；
+// 与硬件一样，出错的字节仍然交给上层
+static void decode(const log_linefmt_t *fmt, const uint8_t *line, size_t nbits, log_linefmt_score_t *s)
+{
+    uint8_t out[SAMPLE_BYTES * 2];
+    size_t len = 0;
+    size_t frame_bits = 1 + fmt->data_bits + (fmt->parity != 'N') + 1;
+    size_t pos = 0;
+    uint32_t frame_err = 0, parity_err = 0;
+
+    while (pos + frame_bits <= nbits && len < sizeof(out)) {
+        if (line[pos] == 1) {
+            pos++;
+            continue;
+        }
+        size_t p = pos + 1;
+        uint8_t v = 0;
+        for (int b = 0; b < fmt->data_bits; b++) {
+            v |= line[p++] << b;
+        }
+        if (fmt->parity != 'N' && line[p++] != parity_bit(v, fmt->data_bits, fmt->parity)) {
+            parity_err++;
+        }
+        out[len++] = v;
+        if (line[p] == 0) {
+            frame_err++;
+            while (p < nbits && line[p] == 0) {
+                p++;
+            }
+        }
+        pos = p;
+    }
+    log_linefmt_feed(s, out, len);
+    log_linefmt_errors(s, frame_err, parity_err);
+}
+
+static size_t gen_text(uint8_t *buf, size_t size)
+{
+    static const char *msgs[] = {
+        "I (%u) wifi: connected to AP, rssi=-%u\r\n",
+        "W (%u) sensor: retry %u of 5, waiting\r\n",
+        "E (%u) modbus: CRC mismatch on slave %u\r\n",
+        "I (%u) app: heap free %u bytes\r\n",
+    };
+    size_t len = 0;
+    while (len < size - 64) {
+        len += sprintf((char *)buf + len, msgs[rng() % 4], (unsigned)(rng() % 100000), (unsigned)(rng() % 100));
+    }
+    return len;
+}
+
+static size_t gen_binary(uint8_t *buf, size_t size, int data_bits)
+{
+    for (size_t i = 0; i < size; i++) {
+        buf[i] = rng() & ((1 << data_bits) - 1);
+    }
+    return size;
+}
+
+static int run(const char *what, const log_linefmt_t *src, const uint8_t *data, size_t len, int max_idle)
+{
+    static uint8_t line[MAX_BITS];
+    log_linefmt_score_t scores[LOG_LINEFMT_NUM_CANDIDATES];
+    char name[4], got[4];
+    size_t nbits = encode(src, data, len, max_idle, line);
+
+    for (int i = 0; i < LOG_LINEFMT_NUM_CANDIDATES; i++) {
+        log_linefmt_reset(&scores[i]);
+        decode(&log_linefmt_candidates[i], line, nbits, &scores[i]);
+        log_linefmt_finish(&scores[i]);
+    }
+    int32_t margin;
+    int best = log_linefmt_pick(scores, LOG_LINEFMT_NUM_CANDIDATES, &margin);
+    bool ok = best >= 0 && log_linefmt_candidates[best].data_bits == src->data_bits &&
+              log_linefmt_candidates[best].parity == src->parity;
+
+    printf("%-6s %s idle<=%d -> %s (score %d, margin %d)%s\n", what, log_linefmt_name(src, name), max_idle,
+           best >= 0 ? log_linefmt_name(&log_linefmt_candidates[best], got) : "-",
+           best >= 0 ? scores[best].score : 0, margin, ok ? "" : "  FAIL");
+    if (!ok) {
+        for (int i = 0; i < LOG_LINEFMT_NUM_CANDIDATES; i++) {
+            printf("    %s: %u bytes, %u printable, %u frame, %u parity, score %d\n",
+                   log_linefmt_name(&log_linefmt_candidates[i], got), scores[i].bytes, scores[i].printable,
+                   scores[i].frame_err, scores[i].parity_err, scores[i].score);
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+int main(void)
+{
+    static uint8_t data[SAMPLE_BYTES];
+    static const log_linefmt_t two_stop[] = {{8, 'N', 2}, {8, 'E', 2}, {7, 'E', 2}};
+    int failed = 0;
+
+    for (int idle = 0; idle <= 3; idle += 3) {
+        for (int i = 0; i < LOG_LINEFMT_NUM_CANDIDATES; i++) {
+            size_t len = gen_text(data, sizeof(data));
+            failed += run("text", &log_linefmt_candidates[i], data, len, idle);
+        }
+        // 2 个停止位的数据应识别为对应的 1 个停止位格式
+        for (size_t i = 0; i < sizeof(two_stop) / sizeof(two_stop[0]); i++) {
+            size_t len = gen_text(data, sizeof(data));
+            failed += run("text", &two_stop[i], data, len, idle);
+        }
+        // 二进制协议：可打印比例没有意义，只靠错误率区分，只测 8 位格式
+        for (int i = 0; i < 3; i++) {
+            size_t len = gen_binary(data, sizeof(data), 8);
+            failed += run("binary", &log_linefmt_candidates[i], data, len, idle);
+        }
+    }
+
+    // 样本不足时不选择任何格式
+    log_linefmt_score_t s[2];
+    log_linefmt_reset(&s[0]);
+    log_linefmt_reset(&s[1]);
+    log_linefmt_feed(&s[0], (const uint8_t *)"hi\n", 3);
+    log_linefmt_finish(&s[0]);
+    log_linefmt_finish(&s[1]);
+    if (log_linefmt_pick(s, 2, NULL) != -1) {
+        printf("short sample picked a format  FAIL\n");
+        failed++;
+    }
+
+    printf("%s: %d failed\n", failed ? "FAIL" : "PASS", failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * log_match 主机端测试：模式超出状态或类别容量时 log_match_add 返回 -1，且不改动匹配器，
+ * 之前添加的模式仍能正常匹配。
+ *
+ *   test_match          失败时返回非 0，由 ctest 运行
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "log_match.h"
+
+static int failed = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) {
+        failed++;
+    }
+}
+
+// 依次取 n 个不同的可打印字符，跳过字母，避免大小写折叠影响计数
+static size_t distinct_chars(char *buf, int n, char first)
+{
+    int len = 0;
+    for (int c = first; len < n && c < 0x7f; c++) {
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+            continue;
+        }
+        buf[len++] = (char)c;
+    }
+    return (size_t)len;
+}
+
+static void test_class_limit(uint8_t flags, const char *name)
+{
+    static log_match_t m, before;
+    char pat[LOG_MATCH_PATTERN_MAX];
+    char what[64];
+
+    log_match_init(&m, flags);
+    check(log_match_add(&m, "error", 5) == 0, "add \"error\"");
+    // "error" 用掉 e/r/o 三个类别，加上“其他”类共 4 个，剩下的类别数少于这个模式的字符数
+    int room = LOG_MATCH_MAX_CLASSES - m.num_classes;
+    size_t len = distinct_chars(pat, room + 1, '!');
+    memcpy(&before, &m, sizeof(m));
+    snprintf(what, sizeof(what), "%s: %zu new classes rejected", name, len);
+    check(log_match_add(&m, pat, len) == -1, what);
+    check(memcmp(&before, &m, sizeof(m)) == 0, "matcher unchanged after rejection");
+
+    // 恰好用完类别的模式仍可添加
+    len = distinct_chars(pat, room, '!');
+    snprintf(what, sizeof(what), "%s: %zu new classes accepted", name, len);
+    check(log_match_add(&m, pat, len) == 1, what);
+    check(m.num_classes == LOG_MATCH_MAX_CLASSES, "all classes used");
+    // 只用已有字符的模式不需要新类别
+    check(log_match_add(&m, "roe", 3) == 2, "add pattern of existing classes");
+    check(log_match_add(&m, "x", 1) == -1, "one more class rejected");
+
+    log_match_compile(&m);
+    check(log_match_line(&m, "an ERROR here", 13) == ((flags & LOG_MATCH_FLAG_NOCASE) ? 0x01 : 0x00),
+          "earlier pattern still matches");
+    check(log_match_line(&m, pat, len) == 0x02, "full-class pattern matches");
+}
+
+static void test_state_limit(void)
+{
+    static log_match_t m, before;
+    char pat[LOG_MATCH_PATTERN_MAX];
+
+    log_match_init(&m, 0);
+    // 同一个字符的长模式只用一个类别，每个字节一个状态
+    memset(pat, '-', sizeof(pat));
+    check(log_match_add(&m, pat, LOG_MATCH_PATTERN_MAX) == 0, "add 32-byte pattern");
+    memset(pat, '=', sizeof(pat));
+    check(log_match_add(&m, pat, LOG_MATCH_PATTERN_MAX - 2) == 1, "add 30-byte pattern");
+    memcpy(&before, &m, sizeof(m));
+    check(log_match_add(&m, "+++", 3) == -1, "pattern beyond state budget rejected");
+    check(memcmp(&before, &m, sizeof(m)) == 0, "matcher unchanged after rejection");
+}
+
+int main(void)
+{
+    test_class_limit(0, "case-sensitive");
+    test_class_limit(LOG_MATCH_FLAG_NOCASE, "nocase");
+    test_state_limit();
+
+    printf("%s: %d failed\n", failed ? "FAIL" : "PASS", failed);
+    return failed ? 1 : 0;
+}
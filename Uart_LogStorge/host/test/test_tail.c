@@ -0,0 +1,167 @@
+/*
+ * log_tail 主机端测试：一写多读的实时流缓冲区。数据流第 n 个字节的值由 n 算出，
+ * 每次读取都按读者的累计偏移核对内容；检查被覆盖的读者跳到最旧的保留数据、lost 计数、
+ * 超过容量的单次写入、中途打开和关闭的读者，以及 32 位累计偏移回绕。
+ *
+ *   test_tail           失败时返回非 0，由 ctest 运行
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "log_tail.h"
+
+#define RING_SIZE 64
+
+static int failed = 0;
+static uint32_t written = 0; // 数据流的累计偏移，与 ring.head 相同
+
+static void check(bool ok, const char *what)
+{
+    printf("%-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) {
+        failed++;
+    }
+}
+
+static uint8_t stream_byte(uint32_t off)
+{
+    return (uint8_t)(off * 7 + (off >> 8) + 3);
+}
+
+static void write_stream(log_tail_t *t, uint32_t len)
+{
+    static uint8_t chunk[4 * RING_SIZE];
+    for (uint32_t i = 0; i < len; i++) {
+        chunk[i] = stream_byte(written + i);
+    }
+    log_tail_write(t, chunk, len);
+    written += len;
+}
+
+// 读出读者的全部数据，核对内容与偏移，返回读出的字节数
+static uint32_t drain(log_tail_t *t, int id, uint32_t max, bool *content_ok)
+{
+    uint8_t out[RING_SIZE];
+    uint32_t total = 0;
+    uint32_t n;
+    while (total < max && (n = log_tail_read(t, id, out, (max - total < sizeof(out)) ? max - total : sizeof(out))) > 0) {
+        uint32_t start = log_tail_cursor(t, id) - n;
+        for (uint32_t i = 0; i < n; i++) {
+            if (out[i] != stream_byte(start + i)) {
+                *content_ok = false;
+            }
+        }
+        total += n;
+    }
+    return total;
+}
+
+static void reset(log_tail_t *t, uint8_t *buf, uint32_t start)
+{
+    log_tail_init(t, buf, RING_SIZE);
+    t->ring.head = t->ring.tail = start;
+    written = start;
+}
+
+static void test_basic(log_tail_t *t, uint8_t *buf)
+{
+    bool ok = true;
+    reset(t, buf, 0);
+    write_stream(t, 10);
+    log_tail_open(t, 0);
+    check(log_tail_avail(t, 0) == 0, "new reader starts at the write position");
+    write_stream(t, 40);
+    check(log_tail_avail(t, 0) == 40, "reader sees data written after open");
+    check(drain(t, 0, ~0u, &ok) == 40 && ok, "reads back 40 bytes in order");
+    check(t->rd[0].lost == 0 && log_tail_avail(t, 0) == 0, "nothing lost, nothing left");
+}
+
+static void test_lapped(log_tail_t *t, uint8_t *buf)
+{
+    bool ok = true;
+    reset(t, buf, 0);
+    log_tail_open(t, 0);
+    log_tail_open(t, 1);
+    uint32_t fast = 0;
+    for (int i = 0; i < 7; i++) {
+        write_stream(t, 30);
+        fast += drain(t, 0, ~0u, &ok);
+    }
+    check(fast == 210 && t->rd[0].lost == 0, "reader keeping up loses nothing");
+    check(log_tail_avail(t, 1) == RING_SIZE, "lapped reader sees at most the capacity");
+    check(log_tail_max_lag(t) == RING_SIZE, "max lag is the lapped reader's");
+    uint32_t slow = drain(t, 1, ~0u, &ok);
+    check(slow == RING_SIZE && t->rd[1].lost == 210 - RING_SIZE, "lapped reader skips to the oldest data");
+    check(ok, "lapped reader content matches the stream");
+
+    // 部分读取后再被覆盖，lost 累加
+    write_stream(t, 40);
+    drain(t, 1, 10, &ok);
+    write_stream(t, 60);
+    uint32_t n = drain(t, 1, ~0u, &ok);
+    check(n == RING_SIZE && t->rd[1].lost == 210 - RING_SIZE + 26, "lost accumulates across laps");
+    check(t->rd[1].lost + slow + 10 + n == written, "read + lost == written since open");
+    check(ok, "content still matches after the second lap");
+}
+
+static void test_oversize(log_tail_t *t, uint8_t *buf)
+{
+    bool ok = true;
+    reset(t, buf, 0);
+    log_tail_open(t, 0);
+    write_stream(t, 20);
+    drain(t, 0, 5, &ok);
+    write_stream(t, 3 * RING_SIZE + 7);
+    check(t->ring.head == written, "oversize write advances head by its full length");
+    check(log_tail_avail(t, 0) == RING_SIZE, "only the last capacity bytes are kept");
+    uint32_t n = drain(t, 0, ~0u, &ok);
+    check(n == RING_SIZE && t->rd[0].lost == written - 5 - RING_SIZE, "oversize write counted as lost");
+    check(ok, "kept bytes are the tail of the oversize write");
+}
+
+static void test_close(log_tail_t *t, uint8_t *buf)
+{
+    uint8_t out[8];
+    reset(t, buf, 0);
+    log_tail_open(t, 2);
+    write_stream(t, 50);
+    log_tail_close(t, 2);
+    check(log_tail_avail(t, 2) == 0 && log_tail_read(t, 2, out, sizeof(out)) == 0, "closed reader reads nothing");
+    check(log_tail_max_lag(t) == 0, "closed reader does not count for max lag");
+    log_tail_open(t, 2);
+    check(log_tail_avail(t, 2) == 0 && t->rd[2].lost == 0, "reopened reader starts fresh");
+}
+
+static void test_wrap(log_tail_t *t, uint8_t *buf)
+{
+    bool ok = true;
+    // 累计偏移接近 32 位上限，读写过程中回绕
+    reset(t, buf, 0xffffffffu - 100);
+    log_tail_open(t, 0);
+    log_tail_open(t, 1);
+    uint32_t read0 = 0;
+    for (int i = 0; i < 10; i++) {
+        write_stream(t, 25);
+        read0 += drain(t, 0, ~0u, &ok);
+    }
+    check(read0 == 250 && t->rd[0].lost == 0, "counter wrap: reader keeping up loses nothing");
+    uint32_t read1 = drain(t, 1, ~0u, &ok);
+    check(read1 == RING_SIZE && t->rd[1].lost == 250 - RING_SIZE, "counter wrap: lapped reader catches up");
+    check(ok, "counter wrap: content matches");
+}
+
+int main(void)
+{
+    static log_tail_t tail;
+    static uint8_t buf[RING_SIZE];
+
+    check(!log_tail_init(&tail, buf, 48), "non power-of-two size rejected");
+    test_basic(&tail, buf);
+    test_lapped(&tail, buf);
+    test_oversize(&tail, buf);
+    test_close(&tail, buf);
+    test_wrap(&tail, buf);
+
+    printf("%s: %d failed\n", failed ? "FAIL" : "PASS", failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "ble_gatt.h"
+#include "ble_alert.h"
+#include "log_mem.h"
+#include "sched_profile.h"
+
+static const char *TAG = "BLE_ALERT";
+
+#define BLE_ALERT_QUEUE_LEN 4
+#define BLE_ALERT_RETRY_MS  500
+
+typedef struct {
+    uint8_t type;
+    uint8_t hits;
+    uint8_t text_len;
+    uint32_t count;
+    uint32_t time_ms;
+    char text[BLE_ALERT_TEXT_MAX];
+} ble_alert_t;
+
+static QueueHandle_t alert_queue = NULL;
+static uint8_t alert_pkt[BLE_ALERT_HDR_LEN + BLE_ALERT_TEXT_MAX];
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static esp_err_t alert_send(const ble_alert_t *a)
+{
+    size_t text_len = a->text_len;
+    size_t room = ble_get_notify_payload(BLE_CONN_ALL) - BLE_ALERT_HDR_LEN;
+    if (text_len > room) {
+        text_len = room;
+    }
+    alert_pkt[0] = a->type;
+    alert_pkt[1] = a->hits;
+    put_u32(&alert_pkt[2], a->count);
+    put_u32(&alert_pkt[6], a->time_ms);
+    memcpy(&alert_pkt[BLE_ALERT_HDR_LEN], a->text, text_len);
+    // 告警发给所有连接，按最小的 MTU 截断
+    return ble_log_svc_notify(BLE_CONN_ALL, LOG_SVC_IDX_ALERT_VAL, alert_pkt, BLE_ALERT_HDR_LEN + text_len);
+}
+
+// 发送可能因拥塞阻塞，放在独立任务中，不占用 uart_task 的时间
+static void ble_alert_task(void *pvParameters)
+{
+    ble_alert_t alert;
+    while (1) {
+        if (xQueuePeek(alert_queue, &alert, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (!ble_is_connected() || alert_send(&alert) != ESP_OK) {
+            // 留在队列中，连接后再发
+            vTaskDelay(pdMS_TO_TICKS(BLE_ALERT_RETRY_MS));
+            continue;
+        }
+        xQueueReceive(alert_queue, &alert, 0);
+    }
+}
+
+void ble_alert_raise(uint8_t type, uint8_t hits, uint32_t count, uint32_t time_ms, const char *text, size_t len)
+{
+    ble_alert_t alert = {
+        .type = type,
+        .hits = hits,
+        .count = count,
+        .time_ms = time_ms,
+    };
+    if (alert_queue == NULL) {
+        return;
+    }
+    alert.text_len = (len < BLE_ALERT_TEXT_MAX) ? len : BLE_ALERT_TEXT_MAX;
+    memcpy(alert.text, text, alert.text_len);
+    if (xQueueSend(alert_queue, &alert, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Alert queue full, alert %" PRIu32 " dropped", count);
+    }
+}
+
+void ble_alert_init(void)
+{
+    alert_queue = xQueueCreate(BLE_ALERT_QUEUE_LEN, sizeof(ble_alert_t));
+    if (alert_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create alert queue");
+        return;
+    }
+    log_mem_add_static(LOG_MEM_BLE, sizeof(alert_pkt));
+    xTaskCreate(ble_alert_task, "ble_alert_task", TASK_STACK_BLE_ALERT, NULL, TASK_PRIO_BLE_ALERT, NULL);
+}
@@ -0,0 +1,19 @@
+#ifndef __BLE_ALERT_H__
+#define __BLE_ALERT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 告警特征（0xEE06）只支持通知，多字节字段均为小端：
+// [type u8][hits u8][count u32][time_ms u32][text...]
+// hits 为命中的触发模式位图（按 CONFIG_LOG_TRIGGER_PATTERNS 中的顺序），count 为累计触发次数，
+// text 为命中行（从行首开始，按 MTU 截断，不含换行）
+#define BLE_ALERT_TRIGGER  0x01
+#define BLE_ALERT_HDR_LEN  10
+#define BLE_ALERT_TEXT_MAX 96
+
+void ble_alert_init(void);
+// 可在 uart_task 中调用，不阻塞；未连接时最多保留 4 条，连接后依次发出
+void ble_alert_raise(uint8_t type, uint8_t hits, uint32_t count, uint32_t time_ms, const char *text, size_t len);
+
+#endif
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "ble_gatt.h"
+#include "ble_file.h"
+#include "tfcard/bsp_tfcard.h"
+#include "log_mem.h"
+#include "sched_profile.h"
+
+static const char *TAG = "BLE_FILE";
+
+// 按 FATFS 扇区（CONFIG_FATFS_SECTOR_4096）对齐整块读取，避免与写入任务争抢时产生大量小读
+#define FILE_XFER_BLOCK_SIZE 4096
+#define FILE_XFER_QUEUE_LEN 2
+#define FILE_XFER_NAME_MAX 64
+#define FILE_XFER_HDR_LEN 3 // [type][seq u16]
+
+typedef struct {
+    uint16_t conn_id;
+    uint8_t cmd;
+    uint32_t offset;
+    uint32_t length;
+    char name[FILE_XFER_NAME_MAX];
+} file_req_t;
+
+static QueueHandle_t file_req_queue = NULL;
+static volatile bool file_abort_flag = false;
+static volatile uint16_t file_conn = BLE_CONN_ALL; // 正在处理的请求来自的连接
+static uint16_t file_seq = 0;
+
+static uint8_t file_block[FILE_XFER_BLOCK_SIZE];
+static uint8_t file_pkt[FILE_XFER_HDR_LEN + 256];
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static esp_err_t file_send_pkt(uint8_t type, const uint8_t *payload, size_t len)
+{
+    file_pkt[0] = type;
+    put_u16(&file_pkt[1], file_seq++);
+    memcpy(&file_pkt[FILE_XFER_HDR_LEN], payload, len);
+    return ble_log_svc_notify(file_conn, LOG_SVC_IDX_FILE_DATA_VAL, file_pkt, FILE_XFER_HDR_LEN + len);
+}
+
+static void file_send_end(uint8_t status, uint32_t count, uint32_t crc)
+{
+    uint8_t end[9];
+    end[0] = status;
+    put_u32(&end[1], count);
+    put_u32(&end[5], crc);
+    file_send_pkt(BLE_FILE_PKT_END, end, sizeof(end));
+}
+
+// 单个通知可承载的数据量，受 MTU 和本地发送缓冲限制
+static size_t file_pkt_payload(void)
+{
+    size_t payload = ble_get_notify_payload(file_conn) - FILE_XFER_HDR_LEN;
+    return (payload < sizeof(file_pkt) - FILE_XFER_HDR_LEN) ? payload : sizeof(file_pkt) - FILE_XFER_HDR_LEN;
+}
+
+static void file_list(void)
+{
+    DIR *dir = opendir(TF_CARD_MOUNT_POINT);
+    if (dir == NULL) {
+        file_send_end(BLE_FILE_STATUS_IO_ERROR, 0, 0);
+        return;
+    }
+
+    const char *active = tfcard_get_log_path();
+    char path[sizeof(TF_CARD_MOUNT_POINT) + FILE_XFER_NAME_MAX + 1];
+    uint8_t entry[4 + 1 + FILE_XFER_NAME_MAX];
+    uint32_t count = 0;
+    struct dirent *de;
+    struct stat st;
+
+    while ((de = readdir(dir)) != NULL && !file_abort_flag) {
+        if (de->d_type == DT_DIR) {
+            continue;
+        }
+        size_t name_len = strnlen(de->d_name, FILE_XFER_NAME_MAX);
+        if (name_len + 5 > file_pkt_payload()) {
+            name_len = file_pkt_payload() - 5;
+        }
+        snprintf(path, sizeof(path), "%s/%s", TF_CARD_MOUNT_POINT, de->d_name);
+        if (stat(path, &st) != 0) {
+            continue;
+        }
+        put_u32(entry, (uint32_t)st.st_size);
+        entry[4] = (strcmp(path, active) == 0) ? BLE_FILE_ENTRY_FLAG_ACTIVE : 0;
+        memcpy(&entry[5], de->d_name, name_len);
+        if (file_send_pkt(BLE_FILE_PKT_ENTRY, entry, 5 + name_len) != ESP_OK) {
+            break;
+        }
+        count++;
+    }
+    closedir(dir);
+
+    file_send_end(file_abort_flag ? BLE_FILE_STATUS_ABORTED : BLE_FILE_STATUS_OK, count, 0);
+}
+
+static void file_read(const file_req_t *req)
+{
+    char path[sizeof(TF_CARD_MOUNT_POINT) + FILE_XFER_NAME_MAX + 1];
+    struct stat st;
+
+    // 只允许访问挂载点根目录下的文件
+    if (req->name[0] == '\0' || strchr(req->name, '/') != NULL || strcmp(req->name, "..") == 0) {
+        file_send_end(BLE_FILE_STATUS_BAD_REQUEST, 0, 0);
+        return;
+    }
+    snprintf(path, sizeof(path), "%s/%s", TF_CARD_MOUNT_POINT, req->name);
+    if (stat(path, &st) != 0) {
+        file_send_end(BLE_FILE_STATUS_NOT_FOUND, 0, 0);
+        return;
+    }
+
+    // 以请求时的文件长度为准，正在追加的文件不会越读越长
+    uint32_t file_size = (uint32_t)st.st_size;
+    if (req->offset > file_size) {
+        file_send_end(BLE_FILE_STATUS_BAD_REQUEST, 0, 0);
+        return;
+    }
+    uint32_t end = file_size;
+    if (req->length != 0 && req->length < file_size - req->offset) {
+        end = req->offset + req->length;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        file_send_end(BLE_FILE_STATUS_IO_ERROR, 0, 0);
+        return;
+    }
+
+    uint32_t block_pos = req->offset & ~(FILE_XFER_BLOCK_SIZE - 1);
+    uint32_t pos = req->offset;
+    uint32_t crc = 0;
+    uint8_t status = BLE_FILE_STATUS_OK;
+    size_t payload = file_pkt_payload();
+
+    ESP_LOGI(TAG, "Read %s [%" PRIu32 ", %" PRIu32 ") of %" PRIu32, req->name, req->offset, end, file_size);
+    if ((uint32_t)lseek(fd, block_pos, SEEK_SET) != block_pos) {
+        status = BLE_FILE_STATUS_IO_ERROR;
+    }
+
+    while (status == BLE_FILE_STATUS_OK && pos < end) {
+        ssize_t got = read(fd, file_block, FILE_XFER_BLOCK_SIZE);
+        if (got <= 0) {
+            status = BLE_FILE_STATUS_IO_ERROR;
+            break;
+        }
+        uint32_t blk_start = pos - block_pos;
+        uint32_t blk_end = ((uint32_t)got < end - block_pos) ? (uint32_t)got : end - block_pos;
+        block_pos += got;
+
+        for (uint32_t i = blk_start; i < blk_end; i += payload) {
+            if (file_abort_flag) {
+                status = BLE_FILE_STATUS_ABORTED;
+                break;
+            }
+            size_t n = (blk_end - i < payload) ? blk_end - i : payload;
+            if (file_send_pkt(BLE_FILE_PKT_DATA, &file_block[i], n) != ESP_OK) {
+                status = BLE_FILE_STATUS_ABORTED;
+                break;
+            }
+            crc = esp_rom_crc32_le(crc, &file_block[i], n);
+            pos += n;
+        }
+    }
+    close(fd);
+
+    ESP_LOGI(TAG, "Read done, status %d, %" PRIu32 " bytes, crc %08" PRIx32, status, pos - req->offset, crc);
+    file_send_end(status, pos - req->offset, crc);
+}
+
+static void ble_file_task(void *pvParameters)
+{
+    file_req_t req;
+    while (1) {
+        if (xQueueReceive(file_req_queue, &req, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        file_abort_flag = false;
+        file_conn = req.conn_id;
+        file_seq = 0;
+        if (GetTfCardState() != TF_CARD_STATE_MOUNT) {
+            file_send_end(BLE_FILE_STATUS_IO_ERROR, 0, 0);
+            continue;
+        }
+        switch (req.cmd) {
+        case BLE_FILE_CMD_LIST:
+            file_list();
+            break;
+        case BLE_FILE_CMD_READ:
+            file_read(&req);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// 在 BLE 回调上下文中调用，只做解析和投递，读卡与发送都在 ble_file_task 中完成
+void ble_file_handle_ctrl(uint16_t conn_id, const uint8_t *data, size_t len)
+{
+    if (len < 1 || file_req_queue == NULL) {
+        return;
+    }
+
+    file_req_t req = {0};
+    req.conn_id = conn_id;
+    req.cmd = data[0];
+    switch (req.cmd) {
+    case BLE_FILE_CMD_ABORT:
+        ble_file_abort(conn_id);
+        return;
+    case BLE_FILE_CMD_LIST:
+        break;
+    case BLE_FILE_CMD_READ:
+        if (len < 9) {
+            ESP_LOGW(TAG, "Read request too short (%d)", len);
+            return;
+        }
+        req.offset = get_u32(&data[1]);
+        req.length = get_u32(&data[5]);
+        size_t name_len = len - 9;
+        if (name_len >= sizeof(req.name)) {
+            name_len = sizeof(req.name) - 1;
+        }
+        memcpy(req.name, &data[9], name_len);
+        break;
+    default:
+        ESP_LOGW(TAG, "Unknown file command 0x%02x", req.cmd);
+        return;
+    }
+
+    if (xQueueSend(file_req_queue, &req, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "File transfer busy, command 0x%02x dropped", req.cmd);
+    }
+}
+
+void ble_file_abort(uint16_t conn_id)
+{
+    if (file_conn == conn_id) {
+        file_abort_flag = true;
+    }
+}
+
+void ble_file_init(void)
+{
+    file_req_queue = xQueueCreate(FILE_XFER_QUEUE_LEN, sizeof(file_req_t));
+    if (file_req_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create file request queue");
+        return;
+    }
+    log_mem_add_static(LOG_MEM_BLE, sizeof(file_block) + sizeof(file_pkt));
+    xTaskCreate(ble_file_task, "ble_file_task", TASK_STACK_BLE_FILE, NULL, TASK_PRIO_BLE_FILE, NULL);
+}
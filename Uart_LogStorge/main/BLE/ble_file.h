@@ -0,0 +1,33 @@
+#ifndef __BLE_FILE_H__
+#define __BLE_FILE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 文件控制特征（0xEE01）命令
+#define BLE_FILE_CMD_LIST   0x01 // [cmd]
+#define BLE_FILE_CMD_READ   0x02 // [cmd][offset u32][length u32][name...]，length 为 0 表示读到文件尾
+#define BLE_FILE_CMD_ABORT  0x03 // [cmd]
+
+// 文件数据特征（0xEE02）通知帧，多字节字段均为小端
+#define BLE_FILE_PKT_ENTRY  0x81 // [type][seq u16][size u32][flags u8][name...]
+#define BLE_FILE_PKT_DATA   0x82 // [type][seq u16][data...]
+#define BLE_FILE_PKT_END    0x83 // [type][seq u16][status u8][count/bytes u32][crc32 u32]
+
+#define BLE_FILE_ENTRY_FLAG_ACTIVE 0x01 // 该文件正在被写入
+
+// 结束帧状态码
+#define BLE_FILE_STATUS_OK          0
+#define BLE_FILE_STATUS_NOT_FOUND   1
+#define BLE_FILE_STATUS_BAD_REQUEST 2
+#define BLE_FILE_STATUS_ABORTED     3
+#define BLE_FILE_STATUS_IO_ERROR    4
+#define BLE_FILE_STATUS_BUSY        5
+
+void ble_file_init(void);
+// 结果发给发出命令的连接 conn_id
+void ble_file_handle_ctrl(uint16_t conn_id, const uint8_t *data, size_t len);
+// 终止 conn_id 发起的传输（断开连接时调用），其他连接的传输不受影响
+void ble_file_abort(uint16_t conn_id);
+
+#endif
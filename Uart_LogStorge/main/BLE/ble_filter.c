@@ -0,0 +1,151 @@
+#include <string.h>
+#include "esp_log.h"
+#include "ble_gatt.h"
+#include "ble_filter.h"
+#include "log_filter.h"
+#include "log_mem.h"
+
+static const char *TAG = "BLE_FILTER";
+
+// 双缓冲：新过滤器在空闲的一份上编译好后再整体切换，转发路径不会看到半成品
+static log_filter_t filter_buf[2];
+static log_filter_t *filter_active = NULL;
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+// 解析一组 {[len][pattern]}，返回消耗的字节数，失败返回 0
+static size_t parse_patterns(log_filter_t *f, const uint8_t *p, size_t len, bool include)
+{
+    if (len < 1) {
+        return 0;
+    }
+    int n = p[0];
+    size_t pos = 1;
+    for (int i = 0; i < n; i++) {
+        if (pos >= len || pos + 1 + p[pos] > len) {
+            return 0;
+        }
+        size_t plen = p[pos++];
+        int ret = include ? log_filter_add_include(f, (const char *)&p[pos], plen)
+                          : log_filter_add_exclude(f, (const char *)&p[pos], plen);
+        if (ret < 0) {
+            ESP_LOGW(TAG, "%s pattern %d rejected (too long or too many patterns)", include ? "Include" : "Exclude", i);
+            return 0;
+        }
+        pos += plen;
+    }
+    return pos;
+}
+
+// 在 BLE 回调上下文中调用；编译 DFA 只有查表构建，耗时在百微秒以内
+// 过滤器本身不需要初始化，只登记静态缓冲区
+void ble_filter_init(void)
+{
+    log_mem_add_static(LOG_MEM_BLE, sizeof(filter_buf));
+}
+
+bool ble_filter_handle_write(const uint8_t *data, size_t len)
+{
+    if (len < 1) {
+        return false;
+    }
+    switch (data[0]) {
+    case BLE_FILTER_CMD_SET: {
+        if (len < 4) {
+            return false;
+        }
+        log_filter_t *next = (filter_active == &filter_buf[0]) ? &filter_buf[1] : &filter_buf[0];
+        uint8_t flags = 0;
+        if (data[1] & BLE_FILTER_FLAG_NOCASE) {
+            flags |= LOG_FILTER_FLAG_NOCASE;
+        }
+        if (data[1] & BLE_FILTER_FLAG_UNLEVELED) {
+            flags |= LOG_FILTER_FLAG_UNLEVELED;
+        }
+        log_filter_init(next, flags, data[2]);
+
+        size_t pos = 3;
+        size_t used = parse_patterns(next, &data[pos], len - pos, true);
+        if (used == 0) {
+            return false;
+        }
+        pos += used;
+        // 排除模式可省略
+        if (pos < len) {
+            used = parse_patterns(next, &data[pos], len - pos, false);
+            if (used == 0) {
+                return false;
+            }
+            pos += used;
+        }
+        log_filter_compile(next);
+        ble_stream_set_filter(next);
+        filter_active = next;
+        ESP_LOGI(TAG, "Filter installed: %d include, %d exclude, level mask 0x%02x",
+                 next->include.num_patterns, next->exclude.num_patterns, next->level_mask);
+        return true;
+    }
+    case BLE_FILTER_CMD_CLEAR:
+        ble_filter_clear();
+        return true;
+    case BLE_FILTER_CMD_RESET:
+        if (filter_active != NULL) {
+            log_filter_reset_stats(filter_active);
+        }
+        return true;
+    default:
+        ESP_LOGW(TAG, "Invalid filter command 0x%02x", data[0]);
+        return false;
+    }
+}
+
+size_t ble_filter_read_stats(uint8_t *buf, size_t size)
+{
+    const log_filter_t *f = filter_active;
+    if (size < BLE_FILTER_STATS_MAX) {
+        return 0;
+    }
+    memset(buf, 0, BLE_FILTER_STATS_MAX);
+    if (f == NULL) {
+        return 5 + 10 * 4;
+    }
+
+    // 计数器由 UART 任务更新，这里直接读取快照，单个 32 位字段的读取是原子的
+    buf[0] = 1;
+    buf[1] = f->flags;
+    buf[2] = f->level_mask;
+    buf[3] = f->include.num_patterns;
+    buf[4] = f->exclude.num_patterns;
+    size_t pos = 5;
+    put_u32(&buf[pos], f->lines_in);
+    put_u32(&buf[pos + 4], f->lines_out);
+    put_u32(&buf[pos + 8], f->bytes_in);
+    put_u32(&buf[pos + 12], f->bytes_out);
+    put_u32(&buf[pos + 16], f->bytes_dropped);
+    pos += 20;
+    for (int i = 0; i < LOG_FILTER_LEVEL_NUM; i++, pos += 4) {
+        put_u32(&buf[pos], f->level_hits[i]);
+    }
+    for (int i = 0; i < f->include.num_patterns; i++, pos += 4) {
+        put_u32(&buf[pos], f->include_hits[i]);
+    }
+    for (int i = 0; i < f->exclude.num_patterns; i++, pos += 4) {
+        put_u32(&buf[pos], f->exclude_hits[i]);
+    }
+    return pos;
+}
+
+void ble_filter_clear(void)
+{
+    if (filter_active != NULL) {
+        ble_stream_set_filter(NULL);
+        filter_active = NULL;
+        ESP_LOGI(TAG, "Filter cleared");
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef __BLE_FILTER_H__
+#define __BLE_FILTER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// 实时流过滤特征（0xEE04）写入的命令
+// SET:   [cmd][flags u8][level_mask u8][n_inc u8]{[len u8][pattern...]}[n_exc u8]{[len u8][pattern...]}
+//        level_mask 位：E=0x01 W=0x02 I=0x04 D=0x08 V=0x10，为 0 表示不按级别过滤
+// CLEAR: [cmd]，取消过滤，恢复全量转发
+// RESET: [cmd]，计数器清零
+#define BLE_FILTER_CMD_SET   0x01
+#define BLE_FILTER_CMD_CLEAR 0x02
+#define BLE_FILTER_CMD_RESET 0x03
+
+#define BLE_FILTER_FLAG_NOCASE    0x01
+#define BLE_FILTER_FLAG_UNLEVELED 0x02 // 设置级别时放行没有级别标记的行
+
+// 读取该特征返回计数器，多字节字段均为小端：
+// [active u8][flags u8][level_mask u8][n_inc u8][n_exc u8]
+// [lines_in u32][lines_out u32][bytes_in u32][bytes_out u32][bytes_dropped u32]
+// [level_hits u32 x5][include_hits u32 x n_inc][exclude_hits u32 x n_exc]
+#define BLE_FILTER_STATS_MAX 128
+
+void ble_filter_init(void);
+bool ble_filter_handle_write(const uint8_t *data, size_t len);
+size_t ble_filter_read_stats(uint8_t *buf, size_t size);
+void ble_filter_clear(void);
+
+#endif
@@ -22,8 +22,8 @@
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
 #include "esp_bt.h"
 
 #include "esp_gap_ble_api.h"
@@ -39,10 +39,28 @@
 
 #include "sdkconfig.h"
 
+#include "ble_gatt.h"
+#include "ble_file.h"
+#include "ble_query.h"
+#include "ble_filter.h"
+#include "ble_trace.h"
+#include "ble_alert.h"
+#include "log_stats.h"
+#include "log_trace.h"
+#include "log_mem.h"
+#include "log_tail.h"
+#include "sched_profile.h"
+#include "log_sched.h"
+#include "tfcard/bsp_tfcard.h"
+#include "ws2812/ws2812.h"
+#include "app_config.h"
+
 #define GATTS_TAG "BLE_GATT:"
 
 ///Declare the static function
 static void gatts_profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param);
+static void gatts_profile_b_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param);
+static size_t ble_stats_snapshot(uint8_t *buf, size_t size);
 
 #define GATTS_SERVICE_UUID_TEST_A   0x00FF
 #define GATTS_CHAR_UUID_TEST_A      0xFF01
@@ -62,14 +80,95 @@ static char test_device_name[ESP_BLE_ADV_NAME_LEN_MAX] = "ESP32C3_UARTLOGGER";
 static uint8_t char1_str[] = {0x11,0x22,0x33};
 static esp_gatt_char_prop_t a_property = 0;
 
+// 实时流缓冲区：uart_task 只写一份，每个打开通知的客户端按自己的读位置发送，由 uart_ble_mutex 保护
 #define UART_BLE_RINGBUF_SIZE 4096
-static RingbufHandle_t uart_ble_ringbuf = NULL;
+static uint8_t uart_ble_ring_storage[UART_BLE_RINGBUF_SIZE];
+static log_tail_t uart_ble_tail;
 static SemaphoreHandle_t uart_ble_mutex = NULL;
-static uint16_t negotiated_mtu = BLE_MTU_REQUEST; // Default to 20 bytes if MTU negotiation fails
+static StaticSemaphore_t uart_ble_mutex_buf;
+static log_filter_t *ble_stream_filter = NULL; // 实时流过滤器，由 uart_ble_mutex 保护，NULL 表示全量转发
+static char ble_filter_out[2048];
+static uint8_t ble_tx_chunk[BLE_MTU_REQUEST - 3];
+
+_Static_assert(CONFIG_BLE_MAX_CLIENTS <= LOG_TAIL_MAX_READERS, "BLE_MAX_CLIENTS exceeds LOG_TAIL_MAX_READERS");
+
+// 每个连接的状态，客户端编号即 uart_ble_tail 中的读者编号。
+// 只在 BTC 任务中建立和清除：建立时最后置 used，清除时最先清 used，其他任务读到 used 时其余字段有效
+typedef struct {
+    bool used;
+    bool notify;                // 0xFF01 实时流通知已打开
+    volatile bool congested;    // 协议栈发送队列拥塞，由 ESP_GATTS_CONGEST_EVT 维护
+    uint16_t conn_id;
+    uint16_t payload;           // 单条通知的有效载荷（MTU - 3）
+    uint32_t lost;              // 已计入 ble_lag_bytes 的跳过字节数
+} ble_client_t;
+
+static ble_client_t ble_clients[CONFIG_BLE_MAX_CLIENTS];
+static uint8_t ble_client_count = 0;
+static uint8_t ble_stream_clients = 0;  // 打开实时流的客户端数，由 uart_ble_mutex 保护
+#define BLE_CONGEST_WAIT_MS 2000
+
+static ble_client_t *ble_client_find(uint16_t conn_id)
+{
+    for (int i = 0; i < CONFIG_BLE_MAX_CLIENTS; i++) {
+        ble_client_t *c = &ble_clients[i];
+        if (__atomic_load_n(&c->used, __ATOMIC_ACQUIRE) && c->conn_id == conn_id) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+// 连接建立时分配客户端，没有空位返回 NULL；通知打开之前不接收实时流
+static ble_client_t *ble_client_open(uint16_t conn_id)
+{
+    for (int i = 0; i < CONFIG_BLE_MAX_CLIENTS; i++) {
+        ble_client_t *c = &ble_clients[i];
+        if (!c->used) {
+            c->notify = false;
+            c->congested = false;
+            c->conn_id = conn_id;
+            c->payload = 20;    // 默认 MTU 23，MTU 交换后更新
+            c->lost = 0;
+            __atomic_store_n(&c->used, true, __ATOMIC_RELEASE);
+            log_stats.ble_clients = ++ble_client_count;
+            return c;
+        }
+    }
+    return NULL;
+}
+
+// 打开通知时从当前写位置开始跟踪，之前缓冲的数据不补发
+static void ble_client_set_notify(ble_client_t *c, bool on)
+{
+    int id = c - ble_clients;
 
-static uint8_t connect_state = 0;
-#define CONNECT_STATE_DISCONNECTED 0
-#define CONNECT_STATE_CONNECTED 1
+    if (c->notify == on) {
+        return;
+    }
+    xSemaphoreTake(uart_ble_mutex, portMAX_DELAY);
+    if (on) {
+        log_tail_open(&uart_ble_tail, id);
+        c->lost = 0;
+        ble_stream_clients++;
+    } else {
+        log_tail_close(&uart_ble_tail, id);
+        ble_stream_clients--;
+    }
+    c->notify = on;
+    xSemaphoreGive(uart_ble_mutex);
+}
+
+static void ble_client_close(ble_client_t *c)
+{
+    ble_client_set_notify(c, false);
+    __atomic_store_n(&c->used, false, __ATOMIC_RELEASE);
+    log_stats.ble_clients = --ble_client_count;
+    if (ble_client_count == 0) {
+        // 过滤条件对所有客户端共用，最后一个客户端断开后恢复全量转发
+        ble_filter_clear();
+    }
+}
 
 static esp_attr_value_t gatts_demo_char1_val =
 {
@@ -154,8 +253,9 @@ static esp_ble_adv_params_t adv_params = {
     .adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY,
 };
 
-#define PROFILE_NUM 1
+#define PROFILE_NUM 2
 #define PROFILE_A_APP_ID 0
+#define PROFILE_B_APP_ID 1
 
 struct gatts_profile_inst {
     esp_gatts_cb_t gatts_cb;
@@ -178,17 +278,157 @@ static struct gatts_profile_inst gl_profile_tab[PROFILE_NUM] = {
         .gatts_cb = gatts_profile_a_event_handler,
         .gatts_if = ESP_GATT_IF_NONE,       /* Not get the gatt_if, so initial is ESP_GATT_IF_NONE */
     },
+    [PROFILE_B_APP_ID] = {
+        .gatts_cb = gatts_profile_b_event_handler,
+        .gatts_if = ESP_GATT_IF_NONE,
+    },
+};
+
+/* 日志服务（0x00EE）：使用属性表一次性创建，新增特征只需扩展 LOG_SVC_IDX_* 与 log_svc_db */
+#define LOG_SVC_UUID            0x00EE
+#define LOG_SVC_INST_ID         0
+#define LOG_CHAR_UUID_FILE_CTRL 0xEE01
+#define LOG_CHAR_UUID_FILE_DATA 0xEE02
+#define LOG_CHAR_UUID_QUERY     0xEE03
+#define LOG_CHAR_UUID_FILTER    0xEE04
+#define LOG_CHAR_UUID_TRACE     0xEE05
+#define LOG_CHAR_UUID_ALERT     0xEE06
+#define LOG_CHAR_UUID_SCHED     0xEE07
+#define LOG_CHAR_UUID_CONFIG    0xEE08
+
+#define LOG_SVC_CTRL_VAL_LEN_MAX 128
+#define LOG_SVC_DATA_VAL_LEN_MAX (BLE_MTU_REQUEST - 3)
+#define CHAR_DECLARATION_SIZE   (sizeof(uint8_t))
+
+static const uint16_t log_svc_uuid = LOG_SVC_UUID;
+static const uint16_t log_char_uuid_file_ctrl = LOG_CHAR_UUID_FILE_CTRL;
+static const uint16_t log_char_uuid_file_data = LOG_CHAR_UUID_FILE_DATA;
+static const uint16_t log_char_uuid_query = LOG_CHAR_UUID_QUERY;
+static const uint16_t log_char_uuid_filter = LOG_CHAR_UUID_FILTER;
+static const uint16_t log_char_uuid_trace = LOG_CHAR_UUID_TRACE;
+static const uint16_t log_char_uuid_alert = LOG_CHAR_UUID_ALERT;
+static const uint16_t log_char_uuid_sched = LOG_CHAR_UUID_SCHED;
+static const uint16_t log_char_uuid_config = LOG_CHAR_UUID_CONFIG;
+static const uint16_t primary_service_uuid = ESP_GATT_UUID_PRI_SERVICE;
+static const uint16_t character_declaration_uuid = ESP_GATT_UUID_CHAR_DECLARE;
+static const uint16_t character_client_config_uuid = ESP_GATT_UUID_CHAR_CLIENT_CONFIG;
+static const uint8_t char_prop_read = ESP_GATT_CHAR_PROP_BIT_READ;
+static const uint8_t char_prop_write = ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR;
+static const uint8_t char_prop_notify = ESP_GATT_CHAR_PROP_BIT_NOTIFY;
+static const uint8_t char_prop_write_notify = ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_NOTIFY;
+static const uint8_t char_prop_read_write = ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE;
+static uint8_t log_svc_ctrl_value[LOG_SVC_CTRL_VAL_LEN_MAX];
+static uint8_t log_svc_data_value[1];
+static uint8_t log_svc_data_ccc[2] = {0x00, 0x00};
+static uint8_t log_svc_query_value[LOG_SVC_CTRL_VAL_LEN_MAX];
+static uint8_t log_svc_query_ccc[2] = {0x00, 0x00};
+static uint8_t log_svc_filter_value[LOG_SVC_CTRL_VAL_LEN_MAX];
+static uint8_t log_svc_trace_value[LOG_SVC_CTRL_VAL_LEN_MAX];
+static uint8_t log_svc_trace_ccc[2] = {0x00, 0x00};
+static uint8_t log_svc_alert_value[1];
+static uint8_t log_svc_alert_ccc[2] = {0x00, 0x00};
+static uint8_t log_svc_sched_value[1];
+static uint8_t log_svc_config_value[LOG_SVC_CTRL_VAL_LEN_MAX];
+
+static uint16_t log_svc_handle_table[LOG_SVC_IDX_NB];
+
+static const esp_gatts_attr_db_t log_svc_db[LOG_SVC_IDX_NB] = {
+    [LOG_SVC_IDX_SVC] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&primary_service_uuid, ESP_GATT_PERM_READ,
+      sizeof(uint16_t), sizeof(log_svc_uuid), (uint8_t *)&log_svc_uuid}},
+
+    // 文件控制：写入 LIST / READ / ABORT 命令
+    [LOG_SVC_IDX_FILE_CTRL_CHAR] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_write}},
+    [LOG_SVC_IDX_FILE_CTRL_VAL] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&log_char_uuid_file_ctrl, ESP_GATT_PERM_WRITE,
+      LOG_SVC_CTRL_VAL_LEN_MAX, 0, log_svc_ctrl_value}},
+
+    // 文件数据：目录项、数据块和结束帧都通过通知推送
+    [LOG_SVC_IDX_FILE_DATA_CHAR] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_notify}},
+    [LOG_SVC_IDX_FILE_DATA_VAL] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&log_char_uuid_file_data, ESP_GATT_PERM_READ,
+      LOG_SVC_DATA_VAL_LEN_MAX, sizeof(log_svc_data_value), log_svc_data_value}},
+    [LOG_SVC_IDX_FILE_DATA_CFG] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_client_config_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+      sizeof(uint16_t), sizeof(log_svc_data_ccc), log_svc_data_ccc}},
+
+    // 日志检索：写入查询条件，命中行通过同一特征的通知返回
+    [LOG_SVC_IDX_QUERY_CHAR] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_write_notify}},
+    [LOG_SVC_IDX_QUERY_VAL] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&log_char_uuid_query, ESP_GATT_PERM_WRITE,
+      LOG_SVC_CTRL_VAL_LEN_MAX, 0, log_svc_query_value}},
+    [LOG_SVC_IDX_QUERY_CFG] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_client_config_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+      sizeof(uint16_t), sizeof(log_svc_query_ccc), log_svc_query_ccc}},
+
+    // 实时流过滤：写入过滤条件，读取返回各过滤项的命中计数（由应用层应答）
+    [LOG_SVC_IDX_FILTER_CHAR] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_read_write}},
+    [LOG_SVC_IDX_FILTER_VAL] =
+    {{ESP_GATT_RSP_BY_APP}, {ESP_UUID_LEN_16, (uint8_t *)&log_char_uuid_filter, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+      LOG_SVC_CTRL_VAL_LEN_MAX, 0, log_svc_filter_value}},
+
+    // 热路径跟踪：写入导出命令，事件和延迟直方图通过通知返回
+    [LOG_SVC_IDX_TRACE_CHAR] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_write_notify}},
+    [LOG_SVC_IDX_TRACE_VAL] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&log_char_uuid_trace, ESP_GATT_PERM_WRITE,
+      LOG_SVC_CTRL_VAL_LEN_MAX, 0, log_svc_trace_value}},
+    [LOG_SVC_IDX_TRACE_CFG] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_client_config_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+      sizeof(uint16_t), sizeof(log_svc_trace_ccc), log_svc_trace_ccc}},
+
+    // 告警：触发式采集命中时推送通知
+    [LOG_SVC_IDX_ALERT_CHAR] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_notify}},
+    [LOG_SVC_IDX_ALERT_VAL] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&log_char_uuid_alert, ESP_GATT_PERM_READ,
+      LOG_SVC_DATA_VAL_LEN_MAX, sizeof(log_svc_alert_value), log_svc_alert_value}},
+    [LOG_SVC_IDX_ALERT_CFG] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_client_config_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+      sizeof(uint16_t), sizeof(log_svc_alert_ccc), log_svc_alert_ccc}},
+
+    // 调度报告：读取返回各任务的 CPU 占用、栈高水位和抢占次数（由应用层应答）
+    [LOG_SVC_IDX_SCHED_CHAR] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_read}},
+    [LOG_SVC_IDX_SCHED_VAL] =
+    {{ESP_GATT_RSP_BY_APP}, {ESP_UUID_LEN_16, (uint8_t *)&log_char_uuid_sched, ESP_GATT_PERM_READ,
+      LOG_SCHED_REPORT_MAX, 0, log_svc_sched_value}},
+
+    // 运行配置：写入修改命令，读取返回已保存的配置（由应用层应答）
+    [LOG_SVC_IDX_CONFIG_CHAR] =
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
+      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_read_write}},
+    [LOG_SVC_IDX_CONFIG_VAL] =
+    {{ESP_GATT_RSP_BY_APP}, {ESP_UUID_LEN_16, (uint8_t *)&log_char_uuid_config, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+      LOG_SVC_CTRL_VAL_LEN_MAX, 0, log_svc_config_value}},
 };
 
 typedef struct {
     uint8_t                 *prepare_buf;
     int                     prepare_len;
+    uint16_t                conn_id;        // prepare_buf 非空时为占用缓冲区的连接
 } prepare_type_env_t;
 
 static prepare_type_env_t a_prepare_write_env;
+// 长写入缓冲区由所有连接共用，同一时间只属于一个连接：其他连接的准备写入回复 PREPARE_Q_FULL，
+// 占用方执行/取消写入或断开后释放；缓冲区和响应都静态分配，不在 BTC 任务里 malloc
+static uint8_t prepare_buf_storage[PREPARE_BUF_MAX_SIZE];
+static esp_gatt_rsp_t prepare_write_rsp;
 
 void example_write_event_env(esp_gatt_if_t gatts_if, prepare_type_env_t *prepare_write_env, esp_ble_gatts_cb_param_t *param);
 void example_exec_write_event_env(prepare_type_env_t *prepare_write_env, esp_ble_gatts_cb_param_t *param);
+static void prepare_write_release(prepare_type_env_t *prepare_write_env, uint16_t conn_id);
 
 static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
 {
@@ -261,31 +501,24 @@ void example_write_event_env(esp_gatt_if_t gatts_if, prepare_type_env_t *prepare
                 status = ESP_GATT_INVALID_OFFSET;
             } else if ((param->write.offset + param->write.len) > PREPARE_BUF_MAX_SIZE) {
                 status = ESP_GATT_INVALID_ATTR_LEN;
+            } else if (prepare_write_env->prepare_buf != NULL && prepare_write_env->conn_id != param->write.conn_id) {
+                status = ESP_GATT_PREPARE_Q_FULL;
             }
             if (status == ESP_GATT_OK && prepare_write_env->prepare_buf == NULL) {
-                prepare_write_env->prepare_buf = (uint8_t *)malloc(PREPARE_BUF_MAX_SIZE*sizeof(uint8_t));
+                prepare_write_env->prepare_buf = prepare_buf_storage;
                 prepare_write_env->prepare_len = 0;
-                if (prepare_write_env->prepare_buf == NULL) {
-                    ESP_LOGE(GATTS_TAG, "Gatt_server prep no mem");
-                    status = ESP_GATT_NO_RESOURCES;
-                }
+                prepare_write_env->conn_id = param->write.conn_id;
             }
 
-            esp_gatt_rsp_t *gatt_rsp = (esp_gatt_rsp_t *)malloc(sizeof(esp_gatt_rsp_t));
-            if (gatt_rsp) {
-                gatt_rsp->attr_value.len = param->write.len;
-                gatt_rsp->attr_value.handle = param->write.handle;
-                gatt_rsp->attr_value.offset = param->write.offset;
-                gatt_rsp->attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
-                memcpy(gatt_rsp->attr_value.value, param->write.value, param->write.len);
-                esp_err_t response_err = esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, status, gatt_rsp);
-                if (response_err != ESP_OK){
-                    ESP_LOGE(GATTS_TAG, "Send response error\n");
-                }
-                free(gatt_rsp);
-            } else {
-                ESP_LOGE(GATTS_TAG, "malloc failed, no resource to send response error\n");
-                status = ESP_GATT_NO_RESOURCES;
+            esp_gatt_rsp_t *gatt_rsp = &prepare_write_rsp;
+            gatt_rsp->attr_value.len = param->write.len;
+            gatt_rsp->attr_value.handle = param->write.handle;
+            gatt_rsp->attr_value.offset = param->write.offset;
+            gatt_rsp->attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
+            memcpy(gatt_rsp->attr_value.value, param->write.value, param->write.len);
+            esp_err_t response_err = esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, status, gatt_rsp);
+            if (response_err != ESP_OK){
+                ESP_LOGE(GATTS_TAG, "Send response error\n");
             }
             if (status != ESP_GATT_OK){
                 return;
@@ -302,16 +535,25 @@ void example_write_event_env(esp_gatt_if_t gatts_if, prepare_type_env_t *prepare
 }
 
 void example_exec_write_event_env(prepare_type_env_t *prepare_write_env, esp_ble_gatts_cb_param_t *param){
+    // 缓冲区属于其他连接时不动它，该连接的准备写入已被拒绝，没有要执行的数据
+    if (prepare_write_env->prepare_buf == NULL || prepare_write_env->conn_id != param->exec_write.conn_id) {
+        return;
+    }
     if (param->exec_write.exec_write_flag == ESP_GATT_PREP_WRITE_EXEC){
         ESP_LOG_BUFFER_HEX(GATTS_TAG, prepare_write_env->prepare_buf, prepare_write_env->prepare_len);
     }else{
         ESP_LOGI(GATTS_TAG,"Prepare write cancel");
     }
-    if (prepare_write_env->prepare_buf) {
-        free(prepare_write_env->prepare_buf);
+    prepare_write_release(prepare_write_env, param->exec_write.conn_id);
+}
+
+// 释放 conn_id 占用的长写入缓冲区，不属于该连接时不变
+static void prepare_write_release(prepare_type_env_t *prepare_write_env, uint16_t conn_id)
+{
+    if (prepare_write_env->prepare_buf != NULL && prepare_write_env->conn_id == conn_id) {
         prepare_write_env->prepare_buf = NULL;
+        prepare_write_env->prepare_len = 0;
     }
-    prepare_write_env->prepare_len = 0;
 }
 
 static void gatts_profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param) {
@@ -367,13 +609,30 @@ static void gatts_profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_i
         }
 
         esp_gatt_rsp_t rsp;
+        uint8_t snapshot[LOG_STATS_SNAPSHOT_MAX];
         memset(&rsp, 0, sizeof(esp_gatt_rsp_t));
+        if (param->read.handle == gl_profile_tab[PROFILE_A_APP_ID].descr_handle) {
+            // 描述符返回该连接的 CCCD 值
+            ble_client_t *c = ble_client_find(param->read.conn_id);
+            rsp.attr_value.handle = param->read.handle;
+            rsp.attr_value.len = 2;
+            rsp.attr_value.value[0] = (c != NULL && c->notify) ? 0x01 : 0x00;
+            esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id,
+                                        ESP_GATT_OK, &rsp);
+            break;
+        }
+
+        // 特征值返回运行统计快照，超过 MTU 时客户端按 offset 长读
+        size_t snapshot_len = ble_stats_snapshot(snapshot, sizeof(snapshot));
+        if (param->read.offset > snapshot_len) {
+            esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id,
+                                        ESP_GATT_INVALID_OFFSET, NULL);
+            break;
+        }
         rsp.attr_value.handle = param->read.handle;
-        rsp.attr_value.len = 4;
-        rsp.attr_value.value[0] = 0xde;
-        rsp.attr_value.value[1] = 0xed;
-        rsp.attr_value.value[2] = 0xbe;
-        rsp.attr_value.value[3] = 0xef;
+        rsp.attr_value.offset = param->read.offset;
+        rsp.attr_value.len = snapshot_len - param->read.offset;
+        memcpy(rsp.attr_value.value, &snapshot[param->read.offset], rsp.attr_value.len);
         esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id,
                                     ESP_GATT_OK, &rsp);
         break;
@@ -385,9 +644,13 @@ static void gatts_profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_i
             ESP_LOG_BUFFER_HEX(GATTS_TAG, param->write.value, param->write.len);
             if (gl_profile_tab[PROFILE_A_APP_ID].descr_handle == param->write.handle && param->write.len == 2){
                 uint16_t descr_value = param->write.value[1]<<8 | param->write.value[0];
+                ble_client_t *c = ble_client_find(param->write.conn_id);
+                if (c != NULL) {
+                    ble_client_set_notify(c, descr_value == 0x0001);
+                }
                 if (descr_value == 0x0001){
                     if (a_property & ESP_GATT_CHAR_PROP_BIT_NOTIFY){
-                        ESP_LOGI(GATTS_TAG, "Notification enable");
+                        ESP_LOGI(GATTS_TAG, "Notification enable, conn_id %d", param->write.conn_id);
                     }
                 }else if (descr_value == 0x0002){
                     if (a_property & ESP_GATT_CHAR_PROP_BIT_INDICATE){
@@ -411,11 +674,15 @@ static void gatts_profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_i
         esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, ESP_GATT_OK, NULL);
         example_exec_write_event_env(&a_prepare_write_env, param);
         break;
-    case ESP_GATTS_MTU_EVT:
-        ESP_LOGI(GATTS_TAG, "MTU exchange, MTU %d", param->mtu.mtu);
-        negotiated_mtu = param->mtu.mtu - 3; // Subtract 3 bytes for BLE overhead
-        if (negotiated_mtu > BLE_MTU_REQUEST) negotiated_mtu = BLE_MTU_REQUEST; // Enforce maximum MTU
+    case ESP_GATTS_MTU_EVT: {
+        ESP_LOGI(GATTS_TAG, "MTU exchange, conn_id %d, MTU %d", param->mtu.conn_id, param->mtu.mtu);
+        ble_client_t *c = ble_client_find(param->mtu.conn_id);
+        if (c != NULL) {
+            uint16_t payload = param->mtu.mtu - 3; // Subtract 3 bytes for BLE overhead
+            c->payload = (payload > BLE_MTU_REQUEST - 3) ? BLE_MTU_REQUEST - 3 : payload;
+        }
         break;
+    }
     case ESP_GATTS_UNREG_EVT:
         break;
     case ESP_GATTS_CREATE_EVT:
@@ -484,26 +751,44 @@ static void gatts_profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_i
         conn_params.timeout = 400;    // timeout = 400*10ms = 4000ms
         ESP_LOGI(GATTS_TAG, "Connected, conn_id %u, remote "ESP_BD_ADDR_STR"",
                  param->connect.conn_id, ESP_BD_ADDR_HEX(param->connect.remote_bda));
-        gl_profile_tab[PROFILE_A_APP_ID].conn_id = param->connect.conn_id;
+        if (ble_client_open(param->connect.conn_id) == NULL) {
+            // 广播在连接数满时已停止，正常不会走到这里
+            ESP_LOGW(GATTS_TAG, "No free client slot, dropping conn_id %u", param->connect.conn_id);
+            esp_ble_gap_disconnect(param->connect.remote_bda);
+            break;
+        }
         //start sent the update connection parameters to the peer device.
         esp_ble_gap_update_conn_params(&conn_params);
 
         //请求增大MTU
-        esp_err_t mtu_ret = esp_ble_gattc_send_mtu_req(gl_profile_tab[PROFILE_A_APP_ID].gatts_if, BLE_MTU_REQUEST);
+        esp_err_t mtu_ret = esp_ble_gattc_send_mtu_req(gl_profile_tab[PROFILE_A_APP_ID].gatts_if, param->connect.conn_id);
         if (mtu_ret){
             ESP_LOGE(GATTS_TAG, "send mtu request failed, error code = %x", mtu_ret);
         }
 
-        connect_state = CONNECT_STATE_CONNECTED;
+        // 连接建立后控制器停止广播，还有空位时继续广播，其他客户端可以同时连接
+        if (ble_client_count < CONFIG_BLE_MAX_CLIENTS) {
+            esp_ble_gap_start_advertising(&adv_params);
+        }
+        led_set_state(LOG_LED_BLE, true);
         break;
     }
-    case ESP_GATTS_DISCONNECT_EVT:
-        ESP_LOGI(GATTS_TAG, "Disconnected, remote "ESP_BD_ADDR_STR", reason 0x%02x",
-                 ESP_BD_ADDR_HEX(param->disconnect.remote_bda), param->disconnect.reason);
-        esp_ble_gap_start_advertising(&adv_params);
-
-        connect_state = CONNECT_STATE_DISCONNECTED;
+    case ESP_GATTS_DISCONNECT_EVT: {
+        ESP_LOGI(GATTS_TAG, "Disconnected, conn_id %u, remote "ESP_BD_ADDR_STR", reason 0x%02x",
+                 param->disconnect.conn_id, ESP_BD_ADDR_HEX(param->disconnect.remote_bda), param->disconnect.reason);
+        prepare_write_release(&a_prepare_write_env, param->disconnect.conn_id);
+        ble_client_t *c = ble_client_find(param->disconnect.conn_id);
+        if (c == NULL) {
+            break;
+        }
+        // 连接数满时广播已停止，腾出空位后重新开始
+        if (ble_client_count == CONFIG_BLE_MAX_CLIENTS) {
+            esp_ble_gap_start_advertising(&adv_params);
+        }
+        ble_client_close(c);
+        led_set_state(LOG_LED_BLE, ble_client_count > 0);
         break;
+    }
     case ESP_GATTS_CONF_EVT:
         ESP_LOGI(GATTS_TAG, "Confirm receive, status %d, attr_handle %d", param->conf.status, param->conf.handle);
         if (param->conf.status != ESP_GATT_OK){
@@ -520,8 +805,198 @@ static void gatts_profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_i
     }
 }
 
+// 根据属性句柄查找日志服务中的属性索引，找不到返回 LOG_SVC_IDX_NB
+static int log_svc_find_idx(uint16_t handle)
+{
+    for (int i = 0; i < LOG_SVC_IDX_NB; i++) {
+        if (log_svc_handle_table[i] == handle) {
+            return i;
+        }
+    }
+    return LOG_SVC_IDX_NB;
+}
+
+static void gatts_profile_b_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
+{
+    switch (event) {
+    case ESP_GATTS_REG_EVT: {
+        esp_err_t create_attr_ret = esp_ble_gatts_create_attr_tab(log_svc_db, gatts_if, LOG_SVC_IDX_NB, LOG_SVC_INST_ID);
+        if (create_attr_ret){
+            ESP_LOGE(GATTS_TAG, "create log service attr table failed, error code = %x", create_attr_ret);
+        }
+        break;
+    }
+    case ESP_GATTS_CREAT_ATTR_TAB_EVT:
+        if (param->add_attr_tab.status != ESP_GATT_OK){
+            ESP_LOGE(GATTS_TAG, "create log service attr table failed, error code=0x%x", param->add_attr_tab.status);
+        } else if (param->add_attr_tab.num_handle != LOG_SVC_IDX_NB){
+            ESP_LOGE(GATTS_TAG, "log service attr table abnormally, num_handle (%d) doesn't equal to LOG_SVC_IDX_NB(%d)",
+                     param->add_attr_tab.num_handle, LOG_SVC_IDX_NB);
+        } else {
+            ESP_LOGI(GATTS_TAG, "log service attr table created, number handle = %d", param->add_attr_tab.num_handle);
+            memcpy(log_svc_handle_table, param->add_attr_tab.handles, sizeof(log_svc_handle_table));
+            gl_profile_tab[PROFILE_B_APP_ID].service_handle = log_svc_handle_table[LOG_SVC_IDX_SVC];
+            esp_ble_gatts_start_service(log_svc_handle_table[LOG_SVC_IDX_SVC]);
+        }
+        break;
+    case ESP_GATTS_WRITE_EVT: {
+        if (param->write.is_prep) {
+            // 日志服务的命令都在一个 MTU 内，不支持长写
+            if (param->write.need_rsp) {
+                esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, ESP_GATT_REQ_NOT_SUPPORTED, NULL);
+            }
+            break;
+        }
+        // 文件、检索和跟踪的结果发给发出命令的连接
+        int idx = log_svc_find_idx(param->write.handle);
+        switch (idx) {
+        case LOG_SVC_IDX_FILE_CTRL_VAL:
+            ble_file_handle_ctrl(param->write.conn_id, param->write.value, param->write.len);
+            break;
+        case LOG_SVC_IDX_FILE_DATA_CFG:
+            ESP_LOGI(GATTS_TAG, "File data notify %s", (param->write.len == 2 && param->write.value[0] & 0x01) ? "enable" : "disable");
+            break;
+        case LOG_SVC_IDX_QUERY_VAL:
+            ble_query_handle_write(param->write.conn_id, param->write.value, param->write.len);
+            break;
+        case LOG_SVC_IDX_TRACE_VAL:
+            ble_trace_handle_write(param->write.conn_id, param->write.value, param->write.len);
+            break;
+        case LOG_SVC_IDX_FILTER_VAL:
+        case LOG_SVC_IDX_CONFIG_VAL: {
+            bool ok = (idx == LOG_SVC_IDX_FILTER_VAL) ? ble_filter_handle_write(param->write.value, param->write.len)
+                                                      : app_config_handle_write(param->write.value, param->write.len);
+            if (param->write.need_rsp) {
+                esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id,
+                                            ok ? ESP_GATT_OK : ESP_GATT_ILLEGAL_PARAMETER, NULL);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        break;
+    }
+    case ESP_GATTS_READ_EVT: {
+        // 过滤特征、调度报告和运行配置由应用层应答，支持长读（按 offset 续读）
+        if (!param->read.need_rsp) {
+            break;
+        }
+        int idx = log_svc_find_idx(param->read.handle);
+        if (idx != LOG_SVC_IDX_FILTER_VAL && idx != LOG_SVC_IDX_SCHED_VAL && idx != LOG_SVC_IDX_CONFIG_VAL) {
+            break;
+        }
+        esp_gatt_rsp_t rsp;
+        // 只在 BTC 任务中应答，静态分配不占用协议栈任务的栈
+        static uint8_t stats[LOG_SCHED_REPORT_MAX > BLE_FILTER_STATS_MAX ? LOG_SCHED_REPORT_MAX : BLE_FILTER_STATS_MAX];
+        memset(&rsp, 0, sizeof(esp_gatt_rsp_t));
+        size_t len;
+        if (idx == LOG_SVC_IDX_SCHED_VAL) {
+            len = sched_profile_read_report(stats, sizeof(stats));
+        } else if (idx == LOG_SVC_IDX_CONFIG_VAL) {
+            len = app_config_read(stats, sizeof(stats));
+        } else {
+            len = ble_filter_read_stats(stats, sizeof(stats));
+        }
+        if (param->read.offset > len) {
+            esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, ESP_GATT_INVALID_OFFSET, NULL);
+            break;
+        }
+        rsp.attr_value.handle = param->read.handle;
+        rsp.attr_value.offset = param->read.offset;
+        rsp.attr_value.len = len - param->read.offset;
+        memcpy(rsp.attr_value.value, &stats[param->read.offset], rsp.attr_value.len);
+        esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, ESP_GATT_OK, &rsp);
+        break;
+    }
+    case ESP_GATTS_DISCONNECT_EVT:
+        // 连接由 profile A 管理，这里只终止该连接发起的传输；过滤条件在最后一个客户端断开时清除
+        ble_file_abort(param->disconnect.conn_id);
+        ble_query_end_session(param->disconnect.conn_id);
+        break;
+    default:
+        break;
+    }
+}
+
+bool ble_is_connected(void)
+{
+    return ble_client_count > 0;
+}
+
+bool ble_conn_is_connected(uint16_t conn_id)
+{
+    return ble_client_find(conn_id) != NULL;
+}
+
+uint16_t ble_get_notify_payload(uint16_t conn_id)
+{
+    uint16_t payload = BLE_MTU_REQUEST - 3;
+    bool found = false;
+    for (int i = 0; i < CONFIG_BLE_MAX_CLIENTS; i++) {
+        const ble_client_t *c = &ble_clients[i];
+        if (c->used && (conn_id == BLE_CONN_ALL || c->conn_id == conn_id)) {
+            payload = (c->payload < payload) ? c->payload : payload;
+            found = true;
+        }
+    }
+    return found ? payload : 20;
+}
+
+static esp_err_t log_svc_send(const ble_client_t *c, int idx, const uint8_t *data, uint16_t len)
+{
+    return esp_ble_gatts_send_indicate(gl_profile_tab[PROFILE_B_APP_ID].gatts_if, c->conn_id,
+                                       log_svc_handle_table[idx], len, (uint8_t *)data, false);
+}
+
+// 向日志服务的特征发送一条通知，该连接拥塞时阻塞等待，调用方须在任务上下文中调用。
+// BLE_CONN_ALL 发给所有连接，拥塞的连接跳过，至少一个连接发送成功时返回 ESP_OK
+esp_err_t ble_log_svc_notify(uint16_t conn_id, int idx, const uint8_t *data, uint16_t len)
+{
+    if (idx <= LOG_SVC_IDX_SVC || idx >= LOG_SVC_IDX_NB || !ble_is_connected()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len > ble_get_notify_payload(conn_id)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (conn_id == BLE_CONN_ALL) {
+        esp_err_t ret = ESP_ERR_TIMEOUT;
+        for (int i = 0; i < CONFIG_BLE_MAX_CLIENTS; i++) {
+            const ble_client_t *c = &ble_clients[i];
+            if (__atomic_load_n(&c->used, __ATOMIC_ACQUIRE) && !c->congested &&
+                log_svc_send(c, idx, data, len) == ESP_OK) {
+                ret = ESP_OK;
+            }
+        }
+        return ret;
+    }
+
+    int waited_ms = 0;
+    const ble_client_t *c;
+    while ((c = ble_client_find(conn_id)) != NULL && c->congested) {
+        if (waited_ms >= BLE_CONGEST_WAIT_MS) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+        waited_ms += 10;
+    }
+    if (c == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return log_svc_send(c, idx, data, len);
+}
+
 static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
 {
+    // 拥塞状态按连接记录，与 profile 无关，统一在这里处理
+    if (event == ESP_GATTS_CONGEST_EVT) {
+        ble_client_t *c = ble_client_find(param->congest.conn_id);
+        if (c != NULL) {
+            c->congested = param->congest.congested;
+        }
+    }
+
     /* If event is register event, store the gatts_if for each profile */
     if (event == ESP_GATTS_REG_EVT) {
         if (param->reg.status == ESP_GATT_OK) {
@@ -549,78 +1024,105 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
     } while (0);
 }
 
-// BLE发送任务：定时从ringbuffer读取数据并发送到BLE
+// BLE发送任务：轮流为每个打开通知的客户端从它自己的读位置取一包发送。
+// 拥塞的客户端本轮跳过，落后太多时由 log_tail 跳过被覆盖的数据，不影响其他客户端
 static void ble_tx_task(void *pvParameters)
 {
-    uint8_t *ble_data;
-    size_t data_len;
-    size_t bytes_sent;
-    size_t chunk_size;
     while(1)
     {
-        if (uart_ble_ringbuf != NULL && connect_state == CONNECT_STATE_CONNECTED)
+        size_t round_sent = 0;
+        for (int i = 0; i < CONFIG_BLE_MAX_CLIENTS; i++)
         {
-            if (xSemaphoreTake(uart_ble_mutex, portMAX_DELAY) == pdTRUE)
-            {
-                // 读取ringbuffer数据
-                ble_data = (uint8_t *)xRingbufferReceive(uart_ble_ringbuf, &data_len, 0);
-                xSemaphoreGive(uart_ble_mutex);
-                
-                if (ble_data != NULL && data_len > 0)
-                {
-                    bytes_sent = 0;
-                    
-                    ESP_LOGI(GATTS_TAG, "Sending %d bytes to BLE", data_len);
-
-                    // Calculate actual data size per packet (MTU - 3 bytes for overhead)
-                    chunk_size = (negotiated_mtu > 20) ? negotiated_mtu : 20;
-                    
-                    // Send data in chunks
-                    while (bytes_sent < data_len)
-                    {
-                        size_t send_len = (data_len - bytes_sent) > chunk_size ? chunk_size : (data_len - bytes_sent);
-                        
-                        esp_ble_gatts_send_indicate(gl_profile_tab[PROFILE_A_APP_ID].gatts_if,
-                                                  gl_profile_tab[PROFILE_A_APP_ID].conn_id,
-                                                  gl_profile_tab[PROFILE_A_APP_ID].char_handle,
-                                                  send_len, &ble_data[bytes_sent], false);
-                        
-                        bytes_sent += send_len;
-                        vTaskDelay(pdMS_TO_TICKS(20)); // Small delay between packets
-                    }
-                    vRingbufferReturnItem(uart_ble_ringbuf, (void *)ble_data);
-                }
+            ble_client_t *c = &ble_clients[i];
+            if (!__atomic_load_n(&c->used, __ATOMIC_ACQUIRE) || !c->notify || c->congested) {
+                continue;
+            }
+
+            xSemaphoreTake(uart_ble_mutex, portMAX_DELAY);
+            uint16_t conn_id = c->conn_id;
+            uint32_t n = log_tail_read(&uart_ble_tail, i, ble_tx_chunk, c->payload);
+            uint32_t out_off = log_tail_cursor(&uart_ble_tail, i);
+            uint32_t lost = uart_ble_tail.rd[i].lost;
+            log_stats.ble_lag_bytes += lost - c->lost;
+            c->lost = lost;
+            xSemaphoreGive(uart_ble_mutex);
+            if (n == 0) {
+                continue;
             }
+
+            LOG_TRACE(LOG_TRACE_CH_BLE, LOG_TRACE_BLE_TX_BEGIN, n);
+            esp_err_t ret = esp_ble_gatts_send_indicate(gl_profile_tab[PROFILE_A_APP_ID].gatts_if, conn_id,
+                                                        gl_profile_tab[PROFILE_A_APP_ID].char_handle,
+                                                        n, ble_tx_chunk, false);
+            if (ret == ESP_OK) {
+                log_stats.ble_notified_bytes += n;
+            } else {
+                log_stats.ble_notify_errors++;
+            }
+            // 延迟按最先送达的客户端统计，较慢的客户端再次经过同一偏移时不重复计入
+            LOG_LAT_DONE(LOG_LAT_BLE, out_off, (uint32_t)esp_timer_get_time());
+            LOG_TRACE(LOG_TRACE_CH_BLE, LOG_TRACE_BLE_TX_END, n);
+            round_sent += n;
         }
-        // 定时检查，每100ms一次
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // 有数据时每轮间隔 20ms，空闲时每100ms检查一次
+        vTaskDelay(pdMS_TO_TICKS(round_sent > 0 ? 20 : 100));
+    }
+}
+
+// 切换实时流过滤器，返回后旧的过滤器不再被转发路径使用，调用方可以重用
+void ble_stream_set_filter(log_filter_t *filter)
+{
+    if (uart_ble_mutex == NULL) {
+        ble_stream_filter = filter;
+        return;
+    }
+    xSemaphoreTake(uart_ble_mutex, portMAX_DELAY);
+    ble_stream_filter = filter;
+    xSemaphoreGive(uart_ble_mutex);
+}
+
+static size_t ble_stats_snapshot(uint8_t *buf, size_t size)
+{
+    uint8_t flags = 0;
+    if (GetTfCardState() == TF_CARD_STATE_MOUNT) {
+        flags |= LOG_STATS_FLAG_CARD_MOUNTED;
+    }
+    if (ble_is_connected()) {
+        flags |= LOG_STATS_FLAG_BLE_CONNECTED;
     }
+    if (ble_stream_filter != NULL) {
+        flags |= LOG_STATS_FLAG_BLE_FILTER;
+    }
+    log_stats.uptime_ms = esp_log_timestamp();
+    return log_stats_snapshot(&log_stats, flags, buf, size);
 }
 
+// 写入从不等待发送：缓冲区满时覆盖最旧的数据，落后的客户端跳过这部分
 void ble_write_to_buffer(const char *data, size_t len)
 {
-    if (uart_ble_ringbuf != NULL && connect_state == CONNECT_STATE_CONNECTED)
+    if (uart_ble_mutex == NULL || ble_stream_clients == 0)
     {
-        if (xSemaphoreTake(uart_ble_mutex, portMAX_DELAY) == pdTRUE)
-        {
-            // 等待缓冲区有足够空间
-            size_t free_size = xRingbufferGetCurFreeSize(uart_ble_ringbuf);
-            while (free_size < len)
-            {
+        return;
+    }
+    if (xSemaphoreTake(uart_ble_mutex, portMAX_DELAY) == pdTRUE)
+    {
+        log_stats.ble_in_bytes += len;
+        // 过滤在进入缓冲区之前完成，被过滤掉的行不占用BLE带宽
+        if (ble_stream_filter != NULL) {
+            uint32_t dropped = ble_stream_filter->bytes_dropped;
+            len = log_filter_feed(ble_stream_filter, data, len, ble_filter_out, sizeof(ble_filter_out));
+            data = ble_filter_out;
+            log_stats.ble_drop_bytes += ble_stream_filter->bytes_dropped - dropped;
+            if (len == 0) {
                 xSemaphoreGive(uart_ble_mutex);
-                vTaskDelay(pdMS_TO_TICKS(10));
-                free_size = xRingbufferGetCurFreeSize(uart_ble_ringbuf);
-                xSemaphoreTake(uart_ble_mutex, portMAX_DELAY);
+                return;
             }
-            ESP_LOGI(GATTS_TAG, "Writing %d bytes to BLE ringbuffer", len);
-            // 写入ringbuffer
-            xRingbufferSend(uart_ble_ringbuf, data, len, portMAX_DELAY);
-            xSemaphoreGive(uart_ble_mutex);
         }
-    }
-    else
-    {
-        ESP_LOGW(GATTS_TAG, "BLE not connected, cannot write data to BLE ringbuffer");
+        log_tail_write(&uart_ble_tail, data, len);
+        LOG_TRACE(LOG_TRACE_CH_UART, LOG_TRACE_BLE_ENQ, len);
+        LOG_LAT_MARK(LOG_LAT_BLE, log_tail_head(&uart_ble_tail));
+        log_stats_update_hwm(&log_stats.ble_ring_hwm, log_tail_max_lag(&uart_ble_tail));
+        xSemaphoreGive(uart_ble_mutex);
     }
 }
 
@@ -628,14 +1130,12 @@ void ble_gatt_init(void)
 {
     esp_err_t ret;
 
-    // Initialize NVS.
-    ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK( ret );
+    // NVS 已由 app_config_init 初始化，设备名来自运行配置
+    strlcpy(test_device_name, app_config()->device_name, sizeof(test_device_name));
 
+    // 实时流缓冲区和互斥锁在协议栈启动前建立，连接事件中会用到
+    log_tail_init(&uart_ble_tail, uart_ble_ring_storage, sizeof(uart_ble_ring_storage));
+    uart_ble_mutex = xSemaphoreCreateMutexStatic(&uart_ble_mutex_buf);
     #if CONFIG_EXAMPLE_CI_PIPELINE_ID
     memcpy(test_device_name, esp_bluedroid_get_example_name(), ESP_BLE_ADV_NAME_LEN_MAX);
     #endif
@@ -681,22 +1181,30 @@ void ble_gatt_init(void)
         ESP_LOGE(GATTS_TAG, "gatts app register error, error code = %x", ret);
         return;
     }
+    ret = esp_ble_gatts_app_register(PROFILE_B_APP_ID);
+    if (ret){
+        ESP_LOGE(GATTS_TAG, "gatts app register error, error code = %x", ret);
+        return;
+    }
 
     esp_err_t local_mtu_ret = esp_ble_gatt_set_local_mtu(BLE_MTU_REQUEST);
     if (local_mtu_ret){
         ESP_LOGE(GATTS_TAG, "set local  MTU failed, error code = %x", local_mtu_ret);
     }
 
-    // 初始化ringbuffer和互斥锁
-    uart_ble_ringbuf = xRingbufferCreate(UART_BLE_RINGBUF_SIZE, RINGBUF_TYPE_BYTEBUF);
-    uart_ble_mutex = xSemaphoreCreateMutex();
-    if (uart_ble_ringbuf == NULL || uart_ble_mutex == NULL){
-        ESP_LOGE(GATTS_TAG, "Failed to create ringbuffer or mutex");
-    }
-    else{
-        // 创建串口接收任务和BLE发送任务
-        xTaskCreate(ble_tx_task, "ble_tx_task", 2048, NULL, 5, NULL);
-    }
+    log_stats.ble_ring_size = UART_BLE_RINGBUF_SIZE;
+    log_mem_add_static(LOG_MEM_BLE, sizeof(uart_ble_ring_storage) + sizeof(uart_ble_tail) + sizeof(uart_ble_mutex_buf) +
+                                    sizeof(ble_clients) + sizeof(ble_tx_chunk) + sizeof(ble_filter_out) +
+                                    sizeof(prepare_buf_storage) + sizeof(prepare_write_rsp));
+    // 创建BLE发送任务
+    xTaskCreate(ble_tx_task, "ble_tx_task", TASK_STACK_BLE_TX, NULL, TASK_PRIO_BLE_TX, NULL);
+
+    // 文件传输与日志检索服务
+    ble_filter_init();
+    ble_file_init();
+    ble_query_init();
+    ble_trace_init();
+    ble_alert_init();
 
     
     return;
@@ -1,11 +1,59 @@
 #ifndef __BLE_GATT_H__
 #define __BLE_GATT_H__
 
+#include <stdbool.h>
+#include "esp_err.h"
 #include "freertos/ringbuf.h"
 #include "freertos/semphr.h"
+#include "log_filter.h"
 
+// 日志服务（0x00EE）属性表索引
+enum {
+    LOG_SVC_IDX_SVC,
+
+    LOG_SVC_IDX_FILE_CTRL_CHAR,
+    LOG_SVC_IDX_FILE_CTRL_VAL,
+
+    LOG_SVC_IDX_FILE_DATA_CHAR,
+    LOG_SVC_IDX_FILE_DATA_VAL,
+    LOG_SVC_IDX_FILE_DATA_CFG,
+
+    LOG_SVC_IDX_QUERY_CHAR,
+    LOG_SVC_IDX_QUERY_VAL,
+    LOG_SVC_IDX_QUERY_CFG,
+
+    LOG_SVC_IDX_FILTER_CHAR,
+    LOG_SVC_IDX_FILTER_VAL,
+
+    LOG_SVC_IDX_TRACE_CHAR,
+    LOG_SVC_IDX_TRACE_VAL,
+    LOG_SVC_IDX_TRACE_CFG,
+
+    LOG_SVC_IDX_ALERT_CHAR,
+    LOG_SVC_IDX_ALERT_VAL,
+    LOG_SVC_IDX_ALERT_CFG,
+
+    LOG_SVC_IDX_SCHED_CHAR,
+    LOG_SVC_IDX_SCHED_VAL,
+
+    LOG_SVC_IDX_CONFIG_CHAR,
+    LOG_SVC_IDX_CONFIG_VAL,
+
+    LOG_SVC_IDX_NB,
+};
 
 void ble_gatt_init(void);
 void ble_write_to_buffer(const char *data, size_t len);
+void ble_stream_set_filter(log_filter_t *filter);
+
+// 同时连接多个客户端（CONFIG_BLE_MAX_CLIENTS），日志服务的通知按连接发送，BLE_CONN_ALL 表示所有连接
+#define BLE_CONN_ALL 0xFFFF
+
+// 任一客户端已连接
+bool ble_is_connected(void);
+bool ble_conn_is_connected(uint16_t conn_id);
+// 单条通知的有效载荷，按该连接的 MTU；BLE_CONN_ALL 时取所有连接中最小的
+uint16_t ble_get_notify_payload(uint16_t conn_id);
+esp_err_t ble_log_svc_notify(uint16_t conn_id, int idx, const uint8_t *data, uint16_t len);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "ble_gatt.h"
+#include "ble_query.h"
+#include "tfcard/bsp_tfcard.h"
+#include "log_match.h"
+#include "log_search.h"
+#include "log_mem.h"
+#include "sched_profile.h"
+
+static const char *TAG = "BLE_QUERY";
+
+#define QUERY_BLOCK_SIZE 4096
+#define QUERY_REQ_MAX 128
+#define QUERY_NAME_MAX 64
+#define QUERY_HDR_LEN 3          // [type][seq u16]
+#define QUERY_MATCH_HDR_LEN 8    // [offset u32][ts u32]
+
+typedef struct {
+    uint16_t conn_id;
+    uint8_t len;
+    uint8_t data[QUERY_REQ_MAX];
+} query_req_t;
+
+static QueueHandle_t query_req_queue = NULL;
+static volatile bool query_abort_flag = false;
+static volatile bool query_session_end = false;
+static volatile uint16_t query_conn = BLE_CONN_ALL; // 正在运行的查询来自的连接
+static uint16_t query_seq = 0;
+
+// 检索状态都比较大，放在静态区，同一时间只运行一个查询
+static uint8_t query_block[QUERY_BLOCK_SIZE];
+static uint8_t query_pkt[QUERY_HDR_LEN + 256];
+static log_match_t query_match;
+static log_search_t query_search;
+
+// 会话索引：同一连接内对同一文件的重复查询可以按时间跳过分块，断开连接后失效
+static log_index_t session_index;
+static char session_path[sizeof(TF_CARD_MOUNT_POINT) + QUERY_NAME_MAX + 1];
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static esp_err_t query_send_pkt(uint8_t type, const uint8_t *payload, size_t len)
+{
+    size_t max = ble_get_notify_payload(query_conn) - QUERY_HDR_LEN;
+    if (max > sizeof(query_pkt) - QUERY_HDR_LEN) {
+        max = sizeof(query_pkt) - QUERY_HDR_LEN;
+    }
+    if (len > max) {
+        len = max; // 超长的命中行截断，客户端可按 offset 通过文件服务取全
+    }
+    query_pkt[0] = type;
+    put_u16(&query_pkt[1], query_seq++);
+    memcpy(&query_pkt[QUERY_HDR_LEN], payload, len);
+    return ble_log_svc_notify(query_conn, LOG_SVC_IDX_QUERY_VAL, query_pkt, QUERY_HDR_LEN + len);
+}
+
+static void query_send_end(uint8_t status, uint32_t matched, uint32_t scanned, uint32_t skipped)
+{
+    uint8_t end[13];
+    end[0] = status;
+    put_u32(&end[1], matched);
+    put_u32(&end[5], scanned);
+    put_u32(&end[9], skipped);
+    query_send_pkt(BLE_QUERY_PKT_END, end, sizeof(end));
+}
+
+static bool query_match_cb(void *ctx, uint32_t offset, uint32_t ts, const char *line, size_t len)
+{
+    static uint8_t body[QUERY_MATCH_HDR_LEN + 256];
+    if (len > sizeof(body) - QUERY_MATCH_HDR_LEN) {
+        len = sizeof(body) - QUERY_MATCH_HDR_LEN;
+    }
+    put_u32(&body[0], offset);
+    put_u32(&body[4], ts);
+    memcpy(&body[QUERY_MATCH_HDR_LEN], line, len);
+    if (query_send_pkt(BLE_QUERY_PKT_MATCH, body, QUERY_MATCH_HDR_LEN + len) != ESP_OK) {
+        return false;
+    }
+    return !query_abort_flag;
+}
+
+// 解析查询条件并编译匹配器，返回目标文件路径，失败返回 false
+static bool query_parse(const query_req_t *req, char *path, size_t path_size, uint32_t *t_start, uint32_t *t_end)
+{
+    const uint8_t *p = req->data;
+    size_t len = req->len;
+
+    if (len < 11) {
+        return false;
+    }
+    uint8_t flags = p[1];
+    *t_start = get_u32(&p[2]);
+    *t_end = get_u32(&p[6]);
+    size_t name_len = p[10];
+    size_t pos = 11;
+    if (pos + name_len + 1 > len || name_len >= QUERY_NAME_MAX) {
+        return false;
+    }
+
+    if (name_len == 0) {
+        snprintf(path, path_size, "%s", tfcard_get_log_path());
+    } else {
+        char name[QUERY_NAME_MAX];
+        memcpy(name, &p[pos], name_len);
+        name[name_len] = '\0';
+        if (strchr(name, '/') != NULL || strcmp(name, "..") == 0) {
+            return false;
+        }
+        snprintf(path, path_size, "%s/%s", TF_CARD_MOUNT_POINT, name);
+    }
+    pos += name_len;
+
+    int npat = p[pos++];
+    log_match_init(&query_match, (flags & BLE_QUERY_FLAG_NOCASE) ? LOG_MATCH_FLAG_NOCASE : 0);
+    for (int i = 0; i < npat; i++) {
+        if (pos >= len || pos + 1 + p[pos] > len) {
+            return false;
+        }
+        size_t plen = p[pos++];
+        if (log_match_add(&query_match, (const char *)&p[pos], plen) < 0) {
+            ESP_LOGW(TAG, "Pattern %d rejected (too long or too many patterns)", i);
+            return false;
+        }
+        pos += plen;
+    }
+    log_match_compile(&query_match);
+    return true;
+}
+
+static void query_run(const query_req_t *req)
+{
+    char path[sizeof(session_path)];
+    uint32_t t_start, t_end;
+    struct stat st;
+
+    if (!query_parse(req, path, sizeof(path), &t_start, &t_end)) {
+        query_send_end(BLE_QUERY_STATUS_BAD_REQUEST, 0, 0, 0);
+        return;
+    }
+    if (stat(path, &st) != 0) {
+        query_send_end(BLE_QUERY_STATUS_NOT_FOUND, 0, 0, 0);
+        return;
+    }
+
+    if (query_session_end || strcmp(path, session_path) != 0) {
+        log_index_reset(&session_index);
+        strcpy(session_path, path);
+        query_session_end = false;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        query_send_end(BLE_QUERY_STATUS_IO_ERROR, 0, 0, 0);
+        return;
+    }
+
+    // 只扫描查询开始时已经写入的部分
+    uint32_t end = (uint32_t)st.st_size;
+    uint32_t off = 0;
+    uint32_t block_pos = UINT32_MAX;
+    size_t block_len = 0;
+    uint8_t status = BLE_QUERY_STATUS_OK;
+    uint32_t t0 = esp_log_timestamp();
+
+    log_search_init(&query_search, &query_match, t_start, t_end, &session_index, query_match_cb, NULL);
+    while (off < end && !query_search.stop) {
+        if (query_abort_flag || !ble_conn_is_connected(query_conn)) {
+            status = BLE_QUERY_STATUS_ABORTED;
+            break;
+        }
+        // 按 4 KB 对齐整块读取，跳块后从对齐位置重新读
+        uint32_t want = off & ~(QUERY_BLOCK_SIZE - 1);
+        if (want != block_pos) {
+            if ((uint32_t)lseek(fd, want, SEEK_SET) != want) {
+                status = BLE_QUERY_STATUS_IO_ERROR;
+                break;
+            }
+            ssize_t got = read(fd, query_block, QUERY_BLOCK_SIZE);
+            if (got <= 0) {
+                status = BLE_QUERY_STATUS_IO_ERROR;
+                break;
+            }
+            block_pos = want;
+            block_len = got;
+        }
+        uint32_t blk_end = block_pos + block_len;
+        if (blk_end > end) {
+            blk_end = end;
+        }
+        if (blk_end <= off) {
+            // 文件比查询开始时短，说明被截断或卡出错
+            status = BLE_QUERY_STATUS_IO_ERROR;
+            break;
+        }
+        off = log_search_feed(&query_search, off, &query_block[off - block_pos], blk_end - off);
+    }
+    if (status == BLE_QUERY_STATUS_OK && !query_search.stop) {
+        log_search_finish(&query_search);
+    }
+    if (query_search.stop && status == BLE_QUERY_STATUS_OK) {
+        status = BLE_QUERY_STATUS_ABORTED;
+    }
+    close(fd);
+
+    ESP_LOGI(TAG, "Query %s: %" PRIu32 " lines, scanned %" PRIu32 ", skipped %" PRIu32 " bytes in %" PRIu32 " ms",
+             path, query_search.lines_matched, query_search.bytes_scanned, query_search.bytes_skipped,
+             esp_log_timestamp() - t0);
+    query_send_end(status, query_search.lines_matched, query_search.bytes_scanned, query_search.bytes_skipped);
+}
+
+static void ble_query_task(void *pvParameters)
+{
+    static query_req_t req;
+    while (1) {
+        if (xQueueReceive(query_req_queue, &req, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        query_abort_flag = false;
+        query_conn = req.conn_id;
+        query_seq = 0;
+        if (GetTfCardState() != TF_CARD_STATE_MOUNT) {
+            query_send_end(BLE_QUERY_STATUS_IO_ERROR, 0, 0, 0);
+            continue;
+        }
+        query_run(&req);
+    }
+}
+
+// 在 BLE 回调上下文中调用，只复制请求，解析和扫描在 ble_query_task 中完成
+void ble_query_handle_write(uint16_t conn_id, const uint8_t *data, size_t len)
+{
+    if (len < 1 || query_req_queue == NULL) {
+        return;
+    }
+    if (data[0] == BLE_QUERY_CMD_ABORT) {
+        if (query_conn == conn_id) {
+            query_abort_flag = true;
+        }
+        return;
+    }
+    if (data[0] != BLE_QUERY_CMD_QUERY || len > QUERY_REQ_MAX) {
+        ESP_LOGW(TAG, "Invalid query command 0x%02x, len %d", data[0], len);
+        return;
+    }
+
+    query_req_t req;
+    req.conn_id = conn_id;
+    req.len = len;
+    memcpy(req.data, data, len);
+    if (xQueueSend(query_req_queue, &req, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Query busy, request dropped");
+    }
+}
+
+void ble_query_end_session(uint16_t conn_id)
+{
+    if (query_conn == conn_id) {
+        query_abort_flag = true;
+        query_session_end = true;
+    }
+}
+
+void ble_query_init(void)
+{
+    query_req_queue = xQueueCreate(1, sizeof(query_req_t));
+    if (query_req_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create query queue");
+        return;
+    }
+    log_mem_add_static(LOG_MEM_BLE, sizeof(query_block) + sizeof(query_pkt) + sizeof(session_path));
+    xTaskCreate(ble_query_task, "ble_query_task", TASK_STACK_BLE_QUERY, NULL, TASK_PRIO_BLE_QUERY, NULL);
+}
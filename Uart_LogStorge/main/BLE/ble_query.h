@@ -0,0 +1,32 @@
+#ifndef __BLE_QUERY_H__
+#define __BLE_QUERY_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 检索特征（0xEE03）写入的命令
+// QUERY: [cmd][flags u8][t_start u32][t_end u32][name_len u8][name...][n u8]{[len u8][pattern...]}
+//        name 为空表示当前日志文件，t_end 为 0xFFFFFFFF 表示不限，模式以 '^' 开头表示只匹配行首
+#define BLE_QUERY_CMD_QUERY 0x01
+#define BLE_QUERY_CMD_ABORT 0x02
+
+#define BLE_QUERY_FLAG_NOCASE 0x01
+
+// 检索特征通知帧，多字节字段均为小端
+#define BLE_QUERY_PKT_MATCH 0x91 // [type][seq u16][offset u32][ts u32][line...]
+#define BLE_QUERY_PKT_END   0x92 // [type][seq u16][status u8][matched u32][scanned u32][skipped u32]
+
+// 结束帧状态码与文件服务一致
+#define BLE_QUERY_STATUS_OK          0
+#define BLE_QUERY_STATUS_NOT_FOUND   1
+#define BLE_QUERY_STATUS_BAD_REQUEST 2
+#define BLE_QUERY_STATUS_ABORTED     3
+#define BLE_QUERY_STATUS_IO_ERROR    4
+
+void ble_query_init(void);
+// 命中行发给发出查询的连接 conn_id
+void ble_query_handle_write(uint16_t conn_id, const uint8_t *data, size_t len);
+// conn_id 断开：终止它发起的查询并丢弃会话索引
+void ble_query_end_session(uint16_t conn_id);
+
+#endif
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "ble_gatt.h"
+#include "ble_trace.h"
+#include "log_trace.h"
+#include "log_mem.h"
+#include "sched_profile.h"
+
+static const char *TAG = "BLE_TRACE";
+
+#define TRACE_HDR_LEN 3 // [type][seq u16]
+#define TRACE_EVT_LEN 8
+
+typedef struct {
+    uint16_t conn_id;
+    uint8_t cmd;
+} trace_cmd_t;
+
+static QueueHandle_t trace_cmd_queue = NULL;
+static uint16_t trace_conn = BLE_CONN_ALL; // 正在导出的命令来自的连接
+static uint16_t trace_seq = 0;
+
+static uint8_t trace_pkt[TRACE_HDR_LEN + 256];
+static log_trace_event_t trace_events[LOG_TRACE_EVENTS];
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static size_t trace_pkt_payload(void)
+{
+    size_t payload = ble_get_notify_payload(trace_conn) - TRACE_HDR_LEN;
+    return (payload < sizeof(trace_pkt) - TRACE_HDR_LEN) ? payload : sizeof(trace_pkt) - TRACE_HDR_LEN;
+}
+
+// 负载已写在 trace_pkt[TRACE_HDR_LEN] 之后
+static esp_err_t trace_send_pkt(uint8_t type, size_t len)
+{
+    trace_pkt[0] = type;
+    put_u16(&trace_pkt[1], trace_seq++);
+    return ble_log_svc_notify(trace_conn, LOG_SVC_IDX_TRACE_VAL, trace_pkt, TRACE_HDR_LEN + len);
+}
+
+static esp_err_t trace_dump_ble(void)
+{
+    uint8_t *body = &trace_pkt[TRACE_HDR_LEN];
+    size_t payload = trace_pkt_payload();
+    esp_err_t ret;
+
+    put_u16(&body[0], esp_rom_get_cpu_ticks_per_us());
+    body[2] = LOG_TRACE_CH_NUM;
+    body[3] = LOG_LAT_NUM;
+    body[4] = LOG_HIST_BINS;
+    body[5] = LOG_HIST_BASE_SHIFT;
+    ret = trace_send_pkt(BLE_TRACE_PKT_HDR, 6);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    size_t per_pkt = (payload - 6) / TRACE_EVT_LEN;
+    for (int ch = 0; ch < LOG_TRACE_CH_NUM; ch++) {
+        uint32_t first_seq;
+        size_t n = log_trace_copy(&log_trace_bufs[ch], trace_events, LOG_TRACE_EVENTS, &first_seq);
+        for (size_t i = 0; i < n; i += per_pkt) {
+            size_t cnt = (n - i < per_pkt) ? n - i : per_pkt;
+            body[0] = ch;
+            put_u32(&body[1], first_seq + i);
+            body[5] = cnt;
+            for (size_t k = 0; k < cnt; k++) {
+                uint8_t *e = &body[6 + k * TRACE_EVT_LEN];
+                put_u32(&e[0], trace_events[i + k].t);
+                put_u16(&e[4], trace_events[i + k].id);
+                put_u16(&e[6], trace_events[i + k].arg);
+            }
+            ret = trace_send_pkt(BLE_TRACE_PKT_EVT, 6 + cnt * TRACE_EVT_LEN);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+
+    size_t bins_per_pkt = (payload - 7) / 4;
+    for (int lat = 0; lat < LOG_LAT_NUM; lat++) {
+        for (int b = 0; b < LOG_HIST_BINS; b += bins_per_pkt) {
+            size_t cnt = (LOG_HIST_BINS - b < bins_per_pkt) ? LOG_HIST_BINS - b : bins_per_pkt;
+            body[0] = lat;
+            put_u32(&body[1], log_lat[lat].overflow);
+            body[5] = b;
+            body[6] = cnt;
+            for (size_t k = 0; k < cnt; k++) {
+                put_u32(&body[7 + k * 4], log_lat[lat].hist[b + k]);
+            }
+            ret = trace_send_pkt(BLE_TRACE_PKT_HIST, 7 + cnt * 4);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+// 串口导出：每行一条记录，主机脚本从串口日志中按 "TRACE " 前缀提取
+static void trace_dump_serial(void)
+{
+    ESP_LOGI(TAG, "TRACE hdr %" PRIu32 " %d %d %d %d", esp_rom_get_cpu_ticks_per_us(),
+             LOG_TRACE_CH_NUM, LOG_LAT_NUM, LOG_HIST_BINS, LOG_HIST_BASE_SHIFT);
+    for (int ch = 0; ch < LOG_TRACE_CH_NUM; ch++) {
+        uint32_t first_seq;
+        size_t n = log_trace_copy(&log_trace_bufs[ch], trace_events, LOG_TRACE_EVENTS, &first_seq);
+        for (size_t i = 0; i < n; i++) {
+            ESP_LOGI(TAG, "TRACE ev %d %" PRIu32 " %" PRIu32 " %u %u", ch, first_seq + i,
+                     trace_events[i].t, trace_events[i].id, trace_events[i].arg);
+        }
+    }
+    for (int lat = 0; lat < LOG_LAT_NUM; lat++) {
+        char line[LOG_HIST_BINS * 11 + 1];
+        int pos = 0;
+        for (int b = 0; b < LOG_HIST_BINS; b++) {
+            pos += snprintf(line + pos, sizeof(line) - pos, " %" PRIu32, log_lat[lat].hist[b]);
+        }
+        ESP_LOGI(TAG, "TRACE lat %d %" PRIu32 "%s", lat, log_lat[lat].overflow, line);
+    }
+    ESP_LOGI(TAG, "TRACE end");
+}
+
+static void ble_trace_task(void *pvParameters)
+{
+    trace_cmd_t cmd;
+    while (1) {
+        if (xQueueReceive(trace_cmd_queue, &cmd, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        trace_conn = cmd.conn_id;
+        switch (cmd.cmd) {
+        case BLE_TRACE_CMD_DUMP: {
+            trace_seq = 0;
+            esp_err_t ret = trace_dump_ble();
+            uint8_t *body = &trace_pkt[TRACE_HDR_LEN];
+            body[0] = (ret == ESP_OK) ? 0 : 1;
+            trace_send_pkt(BLE_TRACE_PKT_END, 1);
+            break;
+        }
+        case BLE_TRACE_CMD_DUMP_SERIAL:
+            trace_dump_serial();
+            break;
+        case BLE_TRACE_CMD_RESET:
+            log_trace_reset();
+            ESP_LOGI(TAG, "Latency histograms cleared");
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// 在 BLE 回调上下文中调用，导出在 ble_trace_task 中完成
+void ble_trace_handle_write(uint16_t conn_id, const uint8_t *data, size_t len)
+{
+    trace_cmd_t cmd = {.conn_id = conn_id};
+
+    if (len < 1 || trace_cmd_queue == NULL) {
+        return;
+    }
+    if (data[0] < BLE_TRACE_CMD_DUMP || data[0] > BLE_TRACE_CMD_RESET) {
+        ESP_LOGW(TAG, "Invalid trace command 0x%02x", data[0]);
+        return;
+    }
+    cmd.cmd = data[0];
+    if (xQueueSend(trace_cmd_queue, &cmd, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Trace busy, command dropped");
+    }
+}
+
+void ble_trace_init(void)
+{
+    trace_cmd_queue = xQueueCreate(2, sizeof(trace_cmd_t));
+    if (trace_cmd_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create trace command queue");
+        return;
+    }
+    log_mem_add_static(LOG_MEM_BLE, sizeof(trace_pkt) + sizeof(trace_events));
+    xTaskCreate(ble_trace_task, "ble_trace_task", TASK_STACK_BLE_TRACE, NULL, TASK_PRIO_BLE_TRACE, NULL);
+}
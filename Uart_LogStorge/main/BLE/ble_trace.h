@@ -0,0 +1,22 @@
+#ifndef __BLE_TRACE_H__
+#define __BLE_TRACE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 跟踪特征（0xEE05）写入的命令
+#define BLE_TRACE_CMD_DUMP        0x01 // 通过本特征的通知导出
+#define BLE_TRACE_CMD_DUMP_SERIAL 0x02 // 输出到串口日志，每行以 "TRACE " 开头
+#define BLE_TRACE_CMD_RESET       0x03 // 清空延迟直方图
+
+// 跟踪特征通知帧，多字节字段均为小端
+#define BLE_TRACE_PKT_HDR  0xA1 // [type][seq u16][cycles_per_us u16][n_ch u8][n_lat u8][bins u8][base_shift u8]
+#define BLE_TRACE_PKT_EVT  0xA2 // [type][seq u16][ch u8][first_seq u32][n u8]{[t u32][id u16][arg u16]}
+#define BLE_TRACE_PKT_HIST 0xA3 // [type][seq u16][lat u8][overflow u32][first_bin u8][n u8]{[count u32]}
+#define BLE_TRACE_PKT_END  0xA4 // [type][seq u16][status u8]
+
+void ble_trace_init(void);
+// 导出结果发给发出命令的连接 conn_id
+void ble_trace_handle_write(uint16_t conn_id, const uint8_t *data, size_t len);
+
+#endif
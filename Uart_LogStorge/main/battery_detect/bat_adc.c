@@ -17,7 +17,11 @@
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
 #include "bat_adc.h"
+#include "log_stats.h"
 #include "sleep_wakeup/sleep_wakeup.h"
+#include "tfcard/bsp_tfcard.h"
+#include "ws2812/ws2812.h"
+#include "sched_profile.h"
 
 const static char *TAG = "BAT-ADC";
 
@@ -25,8 +29,15 @@ const static char *TAG = "BAT-ADC";
 #define BAT_ADC1_CHAN3 ADC_CHANNEL_3
 #define BAT_ADC_ATTEN ADC_ATTEN_DB_12
 
-static int adc_raw[1][10];
-static int voltage[1][10];
+#define BAT_SAMPLES          8    // 每个周期连续采样次数，取平均后再换算电压
+#define BAT_PERIOD_MS        1000
+#define BAT_PERIOD_LOW_MS    250  // 低电量时加快检测，尽早发现跌破临界值
+#define BAT_STOP_TIMEOUT_MS  3000 // 等待 TF 卡写完并关闭文件的最长时间
+
+static adc_oneshot_unit_handle_t adc1_handle = NULL;
+static adc_cali_handle_t adc1_cali_chan0_handle = NULL;
+static bool do_calibration1_chan0 = false;
+static log_battery_t bat;
 
 // ADC Calibration
 
@@ -69,14 +80,82 @@ static bool battery_adc_calibration_init(adc_unit_t unit, adc_channel_t channel,
     return calibrated;
 }
 
+// 一次检测：BAT_SAMPLES 次原始值取平均后校准，分压电阻为 1:1，返回电池电压 mV，失败返回 0
+static int bat_read_mv(void)
+{
+    int raw_sum = 0;
+    for (int i = 0; i < BAT_SAMPLES; i++) {
+        int raw;
+        // 采样失败只跳过本周期，不影响采集任务
+        if (adc_oneshot_read(adc1_handle, BAT_ADC1_CHAN3, &raw) != ESP_OK) {
+            ESP_LOGW(TAG, "ADC read failed");
+            return 0;
+        }
+        raw_sum += raw;
+    }
+    int raw = raw_sum / BAT_SAMPLES;
+    int mv = 0;
+    if (!do_calibration1_chan0 || adc_cali_raw_to_voltage(adc1_cali_chan0_handle, raw, &mv) != ESP_OK) {
+        return 0;
+    }
+    return mv * 2;
+}
+
+static void bat_on_level_change(log_battery_level_t from, log_battery_level_t to)
+{
+    if (to == LOG_BATTERY_CRITICAL) {
+        // 临界电量：停止接收新数据，写完缓冲区并关闭日志文件，然后进入浅睡眠等待充电
+        ESP_LOGE(TAG, "BAT critical (%u mV), flushing logs", bat.avg_mv);
+        esp_err_t ret = tfcard_emergency_stop(BAT_STOP_TIMEOUT_MS);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Emergency flush failed (%s)", esp_err_to_name(ret));
+        }
+        led_set_state(LOG_LED_LOW_BAT, true);
+        if (Get_sleep_state() == SLEEP_STATE_OFF) {
+            sleep_wakeup_init();
+        }
+    } else if (to == LOG_BATTERY_LOW) {
+        ESP_LOGW(TAG, "BAT low (%u mV)", bat.avg_mv);
+        led_set_state(LOG_LED_LOW_BAT, true);
+    } else {
+        ESP_LOGI(TAG, "BAT ok (%u mV)", bat.avg_mv);
+        led_set_state(LOG_LED_LOW_BAT, false);
+    }
+    if (from == LOG_BATTERY_CRITICAL) {
+        tfcard_resume();
+    }
+}
+
 void BAT_detect_Task(void *pvParameter)
+{
+    log_battery_level_t level = bat.level;
+
+    while (1)
+    {
+        int mv = bat_read_mv();
+        if (mv > 0) {
+            log_battery_level_t next = log_battery_update(&bat, mv);
+            log_stats.battery_mv = bat.avg_mv;
+            if (next != level) {
+                bat_on_level_change(level, next);
+                level = next;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(level == LOG_BATTERY_OK ? BAT_PERIOD_MS : BAT_PERIOD_LOW_MS));
+    }
+}
+
+// 同步完成 ADC 初始化和第一次检测，返回后即可用 BAT_adc_get_voltage / BAT_adc_get_level
+void BAT_adc_init(void)
 {
     //-------------ADC1 Init---------------//
-    adc_oneshot_unit_handle_t adc1_handle;
     adc_oneshot_unit_init_cfg_t init_config1 = {
         .unit_id = ADC_UNIT_1,
     };
-    ESP_ERROR_CHECK(adc_oneshot_new_unit(&init_config1, &adc1_handle));
+    if (adc_oneshot_new_unit(&init_config1, &adc1_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init ADC1, battery monitor disabled");
+        return;
+    }
 
     //-------------ADC1 Config---------------//
     adc_oneshot_chan_cfg_t config = {
@@ -85,37 +164,27 @@ void BAT_detect_Task(void *pvParameter)
     };
     ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, BAT_ADC1_CHAN3, &config));
     // ADC1 Calibration Init
-    adc_cali_handle_t adc1_cali_chan0_handle = NULL;
-    bool do_calibration1_chan0 = battery_adc_calibration_init(ADC_UNIT_1, BAT_ADC1_CHAN3, BAT_ADC_ATTEN, &adc1_cali_chan0_handle);
+    do_calibration1_chan0 = battery_adc_calibration_init(ADC_UNIT_1, BAT_ADC1_CHAN3, BAT_ADC_ATTEN, &adc1_cali_chan0_handle);
 
-    while (1)
-    {
-        ESP_ERROR_CHECK(adc_oneshot_read(adc1_handle, BAT_ADC1_CHAN3, &adc_raw[0][0]));
-        // ESP_LOGI(TAG, "ADC%d Channel[%d] Raw Data: %d", ADC_UNIT_1 + 1, BAT_ADC1_CHAN3, adc_raw[0][0]);
-        if(do_calibration1_chan0)
-        {
-            ESP_ERROR_CHECK(adc_cali_raw_to_voltage(adc1_cali_chan0_handle, adc_raw[0][0], &voltage[0][0]));
-            // ESP_LOGI(TAG, "ADC%d Channel[%d] Cali Voltage: %d mV", ADC_UNIT_1 + 1, BAT_ADC1_CHAN3, voltage[0][0]);
-        }
-        // ESP_LOGI(TAG, "BAT_ADC: %d mV", voltage[0][0] * 2);
-        float bat_voltage = voltage[0][0] * 2 / 1000;
-        if(bat_voltage < BAT_VOLTAGE_LOW)
-        {
-            ESP_LOGE(TAG,"BAT voltage low,enter light sleep!!!!!!!! ");
-            sleep_wakeup_init();
-        }
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    log_battery_init(&bat, CONFIG_BAT_LOW_MV, CONFIG_BAT_CRITICAL_MV, CONFIG_BAT_HYSTERESIS_MV);
+    int mv = bat_read_mv();
+    if (mv > 0) {
+        log_battery_update(&bat, mv);
+        log_stats.battery_mv = bat.avg_mv;
     }
-}
 
-void BAT_adc_init(void)
-{
-    xTaskCreate(BAT_detect_Task, "BAT_detect_task", 2048, NULL, 10, NULL);
+    // 优先级低于 uart_task / tfcard_task，只在检测周期内短暂占用 CPU
+    xTaskCreate(BAT_detect_Task, "BAT_detect_task", TASK_STACK_BATTERY, NULL, TASK_PRIO_BATTERY, NULL);
 }
 
 float BAT_adc_get_voltage(void)
 {
-    float bat_voltage = voltage[0][0] * 2 / 1000;
+    float bat_voltage = bat.avg_mv / 1000.0f;
     ESP_LOGI(TAG, "BAT_ADC: %.2f V", bat_voltage);
     return bat_voltage;
-}
\ No newline at end of file
+}
+
+log_battery_level_t BAT_adc_get_level(void)
+{
+    return bat.level;
+}
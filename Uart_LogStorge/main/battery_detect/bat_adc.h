@@ -1,5 +1,8 @@
+#include "sdkconfig.h"
 #include "esp_adc/adc_oneshot.h"
-#define BAT_VOLTAGE_LOW 0.5f
+#include "log_battery.h"
+#define BAT_VOLTAGE_LOW (CONFIG_BAT_LOW_MV / 1000.0f)
 void BAT_detect_Task(void *pvParameter);
 void BAT_adc_init(void);
-float BAT_adc_get_voltage(void);
\ No newline at end of file
+float BAT_adc_get_voltage(void);
+log_battery_level_t BAT_adc_get_level(void);
@@ -0,0 +1,211 @@
+#include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+#include "app_config.h"
+#include "log_config.h"
+#include "sched_profile.h"
+#include "tfcard/bsp_tfcard.h"
+
+static const char *TAG = "CONFIG";
+
+#define APP_CONFIG_NVS_NAMESPACE "logcfg"
+#define APP_CONFIG_REBOOT_FLUSH_MS 3000
+
+// C3 上可以用作 UART 的引脚：GPIO4~7 接 TF 卡，GPIO10 接 LED，GPIO11~17 为 Flash，
+// GPIO18/19 为 USB D-/D+，GPIO20/21 为 UART0 控制台；GPIO3 在打开电池检测时用作 ADC1 通道 3（bat_adc.c）
+#ifdef CONFIG_BAT_MONITOR_ENABLE
+#define APP_UART_PIN_MASK ((1u << 0) | (1u << 1) | (1u << 2) | (1u << 8) | (1u << 9))
+#else
+#define APP_UART_PIN_MASK ((1u << 0) | (1u << 1) | (1u << 2) | (1u << 3) | (1u << 8) | (1u << 9))
+#endif
+
+#define CFG_U32(k, n, fl, field, lo, hi, mask, d) \
+    {k, n, LOG_CONFIG_TYPE_U32, fl, offsetof(app_config_t, field), sizeof(uint32_t), lo, hi, mask, d, NULL}
+
+static const log_config_desc_t config_desc[] = {
+    CFG_U32(APP_CONFIG_KEY_BAUD, "baud", LOG_CONFIG_FLAG_LIVE, baud, 1200, 2000000, 0, 115200),
+    CFG_U32(APP_CONFIG_KEY_FLUSH_MS, "flush_ms", LOG_CONFIG_FLAG_LIVE, flush_ms, 10, 10000, 0, 500),
+    CFG_U32(APP_CONFIG_KEY_READ_MS, "read_ms", LOG_CONFIG_FLAG_LIVE, read_target_ms, 5, 100, 0,
+            CONFIG_UART_READ_TARGET_MS),
+    CFG_U32(APP_CONFIG_KEY_UART_RX_PIN, "rx_pin", 0, uart_rx_pin, 0, 9, APP_UART_PIN_MASK, 0),
+    CFG_U32(APP_CONFIG_KEY_UART_TX_PIN, "tx_pin", 0, uart_tx_pin, 0, 9, APP_UART_PIN_MASK, 1),
+    {APP_CONFIG_KEY_DEVICE_NAME, "dev_name", LOG_CONFIG_TYPE_STR, 0, offsetof(app_config_t, device_name),
+     sizeof(((app_config_t *)0)->device_name), 1, APP_CONFIG_NAME_MAX, 0, 0, "ESP32C3_UARTLOGGER"},
+};
+#define APP_CONFIG_DESC_NUM ((int)(sizeof(config_desc) / sizeof(config_desc[0])))
+
+// 两份快照轮流发布；修改只来自 BTC 任务，读者每轮循环只读取几个 32 位字段
+static app_config_t config_snap[2];
+static const app_config_t *config_cur = &config_snap[0];
+// NVS 中保存的值，只由 BTC 任务访问
+static app_config_t config_stored;
+
+const app_config_t *app_config(void)
+{
+    return __atomic_load_n(&config_cur, __ATOMIC_ACQUIRE);
+}
+
+static void config_load(nvs_handle_t nvs, app_config_t *cfg)
+{
+    for (int i = 0; i < APP_CONFIG_DESC_NUM; i++) {
+        const log_config_desc_t *e = &config_desc[i];
+        esp_err_t ret;
+        if (e->type == LOG_CONFIG_TYPE_U32) {
+            uint32_t v;
+            ret = nvs_get_u32(nvs, e->name, &v);
+            if (ret == ESP_OK && !log_config_check_u32(e, v)) {
+                ESP_LOGW(TAG, "%s = %" PRIu32 " out of range, using default", e->name, v);
+                continue;
+            }
+            if (ret == ESP_OK) {
+                *(uint32_t *)((uint8_t *)cfg + e->offset) = v;
+            }
+        } else {
+            char str[APP_CONFIG_NAME_MAX + 1];
+            size_t len = sizeof(str);
+            ret = nvs_get_str(nvs, e->name, str, &len);
+            if (ret == ESP_OK && len - 1 >= e->min && len <= e->size) {
+                strcpy(log_config_str(e, cfg), str);
+            }
+        }
+        if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "Failed to read %s (%s), using default", e->name, esp_err_to_name(ret));
+        }
+    }
+}
+
+void app_config_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
+    app_config_t *cfg = &config_snap[0];
+    log_config_defaults(config_desc, APP_CONFIG_DESC_NUM, cfg);
+    nvs_handle_t nvs;
+    if (nvs_open(APP_CONFIG_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        config_load(nvs, cfg);
+        nvs_close(nvs);
+    }
+    if (cfg->uart_rx_pin == cfg->uart_tx_pin) {
+        ESP_LOGW(TAG, "RX and TX both on GPIO%" PRIu32 ", using default pins", cfg->uart_rx_pin);
+        app_config_t def;
+        log_config_defaults(config_desc, APP_CONFIG_DESC_NUM, &def);
+        cfg->uart_rx_pin = def.uart_rx_pin;
+        cfg->uart_tx_pin = def.uart_tx_pin;
+    }
+    config_stored = *cfg;
+    ESP_LOGI(TAG, "baud %" PRIu32 ", flush %" PRIu32 " ms, read target %" PRIu32 " ms, RX GPIO%" PRIu32
+             ", TX GPIO%" PRIu32 ", name %s", cfg->baud, cfg->flush_ms, cfg->read_target_ms, cfg->uart_rx_pin,
+             cfg->uart_tx_pin, cfg->device_name);
+}
+
+static esp_err_t config_save(const log_config_desc_t *e)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(APP_CONFIG_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (e == NULL) {
+        ret = nvs_erase_all(nvs);
+    } else if (e->type == LOG_CONFIG_TYPE_U32) {
+        ret = nvs_set_u32(nvs, e->name, log_config_get_u32(e, &config_stored));
+    } else {
+        ret = nvs_set_str(nvs, e->name, log_config_str(e, &config_stored));
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return ret;
+}
+
+// 在线生效的字段：复制当前快照到另一份，修改后发布
+static void config_publish(const log_config_desc_t *e)
+{
+    const app_config_t *cur = app_config();
+    app_config_t *next = &config_snap[(cur == &config_snap[0]) ? 1 : 0];
+    *next = *cur;
+    *(uint32_t *)((uint8_t *)next + e->offset) = log_config_get_u32(e, &config_stored);
+    next->gen++;
+    __atomic_store_n(&config_cur, next, __ATOMIC_RELEASE);
+}
+
+static void config_reboot_task(void *arg)
+{
+    esp_err_t ret = tfcard_emergency_stop(APP_CONFIG_REBOOT_FLUSH_MS);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Card flush before reboot: %s", esp_err_to_name(ret));
+    }
+    esp_restart();
+}
+
+bool app_config_handle_write(const uint8_t *data, size_t len)
+{
+    if (len < 1) {
+        return false;
+    }
+    switch (data[0]) {
+    case APP_CONFIG_CMD_SET: {
+        if (len < 2) {
+            return false;
+        }
+        const log_config_desc_t *e = log_config_find(config_desc, APP_CONFIG_DESC_NUM, data[1]);
+        app_config_t next = config_stored;
+        if (e == NULL || !log_config_set(e, &next, &data[2], len - 2)) {
+            ESP_LOGW(TAG, "Rejected value for key %u", data[1]);
+            return false;
+        }
+        // RX 和 TX 不能用同一个引脚；对调两个引脚时先把其中一个改到空闲引脚
+        if (next.uart_rx_pin == next.uart_tx_pin) {
+            ESP_LOGW(TAG, "Rejected %s: RX and TX would share GPIO%" PRIu32, e->name, next.uart_rx_pin);
+            return false;
+        }
+        config_stored = next;
+        esp_err_t ret = config_save(e);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to save %s (%s)", e->name, esp_err_to_name(ret));
+            return false;
+        }
+        if (e->flags & LOG_CONFIG_FLAG_LIVE) {
+            config_publish(e);
+            ESP_LOGI(TAG, "%s set to %" PRIu32, e->name, log_config_get_u32(e, &config_stored));
+        } else {
+            ESP_LOGI(TAG, "%s saved, takes effect after reboot", e->name);
+        }
+        return true;
+    }
+    case APP_CONFIG_CMD_RESET: {
+        esp_err_t ret = config_save(NULL);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to erase config (%s)", esp_err_to_name(ret));
+            return false;
+        }
+        log_config_defaults(config_desc, APP_CONFIG_DESC_NUM, &config_stored);
+        ESP_LOGI(TAG, "Config erased, defaults apply after reboot");
+        return true;
+    }
+    case APP_CONFIG_CMD_REBOOT:
+        // 写卡可能要等几秒，不能阻塞 BTC 任务
+        ESP_LOGI(TAG, "Reboot requested");
+        return xTaskCreate(config_reboot_task, "cfg_reboot", TASK_STACK_CONFIG, NULL, TASK_PRIO_CONFIG, NULL) == pdPASS;
+    default:
+        return false;
+    }
+}
+
+size_t app_config_read(uint8_t *buf, size_t size)
+{
+    return log_config_dump(config_desc, APP_CONFIG_DESC_NUM, &config_stored, app_config(), buf, size);
+}
@@ -0,0 +1,54 @@
+#ifndef __APP_CONFIG_H__
+#define __APP_CONFIG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 运行配置：启动时从 NVS 读入一份快照，各任务通过 app_config() 取得指针直接读字段，热路径上没有查找。
+ * BLE 配置特征（0xEE08）修改后先写 NVS；可以在线修改的字段（波特率、写卡间隔、读取目标时长）
+ * 同时发布一份新的快照并递增 gen，各任务每轮循环比较 gen，变化时再应用；
+ * 其余字段（引脚、设备名）重启后生效。
+ * 写入命令（多字节字段均为小端）：
+ *   SET:    [0x01][key u8][value...]，数值为 u32，字符串不含结尾的 0
+ *   RESET:  [0x02]，清除 NVS 中的配置，重启后恢复默认值
+ *   REBOOT: [0x03]，写完 TF 卡缓冲区后重启
+ * 读取返回已保存的配置，格式见 log_config.h。
+ * 环形缓冲区在编译期静态分配（CONFIG_TFCARD_RING_KB 等），不在运行配置中。
+ */
+
+#define APP_CONFIG_CMD_SET    0x01
+#define APP_CONFIG_CMD_RESET  0x02
+#define APP_CONFIG_CMD_REBOOT 0x03
+
+// 配置项编号
+#define APP_CONFIG_KEY_BAUD        1
+#define APP_CONFIG_KEY_FLUSH_MS    2
+#define APP_CONFIG_KEY_READ_MS     3
+#define APP_CONFIG_KEY_UART_RX_PIN 4
+#define APP_CONFIG_KEY_UART_TX_PIN 5
+#define APP_CONFIG_KEY_DEVICE_NAME 6
+
+#define APP_CONFIG_NAME_MAX  28
+
+typedef struct {
+    uint32_t gen;               // 在线修改的次数，启动时为 0
+    uint32_t baud;              // UART 波特率
+    uint32_t flush_ms;          // tfcard_task 的写卡间隔
+    uint32_t read_target_ms;    // uart_task 单次读取的目标时长，见 log_rxsize.h
+    uint32_t uart_rx_pin;
+    uint32_t uart_tx_pin;
+    char device_name[APP_CONFIG_NAME_MAX + 1];
+} app_config_t;
+
+// 初始化 NVS 并读入配置，须在其他模块之前调用
+void app_config_init(void);
+
+// 当前快照；在线修改后指向新的快照，调用方每轮循环重新获取，不要长期保存字段的地址
+const app_config_t *app_config(void);
+
+bool app_config_handle_write(const uint8_t *data, size_t len);
+size_t app_config_read(uint8_t *buf, size_t size);
+
+#endif
@@ -0,0 +1,55 @@
+#include "log_battery.h"
+
+void log_battery_init(log_battery_t *b, uint16_t low_mv, uint16_t critical_mv, uint16_t hyst_mv)
+{
+    b->low_mv = low_mv;
+    b->critical_mv = critical_mv;
+    b->hyst_mv = hyst_mv;
+    b->idx = 0;
+    b->count = 0;
+    b->sum = 0;
+    b->avg_mv = 0;
+    b->level = LOG_BATTERY_OK;
+}
+
+log_battery_level_t log_battery_update(log_battery_t *b, uint16_t mv)
+{
+    if (b->count == 0) {
+        for (int i = 0; i < LOG_BATTERY_AVG; i++) {
+            b->window[i] = mv;
+        }
+        b->sum = (uint32_t)mv * LOG_BATTERY_AVG;
+        b->count = LOG_BATTERY_AVG;
+    } else {
+        b->sum += mv - b->window[b->idx];
+        b->window[b->idx] = mv;
+    }
+    b->idx = (b->idx + 1) % LOG_BATTERY_AVG;
+    b->avg_mv = b->sum / LOG_BATTERY_AVG;
+
+    uint16_t v = b->avg_mv;
+    switch (b->level) {
+    case LOG_BATTERY_OK:
+        if (v < b->critical_mv) {
+            b->level = LOG_BATTERY_CRITICAL;
+        } else if (v < b->low_mv) {
+            b->level = LOG_BATTERY_LOW;
+        }
+        break;
+    case LOG_BATTERY_LOW:
+        if (v < b->critical_mv) {
+            b->level = LOG_BATTERY_CRITICAL;
+        } else if (v >= b->low_mv + b->hyst_mv) {
+            b->level = LOG_BATTERY_OK;
+        }
+        break;
+    case LOG_BATTERY_CRITICAL:
+        if (v >= b->low_mv + b->hyst_mv) {
+            b->level = LOG_BATTERY_OK;
+        } else if (v >= b->critical_mv + b->hyst_mv) {
+            b->level = LOG_BATTERY_LOW;
+        }
+        break;
+    }
+    return b->level;
+}
@@ -0,0 +1,35 @@
+#ifndef __LOG_BATTERY_H__
+#define __LOG_BATTERY_H__
+
+#include <stdint.h>
+
+/*
+ * 电池电压判定：对每个周期的读数做滑动平均，再按带回差的阈值切换电量等级。
+ * 下降时低于阈值即切换，回升时需超过 阈值 + 回差 才恢复，避免在阈值附近来回抖动。
+ */
+
+#define LOG_BATTERY_AVG 4 // 滑动平均窗口（采样周期数）
+
+typedef enum {
+    LOG_BATTERY_OK,
+    LOG_BATTERY_LOW,
+    LOG_BATTERY_CRITICAL,
+} log_battery_level_t;
+
+typedef struct {
+    uint16_t low_mv;
+    uint16_t critical_mv;
+    uint16_t hyst_mv;
+    uint16_t window[LOG_BATTERY_AVG];
+    uint8_t idx;
+    uint8_t count;
+    uint32_t sum;
+    uint16_t avg_mv;
+    log_battery_level_t level;
+} log_battery_t;
+
+void log_battery_init(log_battery_t *b, uint16_t low_mv, uint16_t critical_mv, uint16_t hyst_mv);
+// 加入一次读数，返回更新后的等级；第一次读数直接填满平均窗口
+log_battery_level_t log_battery_update(log_battery_t *b, uint16_t mv);
+
+#endif
@@ -0,0 +1,122 @@
+#include <string.h>
+#include "log_capture.h"
+#include "log_frame.h"
+
+static const char hex_digits[] = "0123456789abcdef";
+
+void log_capture_hdr(uint8_t *out, uint8_t type, uint16_t len, uint32_t time_ms)
+{
+    out[0] = LOG_CAPTURE_MAGIC;
+    out[1] = type;
+    out[2] = len & 0xff;
+    out[3] = len >> 8;
+    out[4] = time_ms & 0xff;
+    out[5] = (time_ms >> 8) & 0xff;
+    out[6] = (time_ms >> 16) & 0xff;
+    out[7] = time_ms >> 24;
+    out[8] = out[0] ^ out[1] ^ out[2] ^ out[3] ^ out[4] ^ out[5] ^ out[6] ^ out[7];
+}
+
+size_t log_capture_event(uint8_t *out, uint8_t type, uint32_t time_ms, uint32_t arg)
+{
+    uint8_t *p = out + LOG_CAPTURE_HDR_LEN;
+    log_capture_hdr(out, type, 4, time_ms);
+    p[0] = arg & 0xff;
+    p[1] = (arg >> 8) & 0xff;
+    p[2] = (arg >> 16) & 0xff;
+    p[3] = arg >> 24;
+    return LOG_CAPTURE_HDR_LEN + 4;
+}
+
+size_t log_capture_start(uint8_t *out, uint32_t time_ms, uint32_t baud, uint8_t data_bits, uint8_t parity,
+                         uint8_t stop_bits)
+{
+    uint8_t *p = out + LOG_CAPTURE_HDR_LEN;
+    log_capture_hdr(out, LOG_CAPTURE_START, 8, time_ms);
+    p[0] = baud & 0xff;
+    p[1] = (baud >> 8) & 0xff;
+    p[2] = (baud >> 16) & 0xff;
+    p[3] = baud >> 24;
+    p[4] = data_bits;
+    p[5] = parity;
+    p[6] = stop_bits;
+    p[7] = 0;
+    return LOG_CAPTURE_HDR_LEN + 8;
+}
+
+const char *log_capture_type_name(uint8_t type)
+{
+    switch (type) {
+    case LOG_CAPTURE_DATA: return "DATA";
+    case LOG_CAPTURE_START: return "START";
+    case LOG_CAPTURE_FRAME_ERR: return "FRAME_ERR";
+    case LOG_CAPTURE_PARITY_ERR: return "PARITY_ERR";
+    case LOG_CAPTURE_BREAK: return "BREAK";
+    case LOG_CAPTURE_FIFO_OVF: return "FIFO_OVF";
+    case LOG_CAPTURE_BUFFER_FULL: return "BUFFER_FULL";
+    default: return "?";
+    }
+}
+
+static char *put_hex(char *p, uint32_t v, int digits)
+{
+    for (int i = digits - 1; i >= 0; i--) {
+        *p++ = hex_digits[(v >> (i * 4)) & 0xf];
+    }
+    return p;
+}
+
+size_t log_capture_hex(char *out, size_t out_size, uint32_t time_ms, uint32_t offset, const uint8_t *data, size_t len)
+{
+    size_t o = 0;
+
+    for (size_t i = 0; i < len; i += LOG_CAPTURE_HEX_PER_LINE) {
+        size_t n = (len - i < LOG_CAPTURE_HEX_PER_LINE) ? len - i : LOG_CAPTURE_HEX_PER_LINE;
+        if (o + LOG_CAPTURE_HEX_LINE_MAX > out_size) {
+            break;
+        }
+        char *p = out + o;
+        p += log_frame_prefix(p, time_ms);
+        p = put_hex(p, offset + i, 8);
+        *p++ = ':';
+        for (size_t k = 0; k < LOG_CAPTURE_HEX_PER_LINE; k++) {
+            *p++ = ' ';
+            if (k < n) {
+                p = put_hex(p, data[i + k], 2);
+            } else {
+                *p++ = ' ';
+                *p++ = ' ';
+            }
+        }
+        *p++ = ' ';
+        *p++ = '|';
+        for (size_t k = 0; k < n; k++) {
+            uint8_t c = data[i + k];
+            *p++ = (c >= 0x20 && c < 0x7f) ? (char)c : '.';
+        }
+        *p++ = '|';
+        *p++ = '\n';
+        o = p - out;
+    }
+    return o;
+}
+
+size_t log_capture_event_text(char *out, size_t out_size, uint32_t time_ms, uint8_t type, uint32_t arg)
+{
+    const char *name = log_capture_type_name(type);
+    size_t name_len = strlen(name);
+    if (out_size < LOG_FRAME_PREFIX_MAX + name_len + 16) {
+        return 0;
+    }
+    char *p = out + log_frame_prefix(out, time_ms);
+    *p++ = '<';
+    memcpy(p, name, name_len);
+    p += name_len;
+    if (arg != 0) {
+        *p++ = ' ';
+        p = put_hex(p, arg, 8);
+    }
+    *p++ = '>';
+    *p++ = '\n';
+    return p - out;
+}
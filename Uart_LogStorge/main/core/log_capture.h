@@ -0,0 +1,54 @@
+#ifndef __LOG_CAPTURE_H__
+#define __LOG_CAPTURE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 二进制抓包模式（CONFIG_UART_CAPTURE_RAW）的记录格式：串口数据原样保存，不加时间戳文本和换行，
+ * 驱动上报的线路事件（帧错误、校验错误、BREAK、FIFO 溢出、驱动缓冲区满）作为带外记录插在数据流中的对应位置。
+ * 每条记录为 [magic 0xA5][type u8][len u16][time_ms u32][hdr_xor u8][payload len 字节]，多字节字段小端，
+ * hdr_xor 为前 8 字节的异或，解析时用于在损坏处重新同步。
+ * 数据记录的负载为原始字节；事件记录的负载为 [arg u32]（数据事件之间丢失/涉及的字节数，驱动未提供时为 0）；
+ * 开始记录在每次启动时写一次，负载为 [baud u32][data_bits u8][parity u8][stop_bits u8][reserved u8]，
+ * data_bits 为 5~8，parity 为 'N'/'E'/'O'，stop_bits 为停止位数的两倍（2、3、4 对应 1、1.5、2）。
+ * 解析见 pytest/capture_decode.py。BLE 实时流不发送二进制记录，改为十六进制文本行（log_capture_hex）。
+ * 不依赖 ESP-IDF，设备端和主机端共用。
+ */
+
+#define LOG_CAPTURE_MAGIC   0xA5
+#define LOG_CAPTURE_HDR_LEN 9
+
+#define LOG_CAPTURE_DATA        0x01
+#define LOG_CAPTURE_START       0x02
+#define LOG_CAPTURE_FRAME_ERR   0x10
+#define LOG_CAPTURE_PARITY_ERR  0x11
+#define LOG_CAPTURE_BREAK       0x12
+#define LOG_CAPTURE_FIFO_OVF    0x13
+#define LOG_CAPTURE_BUFFER_FULL 0x14
+
+// 十六进制行每行的数据字节数，及每行最大长度（时间戳、hex、ASCII 和换行）
+#define LOG_CAPTURE_HEX_PER_LINE 16
+#define LOG_CAPTURE_HEX_LINE_MAX (32 + LOG_CAPTURE_HEX_PER_LINE * 4 + 4)
+
+// 记录头写入 out（至少 LOG_CAPTURE_HDR_LEN 字节），负载由调用方紧随其后写入
+void log_capture_hdr(uint8_t *out, uint8_t type, uint16_t len, uint32_t time_ms);
+
+// 事件记录（含 4 字节负载），返回记录长度
+size_t log_capture_event(uint8_t *out, uint8_t type, uint32_t time_ms, uint32_t arg);
+
+// 开始记录，参数含义见文件开头，返回记录长度
+size_t log_capture_start(uint8_t *out, uint32_t time_ms, uint32_t baud, uint8_t data_bits, uint8_t parity,
+                         uint8_t stop_bits);
+
+// 十六进制文本 "[hh:mm:ss.mmm] 00000000: 41 42 ... |AB..|\n"，每 16 字节一行，offset 为首字节在流中的偏移；
+// 返回写入长度，out 空间不足时只写完整的行
+size_t log_capture_hex(char *out, size_t out_size, uint32_t time_ms, uint32_t offset, const uint8_t *data, size_t len);
+
+// 事件的文本行 "[hh:mm:ss.mmm] <BREAK>\n"，arg 不为 0 时附在名称后（"<FIFO_OVF 00000040>"），返回长度
+size_t log_capture_event_text(char *out, size_t out_size, uint32_t time_ms, uint8_t type, uint32_t arg);
+
+const char *log_capture_type_name(uint8_t type);
+
+#endif
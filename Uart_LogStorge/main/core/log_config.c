@@ -0,0 +1,99 @@
+#include <string.h>
+#include "log_config.h"
+
+void log_config_defaults(const log_config_desc_t *d, int n, void *cfg)
+{
+    for (int i = 0; i < n; i++) {
+        if (d[i].type == LOG_CONFIG_TYPE_U32) {
+            *(uint32_t *)((uint8_t *)cfg + d[i].offset) = d[i].def;
+        } else {
+            char *s = log_config_str(&d[i], cfg);
+            strncpy(s, d[i].def_str, d[i].size - 1);
+            s[d[i].size - 1] = '\0';
+        }
+    }
+}
+
+const log_config_desc_t *log_config_find(const log_config_desc_t *d, int n, uint8_t key)
+{
+    for (int i = 0; i < n; i++) {
+        if (d[i].key == key) {
+            return &d[i];
+        }
+    }
+    return NULL;
+}
+
+bool log_config_check_u32(const log_config_desc_t *e, uint32_t v)
+{
+    if (v < e->min || v > e->max) {
+        return false;
+    }
+    return e->allow_mask == 0 || (v < 32 && (e->allow_mask & (1u << v)));
+}
+
+bool log_config_set(const log_config_desc_t *e, void *cfg, const uint8_t *value, size_t len)
+{
+    if (e->type == LOG_CONFIG_TYPE_U32) {
+        if (len != 4) {
+            return false;
+        }
+        uint32_t v = value[0] | (value[1] << 8) | (value[2] << 16) | ((uint32_t)value[3] << 24);
+        if (!log_config_check_u32(e, v)) {
+            return false;
+        }
+        *(uint32_t *)((uint8_t *)cfg + e->offset) = v;
+        return true;
+    }
+
+    if (len < e->min || len > e->max || len >= e->size || memchr(value, '\0', len) != NULL) {
+        return false;
+    }
+    char *s = log_config_str(e, cfg);
+    memcpy(s, value, len);
+    s[len] = '\0';
+    return true;
+}
+
+bool log_config_equal(const log_config_desc_t *e, const void *a, const void *b)
+{
+    if (e->type == LOG_CONFIG_TYPE_U32) {
+        return log_config_get_u32(e, a) == log_config_get_u32(e, b);
+    }
+    return strcmp((const char *)a + e->offset, (const char *)b + e->offset) == 0;
+}
+
+size_t log_config_dump(const log_config_desc_t *d, int n, const void *stored, const void *running, uint8_t *buf,
+                       size_t size)
+{
+    size_t pos = 2;
+
+    if (size < pos) {
+        return 0;
+    }
+    buf[0] = LOG_CONFIG_VERSION;
+    buf[1] = n;
+    for (int i = 0; i < n; i++) {
+        const log_config_desc_t *e = &d[i];
+        const uint8_t *field = (const uint8_t *)stored + e->offset;
+        size_t len = (e->type == LOG_CONFIG_TYPE_U32) ? 4 : strlen((const char *)field);
+        if (pos + 4 + len > size) {
+            return 0;
+        }
+        buf[pos] = e->key;
+        buf[pos + 1] = e->type;
+        buf[pos + 2] = e->flags | (log_config_equal(e, stored, running) ? 0 : LOG_CONFIG_FLAG_PENDING);
+        buf[pos + 3] = len;
+        if (e->type == LOG_CONFIG_TYPE_U32) {
+            uint32_t v = log_config_get_u32(e, stored);
+            buf[pos + 4] = v & 0xff;
+            buf[pos + 5] = (v >> 8) & 0xff;
+            buf[pos + 6] = (v >> 16) & 0xff;
+            buf[pos + 7] = v >> 24;
+        } else {
+            memcpy(&buf[pos + 4], field, len);
+        }
+        pos += 4 + len;
+    }
+    return pos;
+}
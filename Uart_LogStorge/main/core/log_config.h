@@ -0,0 +1,62 @@
+#ifndef __LOG_CONFIG_H__
+#define __LOG_CONFIG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 类型化的键值配置：调用方用描述表说明配置结构体的每个字段（BLE 编号、NVS 键名、类型、范围、默认值），
+ * 这里只做默认值填充、校验、赋值和序列化，不关心存储和字段的含义。
+ * 数值统一为 u32（小端），字符串以 0 结尾，长度范围不含结尾的 0。
+ * 序列化格式：[version u8][num u8]{[key u8][type u8][flags u8][len u8][value...]} x num，
+ * flags 为描述表中的标志，另外 LOG_CONFIG_FLAG_PENDING 表示已保存、重启后才生效。
+ * 不依赖 ESP-IDF，设备端和主机端共用。
+ */
+
+#define LOG_CONFIG_VERSION 1
+
+#define LOG_CONFIG_TYPE_U32 1
+#define LOG_CONFIG_TYPE_STR 2
+
+#define LOG_CONFIG_FLAG_LIVE    0x01 // 修改后立即生效，否则重启后生效
+#define LOG_CONFIG_FLAG_PENDING 0x80
+
+typedef struct {
+    uint8_t key;            // BLE 协议中的编号
+    const char *name;       // NVS 键名，不超过 15 个字符
+    uint8_t type;
+    uint8_t flags;
+    uint16_t offset;        // 字段在配置结构体中的偏移
+    uint16_t size;          // 字段大小（字符串为缓冲区大小，含结尾的 0）
+    uint32_t min, max;      // 数值范围；字符串为长度范围
+    uint32_t allow_mask;    // 非 0 时数值还须在该位图中（引脚等离散取值）
+    uint32_t def;
+    const char *def_str;
+} log_config_desc_t;
+
+void log_config_defaults(const log_config_desc_t *d, int n, void *cfg);
+const log_config_desc_t *log_config_find(const log_config_desc_t *d, int n, uint8_t key);
+
+// 数值字段是否合法
+bool log_config_check_u32(const log_config_desc_t *e, uint32_t v);
+// 校验后写入一个字段，value 为协议中的原始值（u32 为 4 字节小端），不合法时返回 false 且不修改
+bool log_config_set(const log_config_desc_t *e, void *cfg, const uint8_t *value, size_t len);
+// 两份配置中该字段是否相同
+bool log_config_equal(const log_config_desc_t *e, const void *a, const void *b);
+
+static inline uint32_t log_config_get_u32(const log_config_desc_t *e, const void *cfg)
+{
+    return *(const uint32_t *)((const uint8_t *)cfg + e->offset);
+}
+
+static inline char *log_config_str(const log_config_desc_t *e, void *cfg)
+{
+    return (char *)cfg + e->offset;
+}
+
+// 序列化 stored（已保存的值），与 running（正在使用的值）不同的字段标记 PENDING，返回长度，空间不足返回 0
+size_t log_config_dump(const log_config_desc_t *d, int n, const void *stored, const void *running, uint8_t *buf,
+                       size_t size);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef __LOG_CRC_H__
+#define __LOG_CRC_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-32（IEEE 802.3，与 zlib.crc32 一致），crc 传 0 开始，可分段累加
+uint32_t log_crc32(uint32_t crc, const void *data, size_t len);
+
+#endif
@@ -0,0 +1,217 @@
+#include <string.h>
+#include "log_dedup.h"
+#include "log_frame.h"
+
+static const char level_chars[] = "EWIDV";
+
+void log_dedup_init(log_dedup_t *d, uint8_t flags, uint32_t window_ms)
+{
+    memset(d, 0, sizeof(*d));
+    d->flags = flags;
+    d->window_ms = window_ms;
+}
+
+// 找出 ESP-IDF 日志前缀 "I (12345) " 中的 tick 数字（允许前面带颜色码），返回是否找到；
+// 数字位于 [*start, *end)，颜色码和级别字符仍参与比较
+static bool find_ticks(const char *s, size_t len, size_t *start, size_t *end)
+{
+    size_t i = 0;
+    while (i + 1 < len && s[i] == '\033' && s[i + 1] == '[') {
+        i += 2;
+        while (i < len && s[i] != 'm') {
+            i++;
+        }
+        i++;
+    }
+    if (i + 3 >= len || strchr(level_chars, s[i]) == NULL || s[i + 1] != ' ' || s[i + 2] != '(') {
+        return false;
+    }
+    size_t j = i + 3;
+    while (j < len && s[j] >= '0' && s[j] <= '9') {
+        j++;
+    }
+    if (j == i + 3 || j + 1 >= len || s[j] != ')' || s[j + 1] != ' ') {
+        return false;
+    }
+    *start = i + 3;
+    *end = j;
+    return true;
+}
+
+static uint32_t fnv1a(uint32_t h, const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+// 输出缓冲区放不下时整段丢弃，不输出半截内容
+static void out_put(log_dedup_t *d, char *out, size_t out_size, size_t *o, const char *p, size_t n, bool newline)
+{
+    size_t need = n + (newline ? 1 : 0);
+    if (*o + need > out_size) {
+        d->bytes_lost += need;
+        return;
+    }
+    memcpy(out + *o, p, n);
+    if (newline) {
+        out[*o + n] = '\n';
+    }
+    *o += need;
+}
+
+static size_t put_u32(char *p, uint32_t v)
+{
+    char digits[10];
+    size_t n = 0, len;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v > 0);
+    len = n;
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    return len;
+}
+
+static void emit_summary(log_dedup_t *d, char *out, size_t out_size, size_t *o)
+{
+    static const char head[] = "[dedup] previous line repeated ";
+    static const char mid[] = " times between ";
+    static const char to[] = " and ";
+    char buf[LOG_DEDUP_SUMMARY_MAX];
+    size_t n = 0;
+
+    memcpy(buf, head, sizeof(head) - 1);
+    n += sizeof(head) - 1;
+    n += put_u32(buf + n, d->repeats);
+    memcpy(buf + n, mid, sizeof(mid) - 1);
+    n += sizeof(mid) - 1;
+    n += log_frame_prefix(buf + n, d->first_ms) - 1; // 去掉前缀末尾的空格
+    memcpy(buf + n, to, sizeof(to) - 1);
+    n += sizeof(to) - 1;
+    n += log_frame_prefix(buf + n, d->last_ms) - 1;
+    out_put(d, out, out_size, o, buf, n, true);
+    d->summaries++;
+    d->repeats = 0;
+}
+
+static bool summary_due(const log_dedup_t *d, uint32_t now_ms)
+{
+    return d->repeats > 0 && now_ms - d->first_ms >= d->window_ms;
+}
+
+// 处理一整行，n 包含结尾的 '\n'。比较键为去掉行尾换行（和 tick 数字）后的内容，分为 key[0..l1) 和 key2[0..l2) 两段
+static void dedup_line(log_dedup_t *d, const char *line, size_t n, uint32_t now_ms, char *out, size_t out_size,
+                       size_t *o)
+{
+    size_t len = n - 1, l1, l2 = 0, t_start, t_end;
+    const char *key2;
+
+    d->lines_in++;
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    l1 = len;
+    key2 = line + len;
+    if ((d->flags & LOG_DEDUP_FLAG_SKIP_TICKS) && find_ticks(line, len, &t_start, &t_end)) {
+        l1 = t_start;
+        key2 = line + t_end;
+        l2 = len - t_end;
+    }
+    uint32_t h = fnv1a(fnv1a(2166136261u, line, l1), key2, l2);
+    size_t key_len = l1 + l2;
+
+    if (d->prev_valid && h == d->prev_hash && key_len == d->prev_len && memcmp(d->prev, line, l1) == 0 &&
+        memcmp(d->prev + l1, key2, l2) == 0) {
+        if (d->repeats == 0) {
+            d->first_ms = now_ms;
+        }
+        d->repeats++;
+        d->last_ms = now_ms;
+        d->lines_folded++;
+        d->bytes_folded += n;
+        return;
+    }
+    if (d->repeats > 0) {
+        emit_summary(d, out, out_size, o);
+    }
+    out_put(d, out, out_size, o, line, n, false);
+    d->prev_valid = key_len <= LOG_DEDUP_LINE_MAX;
+    if (d->prev_valid) {
+        memcpy(d->prev, line, l1);
+        memcpy(d->prev + l1, key2, l2);
+        d->prev_len = key_len;
+        d->prev_hash = h;
+    }
+}
+
+size_t log_dedup_feed(log_dedup_t *d, const char *data, size_t len, uint32_t now_ms, char *out, size_t out_size)
+{
+    size_t o = 0;
+    size_t i = 0;
+
+    if (summary_due(d, now_ms)) {
+        emit_summary(d, out, out_size, &o);
+    }
+    while (i < len) {
+        const char *nl = memchr(data + i, '\n', len - i);
+        size_t end = (nl != NULL) ? (size_t)(nl - data) + 1 : len; // 本段结束位置（含换行）
+
+        if (d->passthrough) {
+            out_put(d, out, out_size, &o, data + i, end - i, false);
+            d->passthrough = (nl == NULL);
+            i = end;
+            continue;
+        }
+        if (d->line_len == 0 && nl != NULL) {
+            // 整行都在本次数据中，直接判定不复制
+            dedup_line(d, data + i, end - i, now_ms, out, out_size, &o);
+            i = end;
+            continue;
+        }
+
+        size_t n = end - i;
+        if (d->line_len + n > LOG_DEDUP_LINE_MAX) {
+            // 行太长：不参与折叠，已缓存部分和剩余部分原样输出
+            if (d->repeats > 0) {
+                emit_summary(d, out, out_size, &o);
+            }
+            out_put(d, out, out_size, &o, d->line, d->line_len, false);
+            out_put(d, out, out_size, &o, data + i, n, false);
+            d->line_len = 0;
+            d->prev_valid = false;
+            d->passthrough = (nl == NULL);
+        } else {
+            memcpy(d->line + d->line_len, data + i, n);
+            d->line_len += n;
+            if (nl != NULL) {
+                dedup_line(d, d->line, d->line_len, now_ms, out, out_size, &o);
+                d->line_len = 0;
+            }
+        }
+        i = end;
+    }
+    return o;
+}
+
+size_t log_dedup_flush(log_dedup_t *d, uint32_t now_ms, char *out, size_t out_size)
+{
+    size_t o = 0;
+
+    if (d->line_len > 0) {
+        // 半行不再等待，先输出；这一行的剩余部分不参与折叠
+        if (d->repeats > 0) {
+            emit_summary(d, out, out_size, &o);
+        }
+        out_put(d, out, out_size, &o, d->line, d->line_len, false);
+        d->line_len = 0;
+        d->prev_valid = false;
+        d->passthrough = true;
+    } else if (summary_due(d, now_ms)) {
+        emit_summary(d, out, out_size, &o);
+    }
+    return o;
+}
@@ -0,0 +1,66 @@
+#ifndef __LOG_DEDUP_H__
+#define __LOG_DEDUP_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 连续重复行折叠：对串口原始数据逐行比较（先比 FNV-1a 哈希和长度，相同再逐字节确认），
+ * 与上一行相同的行不输出，只计数；出现不同的行、或重复持续了 window_ms 之后，
+ * 输出一行 "[dedup] previous line repeated N times between [t1] and [t2]"，t1/t2 为首次和最后一次重复的时刻。
+ * LOG_DEDUP_FLAG_SKIP_TICKS 时比较跳过 ESP-IDF 日志的 "I (12345) " 前缀，只有 tick 不同的行也视为重复。
+ * 跨调用的半行缓存到下一次再判断，超过 LOG_DEDUP_LINE_MAX 的行不参与折叠，原样输出。
+ * 不依赖 ESP-IDF，设备端和主机端共用。
+ */
+
+#define LOG_DEDUP_LINE_MAX    256
+#define LOG_DEDUP_SUMMARY_MAX 96
+// 输入 len 字节时输出缓冲区所需的大小（缓存的半行、两条汇总行）
+#define LOG_DEDUP_OUT_MAX(len) ((len) + LOG_DEDUP_LINE_MAX + 2 * LOG_DEDUP_SUMMARY_MAX)
+
+#define LOG_DEDUP_FLAG_SKIP_TICKS 0x01
+
+typedef struct {
+    uint8_t flags;
+    uint32_t window_ms;
+
+    // 半行缓存
+    size_t line_len;
+    bool passthrough;       // 超长行或空闲时已输出的半行，剩余部分直接输出
+    char line[LOG_DEDUP_LINE_MAX];
+
+    // 上一行的比较键
+    bool prev_valid;
+    uint32_t prev_hash;
+    size_t prev_len;
+    char prev[LOG_DEDUP_LINE_MAX];
+
+    // 当前的重复段
+    uint32_t repeats;
+    uint32_t first_ms;
+    uint32_t last_ms;
+
+    // 统计
+    uint32_t lines_in;
+    uint32_t lines_folded;  // 被折叠的行数
+    uint32_t bytes_folded;  // 被折叠的字节数
+    uint32_t summaries;     // 输出的汇总行数
+    uint32_t bytes_lost;    // 输出缓冲区不足而丢弃的字节
+} log_dedup_t;
+
+void log_dedup_init(log_dedup_t *d, uint8_t flags, uint32_t window_ms);
+
+// 处理一段原始数据，now_ms 为接收时刻，输出写入 out（至少 LOG_DEDUP_OUT_MAX(len) 字节），返回输出长度
+size_t log_dedup_feed(log_dedup_t *d, const char *data, size_t len, uint32_t now_ms, char *out, size_t out_size);
+
+// 串口空闲时调用：输出缓存的半行，重复段到期时输出汇总行；out 至少 LOG_DEDUP_OUT_MAX(0) 字节
+size_t log_dedup_flush(log_dedup_t *d, uint32_t now_ms, char *out, size_t out_size);
+
+// 是否还有缓存的半行或未输出的汇总
+static inline bool log_dedup_pending(const log_dedup_t *d)
+{
+    return d->line_len > 0 || d->repeats > 0;
+}
+
+#endif
@@ -0,0 +1,180 @@
+#include <string.h>
+#include "log_filter.h"
+#include "log_search.h"
+
+static const char level_chars[LOG_FILTER_LEVEL_NUM] = {'E', 'W', 'I', 'D', 'V'};
+
+void log_filter_init(log_filter_t *f, uint8_t flags, uint8_t level_mask)
+{
+    uint8_t match_flags = (flags & LOG_FILTER_FLAG_NOCASE) ? LOG_MATCH_FLAG_NOCASE : 0;
+    memset(f, 0, sizeof(*f));
+    log_match_init(&f->include, match_flags);
+    log_match_init(&f->exclude, match_flags);
+    f->flags = flags;
+    f->level_mask = level_mask;
+}
+
+int log_filter_add_include(log_filter_t *f, const char *pattern, size_t len)
+{
+    return log_match_add(&f->include, pattern, len);
+}
+
+int log_filter_add_exclude(log_filter_t *f, const char *pattern, size_t len)
+{
+    return log_match_add(&f->exclude, pattern, len);
+}
+
+void log_filter_compile(log_filter_t *f)
+{
+    log_match_compile(&f->include);
+    log_match_compile(&f->exclude);
+}
+
+void log_filter_reset_stats(log_filter_t *f)
+{
+    memset(f->include_hits, 0, sizeof(f->include_hits));
+    memset(f->exclude_hits, 0, sizeof(f->exclude_hits));
+    memset(f->level_hits, 0, sizeof(f->level_hits));
+    f->lines_in = 0;
+    f->lines_out = 0;
+    f->bytes_in = 0;
+    f->bytes_out = 0;
+    f->bytes_dropped = 0;
+}
+
+uint8_t log_filter_line_level(const char *content, size_t len)
+{
+    size_t i = 0;
+    // 跳过 "\033[0;31m" 形式的颜色码
+    while (i + 1 < len && content[i] == '\033' && content[i + 1] == '[') {
+        i += 2;
+        while (i < len && content[i] != 'm') {
+            i++;
+        }
+        i++;
+    }
+    if (i + 2 >= len || content[i + 1] != ' ' || content[i + 2] != '(') {
+        return 0;
+    }
+    for (int l = 0; l < LOG_FILTER_LEVEL_NUM; l++) {
+        if (content[i] == level_chars[l]) {
+            return 1 << l;
+        }
+    }
+    return 0;
+}
+
+static void count_hits(uint32_t *counters, uint8_t hits)
+{
+    for (int i = 0; hits != 0; i++, hits >>= 1) {
+        if (hits & 1) {
+            counters[i]++;
+        }
+    }
+}
+
+// 判定一整行（不含换行）；所有条件都会计算，保证每个计数器都是该模式出现的行数
+static bool filter_line(log_filter_t *f, const char *line, size_t len)
+{
+    uint32_t ts;
+    bool pass = true;
+
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    size_t prefix = log_search_parse_ts(line, len, &ts);
+    const char *content = line + prefix;
+    size_t content_len = len - prefix;
+
+    f->lines_in++;
+    uint8_t level = log_filter_line_level(content, content_len);
+    count_hits(f->level_hits, level);
+    if (f->level_mask != 0) {
+        pass = (level != 0) ? (level & f->level_mask) != 0 : (f->flags & LOG_FILTER_FLAG_UNLEVELED) != 0;
+    }
+    if (f->include.num_patterns > 0) {
+        uint8_t hits = log_match_line(&f->include, content, content_len);
+        count_hits(f->include_hits, hits);
+        pass = pass && hits != 0;
+    }
+    if (f->exclude.num_patterns > 0) {
+        uint8_t hits = log_match_line(&f->exclude, content, content_len);
+        count_hits(f->exclude_hits, hits);
+        pass = pass && hits == 0;
+    }
+    if (pass) {
+        f->lines_out++;
+    }
+    return pass;
+}
+
+// 输出缓冲区放不下时整段丢弃，不输出半截内容
+static void out_put(log_filter_t *f, char *out, size_t out_size, size_t *o, const char *p, size_t n, bool newline)
+{
+    size_t need = n + (newline ? 1 : 0);
+    if (*o + need > out_size) {
+        f->bytes_dropped += need;
+        return;
+    }
+    memcpy(out + *o, p, n);
+    if (newline) {
+        out[*o + n] = '\n';
+    }
+    *o += need;
+    f->bytes_out += need;
+}
+
+size_t log_filter_feed(log_filter_t *f, const char *data, size_t len, char *out, size_t out_size)
+{
+    size_t o = 0;
+    size_t i = 0;
+
+    f->bytes_in += len;
+    while (i < len) {
+        const char *nl = memchr(data + i, '\n', len - i);
+        size_t end = (nl != NULL) ? (size_t)(nl - data) + 1 : len; // 本段结束位置（含换行）
+
+        if (f->line_overflow) {
+            if (f->line_pass) {
+                out_put(f, out, out_size, &o, data + i, end - i, false);
+            }
+            f->line_overflow = (nl == NULL);
+            i = end;
+            continue;
+        }
+        if (f->line_len == 0 && nl != NULL) {
+            // 整行都在本次数据中，直接判定不复制
+            if (filter_line(f, data + i, end - i - 1)) {
+                out_put(f, out, out_size, &o, data + i, end - i, false);
+            }
+            i = end;
+            continue;
+        }
+
+        size_t n = end - i - (nl != NULL ? 1 : 0);
+        size_t take = LOG_FILTER_LINE_MAX - f->line_len;
+        if (take > n) {
+            take = n;
+        }
+        memcpy(f->line + f->line_len, data + i, take);
+        f->line_len += take;
+        i += take;
+
+        if (take < n) {
+            // 行太长：按已缓存部分判定，剩余部分直接沿用结果
+            f->line_pass = filter_line(f, f->line, f->line_len);
+            if (f->line_pass) {
+                out_put(f, out, out_size, &o, f->line, f->line_len, false);
+            }
+            f->line_len = 0;
+            f->line_overflow = true;
+        } else if (nl != NULL) {
+            i++; // 跳过 '\n'
+            if (filter_line(f, f->line, f->line_len)) {
+                out_put(f, out, out_size, &o, f->line, f->line_len, true);
+            }
+            f->line_len = 0;
+        }
+    }
+    return o;
+}
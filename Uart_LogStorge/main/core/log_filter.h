@@ -0,0 +1,64 @@
+#ifndef __LOG_FILTER_H__
+#define __LOG_FILTER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "log_match.h"
+
+/*
+ * 实时日志流的逐行过滤：包含/排除模式集合（log_match）加 ESP-IDF 日志级别，
+ * 只输出通过的整行，并按模式统计命中次数。跨调用的半行会缓存到下一次再判断。
+ */
+
+#define LOG_FILTER_LINE_MAX 1100
+
+// 日志级别位，对应行内容开头的 "E (" / "W (" ...
+#define LOG_FILTER_LEVEL_E   0x01
+#define LOG_FILTER_LEVEL_W   0x02
+#define LOG_FILTER_LEVEL_I   0x04
+#define LOG_FILTER_LEVEL_D   0x08
+#define LOG_FILTER_LEVEL_V   0x10
+#define LOG_FILTER_LEVEL_NUM 5
+
+#define LOG_FILTER_FLAG_NOCASE    0x01 // 模式忽略大小写
+#define LOG_FILTER_FLAG_UNLEVELED 0x02 // 设置了级别时，没有级别标记的行（回溯、非 IDF 输出）也放行
+
+typedef struct {
+    log_match_t include;           // 为空时不按包含条件筛选
+    log_match_t exclude;
+    uint8_t level_mask;            // 为 0 时不按级别筛选
+    uint8_t flags;
+
+    // 半行缓存
+    size_t line_len;
+    bool line_overflow;            // 超长行已按前 LOG_FILTER_LINE_MAX 字节判定，剩余部分沿用结果
+    bool line_pass;
+    char line[LOG_FILTER_LINE_MAX];
+
+    // 统计
+    uint32_t include_hits[LOG_MATCH_MAX_PATTERNS];
+    uint32_t exclude_hits[LOG_MATCH_MAX_PATTERNS];
+    uint32_t level_hits[LOG_FILTER_LEVEL_NUM];
+    uint32_t lines_in;
+    uint32_t lines_out;
+    uint32_t bytes_in;
+    uint32_t bytes_out;
+    uint32_t bytes_dropped;        // 输出缓冲区不足而丢弃的字节
+} log_filter_t;
+
+void log_filter_init(log_filter_t *f, uint8_t flags, uint8_t level_mask);
+// 添加包含/排除模式，规则同 log_match_add，失败返回 -1
+int log_filter_add_include(log_filter_t *f, const char *pattern, size_t len);
+int log_filter_add_exclude(log_filter_t *f, const char *pattern, size_t len);
+// 添加完全部模式后调用
+void log_filter_compile(log_filter_t *f);
+void log_filter_reset_stats(log_filter_t *f);
+
+// 过滤一段数据，通过的行写入 out，返回写入的字节数
+size_t log_filter_feed(log_filter_t *f, const char *data, size_t len, char *out, size_t out_size);
+
+// 识别行内容开头的日志级别（允许前面带 ANSI 颜色码），返回级别位，无法识别返回 0
+uint8_t log_filter_line_level(const char *content, size_t len);
+
+#endif
@@ -0,0 +1,60 @@
+#include <string.h>
+#include "log_frame.h"
+
+static char *put_2digits(char *p, uint32_t v)
+{
+    p[0] = '0' + v / 10;
+    p[1] = '0' + v % 10;
+    return p + 2;
+}
+
+size_t log_frame_prefix(char *out, uint32_t ts_ms)
+{
+    uint32_t hours = ts_ms / 3600000;
+    uint32_t minutes = ts_ms / 60000 % 60;
+    uint32_t seconds = ts_ms / 1000 % 60;
+    uint32_t ms = ts_ms % 1000;
+    char *p = out;
+
+    *p++ = '[';
+    if (hours < 100) {
+        p = put_2digits(p, hours);
+    } else {
+        char digits[10];
+        int n = 0;
+        while (hours > 0) {
+            digits[n++] = '0' + hours % 10;
+            hours /= 10;
+        }
+        while (n > 0) {
+            *p++ = digits[--n];
+        }
+    }
+    *p++ = ':';
+    p = put_2digits(p, minutes);
+    *p++ = ':';
+    p = put_2digits(p, seconds);
+    *p++ = '.';
+    *p++ = '0' + ms / 100;
+    p = put_2digits(p, ms % 100);
+    *p++ = ']';
+    *p++ = ' ';
+    return p - out;
+}
+
+size_t log_frame_chunk(char *out, size_t out_size, uint32_t ts_ms, const uint8_t *data, size_t len, size_t *copied)
+{
+    *copied = 0;
+    if (out_size < LOG_FRAME_PREFIX_MAX) {
+        return 0;
+    }
+    size_t n = log_frame_prefix(out, ts_ms);
+    size_t space = out_size - n - 2; // 保留换行符和终止符
+    size_t copy_len = (len <= space) ? len : space;
+    memcpy(out + n, data, copy_len);
+    n += copy_len;
+    out[n++] = '\n';
+    out[n] = '\0';
+    *copied = copy_len;
+    return n;
+}
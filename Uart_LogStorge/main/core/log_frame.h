@@ -0,0 +1,21 @@
+#ifndef __LOG_FRAME_H__
+#define __LOG_FRAME_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * uart_task 的数据块成帧：每次读到的数据前加 "[hh:mm:ss.mmm] " 时间戳，末尾补 '\n'。
+ * 手写数字格式化，避免在接收路径上调用 snprintf。
+ */
+
+#define LOG_FRAME_PREFIX_MAX 32 // 时间戳前缀、换行和结尾 '\0' 的预留空间
+
+// 格式化时间戳前缀，返回长度（小时不足两位补零，超过 99 小时按实际位数）
+size_t log_frame_prefix(char *out, uint32_t ts_ms);
+
+// 成帧到 out，返回帧长度（不含结尾 '\0'）；*copied 为实际放入的数据字节数，
+// 小于 len 表示 out 空间不足、数据被截断
+size_t log_frame_chunk(char *out, size_t out_size, uint32_t ts_ms, const uint8_t *data, size_t len, size_t *copied);
+
+#endif
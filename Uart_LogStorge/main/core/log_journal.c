@@ -0,0 +1,52 @@
+#include "log_journal.h"
+#include "log_crc.h"
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void log_journal_encode(const log_journal_rec_t *rec, uint8_t *buf)
+{
+    put_u32(&buf[0], LOG_JOURNAL_MAGIC);
+    put_u32(&buf[4], rec->seq);
+    put_u32(&buf[8], rec->file_index);
+    put_u32(&buf[12], rec->committed_len);
+    put_u32(&buf[16], log_crc32(0, buf, 16));
+}
+
+bool log_journal_decode(const uint8_t *buf, log_journal_rec_t *rec)
+{
+    if (get_u32(&buf[0]) != LOG_JOURNAL_MAGIC || get_u32(&buf[16]) != log_crc32(0, buf, 16)) {
+        return false;
+    }
+    rec->seq = get_u32(&buf[4]);
+    rec->file_index = get_u32(&buf[8]);
+    rec->committed_len = get_u32(&buf[12]);
+    return true;
+}
+
+int log_journal_latest(const uint8_t recs[][LOG_JOURNAL_REC_LEN], int n, log_journal_rec_t *rec)
+{
+    int best = -1;
+    for (int i = 0; i < n; i++) {
+        log_journal_rec_t r;
+        if (!log_journal_decode(recs[i], &r)) {
+            continue;
+        }
+        // seq 是回绕计数，用差值比较
+        if (best < 0 || (int32_t)(r.seq - rec->seq) > 0) {
+            *rec = r;
+            best = i;
+        }
+    }
+    return best;
+}
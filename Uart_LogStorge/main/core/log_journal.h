@@ -0,0 +1,37 @@
+#ifndef __LOG_JOURNAL_H__
+#define __LOG_JOURNAL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * TF 卡日志的提交记录：每次 fsync 检查点之后记下当前日志文件序号和已提交长度。
+ * 日志文件里放两个槽，各占一个扇区，按 seq 奇偶轮流写，写到一半断电只会损坏正在写的槽，
+ * 上电时取 CRC 正确且 seq 最新的一条，不需要扫描目录或检查整个文件系统。
+ */
+
+#define LOG_JOURNAL_MAGIC     0x4e524a4c // "LJRN"
+#define LOG_JOURNAL_SLOTS     2
+#define LOG_JOURNAL_SLOT_SIZE 512
+#define LOG_JOURNAL_REC_LEN   20         // [magic][seq][file_index][committed_len][crc32]，均为 u32 小端
+
+typedef struct {
+    uint32_t seq;
+    uint32_t file_index;     // tfcard_log_data_<n>.txt
+    uint32_t committed_len;  // 已经 fsync 的文件长度
+} log_journal_rec_t;
+
+void log_journal_encode(const log_journal_rec_t *rec, uint8_t *buf);
+bool log_journal_decode(const uint8_t *buf, log_journal_rec_t *rec);
+
+// 记录写入的槽号
+static inline uint32_t log_journal_slot(const log_journal_rec_t *rec)
+{
+    return rec->seq % LOG_JOURNAL_SLOTS;
+}
+
+// recs[i] 为第 i 个槽的原始内容，返回最新有效记录的槽号，没有有效记录返回 -1
+int log_journal_latest(const uint8_t recs[][LOG_JOURNAL_REC_LEN], int n, log_journal_rec_t *rec);
+
+#endif
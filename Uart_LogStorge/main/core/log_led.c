@@ -0,0 +1,53 @@
+#include "log_led.h"
+
+typedef struct {
+    uint8_t r, g, b;
+    uint16_t on_ms;         // 每个周期点亮的时长
+    uint16_t period_ms;
+} log_led_pattern_t;
+
+// 亮度与原来的常亮颜色一致（11/255），一个像素的亮度足够在外壳外看到
+static const log_led_pattern_t log_led_patterns[LOG_LED_NUM] = {
+    [LOG_LED_IDLE]     = {0, 11, 0, 200, 2400},  // 绿色慢闪
+    [LOG_LED_BLE]      = {0, 11, 11, 200, 2400}, // 青色慢闪
+    [LOG_LED_WRITING]  = {0, 0, 11, 200, 400},   // 蓝色快闪
+    [LOG_LED_OVERFLOW] = {11, 11, 0, 100, 200},  // 黄色急闪
+    [LOG_LED_CARD_ERR] = {11, 0, 11, 500, 1000}, // 品红慢闪
+    [LOG_LED_LOW_BAT]  = {11, 0, 0, 200, 600},   // 红色
+};
+
+log_led_state_t log_led_update(log_led_t *l, uint32_t now_ms)
+{
+    uint32_t events = __atomic_exchange_n(&l->events, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < LOG_LED_NUM; i++) {
+        if (events & (1u << i)) {
+            l->event_until[i] = now_ms + LOG_LED_EVENT_MS;
+            l->event_active |= 1u << i;
+        } else if ((l->event_active & (1u << i)) && (int32_t)(now_ms - l->event_until[i]) >= 0) {
+            l->event_active &= ~(1u << i);
+        }
+    }
+
+    uint32_t active = __atomic_load_n(&l->states, __ATOMIC_RELAXED) | l->event_active;
+    for (int i = LOG_LED_NUM - 1; i > LOG_LED_IDLE; i--) {
+        if (active & (1u << i)) {
+            return (log_led_state_t)i;
+        }
+    }
+    return LOG_LED_IDLE;
+}
+
+void log_led_render(log_led_state_t st, uint32_t now_ms, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    const log_led_pattern_t *p = &log_led_patterns[(st < LOG_LED_NUM) ? st : LOG_LED_IDLE];
+    bool on = (now_ms % p->period_ms) < p->on_ms;
+    *r = on ? p->r : 0;
+    *g = on ? p->g : 0;
+    *b = on ? p->b : 0;
+}
+
+const char *log_led_name(log_led_state_t st)
+{
+    static const char *const names[LOG_LED_NUM] = {"idle", "ble", "writing", "overflow", "card error", "low battery"};
+    return (st < LOG_LED_NUM) ? names[st] : "?";
+}
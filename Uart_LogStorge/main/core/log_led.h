@@ -0,0 +1,58 @@
+#ifndef __LOG_LED_H__
+#define __LOG_LED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 状态灯：各任务只用原子操作登记状态，不等待 LED。
+ *   - 持续状态（写卡、BLE 已连接、卡异常、电量低）由 log_led_set 置位/清除；
+ *   - 瞬时事件（溢出丢数据等）由 log_led_event 登记，之后显示 LOG_LED_EVENT_MS，期间再次发生则延长。
+ * LED 任务每 LOG_LED_FRAME_MS 调用一次 log_led_update 取优先级最高的状态（枚举值越大越优先），
+ * 再由 log_led_render 按该状态的闪烁图案算出当前帧的颜色。
+ * 不依赖 ESP-IDF，设备端和主机端共用；log_led_set/log_led_event 可在任意任务和中断中调用。
+ */
+
+#define LOG_LED_FRAME_MS 50
+#define LOG_LED_EVENT_MS 1000
+
+typedef enum {
+    LOG_LED_IDLE = 0,   // 空闲
+    LOG_LED_BLE,        // BLE 已连接
+    LOG_LED_WRITING,    // 正在写卡
+    LOG_LED_OVERFLOW,   // 缓冲区满丢数据（事件）
+    LOG_LED_CARD_ERR,   // 卡未挂载或写卡失败
+    LOG_LED_LOW_BAT,    // 电量低
+    LOG_LED_NUM,
+} log_led_state_t;
+
+typedef struct {
+    uint32_t states;                    // 持续状态位图
+    uint32_t events;                    // 还未被 LED 任务取走的事件位图
+    uint32_t event_until[LOG_LED_NUM];  // 事件显示截止时刻（回绕比较），只由 LED 任务访问
+    uint32_t event_active;              // 仍在显示的事件位图，只由 LED 任务访问
+} log_led_t;
+
+static inline void log_led_set(log_led_t *l, log_led_state_t st, bool on)
+{
+    if (on) {
+        __atomic_fetch_or(&l->states, 1u << st, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_and(&l->states, ~(1u << st), __ATOMIC_RELAXED);
+    }
+}
+
+static inline void log_led_event(log_led_t *l, log_led_state_t st)
+{
+    __atomic_fetch_or(&l->events, 1u << st, __ATOMIC_RELAXED);
+}
+
+// 取走新事件、结束到期的事件，返回当前应显示的状态
+log_led_state_t log_led_update(log_led_t *l, uint32_t now_ms);
+
+// 当前帧的颜色（0~255），图案的相位按 now_ms 计算
+void log_led_render(log_led_state_t st, uint32_t now_ms, uint8_t *r, uint8_t *g, uint8_t *b);
+
+const char *log_led_name(log_led_state_t st);
+
+#endif
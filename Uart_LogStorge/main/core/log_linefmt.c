@@ -0,0 +1,79 @@
+#include <string.h>
+#include "log_linefmt.h"
+
+// 按常见程度排列：工控设备多用 8E1/7E1
+const log_linefmt_t log_linefmt_candidates[LOG_LINEFMT_NUM_CANDIDATES] = {
+    {8, 'N', 1},
+    {8, 'E', 1},
+    {8, 'O', 1},
+    {7, 'E', 1},
+    {7, 'O', 1},
+    {7, 'N', 1},
+};
+
+void log_linefmt_reset(log_linefmt_score_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->score = LOG_LINEFMT_NO_SCORE;
+}
+
+void log_linefmt_feed(log_linefmt_score_t *s, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if ((c >= 0x20 && c < 0x7f) || c == '\t' || c == '\r' || c == '\n') {
+            s->printable++;
+        }
+    }
+    s->bytes += len;
+}
+
+void log_linefmt_errors(log_linefmt_score_t *s, uint32_t frame_err, uint32_t parity_err)
+{
+    s->frame_err += frame_err;
+    s->parity_err += parity_err;
+}
+
+int32_t log_linefmt_finish(log_linefmt_score_t *s)
+{
+    if (s->bytes < LOG_LINEFMT_MIN_BYTES) {
+        s->score = LOG_LINEFMT_NO_SCORE;
+    } else {
+        int64_t errors = (int64_t)s->frame_err + s->parity_err;
+        s->score = (int32_t)(((int64_t)s->printable - LOG_LINEFMT_ERR_WEIGHT * errors) * 1000 / s->bytes);
+    }
+    return s->score;
+}
+
+int log_linefmt_pick(const log_linefmt_score_t *s, int n, int32_t *margin)
+{
+    int best = -1;
+    int32_t second = LOG_LINEFMT_NO_SCORE;
+
+    for (int i = 0; i < n; i++) {
+        if (s[i].score == LOG_LINEFMT_NO_SCORE) {
+            continue;
+        }
+        if (best < 0 || s[i].score > s[best].score) {
+            if (best >= 0) {
+                second = s[best].score;
+            }
+            best = i;
+        } else if (s[i].score > second) {
+            second = s[i].score;
+        }
+    }
+    if (margin != NULL) {
+        *margin = (best >= 0 && second != LOG_LINEFMT_NO_SCORE) ? s[best].score - second : 0;
+    }
+    return best;
+}
+
+const char *log_linefmt_name(const log_linefmt_t *fmt, char *buf)
+{
+    buf[0] = '0' + fmt->data_bits;
+    buf[1] = fmt->parity;
+    buf[2] = '0' + fmt->stop_bits;
+    buf[3] = '\0';
+    return buf;
+}
@@ -0,0 +1,51 @@
+#ifndef __LOG_LINEFMT_H__
+#define __LOG_LINEFMT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 串口帧格式（数据位、校验）自动识别的评分部分：设备端按候选格式依次配置 UART、采样一段时间，
+ * 把收到的字节和驱动上报的帧错误/校验错误交给评分器，最后取得分最高的候选。
+ * 得分（千分比）= (可打印字符数 - LOG_LINEFMT_ERR_WEIGHT * 错误数) * 1000 / 字节数，
+ * 格式不对时要么出现大量帧错误/校验错误，要么数据位错位使高位置 1、可打印比例明显下降。
+ * 停止位无法从接收端区分：按 1 个停止位接收 2 个停止位的数据不会出错，因此候选都用 1 个停止位。
+ * 得分相同时取候选表中靠前的格式（更常见）。不依赖 ESP-IDF，设备端和主机端共用。
+ */
+
+#define LOG_LINEFMT_ERR_WEIGHT 4
+#define LOG_LINEFMT_MIN_BYTES  16              // 少于该字节数的样本不参与比较
+#define LOG_LINEFMT_NO_SCORE   (-1000000)
+
+typedef struct {
+    uint8_t data_bits;  // 5~8
+    char parity;        // 'N' / 'E' / 'O'
+    uint8_t stop_bits;  // 1 或 2
+} log_linefmt_t;
+
+#define LOG_LINEFMT_NUM_CANDIDATES 6
+extern const log_linefmt_t log_linefmt_candidates[LOG_LINEFMT_NUM_CANDIDATES];
+
+typedef struct {
+    uint32_t bytes;
+    uint32_t printable;     // 0x20~0x7e 和 \t \r \n
+    uint32_t frame_err;
+    uint32_t parity_err;
+    int32_t score;          // log_linefmt_finish 之后有效
+} log_linefmt_score_t;
+
+void log_linefmt_reset(log_linefmt_score_t *s);
+// 加入一段样本数据
+void log_linefmt_feed(log_linefmt_score_t *s, const uint8_t *data, size_t len);
+// 加入采样期间的错误数
+void log_linefmt_errors(log_linefmt_score_t *s, uint32_t frame_err, uint32_t parity_err);
+// 计算得分，样本不足时为 LOG_LINEFMT_NO_SCORE
+int32_t log_linefmt_finish(log_linefmt_score_t *s);
+
+// 在 n 个已计算得分的结果中选出最高分的下标，都没有得分时返回 -1；margin 不为 NULL 时返回与第二名的分差
+int log_linefmt_pick(const log_linefmt_score_t *s, int n, int32_t *margin);
+
+// "8E1" 形式的名称，buf 至少 4 字节
+const char *log_linefmt_name(const log_linefmt_t *fmt, char *buf);
+
+#endif
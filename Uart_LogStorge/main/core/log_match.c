@@ -0,0 +1,157 @@
+#include <string.h>
+#include <ctype.h>
+#include "log_match.h"
+
+#define LOG_MATCH_NO_EDGE 0xff
+
+void log_match_init(log_match_t *m, uint8_t flags)
+{
+    memset(m, 0, sizeof(*m));
+    // 类别 0 表示模式中未出现的字节
+    m->num_classes = 1;
+    m->num_states = 1;
+    memset(m->next, LOG_MATCH_NO_EDGE, sizeof(m->next));
+    if (flags & LOG_MATCH_FLAG_NOCASE) {
+        // 先把所有字母按小写折叠，类别在首次出现时分配
+        for (int c = 'A'; c <= 'Z'; c++) {
+            m->class_map[c] = LOG_MATCH_NO_EDGE;
+        }
+        for (int c = 'a'; c <= 'z'; c++) {
+            m->class_map[c] = LOG_MATCH_NO_EDGE;
+        }
+    }
+}
+
+static int log_match_class_of(log_match_t *m, uint8_t c)
+{
+    uint8_t cls = m->class_map[c];
+    if (cls != 0 && cls != LOG_MATCH_NO_EDGE) {
+        return cls;
+    }
+    if (m->num_classes >= LOG_MATCH_MAX_CLASSES) {
+        return -1;
+    }
+    cls = m->num_classes++;
+    if (m->class_map[c] == LOG_MATCH_NO_EDGE) {
+        m->class_map[tolower(c)] = cls;
+        m->class_map[toupper(c)] = cls;
+    } else {
+        m->class_map[c] = cls;
+    }
+    return cls;
+}
+
+int log_match_add(log_match_t *m, const char *pattern, size_t len)
+{
+    bool anchored = false;
+    if (len > 0 && pattern[0] == '^') {
+        anchored = true;
+        pattern++;
+        len--;
+    }
+    if (len == 0 || len > LOG_MATCH_PATTERN_MAX || m->num_patterns >= LOG_MATCH_MAX_PATTERNS) {
+        return -1;
+    }
+
+    // 先检查状态和类别容量，避免插入一半失败
+    uint8_t state = 0;
+    size_t depth = 0;
+    while (depth < len) {
+        uint8_t cls = m->class_map[(uint8_t)pattern[depth]];
+        if (cls == 0 || cls == LOG_MATCH_NO_EDGE || m->next[state][cls] == LOG_MATCH_NO_EDGE) {
+            break;
+        }
+        state = m->next[state][cls];
+        depth++;
+    }
+    if (m->num_states + (len - depth) > LOG_MATCH_MAX_STATES) {
+        return -1;
+    }
+    // 剩余部分需要新分配的类别数，折叠的字母按小写只计一次
+    uint8_t seen[256 / 8] = {0};
+    int new_classes = 0;
+    for (size_t i = depth; i < len; i++) {
+        uint8_t c = (uint8_t)pattern[i];
+        uint8_t cls = m->class_map[c];
+        if (cls != 0 && cls != LOG_MATCH_NO_EDGE) {
+            continue;
+        }
+        uint8_t key = (cls == LOG_MATCH_NO_EDGE) ? (uint8_t)tolower(c) : c;
+        if (!(seen[key >> 3] & (1u << (key & 7)))) {
+            seen[key >> 3] |= 1u << (key & 7);
+            new_classes++;
+        }
+    }
+    if (m->num_classes + new_classes > LOG_MATCH_MAX_CLASSES) {
+        return -1;
+    }
+
+    for (; depth < len; depth++) {
+        int cls = log_match_class_of(m, (uint8_t)pattern[depth]);
+        if (cls < 0) {
+            return -1;
+        }
+        if (m->next[state][cls] == LOG_MATCH_NO_EDGE) {
+            m->next[state][cls] = m->num_states++;
+        }
+        state = m->next[state][cls];
+    }
+
+    int id = m->num_patterns++;
+    m->out[state] |= 1 << id;
+    m->pattern_len[id] = len;
+    if (anchored) {
+        m->anchored |= 1 << id;
+    }
+    return id;
+}
+
+void log_match_compile(log_match_t *m)
+{
+    uint8_t queue[LOG_MATCH_MAX_STATES];
+    uint8_t fail_link[LOG_MATCH_MAX_STATES];
+    int head = 0, tail = 0;
+
+    // 未分配类别的折叠字母归入“其他”类
+    for (int c = 0; c < 256; c++) {
+        if (m->class_map[c] == LOG_MATCH_NO_EDGE) {
+            m->class_map[c] = 0;
+        }
+    }
+
+    // 根节点：缺失的边回到根
+    for (int cls = 0; cls < m->num_classes; cls++) {
+        uint8_t s = m->next[0][cls];
+        if (s == LOG_MATCH_NO_EDGE) {
+            m->next[0][cls] = 0;
+        } else {
+            fail_link[s] = 0;
+            queue[tail++] = s;
+        }
+    }
+
+    // BFS：缺失边直接指向失败状态的对应跳转，得到完整 DFA
+    while (head < tail) {
+        uint8_t s = queue[head++];
+        m->out[s] |= m->out[fail_link[s]];
+        for (int cls = 0; cls < m->num_classes; cls++) {
+            uint8_t t = m->next[s][cls];
+            if (t == LOG_MATCH_NO_EDGE) {
+                m->next[s][cls] = m->next[fail_link[s]][cls];
+            } else {
+                fail_link[t] = m->next[fail_link[s]][cls];
+                queue[tail++] = t;
+            }
+        }
+    }
+}
+
+uint8_t log_match_line(const log_match_t *m, const char *line, size_t len)
+{
+    uint8_t state = 0;
+    uint8_t hits = 0;
+    for (size_t i = 0; i < len; i++) {
+        hits |= log_match_step(m, &state, (uint8_t)line[i], i);
+    }
+    return hits;
+}
@@ -0,0 +1,55 @@
+#ifndef __LOG_MATCH_H__
+#define __LOG_MATCH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 多模式子串匹配器（Aho-Corasick），编译成按字节类别索引的完整 DFA，
+ * 扫描时每个字节只需一次查表。只依赖 C 标准库，设备端和主机端共用。
+ */
+
+#define LOG_MATCH_MAX_PATTERNS 8   // 命中结果用 8 位位图表示
+#define LOG_MATCH_MAX_STATES   64  // 所有模式总长度需小于该值
+#define LOG_MATCH_MAX_CLASSES  32  // 模式中不同字符数（含“其他”类）上限
+#define LOG_MATCH_PATTERN_MAX  32
+
+#define LOG_MATCH_FLAG_NOCASE  0x01 // 忽略 ASCII 大小写
+
+typedef struct {
+    uint8_t class_map[256];
+    uint8_t next[LOG_MATCH_MAX_STATES][LOG_MATCH_MAX_CLASSES];
+    uint8_t out[LOG_MATCH_MAX_STATES];     // 到达该状态时结束的模式位图
+    uint8_t pattern_len[LOG_MATCH_MAX_PATTERNS];
+    uint8_t anchored;                      // 只允许出现在行首的模式位图（模式以 '^' 开头）
+    uint8_t num_patterns;
+    uint8_t num_states;
+    uint8_t num_classes;
+} log_match_t;
+
+void log_match_init(log_match_t *m, uint8_t flags);
+// 添加一个模式，返回模式编号；模式为空、过长或超出状态/类别容量时返回 -1
+int log_match_add(log_match_t *m, const char *pattern, size_t len);
+// 添加完全部模式后调用，构建失败跳转并展开为 DFA
+void log_match_compile(log_match_t *m);
+
+// 推进一个字节，pos 为该字节在行内容中的位置（从 0 开始），返回在此结束的模式位图
+static inline uint8_t log_match_step(const log_match_t *m, uint8_t *state, uint8_t c, uint32_t pos)
+{
+    *state = m->next[*state][m->class_map[c]];
+    uint8_t hits = m->out[*state];
+    if (hits & m->anchored) {
+        for (int i = 0; i < m->num_patterns; i++) {
+            if ((m->anchored & (1 << i)) && m->pattern_len[i] != pos + 1) {
+                hits &= ~(1 << i);
+            }
+        }
+    }
+    return hits;
+}
+
+// 在一段完整的行内容上匹配，返回命中的模式位图
+uint8_t log_match_line(const log_match_t *m, const char *line, size_t len);
+
+#endif
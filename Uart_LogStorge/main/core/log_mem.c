@@ -0,0 +1,9 @@
+#include "log_mem.h"
+
+log_mem_entry_t log_mem[LOG_MEM_NUM];
+
+const char *log_mem_name(log_mem_id_t id)
+{
+    static const char *const names[LOG_MEM_NUM] = {"ble", "uart", "led", "tfcard", "sched"};
+    return (id < LOG_MEM_NUM) ? names[id] : "?";
+}
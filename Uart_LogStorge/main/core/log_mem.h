@@ -0,0 +1,36 @@
+#ifndef __LOG_MEM_H__
+#define __LOG_MEM_H__
+
+#include <stdint.h>
+
+/*
+ * 内存预算：采集管线的缓冲区都在编译期确定大小（静态数组），各模块初始化时登记自己的静态缓冲区；
+ * 初始化期间从堆上分配的部分（任务栈、队列、驱动和协议栈）由 app_main 按初始化前后的剩余堆计算，
+ * 启动完成后打印每个子系统的占用和剩余空间。运行期间不再按需分配，长时间运行不会产生堆碎片。
+ * 不依赖 ESP-IDF，设备端和主机端共用。
+ */
+
+typedef enum {
+    LOG_MEM_BLE = 0,
+    LOG_MEM_UART,
+    LOG_MEM_LED,
+    LOG_MEM_CARD,
+    LOG_MEM_SCHED,
+    LOG_MEM_NUM,
+} log_mem_id_t;
+
+typedef struct {
+    uint32_t static_bytes;  // 登记的静态缓冲区
+    uint32_t heap_bytes;    // 初始化期间的堆占用
+} log_mem_entry_t;
+
+extern log_mem_entry_t log_mem[LOG_MEM_NUM];
+
+static inline void log_mem_add_static(log_mem_id_t id, uint32_t bytes)
+{
+    log_mem[id].static_bytes += bytes;
+}
+
+const char *log_mem_name(log_mem_id_t id);
+
+#endif
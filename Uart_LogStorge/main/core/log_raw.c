@@ -0,0 +1,252 @@
+#include <string.h>
+#include "log_raw.h"
+#include "log_crc.h"
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t seg_lba(const log_raw_t *l, uint32_t idx)
+{
+    return l->first_lba + idx * l->seg_sectors;
+}
+
+static int raw_write(log_raw_t *l, uint32_t lba, const void *buf, uint32_t count)
+{
+    if (l->dev.write(l->dev.ctx, lba, buf, count) != 0) {
+        l->errors++;
+        return LOG_RAW_ERR_IO;
+    }
+    return 0;
+}
+
+static int raw_write_hdr(log_raw_t *l)
+{
+    uint8_t *p = l->sector;
+    memset(p, 0, LOG_RAW_SECTOR);
+    put_u32(&p[0], LOG_RAW_SEG_MAGIC);
+    put_u32(&p[4], l->cur.seq);
+    put_u32(&p[8], l->cur.flags);
+    put_u32(&p[12], l->cur.len);
+    put_u32(&p[16], l->cur.crc);
+    put_u32(&p[20], (uint32_t)l->cur.time);
+    put_u32(&p[24], (uint32_t)(l->cur.time >> 32));
+    put_u32(&p[28], l->cur.session);
+    put_u32(&p[32], l->volume);
+    put_u32(&p[36], log_crc32(0, p, 36));
+    return raw_write(l, seg_lba(l, l->seg), p, 1);
+}
+
+int log_raw_read_seg(log_raw_t *l, uint32_t idx, log_raw_seg_t *seg)
+{
+    const uint8_t *p = l->sector;
+    if (l->dev.read(l->dev.ctx, seg_lba(l, idx), l->sector, 1) != 0) {
+        return LOG_RAW_ERR_IO;
+    }
+    if (get_u32(&p[0]) != LOG_RAW_SEG_MAGIC || get_u32(&p[36]) != log_crc32(0, p, 36) ||
+        get_u32(&p[32]) != l->volume) {
+        return 1;
+    }
+    seg->seq = get_u32(&p[4]);
+    seg->flags = get_u32(&p[8]);
+    seg->len = get_u32(&p[12]);
+    seg->crc = get_u32(&p[16]);
+    seg->time = get_u32(&p[20]) | ((uint64_t)get_u32(&p[24]) << 32);
+    seg->session = get_u32(&p[28]);
+    seg->volume = get_u32(&p[32]);
+    return 0;
+}
+
+int log_raw_format(log_raw_t *l, const log_raw_dev_t *dev, uint32_t seg_sectors, uint32_t volume)
+{
+    uint8_t *p = l->sector;
+    // 第 0 段按段大小对齐，LBA 0 到 first_lba 之间只放超级块
+    if (seg_sectors < 2 || dev->sectors < 3 * seg_sectors) {
+        return LOG_RAW_ERR_NOFS;
+    }
+    memset(p, 0, LOG_RAW_SECTOR);
+    put_u32(&p[0], LOG_RAW_SB_MAGIC);
+    put_u32(&p[4], LOG_RAW_VERSION);
+    put_u32(&p[8], seg_sectors);
+    put_u32(&p[12], dev->sectors / seg_sectors - 1);
+    put_u32(&p[16], seg_sectors);
+    put_u32(&p[20], volume);
+    put_u32(&p[24], log_crc32(0, p, 24));
+    l->dev = *dev;
+    if (raw_write(l, 0, p, 1) != 0) {
+        return LOG_RAW_ERR_IO;
+    }
+    return log_raw_mount(l, dev);
+}
+
+// 当前一圈的段：有效且 seq 与第 0 段连续
+static int raw_in_lap(log_raw_t *l, uint32_t idx, uint32_t seq0, bool *in_lap)
+{
+    log_raw_seg_t seg;
+    int ret = log_raw_read_seg(l, idx, &seg);
+    if (ret < 0) {
+        return ret;
+    }
+    *in_lap = (ret == 0 && seg.seq == seq0 + idx);
+    return 0;
+}
+
+int log_raw_mount(log_raw_t *l, const log_raw_dev_t *dev)
+{
+    const uint8_t *p = l->sector;
+    log_raw_seg_t head;
+    uint32_t head_idx;
+    int ret;
+
+    l->dev = *dev;
+    if (dev->read(dev->ctx, 0, l->sector, 1) != 0) {
+        return LOG_RAW_ERR_IO;
+    }
+    if (get_u32(&p[0]) != LOG_RAW_SB_MAGIC || get_u32(&p[24]) != log_crc32(0, p, 24) ||
+        get_u32(&p[4]) != LOG_RAW_VERSION) {
+        return LOG_RAW_ERR_NOFS;
+    }
+    l->seg_sectors = get_u32(&p[8]);
+    l->seg_count = get_u32(&p[12]);
+    l->first_lba = get_u32(&p[16]);
+    l->volume = get_u32(&p[20]);
+    if (l->seg_sectors < 2 || l->seg_count < 2 ||
+        (uint64_t)l->first_lba + (uint64_t)l->seg_count * l->seg_sectors > dev->sectors) {
+        return LOG_RAW_ERR_NOFS;
+    }
+
+    ret = log_raw_read_seg(l, 0, &head);
+    if (ret < 0) {
+        return ret;
+    }
+    if (ret == 0) {
+        // 不变式：[0, lo] 属于当前一圈，[hi, seg_count) 不属于
+        uint32_t seq0 = head.seq, lo = 0, hi = l->seg_count;
+        while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            bool in_lap;
+            if ((ret = raw_in_lap(l, mid, seq0, &in_lap)) < 0) {
+                return ret;
+            }
+            if (in_lap) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        head_idx = lo;
+        ret = log_raw_read_seg(l, head_idx, &head);
+    } else {
+        // 第 0 段的段头刚好在回绕时写坏，最新的是最后一段
+        head_idx = l->seg_count - 1;
+        ret = log_raw_read_seg(l, head_idx, &head);
+    }
+    if (ret < 0) {
+        return ret;
+    }
+
+    l->empty = (ret != 0);
+    if (l->empty) {
+        memset(&head, 0, sizeof(head));
+        head_idx = l->seg_count - 1; // 下一段为第 0 段
+    }
+    l->cur = head;
+    l->seg = head_idx;
+    l->committed = head.len;
+    l->tail_len = 0;
+    l->errors = 0;
+    return 0;
+}
+
+// 进入下一段并写入长度为 0 的段头，让这一段上一圈的内容失效
+static int raw_next_seg(log_raw_t *l, uint32_t flags, uint64_t time)
+{
+    l->seg = (l->seg + 1) % l->seg_count;
+    l->cur.seq++;
+    l->cur.flags = flags;
+    l->cur.len = 0;
+    l->cur.crc = 0;
+    l->cur.time = time;
+    l->committed = 0;
+    l->tail_len = 0;
+    l->empty = false;
+    return raw_write_hdr(l);
+}
+
+int log_raw_begin(log_raw_t *l, uint64_t time)
+{
+    l->cur.session++;
+    return raw_next_seg(l, LOG_RAW_FLAG_SESSION, time);
+}
+
+int log_raw_append(log_raw_t *l, const void *data, size_t len, uint64_t time)
+{
+    const uint8_t *p = data;
+
+    while (len > 0) {
+        if (l->cur.len == log_raw_seg_payload(l)) {
+            if (log_raw_commit(l) != 0 || raw_next_seg(l, 0, time) != 0) {
+                return LOG_RAW_ERR_IO;
+            }
+        }
+        uint32_t room = log_raw_seg_payload(l) - l->cur.len;
+        uint32_t n = (len < room) ? len : room;
+        uint32_t lba = seg_lba(l, l->seg) + 1 + l->cur.len / LOG_RAW_SECTOR;
+
+        if (l->tail_len > 0 || n < LOG_RAW_SECTOR) {
+            // 先补满未满的扇区
+            if (n > LOG_RAW_SECTOR - l->tail_len) {
+                n = LOG_RAW_SECTOR - l->tail_len;
+            }
+            memcpy(l->tail + l->tail_len, p, n);
+            if (l->tail_len + n == LOG_RAW_SECTOR) {
+                if (raw_write(l, lba, l->tail, 1) != 0) {
+                    return LOG_RAW_ERR_IO;
+                }
+                l->tail_len = 0;
+            } else {
+                l->tail_len += n;
+            }
+        } else {
+            // 整扇区直接从调用方的缓冲区写出
+            n &= ~(uint32_t)(LOG_RAW_SECTOR - 1);
+            if (raw_write(l, lba, p, n / LOG_RAW_SECTOR) != 0) {
+                return LOG_RAW_ERR_IO;
+            }
+        }
+        l->cur.crc = log_crc32(l->cur.crc, p, n);
+        l->cur.len += n;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int log_raw_commit(log_raw_t *l)
+{
+    if (l->cur.len == l->committed) {
+        return 0;
+    }
+    if (l->tail_len > 0) {
+        // 扇区剩余部分补 0，补满后会整扇区重写
+        memset(l->tail + l->tail_len, 0, LOG_RAW_SECTOR - l->tail_len);
+        uint32_t lba = seg_lba(l, l->seg) + 1 + l->cur.len / LOG_RAW_SECTOR;
+        if (raw_write(l, lba, l->tail, 1) != 0) {
+            return LOG_RAW_ERR_IO;
+        }
+    }
+    if (raw_write_hdr(l) != 0) {
+        return LOG_RAW_ERR_IO;
+    }
+    l->committed = l->cur.len;
+    return 0;
+}
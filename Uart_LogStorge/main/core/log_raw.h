@@ -0,0 +1,91 @@
+#ifndef __LOG_RAW_H__
+#define __LOG_RAW_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * TF 卡裸扇区循环日志（CONFIG_TFCARD_STORAGE_RAW）：不经过 FAT，数据按固定大小的段顺序写入扇区，
+ * 写到卡尾后回到第一段覆盖最旧的数据。没有 FAT/目录项更新，每次提交只多写一个段头扇区。
+ *
+ * 卡布局：LBA 0 为超级块，记录段大小、段数和卷标识；第 0 段从 first_lba 开始。
+ * 每段第一个扇区为段头 [magic][seq][flags][len][data_crc][time_lo][time_hi][session][volume][hdr_crc]，
+ * 均为 u32 小端，其余扇区为数据。seq 每段加一，段头在开始写一段时写一次（len 为 0，
+ * 使这一段上一圈的旧内容失效），之后每次提交时先写数据扇区再重写段头，断电只丢最后一次提交之后的数据。
+ *
+ * 上电恢复：当前一圈的段满足 seq(i) == seq(0) + i，之后的段是上一圈的（seq 更小）或从未写过，
+ * 对这个单调条件二分查找最新的段，只需读 log2(段数) 个段头。
+ * 导出时从最新段的下一段（最旧的数据）开始顺序读出，见 pytest/rawlog_export.py。
+ * 不依赖 ESP-IDF，扇区读写通过回调注入，主机端用 mock_sd 的扇区接口测试。
+ */
+
+#define LOG_RAW_SECTOR      512
+#define LOG_RAW_SB_MAGIC    0x4253524c // "LRSB"
+#define LOG_RAW_SEG_MAGIC   0x4745534c // "LSEG"
+#define LOG_RAW_VERSION     1
+#define LOG_RAW_SB_LEN      28         // [magic][version][seg_sectors][seg_count][first_lba][volume][crc32]
+#define LOG_RAW_HDR_LEN     40
+#define LOG_RAW_FLAG_SESSION 0x1       // 一次挂载/上电后的第一段
+
+#define LOG_RAW_ERR_IO   -1
+#define LOG_RAW_ERR_NOFS -2            // 没有超级块，或与卡容量不符
+
+typedef struct {
+    int (*read)(void *ctx, uint32_t lba, void *buf, uint32_t count);
+    int (*write)(void *ctx, uint32_t lba, const void *buf, uint32_t count);
+    void *ctx;
+    uint32_t sectors;   // 卡的扇区数
+} log_raw_dev_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t flags;
+    uint32_t len;       // 已提交的数据字节数
+    uint32_t crc;       // 已提交数据的 CRC-32
+    uint32_t session;
+    uint32_t volume;
+    uint64_t time;      // 开始写这一段的时刻，由调用方定义（设备端为 esp_timer 微秒）
+} log_raw_seg_t;
+
+typedef struct {
+    log_raw_dev_t dev;
+    uint32_t seg_sectors;
+    uint32_t seg_count;
+    uint32_t first_lba;
+    uint32_t volume;
+    bool empty;         // 卡上还没有任何段
+
+    log_raw_seg_t cur;  // 当前段，len/crc 包含未提交的数据
+    uint32_t seg;       // 当前段号
+    uint32_t committed; // 段头中记录的长度
+    uint32_t tail_len;  // tail 中未满一个扇区的数据
+    uint32_t errors;
+    uint8_t tail[LOG_RAW_SECTOR];
+    uint8_t sector[LOG_RAW_SECTOR]; // 段头/超级块编码缓冲
+} log_raw_t;
+
+static inline uint32_t log_raw_seg_payload(const log_raw_t *l)
+{
+    return (l->seg_sectors - 1) * LOG_RAW_SECTOR;
+}
+
+// 写超级块，卡上原有内容（包括 FAT）全部作废；seg_sectors 至少为 2，volume 用于区分不同的格式化
+int log_raw_format(log_raw_t *l, const log_raw_dev_t *dev, uint32_t seg_sectors, uint32_t volume);
+
+// 读超级块并查找最新的段，返回 0、LOG_RAW_ERR_NOFS 或 LOG_RAW_ERR_IO
+int log_raw_mount(log_raw_t *l, const log_raw_dev_t *dev);
+
+// 在最新段之后开始新的一段（带 LOG_RAW_FLAG_SESSION），每次挂载后调用一次
+int log_raw_begin(log_raw_t *l, uint64_t time);
+
+// 追加数据，写满一段时自动提交并进入下一段；出错时返回 LOG_RAW_ERR_IO，本次数据中未写入的部分丢弃
+int log_raw_append(log_raw_t *l, const void *data, size_t len, uint64_t time);
+
+// 写出未满一个扇区的数据并重写段头，之后断电不会丢失已追加的数据
+int log_raw_commit(log_raw_t *l);
+
+// 读第 idx 段的段头：0 为有效，1 为无效或属于其他卷，LOG_RAW_ERR_IO 为读失败
+int log_raw_read_seg(log_raw_t *l, uint32_t idx, log_raw_seg_t *seg);
+
+#endif
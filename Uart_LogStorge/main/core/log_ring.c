@@ -0,0 +1,70 @@
+#include <string.h>
+#include "log_ring.h"
+
+bool log_ring_init(log_ring_t *r, uint8_t *buf, uint32_t size)
+{
+    if (size == 0 || (size & (size - 1)) != 0) {
+        return false;
+    }
+    r->buf = buf;
+    r->size = size;
+    r->head = 0;
+    r->tail = 0;
+    return true;
+}
+
+// 只能在生产者和消费者都停止时调用
+void log_ring_reset(log_ring_t *r)
+{
+    r->head = 0;
+    r->tail = 0;
+}
+
+bool log_ring_write(log_ring_t *r, const void *data, uint32_t len)
+{
+    uint32_t head = r->head;
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if (r->size - (head - tail) < len) {
+        return false;
+    }
+    uint32_t pos = head & (r->size - 1);
+    uint32_t first = (len < r->size - pos) ? len : r->size - pos;
+    memcpy(r->buf + pos, data, first);
+    memcpy(r->buf, (const uint8_t *)data + first, len - first);
+    __atomic_store_n(&r->head, head + len, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t log_ring_peek(const log_ring_t *r, const uint8_t **data)
+{
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = r->tail;
+    uint32_t pos = tail & (r->size - 1);
+    uint32_t avail = head - tail;
+    *data = r->buf + pos;
+    return (avail < r->size - pos) ? avail : r->size - pos;
+}
+
+void log_ring_consume(log_ring_t *r, uint32_t len)
+{
+    __atomic_store_n(&r->tail, r->tail + len, __ATOMIC_RELEASE);
+}
+
+uint32_t log_ring_read(log_ring_t *r, void *out, uint32_t max)
+{
+    uint32_t total = 0;
+    while (total < max) {
+        const uint8_t *p;
+        uint32_t n = log_ring_peek(r, &p);
+        if (n == 0) {
+            break;
+        }
+        if (n > max - total) {
+            n = max - total;
+        }
+        memcpy((uint8_t *)out + total, p, n);
+        log_ring_consume(r, n);
+        total += n;
+    }
+    return total;
+}
@@ -0,0 +1,44 @@
+#ifndef __LOG_RING_H__
+#define __LOG_RING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 单生产者/单消费者字节环形缓冲区，不依赖 FreeRTOS，主机端管线与设备端共用。
+ * head/tail 为累计字节数（回绕的 32 位计数），分别只由生产者/消费者修改，
+ * 两侧无需加锁；语义与 RINGBUF_TYPE_BYTEBUF 一致，写入要么全部成功要么不写。
+ */
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;   // 容量，须为 2 的幂
+    uint32_t head;   // 已写入字节数，生产者独占
+    uint32_t tail;   // 已读出字节数，消费者独占
+} log_ring_t;
+
+// size 不是 2 的幂时返回 false
+bool log_ring_init(log_ring_t *r, uint8_t *buf, uint32_t size);
+void log_ring_reset(log_ring_t *r);
+
+static inline uint32_t log_ring_used(const log_ring_t *r)
+{
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+static inline uint32_t log_ring_free(const log_ring_t *r)
+{
+    return r->size - log_ring_used(r);
+}
+
+// 生产者：空间不足时不写入并返回 false
+bool log_ring_write(log_ring_t *r, const void *data, uint32_t len);
+
+// 消费者：取得从读位置开始的连续可读区域（不跨越缓冲区末尾），返回长度
+uint32_t log_ring_peek(const log_ring_t *r, const uint8_t **data);
+void log_ring_consume(log_ring_t *r, uint32_t len);
+// 消费者：最多读出 max 字节，返回实际字节数
+uint32_t log_ring_read(log_ring_t *r, void *out, uint32_t max);
+
+#endif
@@ -0,0 +1,53 @@
+#include "log_rxsize.h"
+
+void log_rxsize_init(log_rxsize_t *r, uint16_t min_len, uint16_t max_len, uint16_t min_tmo_ms, uint16_t max_tmo_ms,
+                     uint16_t target_ms, uint32_t now_ms)
+{
+    r->min_len = min_len;
+    r->max_len = max_len;
+    r->min_tmo_ms = min_tmo_ms;
+    r->max_tmo_ms = max_tmo_ms;
+    r->target_ms = target_ms;
+    r->len = min_len;
+    r->tmo_ms = min_tmo_ms;
+    r->win_start_ms = now_ms;
+    r->win_bytes = 0;
+    r->rate = 0;
+    r->changes = 0;
+}
+
+bool log_rxsize_update(log_rxsize_t *r, size_t got, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - r->win_start_ms;
+
+    r->win_bytes += got;
+    if (elapsed < LOG_RXSIZE_WINDOW_MS) {
+        return false;
+    }
+    r->rate = (uint32_t)((uint64_t)r->win_bytes * 1000 / elapsed);
+    r->win_start_ms = now_ms;
+    r->win_bytes = 0;
+
+    uint32_t want = (uint32_t)((uint64_t)r->rate * r->target_ms / 1000);
+    uint16_t len = r->len;
+    while (len < r->max_len && want > len) {
+        len *= 2;
+    }
+    while (len > r->min_len && want < len / 4) {
+        len /= 2;
+    }
+
+    uint32_t tmo = r->min_tmo_ms;
+    if (want >= r->min_len) {
+        tmo = (uint32_t)((uint64_t)len * 1000 / r->rate);
+        tmo = (tmo < r->min_tmo_ms) ? r->min_tmo_ms : (tmo > r->max_tmo_ms) ? r->max_tmo_ms : tmo;
+    }
+
+    if (len == r->len && tmo == r->tmo_ms) {
+        return false;
+    }
+    r->len = len;
+    r->tmo_ms = (uint16_t)tmo;
+    r->changes++;
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef __LOG_RXSIZE_H__
+#define __LOG_RXSIZE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * uart_task 单次读取长度和超时的自适应：按 LOG_RXSIZE_WINDOW_MS 窗口统计接收速率，
+ * 读取长度取能装下 target_ms 数据量的 2 的幂（min_len~max_len），流量大时每块更大，
+ * 摊薄每块的成帧、时间戳、入队和加锁开销；读取超时取按当前速率装满一块的时间（min_tmo~max_tmo），
+ * 最小一块都装不满 target_ms 的稀疏流量下取 min_tmo，数据到达后尽快成帧，时间戳更贴近实际时刻。
+ * 增大只要超过当前长度，减小要低于当前长度的 1/4，避免在两档之间来回切换。
+ * 不依赖 ESP-IDF，设备端和主机端共用。
+ */
+
+#define LOG_RXSIZE_WINDOW_MS 100
+
+typedef struct {
+    uint16_t min_len, max_len;
+    uint16_t min_tmo_ms, max_tmo_ms;
+    uint16_t target_ms;
+
+    uint16_t len;           // 当前读取长度
+    uint16_t tmo_ms;        // 当前读取超时
+
+    uint32_t win_start_ms;
+    uint32_t win_bytes;
+    uint32_t rate;          // 最近一个窗口的速率，字节/秒
+    uint32_t changes;       // 调整次数
+} log_rxsize_t;
+
+// min_len/max_len 须为 2 的幂
+void log_rxsize_init(log_rxsize_t *r, uint16_t min_len, uint16_t max_len, uint16_t min_tmo_ms, uint16_t max_tmo_ms,
+                     uint16_t target_ms, uint32_t now_ms);
+
+// 每次读取返回后调用（got 可以为 0），窗口结束时重新计算，返回 true 表示 len/tmo_ms 有变化
+bool log_rxsize_update(log_rxsize_t *r, size_t got, uint32_t now_ms);
+
+#endif
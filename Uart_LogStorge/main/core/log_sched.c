@@ -0,0 +1,102 @@
+#include <string.h>
+#include "log_sched.h"
+
+void log_sched_init(log_sched_t *s, uint32_t now_ms)
+{
+    memset(s, 0, sizeof(*s));
+    s->win_start_ms = now_ms;
+}
+
+log_sched_task_t *log_sched_get(log_sched_t *s, uint32_t id, const char *name)
+{
+    for (int i = 0; i < s->num; i++) {
+        if (s->tasks[i].id == id) {
+            s->tasks[i].seen = true;
+            return &s->tasks[i];
+        }
+    }
+    if (s->num >= LOG_SCHED_MAX_TASKS) {
+        return NULL;
+    }
+    log_sched_task_t *t = &s->tasks[s->num++];
+    memset(t, 0, sizeof(*t));
+    t->id = id;
+    strncpy(t->name, name, LOG_SCHED_NAME_LEN);
+    t->seen = true;
+    return t;
+}
+
+void log_sched_window(log_sched_t *s, uint32_t total_run, uint32_t now_ms)
+{
+    // 计数器为 32 位，回绕后按无符号差值计算，窗口长度远小于回绕周期
+    uint32_t total = total_run - s->total_prev;
+    int n = 0;
+
+    for (int i = 0; i < s->num; i++) {
+        log_sched_task_t *t = &s->tasks[i];
+        if (!t->seen) {
+            continue; // 任务已删除
+        }
+        if (t->valid && s->total_valid && total > 0) {
+            uint64_t load = (uint64_t)(t->run_time - t->run_prev) * 1000 / total;
+            t->load = (load > 1000) ? 1000 : (uint16_t)load;
+        } else {
+            t->load = 0;
+        }
+        t->run_prev = t->run_time;
+        t->valid = true;
+        t->seen = false;
+        s->tasks[n++] = *t;
+    }
+    s->num = n;
+    s->total_prev = total_run;
+    s->total_valid = true;
+    s->window_ms = now_ms - s->win_start_ms;
+    s->win_start_ms = now_ms;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+size_t log_sched_report(const log_sched_t *s, uint8_t *buf, size_t size)
+{
+    if (size < LOG_SCHED_REPORT_MAX) {
+        return 0;
+    }
+    memset(buf, 0, LOG_SCHED_HDR_SIZE);
+    buf[0] = LOG_SCHED_VERSION;
+    buf[1] = s->num;
+    buf[2] = s->total;
+    put_u32(&buf[4], s->window_ms);
+    put_u32(&buf[8], s->samples);
+
+    uint8_t *p = &buf[LOG_SCHED_HDR_SIZE];
+    for (int i = 0; i < s->num; i++, p += LOG_SCHED_ENTRY_SIZE) {
+        const log_sched_task_t *t = &s->tasks[i];
+        memset(p, 0, LOG_SCHED_ENTRY_SIZE);
+        memcpy(p, t->name, LOG_SCHED_NAME_LEN);
+        p[LOG_SCHED_NAME_LEN] = t->prio;
+        p[LOG_SCHED_NAME_LEN + 1] = t->state;
+        put_u16(&p[LOG_SCHED_NAME_LEN + 2], t->stack_free);
+        put_u16(&p[LOG_SCHED_NAME_LEN + 4], t->load);
+        put_u32(&p[LOG_SCHED_NAME_LEN + 8], t->preempt);
+    }
+    return p - buf;
+}
+
+const char *log_sched_state_name(uint8_t state)
+{
+    static const char *const names[] = {"run", "ready", "blocked", "susp", "deleted"};
+    return (state < sizeof(names) / sizeof(names[0])) ? names[state] : "?";
+}
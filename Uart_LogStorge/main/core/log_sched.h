@@ -0,0 +1,82 @@
+#ifndef __LOG_SCHED_H__
+#define __LOG_SCHED_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 任务调度统计：采样任务周期性读取 FreeRTOS 任务状态，按任务编号累计
+ *   - CPU 占用：每个窗口结束时按运行时间计数器的增量计算，千分比；
+ *   - 栈高水位：历史最小剩余栈（字节）；
+ *   - 抢占次数：采样时刻处于就绪态但没有在运行（CPU 被更高或同优先级任务占用）的次数，
+ *     采样时刻正在运行的任务由 tick 钩子记录，不计入。
+ * 报告按任务编号顺序序列化，多字节字段均为小端：
+ *   [version u8][num u8][total u8][reserved u8][window_ms u32][samples u32]
+ *   { [name 12][prio u8][state u8][stack_free u16][load_permille u16][reserved u16][preempt u32] } x num
+ * total 为实际任务数，超过 LOG_SCHED_MAX_TASKS 的任务不在报告中。
+ * 不依赖 ESP-IDF，设备端和主机端共用；所有函数只能由采样任务调用。
+ */
+
+#define LOG_SCHED_VERSION    1
+#define LOG_SCHED_MAX_TASKS  20
+#define LOG_SCHED_NAME_LEN   12
+#define LOG_SCHED_HDR_SIZE   12
+#define LOG_SCHED_ENTRY_SIZE (LOG_SCHED_NAME_LEN + 12)
+#define LOG_SCHED_REPORT_MAX (LOG_SCHED_HDR_SIZE + LOG_SCHED_MAX_TASKS * LOG_SCHED_ENTRY_SIZE)
+
+// 任务状态，与 FreeRTOS eTaskState 的取值一致
+#define LOG_SCHED_STATE_RUNNING   0
+#define LOG_SCHED_STATE_READY     1
+#define LOG_SCHED_STATE_BLOCKED   2
+#define LOG_SCHED_STATE_SUSPENDED 3
+#define LOG_SCHED_STATE_DELETED   4
+
+typedef struct {
+    uint32_t id;            // FreeRTOS 任务编号，任务删除后不会复用
+    char name[LOG_SCHED_NAME_LEN];
+    uint8_t prio;
+    uint8_t state;
+    uint16_t stack_free;    // 栈高水位，剩余字节
+    uint16_t load;          // 上一个窗口的 CPU 占用，千分比
+    uint32_t preempt;       // 累计抢占次数
+    uint32_t run_time;      // 运行时间计数器，调用方在窗口结束前更新
+    uint32_t run_prev;      // 上一个窗口结束时的计数
+    bool seen;              // 本窗口内出现过
+    bool valid;             // run_prev 有效
+} log_sched_task_t;
+
+typedef struct {
+    log_sched_task_t tasks[LOG_SCHED_MAX_TASKS];
+    uint8_t num;
+    uint8_t total;          // 最近一次采样时的任务数
+    uint32_t samples;       // 累计采样次数
+    uint32_t window_ms;     // 上一个窗口的长度
+    uint32_t total_prev;    // 上一个窗口结束时的总运行时间计数
+    uint32_t win_start_ms;
+    bool total_valid;
+} log_sched_t;
+
+void log_sched_init(log_sched_t *s, uint32_t now_ms);
+
+// 按任务编号查找，不存在时新建；表满时返回 NULL。返回的记录标记为本窗口出现过
+log_sched_task_t *log_sched_get(log_sched_t *s, uint32_t id, const char *name);
+
+// 一次采样：state 为采样时刻的状态，running 为 tick 钩子记录的正在运行的任务
+static inline void log_sched_note(log_sched_task_t *t, uint8_t state, bool running)
+{
+    t->state = state;
+    if (state == LOG_SCHED_STATE_READY && !running) {
+        t->preempt++;
+    }
+}
+
+// 窗口结束：按各任务的 run_time 和总计数 total_run 计算占用，删除本窗口内没有出现的任务
+void log_sched_window(log_sched_t *s, uint32_t total_run, uint32_t now_ms);
+
+// 序列化报告，buf 至少 LOG_SCHED_REPORT_MAX 字节，返回长度
+size_t log_sched_report(const log_sched_t *s, uint8_t *buf, size_t size);
+
+const char *log_sched_state_name(uint8_t state);
+
+#endif
@@ -0,0 +1,352 @@
+#include <string.h>
+#include "log_search.h"
+
+#define PREFIX_START   0 // 行首，期待 '['
+#define PREFIX_INSIDE  1 // 方括号内的数字、':'、'.'
+#define PREFIX_CLOSE   2 // 读到 ']'，期待空格
+#define PREFIX_DONE    3
+#define PREFIX_MAX_LEN 24
+
+#define LOG_INDEX_SHIFT_INIT 14 // 16 KB
+
+void log_index_reset(log_index_t *index)
+{
+    memset(index, 0, sizeof(*index));
+    index->granule = LOG_INDEX_GRANULE;
+}
+
+static uint32_t index_shift(const log_index_t *x)
+{
+    uint32_t shift = LOG_INDEX_SHIFT_INIT;
+    while ((1u << shift) < x->granule) {
+        shift++;
+    }
+    return shift;
+}
+
+// 索引满时两两合并，粒度翻倍
+static void index_merge(log_index_t *x)
+{
+    for (int i = 0; i < LOG_INDEX_MAX_ENTRIES / 2; i++) {
+        int a = 2 * i, b = 2 * i + 1;
+        x->min_ts[i] = (x->min_ts[a] < x->min_ts[b]) ? x->min_ts[a] : x->min_ts[b];
+        x->max_ts[i] = (x->max_ts[a] > x->max_ts[b]) ? x->max_ts[a] : x->max_ts[b];
+        x->tail_ts[i] = x->tail_ts[b];
+        x->first_line[i] = (x->first_line[a] != LOG_SEARCH_TS_NONE) ? x->first_line[a] : x->first_line[b];
+    }
+    x->count = LOG_INDEX_MAX_ENTRIES / 2;
+    x->granule *= 2;
+}
+
+static void index_push(log_search_t *s)
+{
+    log_index_t *x = s->index;
+    x->min_ts[x->count] = s->acc_min;
+    x->max_ts[x->count] = s->acc_max;
+    x->tail_ts[x->count] = s->acc_tail;
+    x->first_line[x->count] = s->acc_first;
+    x->count++;
+    if (x->count == LOG_INDEX_MAX_ENTRIES) {
+        index_merge(x);
+    }
+    s->acc_min = LOG_SEARCH_TS_NONE;
+    s->acc_max = 0;
+    s->acc_first = LOG_SEARCH_TS_NONE;
+}
+
+// 把一行计入索引；只有刚好接在已索引区域之后的分块才会累加
+static void index_line(log_search_t *s, uint32_t off, uint32_t ts)
+{
+    log_index_t *x = s->index;
+    if (x == NULL) {
+        return;
+    }
+    if ((off >> index_shift(x)) < x->count) {
+        return;
+    }
+    while ((off >> index_shift(x)) > x->count) {
+        index_push(s);
+    }
+    if (s->acc_first == LOG_SEARCH_TS_NONE) {
+        s->acc_first = off;
+    }
+    if (ts != LOG_SEARCH_TS_NONE) {
+        if (ts < s->acc_min) {
+            s->acc_min = ts;
+        }
+        if (ts > s->acc_max) {
+            s->acc_max = ts;
+        }
+    }
+    s->acc_tail = ts;
+}
+
+static bool index_intersects(const log_search_t *s, int g)
+{
+    return s->index->min_ts[g] <= s->t_end && s->index->max_ts[g] >= s->t_start;
+}
+
+static bool has_time_range(const log_search_t *s)
+{
+    return s->t_start != 0 || s->t_end != LOG_SEARCH_TS_NONE;
+}
+
+static bool ts_in_range(const log_search_t *s, uint32_t ts)
+{
+    if (!has_time_range(s)) {
+        return true;
+    }
+    return ts != LOG_SEARCH_TS_NONE && ts >= s->t_start && ts <= s->t_end;
+}
+
+// 新的一行从 off 开始：若所在分块及其后若干分块与时间范围无交集，返回可以续读的偏移
+static uint32_t index_skip_target(log_search_t *s, uint32_t off)
+{
+    log_index_t *x = s->index;
+    if (x == NULL || !has_time_range(s) || off < s->next_check) {
+        return off;
+    }
+    uint32_t shift = index_shift(x);
+    int g = off >> shift;
+    s->next_check = (uint32_t)(g + 1) << shift;
+    if (g + 1 >= x->count || index_intersects(s, g)) {
+        return off;
+    }
+
+    // 最后一个已索引分块留作续读点，保证其后的未索引区域是连续扫描的
+    int h = g;
+    while (h < x->count - 1 && !index_intersects(s, h)) {
+        h++;
+    }
+    while (h > g && x->first_line[h] == LOG_SEARCH_TS_NONE) {
+        h--;
+    }
+    if (h == g || x->first_line[h] <= off) {
+        return off;
+    }
+    s->cur_ts = x->tail_ts[h - 1];
+    s->acc_tail = s->cur_ts;
+    s->next_check = (uint32_t)(h + 1) << shift;
+    return x->first_line[h];
+}
+
+size_t log_search_parse_ts(const char *line, size_t len, uint32_t *ts_ms)
+{
+    // [%02ld:%02ld:%02ld.%03ld]，小时位数不固定
+    uint32_t field[4] = {0};
+    int idx = 0;
+    int digits = 0;
+    size_t i;
+
+    if (len < 2 || line[0] != '[') {
+        return 0;
+    }
+    for (i = 1; i < len && line[i] != ']'; i++) {
+        char c = line[i];
+        if (c >= '0' && c <= '9') {
+            field[idx] = field[idx] * 10 + (c - '0');
+            digits++;
+        } else if ((c == ':' && idx < 2) || (c == '.' && idx == 2)) {
+            if (digits == 0) {
+                return 0;
+            }
+            idx++;
+            digits = 0;
+        } else {
+            return 0;
+        }
+    }
+    if (i >= len || idx != 3 || digits == 0) {
+        return 0;
+    }
+    *ts_ms = ((field[0] * 60 + field[1]) * 60 + field[2]) * 1000 + field[3];
+    i++;
+    if (i < len && line[i] == ' ') {
+        i++;
+    }
+    return i;
+}
+
+void log_search_init(log_search_t *s, const log_match_t *match, uint32_t t_start, uint32_t t_end,
+                     log_index_t *index, log_search_cb_t cb, void *cb_ctx)
+{
+    memset(s, 0, sizeof(*s));
+    s->match = (match != NULL && match->num_patterns > 0) ? match : NULL;
+    s->t_start = t_start;
+    s->t_end = t_end;
+    s->index = index;
+    s->cb = cb;
+    s->cb_ctx = cb_ctx;
+    s->cur_ts = LOG_SEARCH_TS_NONE;
+    s->acc_min = LOG_SEARCH_TS_NONE;
+    s->acc_first = LOG_SEARCH_TS_NONE;
+    s->acc_tail = LOG_SEARCH_TS_NONE;
+}
+
+static void line_put(log_search_t *s, const uint8_t *data, size_t n)
+{
+    if (s->line_len + n > LOG_SEARCH_LINE_MAX) {
+        n = LOG_SEARCH_LINE_MAX - s->line_len;
+    }
+    memcpy(s->line + s->line_len, data, n);
+    s->line_len += n;
+}
+
+// 前缀识别完成（或确认没有前缀）后，决定本行是否需要继续匹配
+static void line_content_start(log_search_t *s, size_t content_off)
+{
+    s->prefix_state = PREFIX_DONE;
+    s->skip_line = !ts_in_range(s, s->cur_ts);
+    s->content_pos = 0;
+    if (s->skip_line || s->match == NULL) {
+        return;
+    }
+    // 补匹配前缀识别期间已缓存的内容字节
+    for (size_t k = content_off; k < s->line_len; k++) {
+        s->hits |= log_match_step(s->match, &s->state, (uint8_t)s->line[k], s->content_pos++);
+    }
+}
+
+static uint32_t line_end(log_search_t *s, uint32_t next_off)
+{
+    if (s->prefix_state != PREFIX_DONE) {
+        line_content_start(s, 0);
+    }
+    index_line(s, s->line_off, s->cur_ts);
+
+    size_t len = s->line_len;
+    if (len > 0 && s->line[len - 1] == '\r') {
+        len--;
+    }
+    if (!s->skip_line && len > 0 && (s->match == NULL || s->hits)) {
+        s->lines_matched++;
+        if (s->cb != NULL && !s->cb(s->cb_ctx, s->line_off, s->cur_ts, s->line, len)) {
+            s->stop = true;
+        }
+    }
+
+    s->line_off = next_off;
+    s->line_len = 0;
+    s->hits = 0;
+    s->state = 0;
+    s->prefix_state = PREFIX_START;
+    s->skip_line = false;
+    return index_skip_target(s, next_off);
+}
+
+static void prefix_step(log_search_t *s, uint8_t c)
+{
+    bool ok = false;
+    switch (s->prefix_state) {
+    case PREFIX_START:
+        ok = (c == '[');
+        if (ok) {
+            s->prefix_state = PREFIX_INSIDE;
+        }
+        break;
+    case PREFIX_INSIDE:
+        ok = (c >= '0' && c <= '9') || c == ':' || c == '.' || c == ']';
+        if (c == ']') {
+            s->prefix_state = PREFIX_CLOSE;
+        }
+        break;
+    case PREFIX_CLOSE: {
+        uint32_t ts;
+        size_t prefix_len = log_search_parse_ts(s->line, s->line_len, &ts);
+        if (c == ' ' && prefix_len == s->line_len) {
+            s->cur_ts = ts;
+            line_content_start(s, prefix_len);
+            return;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    if (!ok || s->line_len > PREFIX_MAX_LEN) {
+        line_content_start(s, 0);
+    }
+}
+
+uint32_t log_search_feed(log_search_t *s, uint32_t offset, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    // 扫描刚开始或刚跳块时，当前位置就是行首
+    if (s->line_len == 0 && s->prefix_state == PREFIX_START && offset == s->line_off) {
+        uint32_t target = index_skip_target(s, offset);
+        if (target != offset) {
+            s->bytes_skipped += target - offset;
+            s->line_off = target;
+            return target;
+        }
+    }
+
+    while (i < len && !s->stop) {
+        if (s->prefix_state != PREFIX_DONE) {
+            uint8_t c = data[i++];
+            if (c == '\n') {
+                uint32_t target = line_end(s, offset + i);
+                if (target != offset + i) {
+                    s->bytes_scanned += i;
+                    s->bytes_skipped += target - (offset + i);
+                    s->line_off = target;
+                    return target;
+                }
+                continue;
+            }
+            line_put(s, &c, 1);
+            prefix_step(s, c);
+            continue;
+        }
+
+        // 时间不在范围内或已经命中：不再逐字节匹配，直接找换行
+        if (s->skip_line || s->match == NULL || s->hits) {
+            const uint8_t *nl = memchr(data + i, '\n', len - i);
+            size_t stop = (nl != NULL) ? (size_t)(nl - data) : len;
+            if (!s->skip_line) {
+                line_put(s, data + i, stop - i);
+            }
+            i = stop;
+            if (nl == NULL) {
+                break;
+            }
+        } else {
+            while (i < len && data[i] != '\n') {
+                uint8_t c = data[i++];
+                if (s->line_len < LOG_SEARCH_LINE_MAX) {
+                    s->line[s->line_len++] = c;
+                }
+                s->hits |= log_match_step(s->match, &s->state, c, s->content_pos++);
+                if (s->hits) {
+                    break;
+                }
+            }
+            if (i >= len || data[i] != '\n') {
+                continue;
+            }
+        }
+
+        i++; // 跳过 '\n'
+        uint32_t target = line_end(s, offset + i);
+        if (target != offset + i) {
+            s->bytes_scanned += i;
+            s->bytes_skipped += target - (offset + i);
+            s->line_off = target;
+            return target;
+        }
+    }
+    s->bytes_scanned += i;
+    return offset + len;
+}
+
+void log_search_finish(log_search_t *s)
+{
+    if (s->line_len > 0 && !s->stop) {
+        // 最后一行没有换行结尾，不计入索引（文件可能还会继续追加）
+        log_index_t *index = s->index;
+        s->index = NULL;
+        line_end(s, s->line_off + s->line_len);
+        s->index = index;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef __LOG_SEARCH_H__
+#define __LOG_SEARCH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "log_match.h"
+
+/*
+ * 对已存储的日志做逐行检索：解析 uart_task 写入的 "[hh:mm:ss.mmm] " 时间戳前缀，
+ * 按时间范围和 log_match 模式筛选整行。不做任何 IO，由调用方分块喂数据。
+ */
+
+#define LOG_SEARCH_LINE_MAX   1100 // uart_task 单次最多 1024 字节数据加时间戳
+#define LOG_SEARCH_TS_NONE    0xffffffff
+#define LOG_INDEX_MAX_ENTRIES 128
+#define LOG_INDEX_GRANULE     (16 * 1024) // 初始索引粒度，索引满后成倍合并
+
+// 会话内的时间索引：记录每个分块内起始行的时间戳范围，后续按时间查询时可整块跳过
+typedef struct {
+    uint32_t granule;
+    uint16_t count;                            // 已完成的分块数，覆盖 [0, count * granule)
+    uint32_t min_ts[LOG_INDEX_MAX_ENTRIES];
+    uint32_t max_ts[LOG_INDEX_MAX_ENTRIES];
+    uint32_t tail_ts[LOG_INDEX_MAX_ENTRIES];   // 分块结束时生效的时间戳，跳块后用于续接无前缀的行
+    uint32_t first_line[LOG_INDEX_MAX_ENTRIES]; // 分块内第一个行首的文件偏移，跳块后从这里续读
+} log_index_t;
+
+// 命中行回调：offset 为行首在文件中的偏移，line 可能因超长被截断
+typedef bool (*log_search_cb_t)(void *ctx, uint32_t offset, uint32_t ts, const char *line, size_t len);
+
+typedef struct {
+    const log_match_t *match;      // 为 NULL 或没有模式时只按时间筛选
+    uint32_t t_start;
+    uint32_t t_end;
+    log_index_t *index;            // 可为 NULL
+    log_search_cb_t cb;
+    void *cb_ctx;
+
+    // 行状态
+    uint32_t line_off;
+    uint32_t content_pos;
+    uint32_t cur_ts;
+    uint8_t state;
+    uint8_t hits;
+    uint8_t prefix_state;
+    bool skip_line;                // 本行时间不在范围内
+    bool stop;
+    size_t line_len;
+    char line[LOG_SEARCH_LINE_MAX];
+
+    // 索引累加器
+    uint32_t next_check;
+    uint32_t acc_min;
+    uint32_t acc_max;
+    uint32_t acc_tail;
+    uint32_t acc_first;
+
+    // 统计
+    uint32_t lines_matched;
+    uint32_t bytes_scanned;
+    uint32_t bytes_skipped;
+} log_search_t;
+
+void log_index_reset(log_index_t *index);
+
+void log_search_init(log_search_t *s, const log_match_t *match, uint32_t t_start, uint32_t t_end,
+                     log_index_t *index, log_search_cb_t cb, void *cb_ctx);
+// 喂入从 offset 开始的一段数据，返回下一次应当读取的文件偏移：
+// 通常是 offset + len，命中索引可跳过的分块时会更大，调用方需从返回值处继续读
+uint32_t log_search_feed(log_search_t *s, uint32_t offset, const uint8_t *data, size_t len);
+// 文件结束时调用，处理最后一行（无换行结尾）
+void log_search_finish(log_search_t *s);
+
+// 解析 "[h:mm:ss.mmm]" 形式的时间戳，成功返回前缀长度（含结尾空格），失败返回 0
+size_t log_search_parse_ts(const char *line, size_t len, uint32_t *ts_ms);
+
+#endif
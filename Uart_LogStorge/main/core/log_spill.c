@@ -0,0 +1,88 @@
+#include "log_spill.h"
+
+bool log_spill_init(log_spill_t *s, const log_spill_flash_t *flash)
+{
+    uint32_t size = flash->size;
+    while (size & (size - 1)) {
+        size &= size - 1; // 保留最高位，计数回绕时物理地址仍然连续
+    }
+    if (flash->sector_size == 0 || (flash->sector_size & (flash->sector_size - 1)) != 0 ||
+        size < 2 * flash->sector_size) {
+        return false;
+    }
+    s->flash = *flash;
+    s->size = size;
+    s->capacity = size - flash->sector_size;
+    s->head = 0;
+    s->tail = 0;
+    s->erased = 0;
+    s->hwm = 0;
+    s->errors = 0;
+    s->failed = false;
+    return true;
+}
+
+// 擦除到能容纳 [head, end) 为止；容量限制保证被擦除的扇区里没有未读数据
+static bool spill_erase_to(log_spill_t *s, uint32_t end)
+{
+    while ((int32_t)(end - s->erased) > 0) {
+        uint32_t addr = s->erased & (s->size - 1);
+        if (s->flash.erase(s->flash.ctx, addr, s->flash.sector_size) != 0) {
+            return false;
+        }
+        s->erased += s->flash.sector_size;
+    }
+    return true;
+}
+
+bool log_spill_write(log_spill_t *s, const void *data, uint32_t len)
+{
+    uint32_t head = s->head;
+    uint32_t tail = __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE);
+    if (s->failed || s->capacity - (head - tail) < len) {
+        return false;
+    }
+    if (!spill_erase_to(s, head + len)) {
+        s->errors++;
+        s->failed = true;
+        return false;
+    }
+
+    uint32_t pos = head & (s->size - 1);
+    uint32_t first = (len < s->size - pos) ? len : s->size - pos;
+    if (s->flash.write(s->flash.ctx, pos, data, first) != 0 ||
+        (len > first && s->flash.write(s->flash.ctx, 0, (const uint8_t *)data + first, len - first) != 0)) {
+        // 写了一半的区域已不再是擦除状态，不能再从这里继续写
+        s->errors++;
+        s->failed = true;
+        return false;
+    }
+    __atomic_store_n(&s->head, head + len, __ATOMIC_RELEASE);
+    if (head + len - tail > s->hwm) {
+        s->hwm = head + len - tail;
+    }
+    return true;
+}
+
+uint32_t log_spill_read(log_spill_t *s, void *out, uint32_t max)
+{
+    uint32_t head = __atomic_load_n(&s->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = s->tail;
+    uint32_t len = head - tail;
+    if (len > max) {
+        len = max;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    uint32_t pos = tail & (s->size - 1);
+    uint32_t first = (len < s->size - pos) ? len : s->size - pos;
+    if (s->flash.read(s->flash.ctx, pos, out, first) != 0 ||
+        (len > first && s->flash.read(s->flash.ctx, 0, (uint8_t *)out + first, len - first) != 0)) {
+        s->errors++;
+        return 0;
+    }
+    __atomic_store_n(&s->tail, tail + len, __ATOMIC_RELEASE);
+    return len;
+}
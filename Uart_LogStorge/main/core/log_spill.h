@@ -0,0 +1,51 @@
+#ifndef __LOG_SPILL_H__
+#define __LOG_SPILL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * 片内 Flash 溢出缓冲：TF 卡写入卡顿、RAM 环形缓冲区超过水位时，新数据先写到专用分区，
+ * 卡恢复后按顺序读回写卡。分区按扇区循环使用（单生产者/单消费者 FIFO，语义同 log_ring），
+ * 写指针只向前推进，每个扇区被擦写的次数相同，不需要额外的磨损均衡层。
+ * 擦除在写指针进入新扇区时进行，始终留一个扇区的间隔，保证擦除不会碰到未读数据。
+ * 不依赖 ESP-IDF，Flash 操作通过回调注入，主机端用 mock_flash 测试。
+ */
+
+typedef struct {
+    int (*read)(void *ctx, uint32_t addr, void *buf, size_t len);
+    int (*write)(void *ctx, uint32_t addr, const void *buf, size_t len);
+    int (*erase)(void *ctx, uint32_t addr, size_t len); // addr/len 按扇区对齐
+    void *ctx;
+    uint32_t size;        // 分区大小，按 2 的幂向下取整使用
+    uint32_t sector_size; // 擦除单位，2 的幂
+} log_spill_flash_t;
+
+typedef struct {
+    log_spill_flash_t flash;
+    uint32_t size;       // 实际使用的大小
+    uint32_t capacity;   // 最多缓存的字节数：size - sector_size
+    uint32_t head;       // 已写入字节数，生产者独占
+    uint32_t tail;       // 已读出字节数，消费者独占
+    uint32_t erased;     // 已擦除区域的上界（累计字节数），生产者独占
+    uint32_t hwm;
+    uint32_t errors;
+    bool failed;         // Flash 写入/擦除出错后不再使用
+} log_spill_t;
+
+// 分区太小（不足两个扇区）时返回 false
+bool log_spill_init(log_spill_t *s, const log_spill_flash_t *flash);
+
+static inline uint32_t log_spill_used(const log_spill_t *s)
+{
+    return __atomic_load_n(&s->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE);
+}
+
+// 生产者：写入全部数据返回 true；空间不足或 Flash 出错时不写入并返回 false
+bool log_spill_write(log_spill_t *s, const void *data, uint32_t len);
+
+// 消费者：按写入顺序最多读出 max 字节，返回实际字节数，读出错时返回 0
+uint32_t log_spill_read(log_spill_t *s, void *out, uint32_t max);
+
+#endif
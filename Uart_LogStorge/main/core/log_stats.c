@@ -0,0 +1,27 @@
+#include "log_stats.h"
+
+log_stats_t log_stats;
+
+size_t log_stats_snapshot(const log_stats_t *s, uint8_t flags, uint8_t *buf, size_t size)
+{
+    const size_t count = sizeof(log_stats_t) / sizeof(uint32_t);
+    if (size < LOG_STATS_SNAPSHOT_MAX) {
+        return 0;
+    }
+
+    buf[0] = LOG_STATS_VERSION;
+    buf[1] = flags;
+    buf[2] = count;
+    buf[3] = LOG_HIST_BINS;
+    // 逐字段拷贝，保证每个字段本身读取是完整的
+    const volatile uint32_t *field = (const volatile uint32_t *)s;
+    uint8_t *p = buf + 4;
+    for (size_t i = 0; i < count; i++, p += 4) {
+        uint32_t v = field[i];
+        p[0] = v & 0xff;
+        p[1] = (v >> 8) & 0xff;
+        p[2] = (v >> 16) & 0xff;
+        p[3] = v >> 24;
+    }
+    return p - buf;
+}
@@ -0,0 +1,120 @@
+#ifndef __LOG_STATS_H__
+#define __LOG_STATS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 采集链路的运行统计。每个计数器只由一个任务写入（注释中标明），
+ * 其他任务直接读取，32 位对齐字段的读写是原子的，不需要加锁。
+ * 结构体只包含 uint32_t，快照按字段顺序以小端序列化，新字段只能追加在末尾。
+ */
+
+#define LOG_STATS_VERSION 1
+
+// 延迟直方图：bin 0 为 < 256 us，之后每个 bin 翻倍，最后一个 bin 收纳所有更长的值
+#define LOG_HIST_BINS       16
+#define LOG_HIST_BASE_SHIFT 8
+
+// 快照头部标志
+#define LOG_STATS_FLAG_CARD_MOUNTED  0x01
+#define LOG_STATS_FLAG_BLE_CONNECTED 0x02
+#define LOG_STATS_FLAG_BLE_FILTER    0x04
+
+typedef struct {
+    uint32_t uptime_ms;
+
+    // uart_task
+    uint32_t uart_rx_bytes;
+    uint32_t uart_rx_chunks;
+    uint32_t uart_baud;
+    uint32_t uart_fifo_ovf;
+    uint32_t uart_buf_full;
+    uint32_t uart_frame_err;
+    uint32_t uart_parity_err;
+
+    // tfcard：进入缓冲区一侧由 uart_task 写，落卡一侧由 tfcard_task 写
+    uint32_t card_in_bytes;
+    uint32_t card_drop_bytes;       // 未挂载时丢弃
+    uint32_t card_written_bytes;
+    uint32_t card_write_errors;
+    uint32_t card_fail_bytes;       // 写卡失败丢失
+    uint32_t card_ring_hwm;
+    uint32_t card_ring_size;
+
+    // BLE 实时流：进入缓冲区一侧由 uart_task 写，发送一侧由 ble_tx_task 写
+    uint32_t ble_in_bytes;
+    uint32_t ble_drop_bytes;        // 被实时流过滤器丢弃
+    uint32_t ble_notified_bytes;    // 各客户端合计
+    uint32_t ble_notify_errors;
+    uint32_t ble_ring_hwm;          // 最慢的客户端落后的最大字节数
+    uint32_t ble_ring_size;
+
+    uint32_t battery_mv;            // 电池检测未启用时为 0
+
+    uint32_t card_write_lat[LOG_HIST_BINS]; // s_write_file 耗时（us）
+
+    // tfcard 日志模式（CONFIG_TFCARD_JOURNAL_ENABLE）
+    uint32_t card_syncs;            // 检查点中 fsync 的次数
+    uint32_t card_recovered_bytes;  // 上电恢复时补回目录项的文件长度
+
+    // 空闲省电（CONFIG_LOG_POWER_SAVE），uart_task
+    uint32_t uart_wakeups;          // 被串口唤醒后开始接收的次数
+    uint32_t uart_wake_err;         // 唤醒后 20 ms 内的帧错误/校验错误
+
+    // tfcard_task：卡热插拔
+    uint32_t card_mounts;           // 挂载成功次数（含启动时）
+    uint32_t card_removals;         // 写卡失败后确认卡已拔出的次数
+
+    // 片内 Flash 溢出分区（CONFIG_TFCARD_SPILL_ENABLE），uart_task
+    uint32_t card_spill_bytes;      // 经溢出分区写卡的字节数
+    uint32_t card_spill_hwm;        // 溢出分区最高占用
+
+    // tfcard_task：SD SPI 时钟
+    uint32_t card_clk_khz;          // 当前实际时钟
+    uint32_t card_clk_steps;        // 因连续写失败降档的次数
+
+    // 触发式采集（CONFIG_LOG_TRIGGER_ENABLE），uart_task
+    uint32_t trig_captures;         // 触发次数
+    uint32_t trig_promoted_bytes;   // 触发窗口内写卡的字节数
+    uint32_t trig_skipped_bytes;    // 窗口外未写卡的字节数
+
+    // 重复行折叠（CONFIG_LOG_DEDUP_ENABLE），uart_task
+    uint32_t dedup_lines;           // 被折叠的行数
+    uint32_t dedup_bytes;           // 被折叠的字节数（写卡和 BLE 都节省了这些数据）
+
+    // uart_task：BREAK（RX 持续低电平超过一帧），二进制抓包模式下另有事件记录
+    uint32_t uart_break;
+    uint32_t cap_events;            // 二进制抓包模式写入的事件记录数
+
+    // uart_task：自适应读取（log_rxsize.h）的当前设置
+    uint32_t uart_read_len;
+    uint32_t uart_read_tmo_ms;
+    uint32_t uart_rx_rate;          // 最近 100 ms 的接收速率，字节/秒
+
+    // BLE 多连接（CONFIG_BLE_MAX_CLIENTS）：连接数由 BTC 任务写，跳过的字节数由 ble_tx_task 写
+    uint32_t ble_clients;           // 当前连接数
+    uint32_t ble_lag_bytes;         // 客户端落后超过缓冲区而跳过的字节数（各客户端合计）
+} log_stats_t;
+
+extern log_stats_t log_stats;
+
+static inline void log_hist_add(uint32_t *bins, uint32_t us)
+{
+    uint32_t v = us >> LOG_HIST_BASE_SHIFT;
+    int b = (v == 0) ? 0 : 32 - __builtin_clz(v);
+    bins[(b < LOG_HIST_BINS) ? b : LOG_HIST_BINS - 1]++;
+}
+
+static inline void log_stats_update_hwm(uint32_t *hwm, uint32_t used)
+{
+    if (used > *hwm) {
+        *hwm = used;
+    }
+}
+
+// 快照格式：[version u8][flags u8][field_count u8][hist_bins u8][field u32 x field_count]，返回长度
+#define LOG_STATS_SNAPSHOT_MAX (4 + sizeof(log_stats_t))
+size_t log_stats_snapshot(const log_stats_t *s, uint8_t flags, uint8_t *buf, size_t size);
+
+#endif
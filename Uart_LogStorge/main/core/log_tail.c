@@ -0,0 +1,88 @@
+#include <string.h>
+#include "log_tail.h"
+
+bool log_tail_init(log_tail_t *t, uint8_t *buf, uint32_t size)
+{
+    memset(t->rd, 0, sizeof(t->rd));
+    return log_ring_init(&t->ring, buf, size);
+}
+
+void log_tail_write(log_tail_t *t, const void *data, uint32_t len)
+{
+    log_ring_t *r = &t->ring;
+
+    if (len > r->size) {
+        // 只保留最后一段，前面的部分视为写入后立即被覆盖
+        uint32_t skip = len - r->size;
+        data = (const uint8_t *)data + skip;
+        len = r->size;
+        r->head += skip;
+        r->tail = r->head;
+    }
+    uint32_t room = log_ring_free(r);
+    if (room < len) {
+        log_ring_consume(r, len - room);
+    }
+    log_ring_write(r, data, len);
+}
+
+void log_tail_open(log_tail_t *t, int id)
+{
+    t->rd[id].active = true;
+    t->rd[id].cursor = t->ring.head;
+    t->rd[id].lost = 0;
+}
+
+void log_tail_close(log_tail_t *t, int id)
+{
+    t->rd[id].active = false;
+}
+
+// 读者落后超过容量时跳到最旧的保留数据
+static void tail_catch_up(log_tail_t *t, log_tail_reader_t *rd)
+{
+    if ((int32_t)(t->ring.tail - rd->cursor) > 0) {
+        rd->lost += t->ring.tail - rd->cursor;
+        rd->cursor = t->ring.tail;
+    }
+}
+
+uint32_t log_tail_avail(const log_tail_t *t, int id)
+{
+    const log_tail_reader_t *rd = &t->rd[id];
+    uint32_t from = ((int32_t)(t->ring.tail - rd->cursor) > 0) ? t->ring.tail : rd->cursor;
+    return rd->active ? t->ring.head - from : 0;
+}
+
+uint32_t log_tail_read(log_tail_t *t, int id, void *out, uint32_t max)
+{
+    log_tail_reader_t *rd = &t->rd[id];
+    const log_ring_t *r = &t->ring;
+
+    if (!rd->active) {
+        return 0;
+    }
+    tail_catch_up(t, rd);
+    uint32_t n = r->head - rd->cursor;
+    if (n > max) {
+        n = max;
+    }
+    uint32_t pos = rd->cursor & (r->size - 1);
+    uint32_t first = (n < r->size - pos) ? n : r->size - pos;
+    memcpy(out, r->buf + pos, first);
+    memcpy((uint8_t *)out + first, r->buf, n - first);
+    rd->cursor += n;
+    return n;
+}
+
+uint32_t log_tail_max_lag(const log_tail_t *t)
+{
+    uint32_t lag = 0;
+    for (int i = 0; i < LOG_TAIL_MAX_READERS; i++) {
+        uint32_t n = log_tail_avail(t, i);
+        if (n > lag) {
+            lag = n;
+        }
+    }
+    return lag;
+}
@@ -0,0 +1,60 @@
+#ifndef __LOG_TAIL_H__
+#define __LOG_TAIL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "log_ring.h"
+
+/*
+ * 一写多读的实时流缓冲区：数据只写一份，每个读者有自己的读位置，多个 BLE 客户端同时跟踪同一日志流。
+ * 存储复用 log_ring，ring.head 为累计写入字节数，ring.tail 为环中仍保留的最旧数据；
+ * 写入从不等待读者，空间不足时丢弃最旧的数据，落后超过容量的读者下次读取时跳到最旧的保留数据，
+ * 跳过的字节计入该读者的 lost，最慢的读者不会拖慢写入方和其他读者。
+ * 新打开的读者从当前写位置开始，只收到之后写入的数据。
+ * 不依赖 ESP-IDF，设备端和主机端共用；所有函数由调用方加锁串行调用。
+ */
+
+#define LOG_TAIL_MAX_READERS 4
+
+typedef struct {
+    bool active;
+    uint32_t cursor;    // 已读出的累计字节数
+    uint32_t lost;      // 被覆盖而跳过的字节数
+} log_tail_reader_t;
+
+typedef struct {
+    log_ring_t ring;
+    log_tail_reader_t rd[LOG_TAIL_MAX_READERS];
+} log_tail_t;
+
+// size 须为 2 的幂，否则返回 false
+bool log_tail_init(log_tail_t *t, uint8_t *buf, uint32_t size);
+
+// 写入一段数据；超过容量时只保留最后 size 字节，但累计偏移按全部长度推进
+void log_tail_write(log_tail_t *t, const void *data, uint32_t len);
+
+// 打开/关闭编号为 id 的读者（0..LOG_TAIL_MAX_READERS-1），id 由调用方分配
+void log_tail_open(log_tail_t *t, int id);
+void log_tail_close(log_tail_t *t, int id);
+
+// 读者可读的字节数（已被覆盖的部分不计）
+uint32_t log_tail_avail(const log_tail_t *t, int id);
+// 最多读出 max 字节，返回实际字节数
+uint32_t log_tail_read(log_tail_t *t, int id, void *out, uint32_t max);
+
+// 最慢的活动读者落后的字节数（不超过容量），没有读者时为 0
+uint32_t log_tail_max_lag(const log_tail_t *t);
+
+// 写入方的累计偏移，用于关联延迟标记
+static inline uint32_t log_tail_head(const log_tail_t *t)
+{
+    return t->ring.head;
+}
+
+static inline uint32_t log_tail_cursor(const log_tail_t *t, int id)
+{
+    return t->rd[id].cursor;
+}
+
+#endif
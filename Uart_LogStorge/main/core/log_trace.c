@@ -0,0 +1,76 @@
+#include <string.h>
+#include "log_trace.h"
+
+#ifndef ESP_PLATFORM
+#include <time.h>
+
+// 主机端没有统一的周期计数器，用纳秒单调时钟代替
+uint32_t log_trace_host_cycles(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+#endif
+
+log_trace_buf_t log_trace_bufs[LOG_TRACE_CH_NUM];
+log_lat_probe_t log_lat[LOG_LAT_NUM];
+uint32_t log_trace_origin_us;
+
+void log_lat_mark(log_lat_probe_t *p, uint32_t off, uint32_t t_us)
+{
+    uint32_t tail = __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE);
+    if (p->head - tail >= LOG_LAT_MARKS) {
+        p->overflow++;
+        return;
+    }
+    uint32_t i = p->head % LOG_LAT_MARKS;
+    p->off[i] = off;
+    p->t_us[i] = t_us;
+    __atomic_store_n(&p->head, p->head + 1, __ATOMIC_RELEASE);
+}
+
+void log_lat_done(log_lat_probe_t *p, uint32_t off, uint32_t now_us)
+{
+    uint32_t head = __atomic_load_n(&p->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = p->tail;
+    // 偏移是回绕的 32 位计数，用差值比较
+    while (tail != head && (int32_t)(off - p->off[tail % LOG_LAT_MARKS]) >= 0) {
+        log_hist_add(p->hist, now_us - p->t_us[tail % LOG_LAT_MARKS]);
+        tail++;
+    }
+    __atomic_store_n(&p->tail, tail, __ATOMIC_RELEASE);
+}
+
+size_t log_trace_copy(const log_trace_buf_t *buf, log_trace_event_t *out, size_t max, uint32_t *first_seq)
+{
+    uint32_t head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+    uint32_t n = (head < LOG_TRACE_EVENTS) ? head : LOG_TRACE_EVENTS;
+    if (n > max) {
+        n = max;
+    }
+    uint32_t first = head - n;
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = buf->ev[(first + i) & (LOG_TRACE_EVENTS - 1)];
+    }
+
+    // 复制期间被写入者覆盖的事件丢掉
+    uint32_t head2 = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+    uint32_t valid_from = (head2 > LOG_TRACE_EVENTS) ? head2 - LOG_TRACE_EVENTS : 0;
+    size_t skip = 0;
+    if (valid_from > first) {
+        skip = (valid_from - first < n) ? valid_from - first : n;
+        memmove(out, out + skip, (n - skip) * sizeof(*out));
+    }
+    *first_seq = first + skip;
+    return n - skip;
+}
+
+void log_trace_reset(void)
+{
+    // 只清直方图，事件环和未完成的标记保留，避免与写入者竞争
+    for (int i = 0; i < LOG_LAT_NUM; i++) {
+        memset(log_lat[i].hist, 0, sizeof(log_lat[i].hist));
+        log_lat[i].overflow = 0;
+    }
+}
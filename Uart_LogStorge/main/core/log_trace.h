@@ -0,0 +1,120 @@
+#ifndef __LOG_TRACE_H__
+#define __LOG_TRACE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "log_stats.h"
+
+/*
+ * 热路径跟踪：每个任务一条无锁事件环（单写者），事件时间戳取 CPU 周期计数；
+ * 另外按字节偏移关联 UART 接收时刻与落卡/通知完成时刻，统计端到端延迟直方图。
+ * 关闭 CONFIG_LOG_TRACE_ENABLE 后所有跟踪点编译为空。
+ */
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#include "esp_cpu.h"
+#ifdef CONFIG_LOG_TRACE_ENABLE
+#define LOG_TRACE_ENABLE 1
+#else
+#define LOG_TRACE_ENABLE 0
+#endif
+#define LOG_TRACE_CYCLES() ((uint32_t)esp_cpu_get_cycle_count())
+#else
+#define LOG_TRACE_ENABLE 1
+uint32_t log_trace_host_cycles(void);
+#define LOG_TRACE_CYCLES() log_trace_host_cycles()
+#endif
+
+#define LOG_TRACE_EVENTS 64 // 每条事件环的容量，须为 2 的幂
+#define LOG_LAT_MARKS    32 // 每个延迟探针最多同时跟踪的未完成数据块
+
+// 事件环，按写入任务划分
+enum {
+    LOG_TRACE_CH_UART,   // uart_task：接收与扇出（含 tfcard_write_to_buffer / ble_write_to_buffer）
+    LOG_TRACE_CH_CARD,   // tfcard_task / s_write_file
+    LOG_TRACE_CH_BLE,    // ble_tx_task
+    LOG_TRACE_CH_NUM,
+};
+
+// 跟踪点编号，arg 一般为字节数
+enum {
+    LOG_TRACE_UART_READ = 1,   // uart_read_bytes 返回
+    LOG_TRACE_CARD_ENQ,        // 写入 TF 卡环形缓冲区完成
+    LOG_TRACE_CARD_ENQ_WAIT,   // TF 卡环形缓冲区空间不足，开始等待
+    LOG_TRACE_BLE_ENQ,         // 写入 BLE 环形缓冲区完成
+    LOG_TRACE_FANOUT_DONE,     // 一个数据块分发完毕
+    LOG_TRACE_CARD_DEQ,        // tfcard_task 取到数据
+    LOG_TRACE_CARD_WRITE_BEGIN,
+    LOG_TRACE_CARD_WRITE_END,  // arg 为写入字节数，失败时为 0
+    LOG_TRACE_BLE_TX_BEGIN,
+    LOG_TRACE_BLE_TX_END,
+};
+
+// 延迟直方图
+enum {
+    LOG_LAT_INGEST,  // uart_read_bytes 返回 -> 扇出完成（含等待缓冲区空间）
+    LOG_LAT_CARD,    // uart_read_bytes 返回 -> 对应字节 s_write_file 完成
+    LOG_LAT_BLE,     // uart_read_bytes 返回 -> 对应字节通知发出
+    LOG_LAT_NUM,
+};
+
+typedef struct {
+    uint32_t t;      // CPU 周期
+    uint16_t id;
+    uint16_t arg;
+} log_trace_event_t;
+
+typedef struct {
+    uint32_t head;   // 已写入事件总数
+    log_trace_event_t ev[LOG_TRACE_EVENTS];
+} log_trace_buf_t;
+
+// 生产者（扇出一侧）登记 “流偏移 off 之前的字节在 t_us 时刻到达”，消费者推进偏移时结算延迟
+typedef struct {
+    uint32_t head;
+    uint32_t tail;
+    uint32_t off[LOG_LAT_MARKS];
+    uint32_t t_us[LOG_LAT_MARKS];
+    uint32_t overflow;             // 标记队列满而未跟踪的数据块数
+    uint32_t hist[LOG_HIST_BINS];
+} log_lat_probe_t;
+
+extern log_trace_buf_t log_trace_bufs[LOG_TRACE_CH_NUM];
+extern log_lat_probe_t log_lat[LOG_LAT_NUM];
+
+static inline void log_trace_event(log_trace_buf_t *buf, uint16_t id, uint32_t arg)
+{
+    uint32_t h = buf->head;
+    log_trace_event_t *e = &buf->ev[h & (LOG_TRACE_EVENTS - 1)];
+    e->t = LOG_TRACE_CYCLES();
+    e->id = id;
+    e->arg = (arg > 0xffff) ? 0xffff : arg;
+    __atomic_store_n(&buf->head, h + 1, __ATOMIC_RELEASE);
+}
+
+void log_lat_mark(log_lat_probe_t *p, uint32_t off, uint32_t t_us);
+void log_lat_done(log_lat_probe_t *p, uint32_t off, uint32_t now_us);
+
+// 当前正在扇出的数据块的接收时刻，由 uart_task 设置，扇出路径上登记延迟标记时使用
+extern uint32_t log_trace_origin_us;
+
+#if LOG_TRACE_ENABLE
+#define LOG_TRACE(ch, id, arg)         log_trace_event(&log_trace_bufs[ch], (id), (arg))
+#define LOG_TRACE_ORIGIN(t_us)         (log_trace_origin_us = (t_us))
+#define LOG_LAT_MARK(lat, off)         log_lat_mark(&log_lat[lat], (off), log_trace_origin_us)
+#define LOG_LAT_DONE(lat, off, now_us) log_lat_done(&log_lat[lat], (off), (now_us))
+#define LOG_LAT_ADD(lat, us)           log_hist_add(log_lat[lat].hist, (us))
+#else
+#define LOG_TRACE(ch, id, arg)         do {} while (0)
+#define LOG_TRACE_ORIGIN(t_us)         do {} while (0)
+#define LOG_LAT_MARK(lat, off)         do {} while (0)
+#define LOG_LAT_DONE(lat, off, now_us) do {} while (0)
+#define LOG_LAT_ADD(lat, us)           do {} while (0)
+#endif
+
+// 读取一条事件环中仍然有效的最近事件（与写入并发安全），返回事件数，*first_seq 为第一条的序号
+size_t log_trace_copy(const log_trace_buf_t *buf, log_trace_event_t *out, size_t max, uint32_t *first_seq);
+void log_trace_reset(void);
+
+#endif
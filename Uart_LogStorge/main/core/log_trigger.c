@@ -0,0 +1,196 @@
+#include <string.h>
+#include "log_trigger.h"
+
+bool log_trigger_init(log_trigger_t *t, uint8_t *buf, uint32_t size, uint32_t pre_ms, uint32_t post_ms,
+                      uint8_t flags)
+{
+    memset(t, 0, sizeof(*t));
+    if (!log_ring_init(&t->pre, buf, size)) {
+        return false;
+    }
+    log_match_init(&t->match, flags);
+    t->pre_ms = pre_ms;
+    t->post_ms = post_ms;
+    t->last_hit_off = -1;
+    return true;
+}
+
+int log_trigger_add(log_trigger_t *t, const char *pattern, size_t len)
+{
+    return log_match_add(&t->match, pattern, len);
+}
+
+void log_trigger_compile(log_trigger_t *t)
+{
+    log_match_compile(&t->match);
+    t->state = 0;
+    t->line_pos = 0;
+}
+
+void log_trigger_reset(log_trigger_t *t)
+{
+    log_ring_reset(&t->pre);
+    t->capturing = false;
+    t->pending = 0;
+    t->state = 0;
+    t->line_pos = 0;
+}
+
+static uint8_t trigger_scan(log_trigger_t *t, const uint8_t *raw, size_t len)
+{
+    uint8_t hits = 0;
+
+    t->last_hit_off = -1;
+    if (t->match.num_patterns == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (raw[i] == '\n') {
+            t->state = 0;
+            t->line_pos = 0;
+            continue;
+        }
+        uint8_t h = log_match_step(&t->match, &t->state, raw[i], t->line_pos++);
+        if (h != 0 && hits == 0) {
+            t->last_hit_off = (int32_t)i;
+        }
+        hits |= h;
+    }
+    return hits;
+}
+
+static void pre_read_hdr(const log_trigger_t *t, uint32_t *time_ms, uint32_t *len)
+{
+    uint8_t hdr[LOG_TRIGGER_REC_HDR];
+    uint32_t mask = t->pre.size - 1;
+    for (int i = 0; i < LOG_TRIGGER_REC_HDR; i++) {
+        hdr[i] = t->pre.buf[(t->pre.tail + i) & mask];
+    }
+    *time_ms = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((uint32_t)hdr[3] << 24);
+    *len = hdr[4] | (hdr[5] << 8);
+}
+
+// 取出最旧的一条记录，emit 为 NULL 时丢弃
+static void pre_pop(log_trigger_t *t, uint32_t len, log_trigger_emit_t emit, void *ctx)
+{
+    log_ring_consume(&t->pre, LOG_TRIGGER_REC_HDR);
+    while (len > 0) {
+        const uint8_t *p;
+        uint32_t n = log_ring_peek(&t->pre, &p);
+        n = (n < len) ? n : len;
+        if (emit != NULL) {
+            emit(ctx, (const char *)p, n);
+        }
+        log_ring_consume(&t->pre, n);
+        len -= n;
+    }
+}
+
+static void pre_drop_oldest(log_trigger_t *t)
+{
+    uint32_t time_ms, len;
+    pre_read_hdr(t, &time_ms, &len);
+    pre_pop(t, len, NULL, NULL);
+    t->skipped_bytes += len;
+}
+
+// 输出最旧的一条待输出记录
+static void pre_emit_oldest(log_trigger_t *t, log_trigger_emit_t emit, void *ctx)
+{
+    uint32_t time_ms, len;
+    pre_read_hdr(t, &time_ms, &len);
+    pre_pop(t, len, emit, ctx);
+    t->pending -= LOG_TRIGGER_REC_HDR + len;
+    t->promoted_bytes += len;
+}
+
+// 追加一条记录；queued 为 true 时记录属于捕获窗口，计入 pending。
+// 环中放不下时先腾出空间：待输出的记录不受 budget 限制直接交给 emit（与不开触发时一样可能等待写卡缓冲区），
+// 之后才丢弃最旧的历史，捕获窗口内的数据不会因为排队而丢失
+static void pre_push(log_trigger_t *t, const char *data, size_t len, uint32_t now_ms, bool queued,
+                     log_trigger_emit_t emit, void *ctx)
+{
+    uint32_t need = LOG_TRIGGER_REC_HDR + len;
+    uint8_t hdr[LOG_TRIGGER_REC_HDR] = {
+        now_ms & 0xff, (now_ms >> 8) & 0xff, (now_ms >> 16) & 0xff, now_ms >> 24, len & 0xff, (len >> 8) & 0xff,
+    };
+
+    if (len > 0xffff || need > t->pre.size) {
+        while (t->pending > 0) {
+            pre_emit_oldest(t, emit, ctx);
+        }
+        if (queued) {
+            emit(ctx, data, len);
+            t->promoted_bytes += len;
+        } else {
+            t->skipped_bytes += len;
+        }
+        return;
+    }
+    while (log_ring_free(&t->pre) < need) {
+        if (t->pending > 0) {
+            pre_emit_oldest(t, emit, ctx);
+        } else {
+            pre_drop_oldest(t);
+        }
+    }
+    log_ring_write(&t->pre, hdr, sizeof(hdr));
+    log_ring_write(&t->pre, data, len);
+    if (queued) {
+        t->pending += need;
+    }
+}
+
+// 触发时把环中的历史转为待输出：早于 now_ms - pre_ms 的记录丢弃。
+// 上一次捕获还没输出完时历史跟在它后面，无法从中间丢弃，整体保留
+static void pre_promote(log_trigger_t *t, uint32_t now_ms)
+{
+    while (t->pending == 0 && log_ring_used(&t->pre) > 0) {
+        uint32_t time_ms, len;
+        pre_read_hdr(t, &time_ms, &len);
+        if ((int32_t)(now_ms - time_ms) <= (int32_t)t->pre_ms) {
+            break;
+        }
+        pre_drop_oldest(t);
+    }
+    t->pending = log_ring_used(&t->pre);
+}
+
+void log_trigger_drain(log_trigger_t *t, uint32_t budget, log_trigger_emit_t emit, void *ctx)
+{
+    while (t->pending > 0) {
+        uint32_t time_ms, len;
+        pre_read_hdr(t, &time_ms, &len);
+        if (len > budget) {
+            break;
+        }
+        pre_emit_oldest(t, emit, ctx);
+        budget -= len;
+    }
+}
+
+bool log_trigger_feed(log_trigger_t *t, const uint8_t *raw, size_t raw_len, const char *framed, size_t framed_len,
+                      uint32_t now_ms, uint32_t budget, log_trigger_emit_t emit, void *ctx)
+{
+    uint8_t hits = trigger_scan(t, raw, raw_len);
+    bool fired = false;
+
+    if (hits != 0) {
+        t->last_hits = hits;
+        if (!t->capturing) {
+            t->capturing = true;
+            t->captures++;
+            pre_promote(t, now_ms);
+            fired = true;
+        }
+        t->post_end_ms = now_ms + t->post_ms;
+    } else if (t->capturing && (int32_t)(now_ms - t->post_end_ms) > 0) {
+        t->capturing = false;
+    }
+
+    if (framed_len > 0) {
+        pre_push(t, framed, framed_len, now_ms, t->capturing, emit, ctx);
+    }
+    log_trigger_drain(t, budget, emit, ctx);
+    return fired;
+}
@@ -0,0 +1,67 @@
+#ifndef __LOG_TRIGGER_H__
+#define __LOG_TRIGGER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "log_match.h"
+#include "log_ring.h"
+
+/*
+ * 触发式采集（逻辑分析仪式）：平时每个成帧后的数据块只进入 RAM 预触发环，
+ * 原始串口数据逐字节送入流式匹配器，某一行命中触发模式时，把环中最近 pre_ms 内的数据块
+ * 和之后 post_ms 内的数据交给 emit（设备端为写卡缓冲区），窗口内再次命中会延长窗口。
+ * 触发后的数据仍先进入环中排队，每次调用最多输出 budget 字节（调用方传入写卡缓冲区的剩余空间），
+ * 触发瞬间几十 KB 的历史数据不会让接收任务阻塞在写卡缓冲区上。
+ * 匹配器按原始字节扫描，不受成帧时按数据块插入的时间戳影响，模式可以跨数据块；
+ * 每个 '\n' 复位状态，'^' 开头的模式只匹配行首。
+ * 预触发环中的记录为 [time_ms u32][len u16][data]，空间不足或超出 pre_ms 时丢弃最旧的历史记录；
+ * 排队的数据放不下时不再受 budget 限制，直接输出。
+ * 不依赖 ESP-IDF，设备端和主机端共用；所有函数只能由同一个任务调用。
+ */
+
+#define LOG_TRIGGER_REC_HDR 6
+
+typedef void (*log_trigger_emit_t)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    log_match_t match;
+    uint8_t state;          // 匹配器状态，跨数据块保持
+    uint32_t line_pos;      // 当前字节在行内的位置
+
+    log_ring_t pre;         // 预触发环
+    uint32_t pre_ms;
+    uint32_t post_ms;
+
+    bool capturing;
+    uint32_t post_end_ms;   // 捕获窗口结束时刻（回绕比较）
+    uint32_t pending;       // 环头部待输出的字节数（含记录头），其后为预触发历史
+
+    uint8_t last_hits;      // 最近一次命中的模式位图
+    int32_t last_hit_off;   // 最近一次命中在原始数据块中的偏移（模式最后一个字节），-1 为本块未命中
+
+    uint32_t captures;      // 触发次数（不含窗口内的再次命中）
+    uint32_t promoted_bytes;// 交给 emit 的字节数
+    uint32_t skipped_bytes; // 未被任何窗口覆盖而丢弃的字节数
+} log_trigger_t;
+
+// buf 为预触发环的存储，size 须为 2 的幂，否则返回 false；flags 同 log_match_init
+bool log_trigger_init(log_trigger_t *t, uint8_t *buf, uint32_t size, uint32_t pre_ms, uint32_t post_ms,
+                      uint8_t flags);
+// 添加触发模式，返回模式编号，失败返回 -1（见 log_match_add）
+int log_trigger_add(log_trigger_t *t, const char *pattern, size_t len);
+// 添加完全部模式后调用
+void log_trigger_compile(log_trigger_t *t);
+
+// 处理一个数据块：raw 为串口原始数据（用于匹配），framed 为成帧后的数据（用于存储），now_ms 为毫秒时间，
+// 之后输出不超过 budget 字节的排队数据。返回 true 表示本块开始了一次新的捕获，调用方据此发出告警
+bool log_trigger_feed(log_trigger_t *t, const uint8_t *raw, size_t raw_len, const char *framed, size_t framed_len,
+                      uint32_t now_ms, uint32_t budget, log_trigger_emit_t emit, void *ctx);
+
+// 只输出排队数据，串口空闲时调用
+void log_trigger_drain(log_trigger_t *t, uint32_t budget, log_trigger_emit_t emit, void *ctx);
+
+// 丢弃预触发环并结束当前捕获，模式保留
+void log_trigger_reset(log_trigger_t *t);
+
+#endif
@@ -0,0 +1,43 @@
+#include <string.h>
+#include "log_writer.h"
+
+void log_writer_init(log_writer_t *w, log_writer_sink_t sink, void *ctx)
+{
+    w->sink = sink;
+    w->ctx = ctx;
+    w->len = 0;
+    w->sink_calls = 0;
+    w->sink_errors = 0;
+}
+
+static int writer_sink(log_writer_t *w, const char *data, size_t len)
+{
+    int ret = w->sink(w->ctx, data, len);
+    w->sink_calls++;
+    if (ret != 0) {
+        w->sink_errors++;
+    }
+    return ret;
+}
+
+void log_writer_push(log_writer_t *w, const char *data, size_t len)
+{
+    if (w->len + len < sizeof(w->buf)) {
+        memcpy(w->buf + w->len, data, len);
+        w->len += len;
+        return;
+    }
+    // 写入缓冲区已满，先写出已攒数据，再整块写出当前数据
+    log_writer_flush(w);
+    writer_sink(w, data, len);
+}
+
+int log_writer_flush(log_writer_t *w)
+{
+    if (w->len == 0) {
+        return 0;
+    }
+    int ret = writer_sink(w, w->buf, w->len);
+    w->len = 0;
+    return ret;
+}
@@ -0,0 +1,32 @@
+#ifndef __LOG_WRITER_H__
+#define __LOG_WRITER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * tfcard_task 的写入合并逻辑：小块数据先攒在 buf 里，攒满或调用 flush 时交给 sink 一次写出，
+ * 放不下的大块数据先把已攒数据写出，再直接整块交给 sink，不再经过 buf 拷贝。
+ * sink 由调用方提供：设备端是 s_write_file（追加写 TF 卡文件），主机端是文件模拟的 SD 卡。
+ */
+
+#define LOG_WRITER_BUF_SIZE 1024
+
+// 返回 0 表示写入成功
+typedef int (*log_writer_sink_t)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    log_writer_sink_t sink;
+    void *ctx;
+    size_t len;          // buf 中待写出的字节数
+    uint32_t sink_calls;
+    uint32_t sink_errors;
+    char buf[LOG_WRITER_BUF_SIZE];
+} log_writer_t;
+
+void log_writer_init(log_writer_t *w, log_writer_sink_t sink, void *ctx);
+void log_writer_push(log_writer_t *w, const char *data, size_t len);
+// 写出 buf 中的剩余数据，没有数据时返回 0 且不调用 sink
+int log_writer_flush(log_writer_t *w);
+
+#endif
@@ -1,3 +1,4 @@
+#include <inttypes.h>
 #include "uart/bsp_uart.h"
 #include "tfcard/bsp_tfcard.h"
 #include "esp_log.h"
@@ -7,44 +8,82 @@
 #include "esp_pm.h"
 #include "esp_sleep.h"
 #include "sleep_wakeup.h"
+#include "power_save.h"
+#include "esp_heap_caps.h"
+#include "log_mem.h"
+#include "sched_profile.h"
+#include "app_config.h"
 
 // 日志标签
 static const char *TAG = "MAIN";
 
+// 初始化期间的堆占用：按调用前后的剩余堆计算，包含任务栈、队列和驱动/协议栈内部的分配
+#define MEM_MEASURE(id, call)                                              \
+    do {                                                                   \
+        size_t before_ = heap_caps_get_free_size(MALLOC_CAP_8BIT);         \
+        call;                                                              \
+        log_mem[id].heap_bytes += before_ - heap_caps_get_free_size(MALLOC_CAP_8BIT); \
+    } while (0)
+
+// 启动完成后打印每个子系统的内存占用和剩余堆
+static void mem_report(void)
+{
+    uint32_t total_static = 0, total_heap = 0;
+
+    for (int i = 0; i < LOG_MEM_NUM; i++) {
+        ESP_LOGI(TAG, "RAM %-7s static %6" PRIu32 "  heap %6" PRIu32, log_mem_name(i), log_mem[i].static_bytes,
+                 log_mem[i].heap_bytes);
+        total_static += log_mem[i].static_bytes;
+        total_heap += log_mem[i].heap_bytes;
+    }
+    ESP_LOGI(TAG, "RAM total   static %6" PRIu32 "  heap %6" PRIu32, total_static, total_heap);
+    ESP_LOGI(TAG, "Heap free %u, minimum %u, largest block %u", heap_caps_get_free_size(MALLOC_CAP_8BIT),
+             heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT), heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
+
 void app_main(void)
 {
     ESP_LOGI(TAG, "Starting application...");
 
-    //未装电池时不打开此功能
-    // BAT_adc_init();
-
-    // if( BAT_adc_get_voltage() > BAT_VOLTAGE_LOW)
-    // {
-    //     ok_led();
-    // }
-    // else
-    // {
-    //     low_battery();
-    //     sleep_wakeup_init();
-    //     while (Get_sleep_state() == SLEEP_STATE_ON)
-    //     {
-    //         vTaskDelay(100);
-    //     }
-    // }
+    // 运行配置（NVS），引脚、波特率和设备名在各模块初始化时读取
+    app_config_init();
+
+    // 状态灯最先启动，等待充电期间也能显示；各模块只登记状态，不依赖初始化顺序
+    MEM_MEASURE(LOG_MEM_LED, ws2812_init());
+
+    //未装电池时不打开此功能（CONFIG_BAT_MONITOR_ENABLE）
+#ifdef CONFIG_BAT_MONITOR_ENABLE
+    BAT_adc_init();
+
+    if (BAT_adc_get_level() == LOG_BATTERY_CRITICAL)
+    {
+        // 电量不足以安全写卡，先浅睡眠等待充电，恢复后再启动采集
+        led_set_state(LOG_LED_LOW_BAT, true);
+        sleep_wakeup_init();
+        while (BAT_adc_get_level() == LOG_BATTERY_CRITICAL)
+        {
+            vTaskDelay(pdMS_TO_TICKS(500));
+        }
+    }
+#endif
+
+    // 空闲时降频、自动浅睡眠（CONFIG_LOG_POWER_SAVE），须在各任务创建前配置好 PM 锁
+    power_save_init();
+
+    // 调度统计（CONFIG_SCHED_PROFILE_ENABLE），各任务的优先级和栈见 sched_profile.h
+    MEM_MEASURE(LOG_MEM_SCHED, sched_profile_init());
 
     // 初始化 BLE
-    ble_gatt_init();
+    MEM_MEASURE(LOG_MEM_BLE, ble_gatt_init());
 
     // 初始化 UART
-    uart_init();
+    MEM_MEASURE(LOG_MEM_UART, uart_init());
 
     vTaskDelay(1000 / portTICK_PERIOD_MS);
 
-    // 初始化 WS2812
-    ws2812_init();
-
     // 初始化 TF 卡
-    tfcard_init();
+    MEM_MEASURE(LOG_MEM_CARD, tfcard_init());
 
     ESP_LOGI(TAG, "Application started successfully");
+    mem_report();
 }
\ No newline at end of file
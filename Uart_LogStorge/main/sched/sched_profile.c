@@ -0,0 +1,125 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_freertos_hooks.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "sched_profile.h"
+#include "log_sched.h"
+#include "log_mem.h"
+
+static const char *TAG = "SCHED";
+
+// 还没有统计数据时只返回报告头
+static size_t sched_empty_report(uint8_t *buf, size_t size)
+{
+    if (size < LOG_SCHED_HDR_SIZE) {
+        return 0;
+    }
+    memset(buf, 0, LOG_SCHED_HDR_SIZE);
+    buf[0] = LOG_SCHED_VERSION;
+    return LOG_SCHED_HDR_SIZE;
+}
+
+#ifdef CONFIG_SCHED_PROFILE_ENABLE
+
+#define SCHED_STATUS_MAX 32
+
+static log_sched_t sched;
+static TaskStatus_t sched_status[SCHED_STATUS_MAX];
+// 报告在窗口结束时生成，BLE 读取时只拷贝，采样任务高于 BLE 任务，不能在读取中途改写
+static uint8_t sched_report[LOG_SCHED_REPORT_MAX];
+static size_t sched_report_len;
+static StaticSemaphore_t sched_report_mutex_buf;
+static SemaphoreHandle_t sched_report_mutex;
+
+// tick 中断时正在运行的任务：采样任务由同一个 tick 唤醒，被它抢占的任务此时处于就绪态，不算作抢占
+static volatile TaskHandle_t sched_tick_task;
+
+static void sched_tick_hook(void)
+{
+    sched_tick_task = xTaskGetCurrentTaskHandle();
+}
+
+static void sched_task(void *arg)
+{
+    TickType_t period = pdMS_TO_TICKS(CONFIG_SCHED_PROFILE_SAMPLE_MS);
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t now_ms = pdTICKS_TO_MS(last_wake);
+
+    log_sched_init(&sched, now_ms);
+    while (1) {
+        vTaskDelayUntil(&last_wake, (period > 0) ? period : 1);
+        TaskHandle_t running = sched_tick_task;
+        configRUN_TIME_COUNTER_TYPE total_run = 0;
+        UBaseType_t n = uxTaskGetSystemState(sched_status, SCHED_STATUS_MAX, &total_run);
+        if (n == 0) {
+            // 任务数超过 SCHED_STATUS_MAX 时不返回任何状态
+            ESP_LOGW(TAG, "More than %d tasks, sampling skipped", SCHED_STATUS_MAX);
+            continue;
+        }
+
+        for (UBaseType_t i = 0; i < n; i++) {
+            const TaskStatus_t *st = &sched_status[i];
+            log_sched_task_t *t = log_sched_get(&sched, st->xTaskNumber, st->pcTaskName);
+            if (t == NULL) {
+                continue;
+            }
+            t->prio = st->uxBasePriority;
+            t->stack_free = st->usStackHighWaterMark; // ESP-IDF 的栈以字节为单位
+            t->run_time = st->ulRunTimeCounter;
+            log_sched_note(t, st->eCurrentState, st->xHandle == running);
+        }
+        sched.total = n;
+        sched.samples++;
+
+        now_ms = pdTICKS_TO_MS(last_wake);
+        if (now_ms - sched.win_start_ms >= CONFIG_SCHED_PROFILE_WINDOW_MS) {
+            log_sched_window(&sched, total_run, now_ms);
+            xSemaphoreTake(sched_report_mutex, portMAX_DELAY);
+            sched_report_len = log_sched_report(&sched, sched_report, sizeof(sched_report));
+            xSemaphoreGive(sched_report_mutex);
+        }
+    }
+}
+
+void sched_profile_init(void)
+{
+    sched_report_mutex = xSemaphoreCreateMutexStatic(&sched_report_mutex_buf);
+    if (esp_register_freertos_tick_hook(sched_tick_hook) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register tick hook");
+        return;
+    }
+    log_mem_add_static(LOG_MEM_SCHED, sizeof(sched) + sizeof(sched_status) + sizeof(sched_report));
+    xTaskCreate(sched_task, "sched_task", TASK_STACK_SCHED, NULL, TASK_PRIO_SCHED, NULL);
+    ESP_LOGI(TAG, "Scheduling stats every %d ms, load window %d ms", CONFIG_SCHED_PROFILE_SAMPLE_MS,
+             CONFIG_SCHED_PROFILE_WINDOW_MS);
+}
+
+size_t sched_profile_read_report(uint8_t *buf, size_t size)
+{
+    if (size < LOG_SCHED_REPORT_MAX || sched_report_mutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(sched_report_mutex, portMAX_DELAY);
+    size_t len = sched_report_len;
+    memcpy(buf, sched_report, len);
+    xSemaphoreGive(sched_report_mutex);
+    // 第一个窗口还没结束时 len 为 0
+    return (len > 0) ? len : sched_empty_report(buf, size);
+}
+
+#else
+
+void sched_profile_init(void)
+{
+    ESP_LOGI(TAG, "Scheduling stats disabled");
+}
+
+size_t sched_profile_read_report(uint8_t *buf, size_t size)
+{
+    return sched_empty_report(buf, size);
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef __SCHED_PROFILE_H__
+#define __SCHED_PROFILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_task.h"
+
+/*
+ * 调度配置：C3 只有一个核，采集任务和蓝牙协议栈的任务在同一个核上按优先级抢占。
+ * ESP-IDF 自带任务的优先级（configMAX_PRIORITIES = 25）：
+ *   蓝牙控制器 23、esp_timer 22、BTU 20、BTC 19、IDLE 0
+ * 分配原则：
+ *   - uart_task 高于 BTU/BTC：每块数据只做成帧和入队，运行时间很短，大量通知时蓝牙主机任务
+ *     可能连续占用 CPU 几毫秒，不能让它们推迟读取，否则 UART 接收缓冲区溢出丢数据；
+ *     低于 esp_timer 和控制器，不影响射频时序；
+ *     前提是这条路径上不打印 INFO 日志：控制台输出一块 1 KB 的数据在 115200 波特率下约 90 ms，
+ *     uart_task 和 ble_write_to_buffer（持有 uart_ble_mutex）里的逐块日志只用 DEBUG 级别或不打印；
+ *   - 调度采样任务与 uart_task 同级，低于 esp_timer 和控制器：tick 唤醒它时同级的 uart_task
+ *     按时间片让出 CPU，处于就绪态，由 tick 钩子记为运行；控制器和 esp_timer 不会被它推迟，
+ *     tick 时正在运行的同样记为运行而不是被抢占，采样时通常已回到阻塞态；
+ *   - tfcard_task 高于所有 BLE 应用任务：BLE 发送任务只在写卡任务等待 SPI 传输或空闲时产生通知，
+ *     写卡不会被实时流推迟；低于 BTC，协议栈的短暂处理仍能及时完成，连接不会超时；
+ *   - BLE 应用任务：实时流 > 文件传输/检索 > 跟踪导出/告警；
+ *   - LED 和电池检测最低，只用于显示和周期检测。
+ * 栈大小按 CONFIG_SCHED_PROFILE_ENABLE 报告的高水位确定，留出约 1 KB 余量。
+ */
+
+#define TASK_PRIO_SCHED      (ESP_TASK_TIMER_PRIO - 1)   // 采样任务，低于 esp_timer 和控制器，不低于 uart_task
+#define TASK_PRIO_UART       (ESP_TASK_BT_BTU_PRIO + 1)
+#define TASK_PRIO_TFCARD     (ESP_TASK_BT_BTC_PRIO - 1)
+#define TASK_PRIO_LIGHT_SLEEP 6
+#define TASK_PRIO_BLE_TX     5
+#define TASK_PRIO_BLE_FILE   4
+#define TASK_PRIO_BLE_QUERY  4
+#define TASK_PRIO_BLE_TRACE  3
+#define TASK_PRIO_BLE_ALERT  3
+#define TASK_PRIO_CONFIG     3     // 配置特征的重启请求，写完卡后重启
+#define TASK_PRIO_LED        2
+#define TASK_PRIO_BATTERY    2
+
+_Static_assert(TASK_PRIO_UART < ESP_TASK_TIMER_PRIO, "uart_task must not delay esp_timer");
+_Static_assert(TASK_PRIO_SCHED < ESP_TASK_TIMER_PRIO && TASK_PRIO_SCHED >= TASK_PRIO_UART,
+               "sched_task must not delay esp_timer and must not be starved by app tasks");
+_Static_assert(TASK_PRIO_TFCARD > TASK_PRIO_BLE_TX, "BLE must not delay card writes");
+
+#define TASK_STACK_UART      4096
+#define TASK_STACK_TFCARD    8192
+#define TASK_STACK_BLE_TX    3072
+#define TASK_STACK_BLE_FILE  4096
+#define TASK_STACK_BLE_QUERY 4096
+#define TASK_STACK_BLE_TRACE 3072
+#define TASK_STACK_BLE_ALERT 2048
+#define TASK_STACK_LIGHT_SLEEP 4096
+#define TASK_STACK_LED       4096
+#define TASK_STACK_BATTERY   3072
+#define TASK_STACK_SCHED     3072
+#define TASK_STACK_CONFIG    3072
+
+// 启动调度统计（CONFIG_SCHED_PROFILE_ENABLE），未启用时为空操作
+void sched_profile_init(void);
+
+// BLE 读取调度报告（格式见 log_sched.h），buf 至少 LOG_SCHED_REPORT_MAX 字节，未启用时只有报告头
+size_t sched_profile_read_report(uint8_t *buf, size_t size);
+
+#endif
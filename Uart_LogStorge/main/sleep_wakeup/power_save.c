@@ -0,0 +1,107 @@
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_pm.h"
+#include "power_save.h"
+
+static const char *TAG = "power_save";
+
+#ifdef CONFIG_LOG_POWER_SAVE
+
+// 降频下限用 XTAL 频率，浅睡眠前后不需要切换 PLL 以外的时钟源
+#define POWER_MAX_FREQ_MHZ CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define POWER_MIN_FREQ_MHZ CONFIG_XTAL_FREQ
+
+typedef struct {
+    const char *name;
+    esp_pm_lock_handle_t no_sleep; // 禁止自动浅睡眠
+    esp_pm_lock_handle_t cpu_max;  // 数据流动期间保持最高主频，避免解析/成帧跟不上
+    bool held;
+} power_lock_t;
+
+static power_lock_t power_locks[POWER_LOCK_NUM] = {
+    [POWER_LOCK_UART] = { .name = "uart_rx" },
+    [POWER_LOCK_CARD] = { .name = "card_flush" },
+};
+static bool power_save_on = false;
+
+void power_save_init(void)
+{
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = POWER_MAX_FREQ_MHZ,
+        .min_freq_mhz = POWER_MIN_FREQ_MHZ,
+        .light_sleep_enable = true,
+    };
+
+    for (int i = 0; i < POWER_LOCK_NUM; i++)
+    {
+        power_lock_t *lock = &power_locks[i];
+        if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, lock->name, &lock->no_sleep) != ESP_OK ||
+            esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, lock->name, &lock->cpu_max) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to create PM lock %s", lock->name);
+            return;
+        }
+    }
+
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+        return;
+    }
+    power_save_on = true;
+    ESP_LOGI(TAG, "DFS %d-%d MHz, automatic light sleep enabled", POWER_MIN_FREQ_MHZ, POWER_MAX_FREQ_MHZ);
+}
+
+bool power_save_enabled(void)
+{
+    return power_save_on;
+}
+
+void power_lock_acquire(power_lock_id_t id)
+{
+    power_lock_t *lock = &power_locks[id];
+    if (!power_save_on || lock->held)
+    {
+        return;
+    }
+    esp_pm_lock_acquire(lock->no_sleep);
+    esp_pm_lock_acquire(lock->cpu_max);
+    lock->held = true;
+}
+
+void power_lock_release(power_lock_id_t id)
+{
+    power_lock_t *lock = &power_locks[id];
+    if (!power_save_on || !lock->held)
+    {
+        return;
+    }
+    esp_pm_lock_release(lock->cpu_max);
+    esp_pm_lock_release(lock->no_sleep);
+    lock->held = false;
+}
+
+#else
+
+void power_save_init(void)
+{
+    ESP_LOGI(TAG, "Power save disabled (CONFIG_LOG_POWER_SAVE)");
+}
+
+bool power_save_enabled(void)
+{
+    return false;
+}
+
+void power_lock_acquire(power_lock_id_t id)
+{
+    (void)id;
+}
+
+void power_lock_release(power_lock_id_t id)
+{
+    (void)id;
+}
+
+#endif
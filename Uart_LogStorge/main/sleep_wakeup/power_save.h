@@ -0,0 +1,27 @@
+#ifndef __POWER_SAVE_H__
+#define __POWER_SAVE_H__
+
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/*
+ * 空闲省电（CONFIG_LOG_POWER_SAVE）：动态调频 + 自动浅睡眠。
+ * 采集链路上的任务在有数据流动或有数据待写卡时持有对应的锁，锁全部释放后系统才会降频、浅睡眠，
+ * 串口上的第一个下降沿把芯片唤醒。未启用时所有接口都是空操作。
+ */
+
+typedef enum {
+    POWER_LOCK_UART = 0, // uart_task：串口有数据流动
+    POWER_LOCK_CARD,     // tfcard_task：有数据还未写入并同步到卡
+    POWER_LOCK_NUM,
+} power_lock_id_t;
+
+// 配置 esp_pm 和串口唤醒源，须在 uart_init 之后调用
+void power_save_init(void);
+bool power_save_enabled(void);
+
+// 同一个锁重复获取/释放不会累加，只由对应的任务调用
+void power_lock_acquire(power_lock_id_t id);
+void power_lock_release(power_lock_id_t id);
+
+#endif
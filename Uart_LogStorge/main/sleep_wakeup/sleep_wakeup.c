@@ -14,6 +14,7 @@
 #include "battery_detect/bat_adc.h"
 #include "sleep_wakeup/sleep_wakeup.h"
 #include "ws2812/ws2812.h"
+#include "sched_profile.h"
 
 #define TIMER_WAKEUP_TIME_US    (5 * 1000 * 1000)
 
@@ -108,7 +109,7 @@ static void light_sleep_task(void *args)
         if( BAT_adc_get_voltage() > BAT_VOLTAGE_LOW)
         {
             ESP_LOGI(TAG,"BAT voltage resume,exit light sleep");
-            ok_led();
+            led_set_state(LOG_LED_LOW_BAT, false);
             sleep_state = SLEEP_STATE_OFF;
             break;
         }
@@ -132,6 +133,6 @@ void sleep_wakeup_init(void)
     /* Enable wakeup from light sleep by timer */
     register_timer_wakeup();
 
-    xTaskCreate(light_sleep_task, "light_sleep_task", 4096, NULL, 6, NULL);
+    xTaskCreate(light_sleep_task, "light_sleep_task", TASK_STACK_LIGHT_SLEEP, NULL, TASK_PRIO_LIGHT_SLEEP, NULL);
 }
 
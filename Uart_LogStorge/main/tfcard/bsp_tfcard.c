@@ -9,10 +9,13 @@
 */
 
 #include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
 #include "bsp_uart.h"
 #include "esp_vfs_fat.h"
+#include "diskio_sdmmc.h"
 #include "sdmmc_cmd.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -21,6 +24,19 @@
 #include "ws2812/ws2812.h"
 #include "esp_timer.h"
 #include "bsp_tfcard.h"
+#include "log_stats.h"
+#include "log_trace.h"
+#include "log_writer.h"
+#include "log_journal.h"
+#include "log_spill.h"
+#include "log_raw.h"
+#include "log_crc.h"
+#include "log_mem.h"
+#include "power_save.h"
+#include "sched_profile.h"
+#include "app_config.h"
+#include "esp_partition.h"
+#include "esp_random.h"
 
 
 
@@ -31,56 +47,169 @@
 #define PIN_NUM_CLK GPIO_NUM_5
 #define PIN_NUM_CS GPIO_NUM_7
 
-#define MOUNT_POINT "/sdcard"
+#define MOUNT_POINT TF_CARD_MOUNT_POINT
 
 #define MAX_CHAR_SIZE 64
-// 增大缓冲区初始大小
-#define BUFFER_SIZE 8192
-#define WRITE_INTERVAL pdMS_TO_TICKS(500) // 1 秒写入一次
-#define BUFFER_RESIZE_THRESHOLD 0.4       // 缓冲区使用达到 60% 时尝试扩容
-#define BUFFER_RESIZE_STEP 2048           // 每次扩容的大小
-#define BUFFER_MAX_SIZE 1024 * 30  // 30KB 最大缓冲区大小
+// 写卡环形缓冲区，编译期确定大小并静态分配，运行中不再扩容
+#define BUFFER_SIZE (CONFIG_TFCARD_RING_KB * 1024)
+#define MOUNT_RETRY_MIN_MS 500     // 挂载失败后的重试间隔，每次失败翻倍
+#define MOUNT_RETRY_MAX_MS 30000
 
 
 static const char *TAG = "tfcard";
 SemaphoreHandle_t tfcard_ringbuf_mutex = NULL;
+// 日志文件和提交记录的读写，与环形缓冲区分开加锁，写卡卡顿时 uart_task 仍可入队
+static SemaphoreHandle_t tfcard_file_mutex = NULL;
 
 void tfcard_task(void *pvParameters);
 
 RingbufHandle_t tfcard_ringbuf = NULL;
+static uint8_t tfcard_ring_storage[BUFFER_SIZE];
+static StaticRingbuffer_t tfcard_ring_struct;
 sdmmc_card_t *card;
 uint8_t sdcard_init_state = TF_CARD_STATE_UNINIT;
 
 const char mount_point[] = MOUNT_POINT;
 
+// 当前正在追加的日志文件，tfcard_task 启动前为空串
+static char log_file_path[128];
+
+#ifdef CONFIG_UART_CAPTURE_RAW
+// 二进制抓包记录，不是文本，用 pytest/capture_decode.py 解析
+#define LOG_FILE_FMT "%s/tfcard_log_data_%d.cap"
+#else
+#define LOG_FILE_FMT "%s/tfcard_log_data_%d.txt"
+#endif
+
+#if defined(CONFIG_TFCARD_JOURNAL_ENABLE) || defined(CONFIG_TFCARD_STORAGE_RAW)
+// 按时间/字节数做检查点：FAT 日志模式下写提交记录（必要时先 fsync），裸扇区模式下重写段头
+#define TFCARD_CHECKPOINT 1
+#define SYNC_INTERVAL_US ((int64_t)CONFIG_TFCARD_SYNC_INTERVAL_MS * 1000)
+
+static uint32_t uncommitted_bytes = 0; // 已写入但还未提交的字节数
+static int64_t last_sync_us = 0;
+#endif
+
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+// 日志模式：日志文件保持打开，每个检查点记录已落盘的长度。
+// fflush 之后当前扇区之前的整扇区已写到卡上，但目录项长度和新分配的簇只在 fsync 时写入；
+// 提交长度不超过上次 fsync 时簇链覆盖的范围，数据进入新的簇时才 fsync，
+// 断电后按提交长度补回目录项，不需要分配新簇
+#define JOURNAL_PATH MOUNT_POINT "/logjrnl.bin"
+
+static FILE *log_fp = NULL;
+static FILE *journal_fp = NULL;
+static log_journal_rec_t journal;      // 最近一次写入的提交记录
+static uint32_t journal_chain_len = 0; // 上次 fsync 后卡上簇链覆盖的长度，重新打开日志文件时清零
+static uint32_t journal_cluster = 0;   // 簇大小（字节），挂载后读取
+#endif
+
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+// 裸扇区循环日志：不挂载文件系统，段直接写入卡的扇区，格式见 log_raw.h
+#define RAW_SEG_SECTORS (CONFIG_TFCARD_RAW_SEGMENT_KB * 1024 / LOG_RAW_SECTOR)
+
+static log_raw_t raw_log;
+static sdmmc_card_t raw_card; // FAT 模式下由 esp_vfs_fat_sdspi_mount 分配
+#endif
+#ifndef CONFIG_TFCARD_STORAGE_RAW
+// 上次运行最后写入的日志文件序号，没有提交记录时为 0
+static int last_file_index = 0;
+#endif
+
+// 紧急停止（低电量）：先停止接收新数据，再由 tfcard_task 写完缓冲区并关闭日志文件
+static volatile bool tfcard_accepting = true; // 在 tfcard_ringbuf_mutex 内修改
+static volatile bool tfcard_stop_req = false;
+static TaskHandle_t tfcard_task_handle = NULL;
+static SemaphoreHandle_t tfcard_stop_done = NULL;
+
+#ifdef CONFIG_TFCARD_SPILL_ENABLE
+// 片内 Flash 溢出分区：环形缓冲区超过水位后新数据写入分区，卡恢复后按顺序读回，逻辑见 log_spill.h
+#define SPILL_PARTITION_LABEL "logspill"
+#define SPILL_DRAIN_MAX 4096 // 每次读回写卡的字节数
+
+static log_spill_t spill;
+static bool spill_ready = false;
+#endif
+
+// 挂载参数在 tfcard_init 中准备好，卡拔出后由 tfcard_task 用同一组参数重新挂载
+// 簇大小由格式化配置决定（CONFIG_TFCARD_FORMAT_PROFILE），SPI DMA 单次传输按整簇分配
+#define SD_ALLOC_UNIT (CONFIG_TFCARD_ALLOC_UNIT_KB * 1024)
+static sdmmc_host_t sd_host = SDSPI_HOST_DEFAULT();
+static sdspi_device_config_t sd_slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
+#ifndef CONFIG_TFCARD_STORAGE_RAW
+static esp_vfs_fat_sdmmc_mount_config_t sd_mount_config = {
+#ifdef CONFIG_EXAMPLE_FORMAT_IF_MOUNT_FAILED
+    .format_if_mount_failed = true,
+#endif
+    .max_files = 5,
+    .allocation_unit_size = SD_ALLOC_UNIT};
+#endif
+
+// SPI 时钟：驱动按 CSD 只用到默认速度 20 MHz，挂载后按档位从高到低试读，取第一个读回一致的档位；
+// 运行中卡仍在线但写入连续失败（CRC 错误、超时）时降一档，本次运行内不再升回
+#define SD_PROBE_SECTORS 16 // 每轮试读的扇区数
+#define SD_PROBE_SECTOR_SIZE 512
+static uint8_t sd_probe_buf[SD_PROBE_SECTORS * SD_PROBE_SECTOR_SIZE] __attribute__((aligned(4)));
+#define SD_PROBE_ROUNDS 4
+#define SD_ERR_STEP_DOWN 3  // 卡仍在线时连续写失败的次数
+// C3 的 SPI 时钟由 80 MHz APB 分频得到
+static const uint32_t sd_freq_ladder_khz[] = {40000, 26667, 20000, 16000, 10000, 5000, 1000};
+#define SD_FREQ_STEPS (sizeof(sd_freq_ladder_khz) / sizeof(sd_freq_ladder_khz[0]))
+static uint32_t sd_freq_limit_khz = CONFIG_TFCARD_SPI_MAX_FREQ_KHZ;
+
 
 #define WRITE_CHUNK_SIZE 1024 // 每次写入的数据块大小
 
+// 已交给 s_write_file 的字节偏移（无论成功与否），与 card_in_bytes 对应，用于结算延迟标记
+static uint32_t card_flushed_off = 0;
+
+static void card_write_done(size_t len, size_t written)
+{
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    card_flushed_off += len;
+    LOG_TRACE(LOG_TRACE_CH_CARD, LOG_TRACE_CARD_WRITE_END, written);
+    LOG_LAT_DONE(LOG_LAT_CARD, card_flushed_off, now_us);
+}
+
+#ifndef CONFIG_TFCARD_STORAGE_RAW
 // 修改 s_write_file 函数，在函数内部获取和释放锁
 static esp_err_t s_write_file(const char *path, const char *data,size_t len)
 {
-    if (tfcard_ringbuf_mutex == NULL)
+    if (tfcard_file_mutex == NULL)
     {
         ESP_LOGE(TAG, "Mutex is not initialized");
         return ESP_FAIL;
     }
 
     // 获取互斥锁
-    if (xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY) != pdTRUE)
+    if (xSemaphoreTake(tfcard_file_mutex, portMAX_DELAY) != pdTRUE)
     {
         ESP_LOGE(TAG, "Failed to take mutex");
         return ESP_FAIL;
     }
 
     // ESP_LOGI(TAG, "Opening file %s", path);
+    LOG_TRACE(LOG_TRACE_CH_CARD, LOG_TRACE_CARD_WRITE_BEGIN, len);
+    int64_t start_us = esp_timer_get_time();
     FILE *f;
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+    if (log_fp == NULL) {
+        log_fp = fopen(path, "ab"); // 保持打开，检查点时 fsync
+        journal_chain_len = 0;      // 重新打开后簇链状态未知，下一个检查点先 fsync
+    }
+    f = log_fp;
+#else
     f = fopen(path, "ab"); // 以追加模式打开文件
+#endif
 
     if (f == NULL)
     {
         ESP_LOGE(TAG, "Failed to open file for writing");
+        log_stats.card_write_errors++;
+        log_stats.card_fail_bytes += len;
+        card_write_done(len, 0);
         // 释放互斥锁
-        xSemaphoreGive(tfcard_ringbuf_mutex);
+        xSemaphoreGive(tfcard_file_mutex);
         return ESP_FAIL;
     }
 
@@ -93,8 +222,16 @@ static esp_err_t s_write_file(const char *path, const char *data,size_t len)
         if (written != chunk_size) {
             ESP_LOGE(TAG, "Failed to write data to file");
             fclose(f);
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+            // 下次写入时重新打开，提交长度在检查点时按文件实际长度记录
+            log_fp = NULL;
+            uncommitted_bytes += len - remaining;
+#endif
+            log_stats.card_write_errors++;
+            log_stats.card_fail_bytes += remaining;
+            card_write_done(len, 0);
             // 释放互斥锁
-            xSemaphoreGive(tfcard_ringbuf_mutex);
+            xSemaphoreGive(tfcard_file_mutex);
             return ESP_FAIL;
         }
         ptr += written;
@@ -105,14 +242,368 @@ static esp_err_t s_write_file(const char *path, const char *data,size_t len)
 
     // fprintf(f, "%s", data);
 
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+    uncommitted_bytes += len;
+#else
     fclose(f);
+#endif
     // ESP_LOGI(TAG, "Data written to file");
+    log_stats.card_written_bytes += len;
+    log_hist_add(log_stats.card_write_lat, esp_timer_get_time() - start_us);
+    card_write_done(len, len);
 
     // 释放互斥锁
-    xSemaphoreGive(tfcard_ringbuf_mutex);
+    xSemaphoreGive(tfcard_file_mutex);
+
+    return ESP_OK;
+}
+#endif
+
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+static esp_err_t journal_write(void)
+{
+    uint8_t rec[LOG_JOURNAL_REC_LEN];
+    log_journal_encode(&journal, rec);
+    if (fseek(journal_fp, log_journal_slot(&journal) * LOG_JOURNAL_SLOT_SIZE, SEEK_SET) != 0 ||
+        fwrite(rec, 1, sizeof(rec), journal_fp) != sizeof(rec) ||
+        fflush(journal_fp) != 0 || fsync(fileno(journal_fp)) != 0) {
+        ESP_LOGE(TAG, "Failed to write journal");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// 写提交记录；数据超出上次 fsync 的簇链时先 fsync。force 为 false 时只在到达时间或字节数阈值时执行
+static esp_err_t tfcard_checkpoint(bool force)
+{
+    int64_t now_us = esp_timer_get_time();
+    if (uncommitted_bytes == 0 || journal_fp == NULL) {
+        last_sync_us = now_us;
+        return ESP_OK;
+    }
+    if (!force && uncommitted_bytes < CONFIG_TFCARD_SYNC_BYTES && now_us - last_sync_us < SYNC_INTERVAL_US) {
+        return ESP_OK;
+    }
+    if (xSemaphoreTake(tfcard_file_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = ESP_FAIL;
+    struct stat st;
+    // fstat 取打开文件在 FATFS 中的长度，写入出错时也不会记录超出文件内容的长度
+    if (log_fp == NULL) {
+        ESP_LOGW(TAG, "Log file closed after an error, checkpoint deferred");
+    } else if (fflush(log_fp) != 0 || fstat(fileno(log_fp), &st) != 0) {
+        ESP_LOGE(TAG, "Failed to flush log file");
+        fclose(log_fp);
+        log_fp = NULL;
+    } else {
+        // 最后一个不完整的扇区还在 FATFS 的缓冲区里，不 fsync 时只提交之前的整扇区
+        uint32_t len = (uint32_t)st.st_size & ~(uint32_t)(card->csd.sector_size - 1);
+        // 数据进入了卡上簇链之外的簇，或调用方要求全部落盘：fsync 写回数据、FAT 和目录项
+        bool need_sync = force || len > journal_chain_len || journal_cluster == 0;
+        if (need_sync && fsync(fileno(log_fp)) != 0) {
+            ESP_LOGE(TAG, "Failed to sync log file");
+            fclose(log_fp);
+            log_fp = NULL;
+        } else {
+            if (need_sync) {
+                len = st.st_size;
+                journal_chain_len = (journal_cluster == 0) ? len
+                                    : (len + journal_cluster - 1) / journal_cluster * journal_cluster;
+                log_stats.card_syncs++;
+            }
+            uncommitted_bytes = 0;
+            ret = ESP_OK;
+            if (len > journal.committed_len) {
+                journal.seq++;
+                journal.committed_len = len;
+                ret = journal_write();
+            }
+        }
+    }
+    last_sync_us = esp_timer_get_time();
+    xSemaphoreGive(tfcard_file_mutex);
+    return ret;
+}
+
+// 上电恢复：只读提交记录和对应的一个文件，不扫描目录
+static void tfcard_journal_recover(void)
+{
+    int64_t start_us = esp_timer_get_time();
+    uint8_t recs[LOG_JOURNAL_SLOTS][LOG_JOURNAL_REC_LEN];
+    char drv[3] = {(char)('0' + ff_diskio_get_pdrv_card(card)), ':', 0};
+    FATFS *fs;
+    DWORD free_clusters;
+
+    // 簇大小未知时检查点每次都 fsync，恢复时不扩展文件
+    journal_cluster = (f_getfree(drv, &free_clusters, &fs) == FR_OK) ? fs->csize * card->csd.sector_size : 0;
+
+    journal_fp = fopen(JOURNAL_PATH, "r+b");
+    if (journal_fp == NULL) {
+        // 首次使用：建立两个空槽，各占一个扇区
+        journal_fp = fopen(JOURNAL_PATH, "w+b");
+        if (journal_fp == NULL) {
+            ESP_LOGE(TAG, "Failed to create journal, checkpoints disabled");
+            return;
+        }
+        static const uint8_t zero[LOG_JOURNAL_SLOT_SIZE];
+        bool ok = true;
+        for (int i = 0; i < LOG_JOURNAL_SLOTS && ok; i++) {
+            ok = fwrite(zero, 1, sizeof(zero), journal_fp) == sizeof(zero);
+        }
+        // 空槽没有完整落盘时，之后的提交记录掉电后不一定可读，和创建失败一样停用检查点
+        if (!ok || fflush(journal_fp) != 0 || fsync(fileno(journal_fp)) != 0) {
+            ESP_LOGE(TAG, "Failed to initialise journal, checkpoints disabled");
+            fclose(journal_fp);
+            journal_fp = NULL;
+        }
+        return;
+    }
+
+    memset(recs, 0, sizeof(recs));
+    for (int i = 0; i < LOG_JOURNAL_SLOTS; i++) {
+        fseek(journal_fp, i * LOG_JOURNAL_SLOT_SIZE, SEEK_SET);
+        fread(recs[i], 1, LOG_JOURNAL_REC_LEN, journal_fp);
+    }
+    log_journal_rec_t rec;
+    if (log_journal_latest(recs, LOG_JOURNAL_SLOTS, &rec) < 0) {
+        ESP_LOGW(TAG, "No valid journal record");
+        return;
+    }
+    journal.seq = rec.seq;
+    last_file_index = rec.file_index;
+
+    char path[sizeof(log_file_path)];
+    struct stat st;
+    snprintf(path, sizeof(path), LOG_FILE_FMT, MOUNT_POINT, (int)rec.file_index);
+    if (stat(path, &st) != 0) {
+        ESP_LOGW(TAG, "Journaled file %s is missing", path);
+        return;
+    }
+    if ((uint32_t)st.st_size < rec.committed_len && journal_cluster != 0) {
+        // 目录项长度落后于已提交长度（两次 fsync 之间断电）。fsync 先写 FAT 再写目录项，
+        // 卡上的簇链至少覆盖目录项长度所在的整簇；只在这个范围内扩展，lseek 不会分配新簇，
+        // 扩展出的部分就是提交前已写到卡上的数据，再 fsync 写回目录项
+        uint32_t chain = ((uint32_t)st.st_size + journal_cluster - 1) / journal_cluster * journal_cluster;
+        uint32_t len = rec.committed_len;
+        if (len > chain) {
+            ESP_LOGW(TAG, "Committed length %" PRIu32 " beyond the cluster chain, recovering %" PRIu32 " bytes",
+                     len, chain);
+            len = chain;
+        }
+        int fd = (len > (uint32_t)st.st_size) ? open(path, O_WRONLY) : -1;
+        if (fd >= 0 && lseek(fd, len, SEEK_SET) == (off_t)len && fsync(fd) == 0) {
+            log_stats.card_recovered_bytes = len - st.st_size;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    ESP_LOGI(TAG, "Journal: %s committed %" PRIu32 " bytes, size %ld, recovered %" PRIu32 " bytes in %lld ms",
+             path, rec.committed_len, (long)st.st_size, log_stats.card_recovered_bytes,
+             (long long)((esp_timer_get_time() - start_us) / 1000));
+}
+
+// 切换到新日志文件时立即写一条长度为 0 的记录，保证恢复时能找到它
+static void tfcard_journal_start(int file_index)
+{
+    if (journal_fp == NULL) {
+        return;
+    }
+    journal.seq++;
+    journal.file_index = file_index;
+    journal.committed_len = 0;
+    journal_write();
+    last_sync_us = esp_timer_get_time();
+}
+#endif
+
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+static int raw_read_sectors(void *ctx, uint32_t lba, void *buf, uint32_t count)
+{
+    return (sdmmc_read_sectors(card, buf, lba, count) == ESP_OK) ? 0 : -1;
+}
+
+static int raw_write_sectors(void *ctx, uint32_t lba, const void *buf, uint32_t count)
+{
+    return (sdmmc_write_sectors(card, buf, lba, count) == ESP_OK) ? 0 : -1;
+}
+
+// 裸扇区模式下的 s_write_file：追加到当前段，写满一段时 log_raw 自动提交并换段
+static esp_err_t s_write_raw(const char *data, size_t len)
+{
+    if (xSemaphoreTake(tfcard_file_mutex, portMAX_DELAY) != pdTRUE)
+    {
+        return ESP_FAIL;
+    }
+    LOG_TRACE(LOG_TRACE_CH_CARD, LOG_TRACE_CARD_WRITE_BEGIN, len);
+    int64_t start_us = esp_timer_get_time();
+    if (log_raw_append(&raw_log, data, len, start_us) != 0)
+    {
+        ESP_LOGE(TAG, "Failed to write raw log segment %" PRIu32, raw_log.seg);
+        log_stats.card_write_errors++;
+        log_stats.card_fail_bytes += len;
+        card_write_done(len, 0);
+        xSemaphoreGive(tfcard_file_mutex);
+        return ESP_FAIL;
+    }
+    uncommitted_bytes += len;
+    log_stats.card_written_bytes += len;
+    log_hist_add(log_stats.card_write_lat, esp_timer_get_time() - start_us);
+    card_write_done(len, len);
+    xSemaphoreGive(tfcard_file_mutex);
+    return ESP_OK;
+}
+
+// 写出未满扇区的数据并重写段头；force 为 false 时只在到达时间或字节数阈值时执行
+static esp_err_t tfcard_checkpoint(bool force)
+{
+    int64_t now_us = esp_timer_get_time();
+    if (uncommitted_bytes == 0 || card == NULL) {
+        last_sync_us = now_us;
+        return ESP_OK;
+    }
+    if (!force && uncommitted_bytes < CONFIG_TFCARD_SYNC_BYTES && now_us - last_sync_us < SYNC_INTERVAL_US) {
+        return ESP_OK;
+    }
+    if (xSemaphoreTake(tfcard_file_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    esp_err_t ret = ESP_OK;
+    if (log_raw_commit(&raw_log) != 0) {
+        ESP_LOGE(TAG, "Failed to commit raw log segment %" PRIu32, raw_log.seg);
+        ret = ESP_FAIL;
+    } else {
+        uncommitted_bytes = 0;
+        log_stats.card_syncs++;
+    }
+    last_sync_us = esp_timer_get_time();
+    xSemaphoreGive(tfcard_file_mutex);
+    return ret;
+}
 
+// 只初始化卡，不挂载文件系统，过程与 esp_vfs_fat_sdspi_mount 的前半部分相同
+static esp_err_t tfcard_raw_attach(void)
+{
+    sdmmc_host_t host = sd_host;
+    sdspi_dev_handle_t handle;
+    esp_err_t ret = host.init();
+    if (ret != ESP_OK || (ret = sdspi_host_init_device(&sd_slot_config, &handle)) != ESP_OK)
+    {
+        return ret;
+    }
+    host.slot = handle;
+    memset(&raw_card, 0, sizeof(raw_card));
+    card = &raw_card;
+    ret = sdmmc_card_init(&host, card);
+    if (ret != ESP_OK)
+    {
+        sdspi_host_remove_device(handle);
+        card = NULL;
+    }
+    return ret;
+}
+
+static void tfcard_raw_detach(void)
+{
+    sdspi_host_remove_device(card->host.slot);
+    card = NULL;
+}
+
+// 读超级块并二分查找最新的段；没有超级块时按 CONFIG_TFCARD_RAW_FORMAT_CARD 接管这张卡
+static esp_err_t tfcard_raw_recover(void)
+{
+    int64_t start_us = esp_timer_get_time();
+    log_raw_dev_t dev = {
+        .read = raw_read_sectors,
+        .write = raw_write_sectors,
+        .sectors = card->csd.capacity,
+    };
+    int ret = log_raw_mount(&raw_log, &dev);
+    if (ret == LOG_RAW_ERR_NOFS)
+    {
+#ifdef CONFIG_TFCARD_RAW_FORMAT_CARD
+        ESP_LOGW(TAG, "No raw log on the card, writing superblock (%d KB segments)", CONFIG_TFCARD_RAW_SEGMENT_KB);
+        ret = log_raw_format(&raw_log, &dev, RAW_SEG_SECTORS, esp_random());
+#else
+        ESP_LOGE(TAG, "No raw log on the card and CONFIG_TFCARD_RAW_FORMAT_CARD is off, card left untouched");
+#endif
+    }
+    if (ret != 0)
+    {
+        ESP_LOGE(TAG, "Raw log mount failed (%d)", ret);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Raw log: %" PRIu32 " x %" PRIu32 " KB segments, head %s segment %" PRIu32 " seq %" PRIu32
+             " (%" PRIu32 " bytes), found in %lld ms",
+             raw_log.seg_count, raw_log.seg_sectors * LOG_RAW_SECTOR / 1024, raw_log.empty ? "none," : "at",
+             raw_log.seg, raw_log.cur.seq, raw_log.cur.len, (long long)((esp_timer_get_time() - start_us) / 1000));
     return ESP_OK;
 }
+#endif
+
+// 把已写入的数据持久化（日志模式下强制检查点），供低电量等场景调用
+esp_err_t tfcard_sync(void)
+{
+#ifdef TFCARD_CHECKPOINT
+    return tfcard_checkpoint(true);
+#else
+    return ESP_OK; // 每次写入后都会关闭文件
+#endif
+}
+
+// 持久化并关闭日志文件，之后的写入会重新以追加方式打开
+static void tfcard_close_log(void)
+{
+#ifdef TFCARD_CHECKPOINT
+    tfcard_checkpoint(true);
+#endif
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+    if (xSemaphoreTake(tfcard_file_mutex, portMAX_DELAY) == pdTRUE) {
+        if (log_fp != NULL) {
+            fclose(log_fp);
+            log_fp = NULL;
+        }
+        xSemaphoreGive(tfcard_file_mutex);
+    }
+#endif
+}
+
+// 停止接收新数据，等待 tfcard_task 把缓冲区全部写入并关闭日志文件
+esp_err_t tfcard_emergency_stop(uint32_t timeout_ms)
+{
+    if (tfcard_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // 在锁内修改，保证返回后不会再有数据进入环形缓冲区
+    xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY);
+    tfcard_accepting = false;
+    xSemaphoreGive(tfcard_ringbuf_mutex);
+
+    tfcard_stop_req = true;
+    xTaskNotifyGive(tfcard_task_handle);
+    return (xSemaphoreTake(tfcard_stop_done, pdMS_TO_TICKS(timeout_ms)) == pdTRUE) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void tfcard_resume(void)
+{
+    if (tfcard_task_handle == NULL || tfcard_accepting) {
+        return;
+    }
+    tfcard_accepting = true;
+    xTaskNotifyGive(tfcard_task_handle);
+}
+
+// log_writer 的写出回调，ctx 为日志文件路径
+static int tfcard_sink(void *ctx, const char *data, size_t len)
+{
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+    return (s_write_raw(data, len) == ESP_OK) ? 0 : -1;
+#else
+    return (s_write_file((const char *)ctx, data, len) == ESP_OK) ? 0 : -1;
+#endif
+}
 
 static esp_err_t s_read_file(const char *path)
 {
@@ -138,23 +629,18 @@ static esp_err_t s_read_file(const char *path)
     return ESP_OK;
 }
 
+#ifndef CONFIG_TFCARD_STORAGE_RAW
+// 按格式化配置的簇大小格式化；卡容量达到 32 GB 且 FATFS 编译了 exFAT（FF_FS_EXFAT）时 FatFs 会选择 exFAT
 void format_tfcard(char mount_point[],sdmmc_card_t *card)
 
 {
     esp_err_t ret;
-    ret = esp_vfs_fat_sdcard_unmount(mount_point,card);
-
-    if (ret != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Failed to unmount SD card");
-        return;
-    }
 
     ESP_LOGW(TAG, "SD card will be formated after 5 seconds!!!!!!!!!!!");
     vTaskDelay(pdMS_TO_TICKS(5000));
-    ESP_LOGW(TAG, "SD card will be formated now!!!!!!!!!!!");
+    ESP_LOGW(TAG, "SD card will be formated now, %d KB clusters!!!!!!!!!!!", CONFIG_TFCARD_ALLOC_UNIT_KB);
 
-    ret = esp_vfs_fat_sdcard_format(mount_point, card);
+    ret = esp_vfs_fat_sdcard_format_cfg(mount_point, card, &sd_mount_config);
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "Failed to format FATFS (%s)", esp_err_to_name(ret));
@@ -163,97 +649,360 @@ void format_tfcard(char mount_point[],sdmmc_card_t *card)
 
 }
 
+// 打印文件系统类型、簇大小，以及数据区是否与卡的擦除单元（AU）对齐
+static void tfcard_log_fs_layout(void)
+{
+    static const char *fs_names[] = {"?", "FAT12", "FAT16", "FAT32", "exFAT"};
+    char drv[3] = {(char)('0' + ff_diskio_get_pdrv_card(card)), ':', 0};
+    FATFS *fs;
+    DWORD free_clusters;
 
-// 动态调整缓冲区大小
-static bool resize_ringbuffer()
+    if (f_getfree(drv, &free_clusters, &fs) != FR_OK)
+    {
+        return;
+    }
+    uint32_t cluster_kb = fs->csize * card->csd.sector_size / 1024;
+    uint32_t au_kb = card->ssr.alloc_unit_kb;
+    uint32_t data_kb = (uint32_t)(fs->database * card->csd.sector_size / 1024);
+    ESP_LOGI(TAG, "%s, %" PRIu32 " KB clusters, %" PRIu32 " MB free, data area at %" PRIu32 " KB%s",
+             fs_names[fs->fs_type < 5 ? fs->fs_type : 0], cluster_kb,
+             (uint32_t)((uint64_t)free_clusters * cluster_kb / 1024), data_kb,
+             (au_kb != 0 && data_kb % au_kb != 0) ? " (not aligned to the card's AU)" : "");
+    if (cluster_kb < CONFIG_TFCARD_ALLOC_UNIT_KB)
+    {
+        ESP_LOGW(TAG, "Card uses %" PRIu32 " KB clusters, reformat for the %d KB logging profile",
+                 cluster_kb, CONFIG_TFCARD_ALLOC_UNIT_KB);
+    }
+}
+#endif
+
+
+static esp_err_t sd_set_freq(uint32_t freq_khz)
 {
-    static size_t buffer_size = BUFFER_SIZE;
-    size_t buffer_free = xRingbufferGetCurFreeSize(tfcard_ringbuf);
-    // ESP_LOGI(TAG, "buffer_size: %d, buffer_free: %d", buffer_size, buffer_free);
-    if ((float)buffer_free / buffer_size <= BUFFER_RESIZE_THRESHOLD)
+    int real_khz = 0;
+    esp_err_t ret = card->host.set_card_clk(card->host.slot, freq_khz);
+    if (ret == ESP_OK && card->host.get_real_freq(card->host.slot, &real_khz) == ESP_OK)
     {
+        card->real_freq_khz = real_khz;
+        log_stats.card_clk_khz = real_khz;
+    }
+    return ret;
+}
 
-        if (buffer_size + BUFFER_RESIZE_STEP > BUFFER_MAX_SIZE) {
-            ESP_LOGE(TAG, "Cannot resize buffer beyond max size %d", BUFFER_MAX_SIZE);
+static bool sd_probe_read(uint32_t ref_crc)
+{
+    for (int i = 0; i < SD_PROBE_ROUNDS; i++)
+    {
+        if (sdmmc_read_sectors(card, sd_probe_buf, 0, SD_PROBE_SECTORS) != ESP_OK ||
+            log_crc32(0, sd_probe_buf, sizeof(sd_probe_buf)) != ref_crc)
+        {
             return false;
         }
+    }
+    return true;
+}
 
-        if (xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY) == pdTRUE)
-        { // 获取互斥锁
-            RingbufHandle_t new_ringbuf = xRingbufferCreate(buffer_size + BUFFER_RESIZE_STEP, RINGBUF_TYPE_BYTEBUF);
-            if (new_ringbuf == NULL)
-            {
-                ESP_LOGE(TAG, "Failed to create new ring buffer for resizing");
-                xSemaphoreGive(tfcard_ringbuf_mutex); // 释放互斥锁
-                return false;
-            }
+// 以挂载时的时钟读出参考数据，再从不超过 sd_freq_limit_khz 的最高档开始试读；
+// 试读结果与参考数据按 CRC 比较，只需一块静态缓冲区
+static void tfcard_probe_clock(void)
+{
+    uint32_t base_khz = card->real_freq_khz;
+    uint32_t ref_crc;
 
-            // 将旧缓冲区的数据转移到新缓冲区
-            size_t item_size;
-            void *item;
-            while ((item = xRingbufferReceive(tfcard_ringbuf, &item_size, 0)) != NULL)
-            {
-                if (!xRingbufferSend(new_ringbuf, item, item_size, 0))
-                {
-                    ESP_LOGE(TAG, "Failed to transfer data to new ring buffer");
-                    vRingbufferReturnItem(tfcard_ringbuf, item);
-                    vRingbufferDelete(new_ringbuf);
-                    xSemaphoreGive(tfcard_ringbuf_mutex); // 释放互斥锁
-                    return false;
-                }
-                vRingbufferReturnItem(tfcard_ringbuf, item);
-            }
+    if (card->csd.sector_size != SD_PROBE_SECTOR_SIZE ||
+        sdmmc_read_sectors(card, sd_probe_buf, 0, SD_PROBE_SECTORS) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Clock probe skipped, staying at %d kHz", card->real_freq_khz);
+        log_stats.card_clk_khz = card->real_freq_khz;
+        return;
+    }
+    ref_crc = log_crc32(0, sd_probe_buf, sizeof(sd_probe_buf));
+    for (size_t i = 0; i < SD_FREQ_STEPS; i++)
+    {
+        uint32_t freq = sd_freq_ladder_khz[i];
+        if (freq > sd_freq_limit_khz)
+        {
+            continue;
+        }
+        if (freq <= base_khz)
+        {
+            break;
+        }
+        if (sd_set_freq(freq) == ESP_OK && sd_probe_read(ref_crc))
+        {
+            base_khz = 0;
+            break;
+        }
+        ESP_LOGW(TAG, "Clock probe failed at %" PRIu32 " kHz", freq);
+    }
+    if (base_khz != 0)
+    {
+        sd_set_freq(base_khz); // 没有更高的稳定档位，回到挂载时的时钟
+    }
+    ESP_LOGI(TAG, "SD SPI clock %d kHz (limit %" PRIu32 " kHz)", card->real_freq_khz, sd_freq_limit_khz);
+}
+
+// 降一档并把上限固定在新档位，之后重新挂载也不会再试更高的时钟
+static void tfcard_clock_step_down(void)
+{
+    for (size_t i = 0; i < SD_FREQ_STEPS; i++)
+    {
+        if (sd_freq_ladder_khz[i] < (uint32_t)card->real_freq_khz)
+        {
+            int old_khz = card->real_freq_khz;
+            sd_freq_limit_khz = sd_freq_ladder_khz[i];
+            sd_set_freq(sd_freq_limit_khz);
+            log_stats.card_clk_steps++;
+            ESP_LOGW(TAG, "Repeated write errors, SD SPI clock %d -> %d kHz", old_khz, card->real_freq_khz);
+            return;
+        }
+    }
+}
 
-            vRingbufferDelete(tfcard_ringbuf);
-            tfcard_ringbuf = new_ringbuf;
-            ESP_LOGI(TAG, "Ring buffer resized to %d bytes", buffer_size + BUFFER_RESIZE_STEP);
-            buffer_size += BUFFER_RESIZE_STEP;
+// 挂载文件系统，成功后做日志恢复。启动时和卡重新插入后都走这里
+static esp_err_t tfcard_mount(void)
+{
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+    esp_err_t ret = tfcard_raw_attach();
+#else
+    esp_err_t ret = esp_vfs_fat_sdspi_mount(mount_point, &sd_host, &sd_slot_config, &sd_mount_config, &card);
+#endif
 
-            xSemaphoreGive(tfcard_ringbuf_mutex); // 释放互斥锁
+    if (ret != ESP_OK)
+    {
+        if (ret == ESP_FAIL)
+        {
+            ESP_LOGE(TAG, "Failed to mount filesystem. "
+                          "If you want the card to be formatted, set the CONFIG_FORMAT_IF_MOUNT_FAILED menuconfig option.");
+            sdcard_init_state = TF_CARD_STATE_UNMOUNT;
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Failed to initialize the card (%s). "
+                          "Make sure SD card lines have pull-up resistors in place.",
+                     esp_err_to_name(ret));
+            sdcard_init_state = TF_CARD_STATE_UNINIT;
+#ifdef CONFIG_DEBUG_PIN_CONNECTIONS
+            check_sd_card_pins(&config, pin_count);
+#endif
+        }
+        return ret;
+    }
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+    tfcard_probe_clock();
+    if (tfcard_raw_recover() != ESP_OK)
+    {
+        tfcard_raw_detach();
+        sdcard_init_state = TF_CARD_STATE_UNMOUNT;
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Card initialized for raw logging");
+#else
+    ESP_LOGI(TAG, "Filesystem mounted");
+    tfcard_probe_clock();
+#endif
+
+    sdcard_init_state = TF_CARD_STATE_MOUNT;
+    log_stats.card_mounts++;
+
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+    tfcard_journal_recover();
+#endif
+
+    led_set_state(LOG_LED_CARD_ERR, false);
+
+    // Card has been initialized, print its properties
+    sdmmc_card_print_info(stdout, card);
+#ifndef CONFIG_TFCARD_STORAGE_RAW
+    tfcard_log_fs_layout();
+#endif
+    return ESP_OK;
+}
+
+// 卡被拔出或不再响应：关闭文件并卸载，环形缓冲区中的数据保留到重新挂载后再写
+static void tfcard_unmount(void)
+{
+    xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY);
+    sdcard_init_state = TF_CARD_STATE_UNMOUNT;
+    xSemaphoreGive(tfcard_ringbuf_mutex);
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+    xSemaphoreTake(tfcard_file_mutex, portMAX_DELAY);
+    if (log_fp != NULL) {
+        fclose(log_fp);
+        log_fp = NULL;
+    }
+    if (journal_fp != NULL) {
+        fclose(journal_fp);
+        journal_fp = NULL;
+    }
+    uncommitted_bytes = 0;
+    xSemaphoreGive(tfcard_file_mutex);
+#endif
+
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+    // 卡已不在，当前段未提交的数据随之丢失，重新挂载后从新的一段开始
+    xSemaphoreTake(tfcard_file_mutex, portMAX_DELAY);
+    uncommitted_bytes = 0;
+    tfcard_raw_detach();
+    xSemaphoreGive(tfcard_file_mutex);
+#else
+    esp_vfs_fat_sdcard_unmount(mount_point, card);
+    card = NULL;
+#endif
+    log_stats.card_removals++;
+    led_set_state(LOG_LED_WRITING, false);
+    led_set_state(LOG_LED_CARD_ERR, true);
+    ESP_LOGW(TAG, "Card removed, buffering to RAM until it is back");
+}
+
+#ifdef CONFIG_TFCARD_SPILL_ENABLE
+static int spill_flash_read(void *ctx, uint32_t addr, void *buf, size_t len)
+{
+    return (esp_partition_read((const esp_partition_t *)ctx, addr, buf, len) == ESP_OK) ? 0 : -1;
+}
+
+static int spill_flash_write(void *ctx, uint32_t addr, const void *buf, size_t len)
+{
+    return (esp_partition_write((const esp_partition_t *)ctx, addr, buf, len) == ESP_OK) ? 0 : -1;
+}
+
+static int spill_flash_erase(void *ctx, uint32_t addr, size_t len)
+{
+    return (esp_partition_erase_range((const esp_partition_t *)ctx, addr, len) == ESP_OK) ? 0 : -1;
+}
+
+// 分区内容不跨重启保留，每次启动从空开始，扇区在第一次写入前擦除
+static void tfcard_spill_init(void)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           SPILL_PARTITION_LABEL);
+    if (part == NULL)
+    {
+        ESP_LOGE(TAG, "Partition '%s' not found, spill disabled", SPILL_PARTITION_LABEL);
+        return;
+    }
+    log_spill_flash_t flash = {
+        .read = spill_flash_read,
+        .write = spill_flash_write,
+        .erase = spill_flash_erase,
+        .ctx = (void *)part,
+        .size = part->size,
+        .sector_size = part->erase_size,
+    };
+    if (!log_spill_init(&spill, &flash))
+    {
+        ESP_LOGE(TAG, "Partition '%s' is too small, spill disabled", SPILL_PARTITION_LABEL);
+        return;
+    }
+    spill_ready = true;
+    ESP_LOGI(TAG, "Spill partition: %" PRIu32 " KB above %d%% of the ring", spill.capacity / 1024,
+             CONFIG_TFCARD_SPILL_WATERMARK);
+}
+
+// 在 tfcard_ringbuf_mutex 内调用。超过水位或分区里已有数据时写入分区（保证读回顺序），
+// 返回 false 表示应写入环形缓冲区；分区写满时等待 tfcard_task 读回，卡不在或停止接收时丢弃
+static bool tfcard_spill_push(const char *data, size_t len)
+{
+    if (!spill_ready)
+    {
+        return false;
+    }
+    size_t ring_used = log_stats.card_ring_size - xRingbufferGetCurFreeSize(tfcard_ringbuf);
+    if (log_spill_used(&spill) == 0 && ring_used + len <= log_stats.card_ring_size * CONFIG_TFCARD_SPILL_WATERMARK / 100)
+    {
+        return false;
+    }
+    while (!log_spill_write(&spill, data, len))
+    {
+        if (spill.failed)
+        {
+            // Flash 出错：之后只用环形缓冲区，分区里剩余的数据仍会读回
+            ESP_LOGE(TAG, "Spill partition write failed, spill disabled");
+            spill_ready = false;
+            return false;
+        }
+        if (!tfcard_accepting || GetTfCardState() != TF_CARD_STATE_MOUNT)
+        {
+            log_stats.card_drop_bytes += len;
             return true;
         }
+        xSemaphoreGive(tfcard_ringbuf_mutex);
+        vTaskDelay(pdMS_TO_TICKS(100));
+        xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY);
     }
-    return false;
+    log_stats.card_in_bytes += len;
+    log_stats.card_spill_bytes += len;
+    LOG_LAT_MARK(LOG_LAT_CARD, log_stats.card_in_bytes);
+    log_stats_update_hwm(&log_stats.card_spill_hwm, log_spill_used(&spill));
+    return true;
 }
 
+// 环形缓冲区为空时才从分区读回，锁内检查保证不会越过先写入环形缓冲区的数据
+static bool tfcard_spill_drain(log_writer_t *writer)
+{
+    static char buf[SPILL_DRAIN_MAX];
+    UBaseType_t ring_bytes;
+    uint32_t n = 0;
+
+    if (log_spill_used(&spill) == 0)
+    {
+        return false;
+    }
+    xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY);
+    vRingbufferGetInfo(tfcard_ringbuf, NULL, NULL, NULL, NULL, &ring_bytes);
+    if (ring_bytes == 0)
+    {
+        n = log_spill_read(&spill, buf, sizeof(buf));
+    }
+    xSemaphoreGive(tfcard_ringbuf_mutex);
+    if (n > 0)
+    {
+        log_writer_push(writer, buf, n);
+    }
+    return n > 0;
+}
+#endif
+
 void tfcard_init(void)
 {
     esp_err_t ret;
 
     tfcard_ringbuf_mutex = xSemaphoreCreateMutex(); // 创建互斥锁
-    if (tfcard_ringbuf_mutex == NULL)
+    tfcard_file_mutex = xSemaphoreCreateMutex();
+    if (tfcard_ringbuf_mutex == NULL || tfcard_file_mutex == NULL)
     {
         ESP_LOGE(TAG, "Failed to create mutex for ring buffer");
         return;
     }
 
     // 创建环形缓冲区
-    tfcard_ringbuf = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
+    tfcard_ringbuf = xRingbufferCreateStatic(BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF, tfcard_ring_storage,
+                                             &tfcard_ring_struct);
     if (tfcard_ringbuf == NULL)
     {
         ESP_LOGE(TAG, "Failed to create ring buffer");
         return;
     }
-
-    // Options for mounting the filesystem.
-    // If format_if_mount_failed is set to true, SD card will be partitioned and
-    // formatted in case when mounting fails.
-    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
-        .max_files = 5,
-        .allocation_unit_size = 16 * 1024};
+    log_stats.card_ring_size = BUFFER_SIZE;
+    log_mem_add_static(LOG_MEM_CARD, sizeof(tfcard_ring_storage) + sizeof(tfcard_ring_struct) +
+                                     sizeof(sd_probe_buf) + sizeof(log_file_path));
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+    log_mem_add_static(LOG_MEM_CARD, sizeof(raw_log) + sizeof(raw_card));
+#endif
+#ifdef CONFIG_TFCARD_SPILL_ENABLE
+    tfcard_spill_init();
+#endif
 
     ESP_LOGI(TAG, "Initializing SD card");
 
     // Use settings defined above to initialize SD card and mount FAT filesystem.
     // Note: esp_vfs_fat_sdmmc/sdspi_mount is all-in-one convenience functions.
-    // Please check its source code and implement error recovery when developing
-    // production applications.
+    // 挂载失败和卡拔出由 tfcard_task 重试挂载处理
     ESP_LOGI(TAG, "Using SPI peripheral");
 
     // By default, SD card frequency is initialized to SDMMC_FREQ_DEFAULT (20MHz)
     // For setting a specific frequency, use host.max_freq_khz (range 400kHz - 20MHz for SDSPI)
     // Example: for fixed frequency of 10MHz, use host.max_freq_khz = 10000;
-    sdmmc_host_t host = SDSPI_HOST_DEFAULT();
 
     spi_bus_config_t bus_cfg = {
         .mosi_io_num = PIN_NUM_MOSI,
@@ -261,10 +1010,10 @@ void tfcard_init(void)
         .sclk_io_num = PIN_NUM_CLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = 4000,
+        .max_transfer_sz = SD_ALLOC_UNIT + 512, // 整簇写入加上命令/CRC 的余量
     };
 
-    ret = spi_bus_initialize(host.slot, &bus_cfg, SDSPI_DEFAULT_DMA);
+    ret = spi_bus_initialize(sd_host.slot, &bus_cfg, SDSPI_DEFAULT_DMA);
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "Failed to initialize bus.");
@@ -273,50 +1022,42 @@ void tfcard_init(void)
 
     // This initializes the slot without card detect (CD) and write protect (WP) signals.
     // Modify slot_config.gpio_cd and slot_config.gpio_wp if your board has these signals.
-    sdspi_device_config_t slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
-    slot_config.gpio_cs = PIN_NUM_CS;
-    slot_config.host_id = host.slot;
+    sd_slot_config.gpio_cs = PIN_NUM_CS;
+    sd_slot_config.host_id = sd_host.slot;
 
+    // 启动时没有卡也创建任务：数据先进入环形缓冲区，由任务重试挂载
     ESP_LOGI(TAG, "Mounting filesystem");
-    ret = esp_vfs_fat_sdspi_mount(mount_point, &host, &slot_config, &mount_config, &card);
-
-    if (ret != ESP_OK)
-    {
-        if (ret == ESP_FAIL)
-        {
-            ESP_LOGE(TAG, "Failed to mount filesystem. "
-                          "If you want the card to be formatted, set the CONFIG_FORMAT_IF_MOUNT_FAILED menuconfig option.");
-            sdcard_init_state = TF_CARD_STATE_UNMOUNT;
-        }
-        else
-        {
-            ESP_LOGE(TAG, "Failed to initialize the card (%s). "
-                          "Make sure SD card lines have pull-up resistors in place.",
-                     esp_err_to_name(ret));
-            sdcard_init_state = TF_CARD_STATE_UNINIT;
-#ifdef CONFIG_DEBUG_PIN_CONNECTIONS
-            check_sd_card_pins(&config, pin_count);
-#endif
-        }
-        return;
-    }
-    ESP_LOGI(TAG, "Filesystem mounted");
-
-    sdcard_init_state = TF_CARD_STATE_MOUNT;
-
-    ok_led();
-
-    // Card has been initialized, print its properties
-    sdmmc_card_print_info(stdout, card);
+    tfcard_mount();
 
     // 创建 TF 卡任务
-    xTaskCreate(tfcard_task, "tfcard_task", 4096 * 2, NULL, 5, NULL);
+    tfcard_stop_done = xSemaphoreCreateBinary();
+    xTaskCreate(tfcard_task, "tfcard_task", TASK_STACK_TFCARD, NULL, TASK_PRIO_TFCARD, &tfcard_task_handle);
 }
 
 void tfcard_deinit(void)
 {
-    esp_vfs_fat_sdcard_unmount(MOUNT_POINT, card);
-    ESP_LOGI(TAG, "Card unmounted");
+#ifdef TFCARD_CHECKPOINT
+    tfcard_checkpoint(true);
+#endif
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+    if (log_fp != NULL) {
+        fclose(log_fp);
+        log_fp = NULL;
+    }
+    if (journal_fp != NULL) {
+        fclose(journal_fp);
+        journal_fp = NULL;
+    }
+#endif
+    if (sdcard_init_state == TF_CARD_STATE_MOUNT) {
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+        tfcard_raw_detach();
+#else
+        esp_vfs_fat_sdcard_unmount(MOUNT_POINT, card);
+#endif
+        sdcard_init_state = TF_CARD_STATE_UNMOUNT;
+        ESP_LOGI(TAG, "Card unmounted");
+    }
 }
 
 uint8_t GetTfCardState(void)
@@ -324,82 +1065,138 @@ uint8_t GetTfCardState(void)
     return sdcard_init_state;
 }
 
-// TF 卡任务函数
-void tfcard_task(void *pvParameters)
+const char *tfcard_get_log_path(void)
+{
+    return log_file_path;
+}
+
+// 紧急停止：把环形缓冲区剩余数据全部写入并关闭文件，然后等待恢复
+static void tfcard_drain_and_stop(log_writer_t *writer)
 {
-    char file_path[128]; // 足够存储带序号的文件名
-    int file_index = 1;
+    size_t item_size;
+    char *data;
+    int64_t start_us = esp_timer_get_time();
+
+    // 卡不在时数据留在环形缓冲区里，什么也写不了
+    while (sdcard_init_state == TF_CARD_STATE_MOUNT &&
+           (data = (char *)xRingbufferReceive(tfcard_ringbuf, &item_size, 0)) != NULL)
+    {
+        log_writer_push(writer, data, item_size);
+        vRingbufferReturnItem(tfcard_ringbuf, (void *)data);
+    }
+#ifdef CONFIG_TFCARD_SPILL_ENABLE
+    while (sdcard_init_state == TF_CARD_STATE_MOUNT && tfcard_spill_drain(writer))
+    {
+    }
+#endif
+    log_writer_flush(writer);
+    tfcard_close_log();
+    power_lock_release(POWER_LOCK_CARD);
+    tfcard_stop_req = false;
+    ESP_LOGW(TAG, "Logging stopped, buffers flushed in %lld ms", (long long)((esp_timer_get_time() - start_us) / 1000));
+    xSemaphoreGive(tfcard_stop_done);
+
+    while (!tfcard_accepting)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    ESP_LOGI(TAG, "Logging resumed");
+}
+
+#ifdef CONFIG_TFCARD_STORAGE_RAW
+// 每次挂载从最新段的下一段开始新的会话，导出时每个会话对应一个文件
+static void tfcard_open_session(void)
+{
+    xSemaphoreTake(tfcard_file_mutex, portMAX_DELAY);
+    if (log_raw_begin(&raw_log, esp_timer_get_time()) != 0)
+    {
+        // 段头在第一次提交时会重写，这里失败不影响后续写入
+        ESP_LOGW(TAG, "Failed to write raw log segment header");
+    }
+    xSemaphoreGive(tfcard_file_mutex);
+    last_sync_us = esp_timer_get_time();
+    log_file_path[0] = '\0'; // 没有日志文件，BLE 文件查询不可用
+    ESP_LOGI(TAG, "Raw log session %" PRIu32 " from segment %" PRIu32, raw_log.cur.session, raw_log.seg);
+}
+#else
+// 在新挂载的卡上选择日志文件名
+static void tfcard_open_session(void)
+{
+    char *file_path = log_file_path; // 足够存储带序号的文件名
+    int file_index = last_file_index + 1; // 有提交记录时直接从上次的序号之后开始，通常只需 stat 一次
     struct stat st;
 
     // 注意FATFS默认是8.3文件名，长文件名需要打开FATFS_LONG_FILENAMES，才支持比较现代的文件名格式
     //  查找可用的日志文件名
     do
     {
-        snprintf(file_path, sizeof(file_path), "%s/tfcard_log_data_%d.txt", MOUNT_POINT, file_index);
+        snprintf(file_path, sizeof(log_file_path), LOG_FILE_FMT, MOUNT_POINT, file_index);
         file_index++;
     } while (stat(file_path, &st) == 0);
+    last_file_index = file_index - 1;
+#ifdef CONFIG_TFCARD_JOURNAL_ENABLE
+    tfcard_journal_start(file_index - 1);
+#endif
+
+    ESP_LOGI(TAG, "Using log file: %s", file_path);
+}
+#endif
 
-    // ESP_LOGI(TAG, "Using log file: %s", file_path);
+// 写卡失败后确认卡是否还在，不响应则视为拔出
+static bool tfcard_lost(void)
+{
+    return sdmmc_get_status(card) != ESP_OK;
+}
 
+// 卡挂载期间的写卡循环，卡被拔出时返回
+static void tfcard_log_session(log_writer_t *writer)
+{
     size_t item_size;
     char *data;
-    char write_buffer[1024];
-    size_t buffer_index = 0;
     uint64_t last_idle_time = 0;
     uint64_t idle_time = 0;
+    uint32_t sink_errors = writer->sink_errors;
+    uint32_t sink_calls = writer->sink_calls;
+    uint32_t link_errors = 0; // 卡仍在线时的连续写失败次数
+    bool spill_pending = false;
 
     while (1)
     {
-        // 尝试动态调整缓冲区大小
-        resize_ringbuffer();
+        if (tfcard_stop_req)
+        {
+            tfcard_drain_and_stop(writer);
+        }
+
+        // 写卡间隔来自运行配置（flush_ms），可在线修改
+        TickType_t write_interval = pdMS_TO_TICKS(app_config()->flush_ms);
 
-        // 从环形缓冲区读取数据
-        data = (char *)xRingbufferReceive(tfcard_ringbuf, &item_size, WRITE_INTERVAL);
+        // 从环形缓冲区读取数据，溢出分区有数据待读回时不等待
+        data = (char *)xRingbufferReceive(tfcard_ringbuf, &item_size, spill_pending ? 0 : write_interval);
         if (data != NULL)
         {
             idle_time = esp_timer_get_time();
+            LOG_TRACE(LOG_TRACE_CH_CARD, LOG_TRACE_CARD_DEQ, item_size);
+            power_lock_acquire(POWER_LOCK_CARD);
 
-            tfcard_writing();
+            led_set_state(LOG_LED_WRITING, true);
 
-            if (buffer_index + item_size < sizeof(write_buffer))
-            {
-                memcpy(write_buffer + buffer_index, data, item_size);
-                buffer_index += item_size;
-            }
-            else
-            {
-                // 写入缓冲区已满，先写入文件
-                ESP_LOGI(TAG, "Write buffer full, writing to file...");
-                write_buffer[buffer_index] = '\0';
-                // 调用 s_write_file 时会自动获取和释放锁
-                s_write_file(file_path, write_buffer, buffer_index);
-                buffer_index = 0;
-
-                size_t remaining = item_size;
-                const char *src_ptr = data;
-                while (remaining > 0)
-                {
-                    size_t copy_size = (remaining < sizeof(write_buffer)) ? remaining : sizeof(write_buffer);
-                    memcpy(write_buffer, src_ptr, copy_size);
-                    buffer_index = copy_size;
-                    src_ptr += copy_size;
-                    remaining -= copy_size;
-
-                    // 直接写入原始二进制数据（不需要添加终止符）
-                    s_write_file(file_path, write_buffer, buffer_index); // 修改函数签名
-                    buffer_index = 0;
-                }
-            }
+            // 写入缓冲区放不下时，log_writer_push 内部会先写出已攒数据
+            log_writer_push(writer, data, item_size);
             vRingbufferReturnItem(tfcard_ringbuf, (void *)data); // 归还缓冲区
         }
+#ifdef CONFIG_TFCARD_SPILL_ENABLE
+        else if (tfcard_spill_drain(writer))
+        {
+            power_lock_acquire(POWER_LOCK_CARD);
+        }
+        spill_pending = log_spill_used(&spill) > 0;
+#endif
 
         // 定时写入剩余数据
-        if (buffer_index > 0)
+        if (writer->len > 0)
         {
-            write_buffer[buffer_index] = '\0';
             // 调用 s_write_file 时会自动获取和释放锁
-            s_write_file(file_path, write_buffer, buffer_index);
-            buffer_index = 0;
+            log_writer_flush(writer);
         }
         else
         {
@@ -407,39 +1204,151 @@ void tfcard_task(void *pvParameters)
             if (last_idle_time - idle_time > 1000000)
             {
                 last_idle_time = idle_time;
-                ok_led();
+                led_set_state(LOG_LED_WRITING, false);
             }
         }
+#ifdef TFCARD_CHECKPOINT
+        // 省电模式下缓冲区一空就同步，数据落盘后才允许进入浅睡眠
+        tfcard_checkpoint(data == NULL && !spill_pending && power_save_enabled());
+#endif
+        if (data == NULL && !spill_pending)
+        {
+            power_lock_release(POWER_LOCK_CARD);
+        }
 
+        if (writer->sink_errors != sink_errors)
+        {
+            sink_errors = writer->sink_errors;
+            led_post_event(LOG_LED_CARD_ERR);
+            if (tfcard_lost())
+            {
+                return;
+            }
+            if (++link_errors >= SD_ERR_STEP_DOWN)
+            {
+                tfcard_clock_step_down();
+                link_errors = 0;
+            }
+        }
+        else if (writer->sink_calls != sink_calls)
+        {
+            link_errors = 0;
+        }
+        sink_calls = writer->sink_calls;
 
-        vTaskDelay(WRITE_INTERVAL);
+        // 相当于 vTaskDelay(write_interval)，紧急停止时会被提前唤醒；溢出分区读回期间连续写卡
+        if (!spill_pending)
+        {
+            ulTaskNotifyTake(pdTRUE, write_interval);
+        }
     }
 }
 
+// TF 卡任务函数：卡不在时按退避间隔重试挂载，期间数据留在环形缓冲区，挂载后接着写
+void tfcard_task(void *pvParameters)
+{
+    static log_writer_t writer; // 合并小块写入，逻辑见 log_writer.h
+    uint32_t retry_ms = MOUNT_RETRY_MIN_MS;
+
+    log_writer_init(&writer, tfcard_sink, log_file_path);
+    log_mem_add_static(LOG_MEM_CARD, sizeof(writer));
+
+    while (1)
+    {
+        if (sdcard_init_state != TF_CARD_STATE_MOUNT)
+        {
+            if (tfcard_stop_req)
+            {
+                tfcard_drain_and_stop(&writer);
+            }
+            // 等待期间不持有电源锁，缓冲区中的数据在浅睡眠时保持不变
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(retry_ms));
+            if (!tfcard_accepting || tfcard_mount() != ESP_OK)
+            {
+                led_set_state(LOG_LED_CARD_ERR, tfcard_accepting);
+                retry_ms = (retry_ms * 2 < MOUNT_RETRY_MAX_MS) ? retry_ms * 2 : MOUNT_RETRY_MAX_MS;
+                continue;
+            }
+        }
+        retry_ms = MOUNT_RETRY_MIN_MS;
+
+        tfcard_open_session();
+        tfcard_log_session(&writer);
+        power_lock_release(POWER_LOCK_CARD);
+        tfcard_unmount();
+    }
+}
+
+size_t tfcard_buffer_free(void)
+{
+    size_t free_size = 0;
+    if (tfcard_ringbuf != NULL && xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY) == pdTRUE)
+    {
+        free_size = xRingbufferGetCurFreeSize(tfcard_ringbuf);
+        xSemaphoreGive(tfcard_ringbuf_mutex);
+    }
+    return free_size;
+}
+
 // 提供一个公共函数用于向环形缓冲区写入数据，增加限流机制
 void tfcard_write_to_buffer(const char *data, size_t len)
 {
-    if (tfcard_ringbuf != NULL && GetTfCardState() == TF_CARD_STATE_MOUNT)
+    // 卡暂时不在时照常进入缓冲区，由 tfcard_task 在重新挂载后写出
+    if (tfcard_ringbuf != NULL && tfcard_task_handle != NULL)
     {
         if (xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY) == pdTRUE)
         { // 获取互斥锁
+            if (!tfcard_accepting)
+            {
+                // 紧急停止后不再接收新数据
+                log_stats.card_drop_bytes += len;
+                xSemaphoreGive(tfcard_ringbuf_mutex);
+                return;
+            }
+#ifdef CONFIG_TFCARD_SPILL_ENABLE
+            if (tfcard_spill_push(data, len))
+            {
+                xSemaphoreGive(tfcard_ringbuf_mutex);
+                return;
+            }
+#endif
             size_t free_size = xRingbufferGetCurFreeSize(tfcard_ringbuf);
+            if (free_size < len && GetTfCardState() != TF_CARD_STATE_MOUNT)
+            {
+                // 卡不在，等待也不会腾出空间
+                log_stats.card_drop_bytes += len;
+                led_post_event(LOG_LED_OVERFLOW);
+                xSemaphoreGive(tfcard_ringbuf_mutex);
+                return;
+            }
             if (free_size < len)
             {
                 ESP_LOGW(TAG, "Ring buffer is almost full, waiting for space...");
+                LOG_TRACE(LOG_TRACE_CH_UART, LOG_TRACE_CARD_ENQ_WAIT, len);
                 while (xRingbufferGetCurFreeSize(tfcard_ringbuf) < len)
                 {
                     xSemaphoreGive(tfcard_ringbuf_mutex); // 释放互斥锁
                     vTaskDelay(pdMS_TO_TICKS(100));
                     xSemaphoreTake(tfcard_ringbuf_mutex, portMAX_DELAY); // 重新获取互斥锁
+                    if (!tfcard_accepting || GetTfCardState() != TF_CARD_STATE_MOUNT)
+                    {
+                        log_stats.card_drop_bytes += len;
+                        xSemaphoreGive(tfcard_ringbuf_mutex);
+                        return;
+                    }
                 }
             }
             xRingbufferSend(tfcard_ringbuf, data, len, portMAX_DELAY);
+            log_stats.card_in_bytes += len;
+            LOG_TRACE(LOG_TRACE_CH_UART, LOG_TRACE_CARD_ENQ, len);
+            LOG_LAT_MARK(LOG_LAT_CARD, log_stats.card_in_bytes);
+            log_stats_update_hwm(&log_stats.card_ring_hwm, log_stats.card_ring_size - xRingbufferGetCurFreeSize(tfcard_ringbuf));
             xSemaphoreGive(tfcard_ringbuf_mutex); // 释放互斥锁
         }
     }
     else
     {
-        ESP_LOGW(TAG, "TF card is not mounted, data will be discarded");
+        log_stats.card_drop_bytes += len;
+        ESP_LOGW(TAG, "TF card is not initialized, data will be discarded");
     }
 }
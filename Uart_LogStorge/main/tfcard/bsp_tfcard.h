@@ -1,6 +1,7 @@
 #ifndef __TF_CARD_H__
 #define __TF_CARD_H__
 
+#include "esp_err.h"
 #include "freertos/ringbuf.h"
 
 #define TF_CARD_STATE_UNINIT 0
@@ -8,11 +9,20 @@
 #define TF_CARD_STATE_UNMOUNT 2
 #define TF_CARD_STATE_MOUNT 3
 
+#define TF_CARD_MOUNT_POINT "/sdcard"
+
 extern RingbufHandle_t tfcard_ringbuf;
 extern SemaphoreHandle_t tfcard_ringbuf_mutex;
 
 void tfcard_init(void);
 void tfcard_write_to_buffer(const char *data, size_t len);
+// 缓冲区当前剩余空间，不大于该值的写入不会在 tfcard_write_to_buffer 中等待
+size_t tfcard_buffer_free(void);
+esp_err_t tfcard_sync(void);
+// 低电量时调用：停止接收、写完所有缓冲数据并关闭日志文件，timeout_ms 内未完成返回 ESP_ERR_TIMEOUT
+esp_err_t tfcard_emergency_stop(uint32_t timeout_ms);
+void tfcard_resume(void);
 uint8_t GetTfCardState(void);
+const char *tfcard_get_log_path(void);
 
 #endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -12,16 +13,87 @@
 #include "freertos/semphr.h" 
 
 #include "ble_gatt.h"
+#include "log_stats.h"
+#include "log_trace.h"
+#include "log_frame.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "power_save.h"
+#include "log_mem.h"
+#include "log_rxsize.h"
+#include "sched_profile.h"
+#include "ws2812/ws2812.h"
+#include "app_config.h"
+#ifdef CONFIG_LOG_TRIGGER_ENABLE
+#include "log_trigger.h"
+#include "ble_alert.h"
+#endif
+#ifdef CONFIG_LOG_DEDUP_ENABLE
+#include "log_dedup.h"
+#endif
+#ifdef CONFIG_UART_CAPTURE_RAW
+#include "log_capture.h"
+#endif
+#ifdef CONFIG_UART_FORMAT_DETECT
+#include "log_linefmt.h"
+#endif
 
 // --- 配置 ---
 #define RMT_RX_CHANNEL          RMT_CHANNEL_2 // Use a valid RX channel like 2 or 3
 #define UART_PORT_FOR_DETECT    UART_NUM_1
-#define UART_RX_PIN_FOR_DETECT  (GPIO_NUM_0)
-#define UART_TX_PIN_FOR_DETECT  (GPIO_NUM_1)
 
 static const char *TAG = "UART";
 
+// 单次读取的长度和超时随接收速率调整，见 log_rxsize.h；超时不短于一个 tick
+#define UART_READ_MIN 128
+#define UART_READ_MAX 1024
+#define UART_READ_TMO_MIN_MS (portTICK_PERIOD_MS > 10 ? portTICK_PERIOD_MS : 10)
+#define UART_READ_TMO_MAX_MS 50
+
+// 文本模式下只用来统计线路错误，数据仍由 uart_task 直接读取；二进制抓包模式下由 uart_capture_task 按事件读取
+#define UART_EVENT_QUEUE_LEN 20
+static QueueHandle_t uart_event_queue = NULL;
+
+#ifdef CONFIG_LOG_POWER_SAVE
+// 唤醒后这段时间内的帧错误/校验错误计入 uart_wake_err，用来衡量唤醒沿上丢失的数据
+#define UART_WAKE_WINDOW_US (20 * 1000)
+#define UART_IDLE_US ((int64_t)CONFIG_LOG_POWER_IDLE_MS * 1000)
+static int64_t uart_wake_window_end = 0;
+#endif
+
+#ifdef CONFIG_LOG_DEDUP_ENABLE
+// 重复行折叠：成帧前处理原始数据，折叠后的输出可能比读到的数据多出缓存的半行和汇总行
+#define UART_FRAME_EXTRA   LOG_DEDUP_OUT_MAX(0)
+static log_dedup_t uart_dedup;
+static char uart_dedup_out[LOG_DEDUP_OUT_MAX(UART_READ_MAX)];
+#else
+#define UART_FRAME_EXTRA   0
+#endif
+
+// 接收和成帧缓冲区按单次读取的上限静态分配，uart_task 栈上不再放变长数组
+static uint8_t uart_rx_buf[UART_READ_MAX];
+static char uart_frame_buf[UART_READ_MAX + LOG_FRAME_PREFIX_MAX + UART_FRAME_EXTRA];
+
+#ifdef CONFIG_UART_CAPTURE_RAW
+// 二进制抓包：每条数据记录最多的字节数，BLE 十六进制文本约为数据的 6 倍
+#define UART_CAPTURE_CHUNK 512
+static uint8_t uart_capture_rec[LOG_CAPTURE_HDR_LEN + UART_CAPTURE_CHUNK];
+static char uart_capture_hex[(UART_CAPTURE_CHUNK / LOG_CAPTURE_HEX_PER_LINE) * LOG_CAPTURE_HEX_LINE_MAX];
+static uint32_t uart_capture_offset = 0;   // 已保存的数据字节数，十六进制行的偏移
+#endif
+
+#ifdef CONFIG_LOG_TRIGGER_ENABLE
+// 触发式采集：写卡路径经过预触发环，见 log_trigger.h
+static log_trigger_t uart_trigger;
+static uint8_t uart_trigger_buf[CONFIG_LOG_TRIGGER_RING_KB * 1024];
+static void uart_trigger_init(void);
+static void uart_trigger_emit(void *ctx, const char *data, size_t len);
+#endif
+
 void uart_task(void *pvParameters);
+#ifdef CONFIG_UART_CAPTURE_RAW
+void uart_capture_task(void *pvParameters);
+#endif
 
 static int autobaud_detect(uart_port_t uart_num, gpio_num_t rx_pin, gpio_num_t tx_pin)
 {
@@ -177,80 +249,557 @@ static int autobaud_detect(uart_port_t uart_num, gpio_num_t rx_pin, gpio_num_t t
 // 初始化UART
 void uart_init(void)
 {
-        uart_config_t uart_config = {
-        .baud_rate = 115200,
+    // 引脚和初始波特率来自运行配置（默认 GPIO0/GPIO1，115200）
+    const app_config_t *cfg = app_config();
+    gpio_num_t rx_pin = (gpio_num_t)cfg->uart_rx_pin;
+    gpio_num_t tx_pin = (gpio_num_t)cfg->uart_tx_pin;
+    uart_config_t uart_config = {
+        .baud_rate = cfg->baud,
         .data_bits = UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
         .source_clk = UART_SCLK_DEFAULT,
     };
-    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_FOR_DETECT, 1024 * 10, 0, 0, NULL, 0));
+#ifdef CONFIG_LOG_POWER_SAVE
+    // 动态调频会改变 APB 频率，改用 XTAL 时钟保证波特率不随主频变化
+    uart_config.source_clk = UART_SCLK_XTAL;
+#endif
+    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_FOR_DETECT, 1024 * 10, 0, UART_EVENT_QUEUE_LEN, &uart_event_queue, 0));
     ESP_ERROR_CHECK(uart_param_config(UART_PORT_FOR_DETECT, &uart_config));
-    ESP_ERROR_CHECK(uart_set_pin(UART_PORT_FOR_DETECT, UART_TX_PIN_FOR_DETECT, UART_RX_PIN_FOR_DETECT, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+    uart_get_baudrate(UART_PORT_FOR_DETECT, &log_stats.uart_baud);
+    ESP_ERROR_CHECK(uart_set_pin(UART_PORT_FOR_DETECT, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+
+    gpio_set_pull_mode(rx_pin, GPIO_PULLUP_ONLY); //防止设备断电后的浮动电平导致收到乱码数据
+
+#ifdef CONFIG_LOG_POWER_SAVE
+    // 浅睡眠唤醒源：RX 线上的下降沿
+#ifdef CONFIG_LOG_POWER_WAKE_UART
+    ESP_ERROR_CHECK(uart_set_wakeup_threshold(UART_PORT_FOR_DETECT, CONFIG_LOG_POWER_WAKE_THRESHOLD));
+    ESP_ERROR_CHECK(esp_sleep_enable_uart_wakeup(UART_PORT_FOR_DETECT));
+#else
+    ESP_ERROR_CHECK(gpio_wakeup_enable(rx_pin, GPIO_INTR_LOW_LEVEL));
+    ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+#endif
+#endif
+
+#ifdef CONFIG_LOG_TRIGGER_ENABLE
+    uart_trigger_init();
+#endif
+#ifdef CONFIG_LOG_DEDUP_ENABLE
+#ifdef CONFIG_LOG_DEDUP_IGNORE_TICKS
+    log_dedup_init(&uart_dedup, LOG_DEDUP_FLAG_SKIP_TICKS, CONFIG_LOG_DEDUP_WINDOW_MS);
+#else
+    log_dedup_init(&uart_dedup, 0, CONFIG_LOG_DEDUP_WINDOW_MS);
+#endif
+#endif
 
-    gpio_set_pull_mode(UART_RX_PIN_FOR_DETECT, GPIO_PULLUP_ONLY); //防止设备断电后的浮动电平导致收到乱码数据
+#ifdef CONFIG_UART_CAPTURE_RAW
+    log_mem_add_static(LOG_MEM_UART, sizeof(uart_capture_rec) + sizeof(uart_capture_hex));
+#else
+    log_mem_add_static(LOG_MEM_UART, sizeof(uart_rx_buf) + sizeof(uart_frame_buf));
+#endif
+#ifdef CONFIG_LOG_TRIGGER_ENABLE
+    log_mem_add_static(LOG_MEM_UART, sizeof(uart_trigger) + sizeof(uart_trigger_buf));
+#endif
+#ifdef CONFIG_LOG_DEDUP_ENABLE
+    log_mem_add_static(LOG_MEM_UART, sizeof(uart_dedup) + sizeof(uart_dedup_out));
+#endif
 
     // 创建 UART 任务
-    xTaskCreate(uart_task, "uart_task", 4096, NULL, 10, NULL);
+#ifdef CONFIG_UART_CAPTURE_RAW
+    xTaskCreate(uart_capture_task, "uart_task", TASK_STACK_UART, NULL, TASK_PRIO_UART, NULL);
+#else
+    xTaskCreate(uart_task, "uart_task", TASK_STACK_UART, NULL, TASK_PRIO_UART, NULL);
+#endif
+}
+
+#ifdef CONFIG_LOG_TRIGGER_ENABLE
+static void uart_trigger_init(void)
+{
+    const char *p = CONFIG_LOG_TRIGGER_PATTERNS;
+
+    log_trigger_init(&uart_trigger, uart_trigger_buf, sizeof(uart_trigger_buf),
+                     CONFIG_LOG_TRIGGER_PRE_MS, CONFIG_LOG_TRIGGER_POST_MS, 0);
+    // 模式之间用 '|' 分隔
+    while (*p != '\0') {
+        size_t n = strcspn(p, "|");
+        if (n > 0 && log_trigger_add(&uart_trigger, p, n) < 0) {
+            ESP_LOGE(TAG, "Trigger pattern '%.*s' ignored (too many or too long)", (int)n, p);
+        }
+        p += n + (p[n] == '|');
+    }
+    log_trigger_compile(&uart_trigger);
+    ESP_LOGI(TAG, "Trigger mode: %d patterns, %d ms before / %d ms after, %d KB ring",
+             uart_trigger.match.num_patterns, CONFIG_LOG_TRIGGER_PRE_MS, CONFIG_LOG_TRIGGER_POST_MS,
+             CONFIG_LOG_TRIGGER_RING_KB);
+}
+
+static void uart_trigger_emit(void *ctx, const char *data, size_t len)
+{
+    tfcard_write_to_buffer(data, len);
+}
+
+static void uart_trigger_update_stats(void)
+{
+    log_stats.trig_captures = uart_trigger.captures;
+    log_stats.trig_promoted_bytes = uart_trigger.promoted_bytes;
+    log_stats.trig_skipped_bytes = uart_trigger.skipped_bytes;
+}
+
+// 告警内容为命中所在的行：从本块中该行开头（或块首）到行尾（或块尾）
+static void uart_trigger_alert(const uint8_t *data, int len, uint32_t now_ms)
+{
+    int start = uart_trigger.last_hit_off, end = uart_trigger.last_hit_off;
+    while (start > 0 && data[start - 1] != '\n') {
+        start--;
+    }
+    while (end < len && data[end] != '\n' && data[end] != '\r') {
+        end++;
+    }
+    ESP_LOGW(TAG, "Trigger %" PRIu32 " (patterns 0x%02x): %.*s", uart_trigger.captures, uart_trigger.last_hits,
+             end - start, (const char *)&data[start]);
+    ble_alert_raise(BLE_ALERT_TRIGGER, uart_trigger.last_hits, uart_trigger.captures, now_ms,
+                    (const char *)&data[start], end - start);
+}
+#endif
+
+// 成帧后的数据分发到 TF 卡和 BLE；raw 为对应的原始数据，只用于触发匹配
+static void uart_fan_out(const uint8_t *raw, size_t raw_len, const char *framed, size_t framed_len)
+{
+#ifdef CONFIG_LOG_TRIGGER_ENABLE
+    // 只有触发窗口内的数据写入TF卡的环形缓冲区，按原始数据匹配，不受时间戳分块影响
+    uint32_t now_ms = esp_log_timestamp();
+    if (log_trigger_feed(&uart_trigger, raw, raw_len, framed, framed_len, now_ms,
+                         tfcard_buffer_free(), uart_trigger_emit, NULL)) {
+        uart_trigger_alert(raw, (int)raw_len, now_ms);
+    }
+    uart_trigger_update_stats();
+#else
+    // 将带时间戳的数据写入TF卡的环形缓冲区
+    if (framed_len > 0) {
+        tfcard_write_to_buffer(framed, framed_len);
+    }
+#endif
+    // 将带时间戳的数据写入BLE的环形缓冲区
+    if (framed_len > 0) {
+        ble_write_to_buffer(framed, framed_len);
+    }
+}
+
+#ifdef CONFIG_LOG_DEDUP_ENABLE
+static void uart_dedup_update_stats(void)
+{
+    log_stats.dedup_lines = uart_dedup.lines_folded;
+    log_stats.dedup_bytes = uart_dedup.bytes_folded;
+}
+
+// 串口空闲时输出缓存的半行和到期的汇总行
+static void uart_dedup_flush(void)
+{
+    uint32_t now_ms = esp_log_timestamp();
+    size_t n = log_dedup_flush(&uart_dedup, now_ms, uart_dedup_out, sizeof(uart_dedup_out));
+    if (n > 0) {
+        size_t copied;
+        size_t framed_len = log_frame_chunk(uart_frame_buf, sizeof(uart_frame_buf), now_ms,
+                                            (const uint8_t *)uart_dedup_out, n, &copied);
+        uart_fan_out(NULL, 0, uart_frame_buf, framed_len);
+    }
+    uart_dedup_update_stats();
+}
+#endif
+
+#ifdef CONFIG_LOG_POWER_SAVE
+// 唤醒后的第一个事件：被串口/RX 电平唤醒时开始计算唤醒窗口
+static void uart_note_wakeup(void)
+{
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    if (cause == ESP_SLEEP_WAKEUP_UART || cause == ESP_SLEEP_WAKEUP_GPIO) {
+        log_stats.uart_wakeups++;
+        uart_wake_window_end = esp_timer_get_time() + UART_WAKE_WINDOW_US;
+    }
+}
+#endif
+
+// 统计一个驱动事件，只统计错误类事件
+static void uart_count_event(const uart_event_t *event)
+{
+    switch (event->type) {
+    case UART_FIFO_OVF:
+        log_stats.uart_fifo_ovf++;
+        led_post_event(LOG_LED_OVERFLOW);
+        break;
+    case UART_BUFFER_FULL:
+        log_stats.uart_buf_full++;
+        led_post_event(LOG_LED_OVERFLOW);
+        break;
+    case UART_BREAK:
+        log_stats.uart_break++;
+        break;
+    case UART_FRAME_ERR:
+        log_stats.uart_frame_err++;
+#ifdef CONFIG_LOG_POWER_SAVE
+        if (esp_timer_get_time() < uart_wake_window_end) {
+            log_stats.uart_wake_err++;
+        }
+#endif
+        break;
+    case UART_PARITY_ERR:
+        log_stats.uart_parity_err++;
+#ifdef CONFIG_LOG_POWER_SAVE
+        if (esp_timer_get_time() < uart_wake_window_end) {
+            log_stats.uart_wake_err++;
+        }
+#endif
+        break;
+    default:
+        break;
+    }
+}
+
+// 取出驱动上报的事件并统计；队列满时驱动会丢弃事件，不影响数据接收
+static void uart_count_events(void)
+{
+    uart_event_t event;
+    while (xQueueReceive(uart_event_queue, &event, 0) == pdTRUE) {
+        uart_count_event(&event);
+    }
+}
+
+// 运行配置在线修改后调用，波特率有变化时重新设置，返回 true 表示已修改
+static bool uart_apply_baud(const app_config_t *cfg)
+{
+    if (cfg->baud == log_stats.uart_baud) {
+        return false;
+    }
+    esp_err_t ret = uart_set_baudrate(UART_PORT_FOR_DETECT, cfg->baud);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set baud rate %" PRIu32 " (%s)", cfg->baud, esp_err_to_name(ret));
+        return false;
+    }
+    uart_get_baudrate(UART_PORT_FOR_DETECT, &log_stats.uart_baud);
+    ESP_LOGI(TAG, "Baud rate set to %" PRIu32, log_stats.uart_baud);
+    return true;
+}
+
+#ifdef CONFIG_LOG_POWER_SAVE
+// 串口空闲时阻塞在事件队列上，让出 CPU 以便系统进入浅睡眠；驱动收到数据后会投递 UART_DATA 事件
+static void uart_wait_rx(void)
+{
+    uart_event_t event;
+    xQueuePeek(uart_event_queue, &event, portMAX_DELAY);
+    uart_note_wakeup();
+}
+#endif
+
+#ifdef CONFIG_UART_FORMAT_DETECT
+static void uart_format_apply(const log_linefmt_t *fmt)
+{
+    uart_set_word_length(UART_PORT_FOR_DETECT, (uart_word_length_t)(UART_DATA_5_BITS + fmt->data_bits - 5));
+    uart_set_parity(UART_PORT_FOR_DETECT, (fmt->parity == 'E') ? UART_PARITY_EVEN
+                                          : (fmt->parity == 'O') ? UART_PARITY_ODD : UART_PARITY_DISABLE);
+    uart_set_stop_bits(UART_PORT_FOR_DETECT, (fmt->stop_bits == 2) ? UART_STOP_BITS_2 : UART_STOP_BITS_1);
+}
+
+// 用一个候选格式接收 CONFIG_UART_FORMAT_SAMPLE_MS 并评分
+static void uart_format_sample(const log_linefmt_t *fmt, log_linefmt_score_t *s)
+{
+    uint8_t data[256];
+    uart_event_t event;
+
+    log_linefmt_reset(s);
+    uart_format_apply(fmt);
+    uart_flush_input(UART_PORT_FOR_DETECT);
+    xQueueReset(uart_event_queue);
+    int64_t end_us = esp_timer_get_time() + (int64_t)CONFIG_UART_FORMAT_SAMPLE_MS * 1000;
+    while (esp_timer_get_time() < end_us) {
+        int len = uart_read_bytes(UART_PORT_FOR_DETECT, data, sizeof(data), pdMS_TO_TICKS(10));
+        if (len > 0) {
+            log_linefmt_feed(s, data, len);
+        }
+        while (xQueueReceive(uart_event_queue, &event, 0) == pdTRUE) {
+            log_linefmt_errors(s, event.type == UART_FRAME_ERR, event.type == UART_PARITY_ERR);
+        }
+    }
+    log_linefmt_finish(s);
+}
+
+// 帧格式识别，接收任务开始前调用：等目标设备开始发送后依次试探各候选格式，
+// 所有候选都没有收到足够的数据时重新等待；识别期间收到的数据不保存
+static void uart_format_detect(void)
+{
+    log_linefmt_score_t scores[LOG_LINEFMT_NUM_CANDIDATES];
+    uart_event_t event;
+    char name[4];
+    int best = -1;
+    int32_t margin = 0;
+
+    while (best < 0) {
+        xQueuePeek(uart_event_queue, &event, portMAX_DELAY);
+        for (int i = 0; i < LOG_LINEFMT_NUM_CANDIDATES; i++) {
+            uart_format_sample(&log_linefmt_candidates[i], &scores[i]);
+            ESP_LOGI(TAG, "Format %s: %" PRIu32 " bytes, %" PRIu32 " printable, %" PRIu32 " frame / %" PRIu32
+                     " parity errors, score %" PRId32, log_linefmt_name(&log_linefmt_candidates[i], name),
+                     scores[i].bytes, scores[i].printable, scores[i].frame_err, scores[i].parity_err,
+                     scores[i].score);
+        }
+        best = log_linefmt_pick(scores, LOG_LINEFMT_NUM_CANDIDATES, &margin);
+        if (best < 0) {
+            ESP_LOGW(TAG, "Not enough data to detect the line format, waiting");
+        }
+    }
+    uart_format_apply(&log_linefmt_candidates[best]);
+    uart_flush_input(UART_PORT_FOR_DETECT);
+    xQueueReset(uart_event_queue);
+    ESP_LOGI(TAG, "Line format locked to %s at %" PRIu32 " baud (margin %" PRId32 ")",
+             log_linefmt_name(&log_linefmt_candidates[best], name), log_stats.uart_baud, margin);
+}
+#endif
+
+#ifdef CONFIG_UART_CAPTURE_RAW
+// 事件记录写卡，BLE 实时流发送对应的文本行
+static void uart_capture_event(uint8_t type, uint32_t arg)
+{
+    uint8_t rec[LOG_CAPTURE_HDR_LEN + 4];
+    char text[LOG_CAPTURE_HEX_LINE_MAX];
+    uint32_t now_ms = esp_log_timestamp();
+
+    size_t n = log_capture_event(rec, type, now_ms, arg);
+    tfcard_write_to_buffer((const char *)rec, n);
+    n = log_capture_event_text(text, sizeof(text), now_ms, type, arg);
+    ble_write_to_buffer(text, n);
+    log_stats.cap_events++;
+}
+
+// 读出 UART_DATA 事件对应的 size 字节，按原样写成数据记录；不多读，保证之后的事件记录落在正确的位置
+static void uart_capture_data(size_t size)
+{
+    while (size > 0) {
+        size_t want = (size < UART_CAPTURE_CHUNK) ? size : UART_CAPTURE_CHUNK;
+        int len = uart_read_bytes(UART_PORT_FOR_DETECT, uart_capture_rec + LOG_CAPTURE_HDR_LEN, want, 0);
+        if (len <= 0) {
+            break;
+        }
+        LOG_TRACE_ORIGIN((uint32_t)esp_timer_get_time());
+        LOG_TRACE(LOG_TRACE_CH_UART, LOG_TRACE_UART_READ, len);
+        log_stats.uart_rx_bytes += len;
+        log_stats.uart_rx_chunks++;
+
+        uint32_t now_ms = esp_log_timestamp();
+        log_capture_hdr(uart_capture_rec, LOG_CAPTURE_DATA, len, now_ms);
+        tfcard_write_to_buffer((const char *)uart_capture_rec, LOG_CAPTURE_HDR_LEN + len);
+        size_t hex_len = log_capture_hex(uart_capture_hex, sizeof(uart_capture_hex), now_ms, uart_capture_offset,
+                                         uart_capture_rec + LOG_CAPTURE_HDR_LEN, len);
+        ble_write_to_buffer(uart_capture_hex, hex_len);
+        uart_capture_offset += len;
+        size -= len;
+
+        LOG_TRACE(LOG_TRACE_CH_UART, LOG_TRACE_FANOUT_DONE, len);
+        LOG_LAT_ADD(LOG_LAT_INGEST, (uint32_t)esp_timer_get_time() - log_trace_origin_us);
+    }
+}
+
+// 溢出后驱动缓冲区里的数据已不连续，按 ESP-IDF 的建议清空输入和事件队列，参数为丢弃的字节数
+static void uart_capture_overflow(uint8_t type)
+{
+    size_t buffered = 0;
+    uart_get_buffered_data_len(UART_PORT_FOR_DETECT, &buffered);
+    uart_flush_input(UART_PORT_FOR_DETECT);
+    xQueueReset(uart_event_queue);
+    uart_capture_event(type, buffered);
+}
+
+static void uart_capture_start(void)
+{
+    uart_word_length_t data_bits = UART_DATA_8_BITS;
+    uart_parity_t parity = UART_PARITY_DISABLE;
+    uart_stop_bits_t stop_bits = UART_STOP_BITS_1;
+    uint8_t rec[LOG_CAPTURE_HDR_LEN + 8];
+
+    uart_get_word_length(UART_PORT_FOR_DETECT, &data_bits);
+    uart_get_parity(UART_PORT_FOR_DETECT, &parity);
+    uart_get_stop_bits(UART_PORT_FOR_DETECT, &stop_bits);
+    size_t n = log_capture_start(rec, esp_log_timestamp(), log_stats.uart_baud, 5 + data_bits,
+                                 (parity == UART_PARITY_EVEN) ? 'E' : (parity == UART_PARITY_ODD) ? 'O' : 'N',
+                                 1 + stop_bits);
+    tfcard_write_to_buffer((const char *)rec, n);
+    ESP_LOGI(TAG, "Raw capture mode, %" PRIu32 " baud", log_stats.uart_baud);
+}
+
+// 二进制抓包任务：按驱动事件的顺序读取数据和记录线路事件
+void uart_capture_task(void *pvParameters)
+{
+    uart_event_t event;
+    uint32_t cfg_gen = app_config()->gen;
+#ifdef CONFIG_LOG_POWER_SAVE
+    bool rx_active = false;   // 持有 POWER_LOCK_UART
+#endif
+
+#ifdef CONFIG_UART_FORMAT_DETECT
+    uart_format_detect();
+#endif
+    uart_capture_start();
+    while (1) {
+        TickType_t wait = portMAX_DELAY;
+#ifdef CONFIG_LOG_POWER_SAVE
+        if (rx_active) {
+            wait = pdMS_TO_TICKS(CONFIG_LOG_POWER_IDLE_MS);
+        }
+#endif
+        if (xQueueReceive(uart_event_queue, &event, wait) != pdTRUE) {
+#ifdef CONFIG_LOG_POWER_SAVE
+            // 空闲超过 LOG_POWER_IDLE_MS，允许浅睡眠
+            power_lock_release(POWER_LOCK_UART);
+            rx_active = false;
+#endif
+            continue;
+        }
+#ifdef CONFIG_LOG_POWER_SAVE
+        if (!rx_active && power_save_enabled()) {
+            power_lock_acquire(POWER_LOCK_UART);
+            rx_active = true;
+            uart_note_wakeup();
+        }
+#endif
+        const app_config_t *cfg = app_config();
+        if (cfg->gen != cfg_gen) {
+            // 波特率在线修改后在下一个事件时生效，写一条新的开始记录
+            cfg_gen = cfg->gen;
+            if (uart_apply_baud(cfg)) {
+                uart_capture_start();
+            }
+        }
+        uart_count_event(&event);
+        switch (event.type) {
+        case UART_DATA:
+            uart_capture_data(event.size);
+            break;
+        case UART_FRAME_ERR:
+            uart_capture_event(LOG_CAPTURE_FRAME_ERR, 0);
+            break;
+        case UART_PARITY_ERR:
+            uart_capture_event(LOG_CAPTURE_PARITY_ERR, 0);
+            break;
+        case UART_BREAK:
+            uart_capture_event(LOG_CAPTURE_BREAK, 0);
+            break;
+        case UART_FIFO_OVF:
+            uart_capture_overflow(LOG_CAPTURE_FIFO_OVF);
+            break;
+        case UART_BUFFER_FULL:
+            uart_capture_overflow(LOG_CAPTURE_BUFFER_FULL);
+            break;
+        default:
+            break;
+        }
+    }
+}
+#endif
+
+static void uart_rxsize_update_stats(const log_rxsize_t *r)
+{
+    log_stats.uart_read_len = r->len;
+    log_stats.uart_read_tmo_ms = r->tmo_ms;
+    log_stats.uart_rx_rate = r->rate;
 }
 
 // UART 任务
 void uart_task(void *pvParameters)
 {
-    uint32_t data_len = 256;
+    log_rxsize_t rxsize;
+    uint32_t cfg_gen = app_config()->gen;
+#ifdef CONFIG_LOG_POWER_SAVE
+    bool rx_active = false;   // 持有 POWER_LOCK_UART
+    int64_t last_rx_us = 0;
+#endif
 
+#ifdef CONFIG_UART_FORMAT_DETECT
+    uart_format_detect();
+#endif
+    log_rxsize_init(&rxsize, UART_READ_MIN, UART_READ_MAX, UART_READ_TMO_MIN_MS, UART_READ_TMO_MAX_MS,
+                    app_config()->read_target_ms, esp_log_timestamp());
+    uart_rxsize_update_stats(&rxsize);
     while (1) {
-        uint8_t data[data_len];
-        int len = uart_read_bytes(UART_PORT_FOR_DETECT, data, sizeof(data), pdMS_TO_TICKS(10));
-        if (len) {
-            // 获取系统启动以来的毫秒数
-            uint32_t timestamp = esp_log_timestamp();
-
-            // 计算小时、分钟、秒和毫秒
-            uint32_t hours = timestamp / (1000 * 60 * 60);
-            timestamp %= (1000 * 60 * 60);
-            uint32_t minutes = timestamp / (1000 * 60);
-            timestamp %= (1000 * 60);
-            uint32_t seconds = timestamp / 1000;
-            uint32_t milliseconds = timestamp % 1000;
-
-            // 定义带时间戳的缓冲区
-            char timestamped_data[data_len + 32]; // 为时间戳预留空间
-            int timestamp_len = snprintf(timestamped_data, sizeof(timestamped_data), "[%02ld:%02ld:%02ld.%03ld] ", hours, minutes, seconds, milliseconds);
-            size_t available_space = sizeof(timestamped_data) - timestamp_len - 2; // 保留换行符和终止符空间
-            if (available_space > 0 && len > 0) {
-                // 计算实际可拷贝长度
-                size_t copy_len = (len <= available_space) ? len : available_space;
-                
-                memcpy(timestamped_data + timestamp_len, data, copy_len);
-                timestamp_len += copy_len;
-                
-                // 安全添加换行符和终止符
-                timestamped_data[timestamp_len] = '\n';
-                timestamped_data[timestamp_len + 1] = '\0'; // 确保字符串终止
-                timestamp_len++; // 包含换行符的长度
-            } else {
-                // 添加终止符前确保不越界
-                timestamp_len = (timestamp_len < sizeof(timestamped_data)) ? timestamp_len : sizeof(timestamped_data)-1;
-                timestamped_data[timestamp_len] = '\0';
-                
-                // 带限制的缓冲区扩容
-                const size_t MAX_BUFFER_SIZE = 1024; // 1KB 最大缓冲区
-                if (data_len < MAX_BUFFER_SIZE) {
-                    ESP_LOGW(TAG, "数据截断，缓冲区从 %ld 扩容至 %ld", data_len, data_len * 2);
-                    data_len = (data_len * 2 < MAX_BUFFER_SIZE) ? data_len * 2 : MAX_BUFFER_SIZE;
-                } else {
-                    ESP_LOGE(TAG, "达到最大缓冲区限制 %d，数据丢失！", MAX_BUFFER_SIZE);
-                }
+        const app_config_t *cfg = app_config();
+        if (cfg->gen != cfg_gen) {
+            // 在线修改：读取长度在下一个统计窗口按新的目标时长重新计算
+            cfg_gen = cfg->gen;
+            uart_apply_baud(cfg);
+            rxsize.target_ms = cfg->read_target_ms;
+        }
+#ifdef CONFIG_LOG_POWER_SAVE
+        if (!rx_active && power_save_enabled()) {
+            uart_wait_rx();
+            power_lock_acquire(POWER_LOCK_UART);
+            rx_active = true;
+            last_rx_us = esp_timer_get_time();
+        }
+#endif
+        uint8_t *data = uart_rx_buf;
+        int len = uart_read_bytes(UART_PORT_FOR_DETECT, data, rxsize.len, pdMS_TO_TICKS(rxsize.tmo_ms));
+        uart_count_events();
+        log_rxsize_update(&rxsize, (len > 0) ? len : 0, esp_log_timestamp());
+        uart_rxsize_update_stats(&rxsize);
+#ifdef CONFIG_LOG_POWER_SAVE
+        if (len > 0) {
+            last_rx_us = esp_timer_get_time();
+        } else if (rx_active && esp_timer_get_time() - last_rx_us > UART_IDLE_US
+#ifdef CONFIG_LOG_TRIGGER_ENABLE
+                   && uart_trigger.pending == 0 // 排队的触发窗口写完之前不进入等待
+#endif
+#ifdef CONFIG_LOG_DEDUP_ENABLE
+                   && !log_dedup_pending(&uart_dedup)
+#endif
+                   ) {
+            power_lock_release(POWER_LOCK_UART);
+            rx_active = false;
+        }
+#endif
+#ifdef CONFIG_LOG_TRIGGER_ENABLE
+        if (len <= 0 && uart_trigger.pending > 0) {
+            // 串口空闲时继续把排队的触发窗口写入卡缓冲区
+            log_trigger_drain(&uart_trigger, tfcard_buffer_free(), uart_trigger_emit, NULL);
+            uart_trigger_update_stats();
+        }
+#endif
+#ifdef CONFIG_LOG_DEDUP_ENABLE
+        if (len <= 0 && log_dedup_pending(&uart_dedup)) {
+            uart_dedup_flush();
+        }
+#endif
+        if (len > 0) {
+            LOG_TRACE_ORIGIN((uint32_t)esp_timer_get_time());
+            LOG_TRACE(LOG_TRACE_CH_UART, LOG_TRACE_UART_READ, len);
+            log_stats.uart_rx_bytes += len;
+            log_stats.uart_rx_chunks++;
+
+            const uint8_t *frame_src = data;
+            size_t frame_len = len;
+#ifdef CONFIG_LOG_DEDUP_ENABLE
+            // 折叠连续重复的行，之后的成帧、写卡和 BLE 都只处理折叠后的数据
+            frame_len = log_dedup_feed(&uart_dedup, (const char *)data, len, esp_log_timestamp(),
+                                       uart_dedup_out, sizeof(uart_dedup_out));
+            frame_src = (const uint8_t *)uart_dedup_out;
+            uart_dedup_update_stats();
+#endif
+
+            // 带时间戳的缓冲区，成帧格式见 log_frame.h
+            // 成帧缓冲区按 UART_READ_MAX 分配，不会截断
+            char *timestamped_data = uart_frame_buf;
+            size_t copied = 0;
+            size_t timestamp_len = 0;
+            if (frame_len > 0) {
+                timestamp_len = log_frame_chunk(timestamped_data, sizeof(uart_frame_buf),
+                                                esp_log_timestamp(), frame_src, frame_len, &copied);
             }
 
             // ESP_LOGI(TAG, "UART接收到 %d 字节", len);
-            ESP_LOGI(TAG, "%s", timestamped_data);
-            // 将带时间戳的数据写入TF卡的环形缓冲区
-            tfcard_write_to_buffer(timestamped_data, timestamp_len);
-            // 将带时间戳的数据写入BLE的环形缓冲区
-            ble_write_to_buffer(timestamped_data, timestamp_len);
+            if (timestamp_len > 0) {
+                ESP_LOGD(TAG, "%s", timestamped_data);
+            }
+            uart_fan_out(data, len, timestamped_data, timestamp_len);
+            LOG_TRACE(LOG_TRACE_CH_UART, LOG_TRACE_FANOUT_DONE, timestamp_len);
+            LOG_LAT_ADD(LOG_LAT_INGEST, (uint32_t)esp_timer_get_time() - log_trace_origin_us);
             // 回显原始数据
             // uart_write_bytes(UART_PORT_FOR_DETECT, (const char *)timestamped_data, timestamp_len);
         }
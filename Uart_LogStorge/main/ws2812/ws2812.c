@@ -10,6 +10,7 @@
 #include "driver/rmt_tx.h"
 #include "WS2812.h"
 #include "esp_check.h"
+#include "sched_profile.h"
 #define RMT_LED_STRIP_RESOLUTION_HZ 10000000 // 10MHz resolution, 1 tick = 0.1us (led strip needs a high resolution)
 #define RMT_LED_STRIP_GPIO_NUM 10
 
@@ -28,11 +29,8 @@ static rmt_transmit_config_t tx_config = {
 
 static uint8_t led_strip_pixels[EXAMPLE_LED_NUMBERS * 3];
 
-static uint32_t red = 10;
-static uint32_t green = 0;
-static uint32_t blue = 0;
-
-uint16_t frequency = 2000;
+// 全局状态灯，零初始化即为空闲，ws2812_init 之前登记的状态也会在第一帧显示
+static log_led_t led;
 
 typedef struct
 {
@@ -157,38 +155,16 @@ err:
     return ret;
 }
 
-void close_led()
-{
-    red = 0;
-    blue = 0;
-    green = 0;
-}
-
-void ok_led()
+void led_set_state(log_led_state_t st, bool on)
 {
-    red = 0;
-    blue = 0;
-    green = 11;
-    frequency = 2000;
+    log_led_set(&led, st, on);
 }
 
-void tfcard_writing()
+void led_post_event(log_led_state_t st)
 {
-    red = 0;
-    blue = 11;
-    green = 0;
-    frequency = 2000;
+    log_led_event(&led, st);
 }
 
-void low_battery()
-{
-    red = 11;
-    blue = 0;
-    green = 0;
-    frequency = 200;
-}
-
-
 void ws2812_init(void)
 {
     ESP_LOGI(TAG, "Create RMT TX channel");
@@ -211,24 +187,37 @@ void ws2812_init(void)
     ESP_ERROR_CHECK(rmt_enable(led_chan));
 
     // 创建 UART 任务
-    xTaskCreate(WS2812_Task, "WS2812_Task", 4096, NULL, 10, NULL);
+    xTaskCreate(WS2812_Task, "WS2812_Task", TASK_STACK_LED, NULL, TASK_PRIO_LED, NULL);
 }
 
+// 每帧取当前状态，颜色变化时才发送，等待发送完成的只有 LED 任务自己
 void WS2812_Task(void *param)
 {
+    TickType_t last_wake = xTaskGetTickCount();
+    log_led_state_t shown = LOG_LED_NUM;
+    bool sent = false;
+
     while (1)
     {
-        led_strip_pixels[0] = green;
-        led_strip_pixels[1] = red;
-        led_strip_pixels[2] = blue;
-        // Flush RGB values to LEDs
-        ESP_ERROR_CHECK(rmt_transmit(led_chan, led_encoder, led_strip_pixels, sizeof(led_strip_pixels), &tx_config));
-        ESP_ERROR_CHECK(rmt_tx_wait_all_done(led_chan, portMAX_DELAY));
-        vTaskDelay(pdMS_TO_TICKS(200));
-        memset(led_strip_pixels, 0, sizeof(led_strip_pixels));
-        ESP_ERROR_CHECK(rmt_transmit(led_chan, led_encoder, led_strip_pixels, sizeof(led_strip_pixels), &tx_config));
-        ESP_ERROR_CHECK(rmt_tx_wait_all_done(led_chan, portMAX_DELAY));
-        vTaskDelay(pdMS_TO_TICKS(200));
-        vTaskDelay(pdMS_TO_TICKS(frequency));
+        uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+        log_led_state_t st = log_led_update(&led, now_ms);
+        uint8_t r, g, b;
+        log_led_render(st, now_ms, &r, &g, &b);
+        if (st != shown)
+        {
+            ESP_LOGD(TAG, "LED state %s", log_led_name(st));
+            shown = st;
+        }
+
+        if (!sent || led_strip_pixels[0] != g || led_strip_pixels[1] != r || led_strip_pixels[2] != b)
+        {
+            led_strip_pixels[0] = g;
+            led_strip_pixels[1] = r;
+            led_strip_pixels[2] = b;
+            // 一个像素的发送约 80 us，超时只会在 RMT 异常时出现，下一帧重发
+            sent = rmt_transmit(led_chan, led_encoder, led_strip_pixels, sizeof(led_strip_pixels), &tx_config) == ESP_OK &&
+                   rmt_tx_wait_all_done(led_chan, pdMS_TO_TICKS(LOG_LED_FRAME_MS)) == ESP_OK;
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(LOG_LED_FRAME_MS));
     }
-}
\ No newline at end of file
+}
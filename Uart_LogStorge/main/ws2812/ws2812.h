@@ -34,8 +34,11 @@ esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rm
 #ifdef __cplusplus
 }
 #endif
+#include <stdbool.h>
+#include "log_led.h"
+
 void ws2812_init(void);
-void ok_led();
-void close_led();
-void low_battery();
-void tfcard_writing();
+
+// 状态灯（逻辑见 log_led.h）：只做原子置位，不等待 LED，可在 ws2812_init 之前调用
+void led_set_state(log_led_state_t st, bool on);
+void led_post_event(log_led_state_t st);
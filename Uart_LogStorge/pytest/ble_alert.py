@@ -0,0 +1,60 @@
+import sys
+import time
+import struct
+import asyncio
+import argparse
+from bleak import BleakScanner, BleakClient
+
+# 日志服务（0x00EE）下的告警特征，触发式采集（CONFIG_LOG_TRIGGER_ENABLE）命中时推送
+ALERT_UUID = "0000ee06-0000-1000-8000-00805f9b34fb"
+
+TYPE_TRIGGER = 0x01
+
+
+async def find_ble_device(device_name):
+    """扫描并查找指定名称的BLE设备"""
+    devices = await BleakScanner.discover()
+    for device in devices:
+        if device.name and device_name.lower() in device.name.lower():
+            return device.address
+    return None
+
+
+def parse_alert(data):
+    kind, hits, count, time_ms = struct.unpack_from("<BBII", data, 0)
+    text = data[10:].decode(errors="replace")
+    name = "trigger" if kind == TYPE_TRIGGER else f"type 0x{kind:02x}"
+    return f"{name} #{count} at {time_ms / 1000:.3f} s, patterns 0x{hits:02x}: {text}"
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="等待设备端触发式采集的告警")
+    parser.add_argument("--name", default="ESP32C3_UARTLOGGER", help="设备名称")
+    parser.add_argument("--count", type=int, default=0, help="收到多少条告警后退出，0 表示一直等待")
+    args = parser.parse_args()
+
+    address = await find_ble_device(args.name)
+    if not address:
+        print(f"未找到名称包含 '{args.name}' 的BLE设备")
+        sys.exit(1)
+
+    received = 0
+    done = asyncio.Event()
+
+    def on_alert(_sender, data):
+        nonlocal received
+        received += 1
+        print(f"[{time.strftime('%H:%M:%S')}] {parse_alert(bytes(data))}", flush=True)
+        if args.count and received >= args.count:
+            done.set()
+
+    async with BleakClient(address) as client:
+        await client.start_notify(ALERT_UUID, on_alert)
+        try:
+            await done.wait()
+        except (KeyboardInterrupt, asyncio.CancelledError):
+            pass
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,98 @@
+import sys
+import struct
+import asyncio
+import argparse
+from bleak import BleakScanner, BleakClient
+
+# 运行配置特征，命令见 main/config/app_config.h，读取格式见 main/core/log_config.h
+CONFIG_UUID = "0000ee08-0000-1000-8000-00805f9b34fb"
+CMD_SET = 0x01
+CMD_RESET = 0x02
+CMD_REBOOT = 0x03
+TYPE_U32 = 1
+TYPE_STR = 2
+FLAG_LIVE = 0x01
+FLAG_PENDING = 0x80
+KEYS = {"baud": 1, "flush_ms": 2, "read_ms": 3, "rx_pin": 4, "tx_pin": 5, "dev_name": 6}
+
+
+async def find_ble_device(device_name):
+    """扫描并查找指定名称的BLE设备"""
+    devices = await BleakScanner.discover()
+    for device in devices:
+        if device.name and device_name.lower() in device.name.lower():
+            return device.address
+    return None
+
+
+def parse_config(data):
+    version, num = data[0], data[1]
+    names = {v: k for k, v in KEYS.items()}
+    items = []
+    pos = 2
+    for _ in range(num):
+        key, typ, flags, length = struct.unpack_from("<BBBB", data, pos)
+        raw = data[pos + 4:pos + 4 + length]
+        pos += 4 + length
+        value = struct.unpack("<I", raw)[0] if typ == TYPE_U32 else raw.decode(errors="replace")
+        items.append({"key": key, "name": names.get(key, f"key{key}"), "value": value, "flags": flags})
+    return version, items
+
+
+def print_config(version, items):
+    print(f"config v{version}")
+    for it in items:
+        note = "live" if it["flags"] & FLAG_LIVE else "reboot"
+        if it["flags"] & FLAG_PENDING:
+            note += ", pending reboot"
+        print(f"  {it['name']:<10} {it['value']!s:<20} ({note})")
+
+
+def build_set(item):
+    name, _, value = item.partition("=")
+    if name not in KEYS or not value:
+        raise ValueError(f"bad setting '{item}', expected one of {', '.join(KEYS)} as name=value")
+    if name == "dev_name":
+        return bytes([CMD_SET, KEYS[name]]) + value.encode()
+    return bytes([CMD_SET, KEYS[name]]) + struct.pack("<I", int(value, 0))
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="读取或修改设备运行配置")
+    parser.add_argument("--name", default="ESP32C3_UARTLOGGER", help="设备名称")
+    parser.add_argument("--set", action="append", default=[], metavar="NAME=VALUE",
+                        help=f"修改配置项，可多次指定：{', '.join(KEYS)}")
+    parser.add_argument("--reset", action="store_true", help="清除已保存的配置，重启后恢复默认值")
+    parser.add_argument("--reboot", action="store_true", help="写完 TF 卡缓冲区后重启设备")
+    args = parser.parse_args()
+
+    try:
+        cmds = [build_set(s) for s in args.set]
+    except ValueError as e:
+        print(e)
+        sys.exit(1)
+    if args.reset:
+        cmds.append(bytes([CMD_RESET]))
+
+    address = await find_ble_device(args.name)
+    if not address:
+        print(f"未找到名称包含 '{args.name}' 的BLE设备")
+        sys.exit(1)
+
+    async with BleakClient(address) as client:
+        for cmd in cmds:
+            try:
+                await client.write_gatt_char(CONFIG_UUID, cmd, response=True)
+            except Exception as e:
+                # 设备对非法的键或取值返回写错误
+                print(f"write {cmd.hex()} rejected: {e}")
+                sys.exit(1)
+        data = bytes(await client.read_gatt_char(CONFIG_UUID))
+        print_config(*parse_config(data))
+        if args.reboot:
+            await client.write_gatt_char(CONFIG_UUID, bytes([CMD_REBOOT]), response=True)
+            print("rebooting")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
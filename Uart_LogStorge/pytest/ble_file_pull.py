@@ -0,0 +1,139 @@
+import sys
+import time
+import struct
+import zlib
+import asyncio
+import argparse
+from bleak import BleakScanner, BleakClient
+
+# 日志服务（0x00EE）下的文件传输特征
+FILE_CTRL_UUID = "0000ee01-0000-1000-8000-00805f9b34fb"
+FILE_DATA_UUID = "0000ee02-0000-1000-8000-00805f9b34fb"
+
+CMD_LIST = 0x01
+CMD_READ = 0x02
+CMD_ABORT = 0x03
+
+PKT_ENTRY = 0x81
+PKT_DATA = 0x82
+PKT_END = 0x83
+
+STATUS_TEXT = {0: "OK", 1: "NOT_FOUND", 2: "BAD_REQUEST", 3: "ABORTED", 4: "IO_ERROR", 5: "BUSY"}
+
+
+async def find_ble_device(device_name):
+    """扫描并查找指定名称的BLE设备"""
+    devices = await BleakScanner.discover()
+    for device in devices:
+        if device.name and device_name.lower() in device.name.lower():
+            return device.address
+    return None
+
+
+class FileSession:
+    """收集文件数据特征上的通知，检查序号连续性"""
+
+    def __init__(self):
+        self.queue = asyncio.Queue()
+        self.expect_seq = 0
+        self.seq_errors = 0
+
+    def on_notify(self, _sender, data: bytearray):
+        self.queue.put_nowait(bytes(data))
+
+    def reset(self):
+        self.expect_seq = 0
+        self.seq_errors = 0
+
+    async def next_packet(self, timeout):
+        pkt = await asyncio.wait_for(self.queue.get(), timeout)
+        ptype, seq = pkt[0], struct.unpack_from("<H", pkt, 1)[0]
+        if seq != self.expect_seq:
+            self.seq_errors += 1
+        self.expect_seq = (seq + 1) & 0xFFFF
+        return ptype, pkt[3:]
+
+
+async def list_files(client, session, timeout):
+    session.reset()
+    await client.write_gatt_char(FILE_CTRL_UUID, bytes([CMD_LIST]), response=True)
+    files = []
+    while True:
+        ptype, body = await session.next_packet(timeout)
+        if ptype == PKT_ENTRY:
+            size, flags = struct.unpack_from("<IB", body, 0)
+            files.append((body[5:].decode(errors="replace"), size, flags))
+        elif ptype == PKT_END:
+            status, count, _ = struct.unpack_from("<BII", body, 0)
+            return status, files
+
+
+async def read_file(client, session, name, offset, length, timeout):
+    session.reset()
+    req = struct.pack("<BII", CMD_READ, offset, length) + name.encode()
+    await client.write_gatt_char(FILE_CTRL_UUID, req, response=True)
+    chunks = []
+    t_start = time.perf_counter()
+    while True:
+        ptype, body = await session.next_packet(timeout)
+        if ptype == PKT_DATA:
+            chunks.append(body)
+        elif ptype == PKT_END:
+            elapsed = time.perf_counter() - t_start
+            status, total, crc = struct.unpack_from("<BII", body, 0)
+            return status, total, crc, b"".join(chunks), elapsed
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="通过BLE文件服务列出/拉取日志文件并统计吞吐量")
+    parser.add_argument("--name", default="ESP32C3_UARTLOGGER", help="设备名称")
+    parser.add_argument("--file", help="要拉取的文件名，不指定则只列出文件")
+    parser.add_argument("--offset", type=int, default=0)
+    parser.add_argument("--length", type=int, default=0, help="0 表示读到文件尾")
+    parser.add_argument("--out", help="保存拉取结果的本地路径")
+    parser.add_argument("--repeat", type=int, default=1, help="重复拉取次数，用于吞吐量基准")
+    parser.add_argument("--timeout", type=float, default=10.0, help="单个通知的超时时间（秒）")
+    args = parser.parse_args()
+
+    print(f"正在搜索BLE设备: {args.name}...")
+    address = await find_ble_device(args.name)
+    if not address:
+        print(f"未找到名称包含 '{args.name}' 的BLE设备")
+        sys.exit(1)
+
+    session = FileSession()
+    async with BleakClient(address) as client:
+        print(f"已连接 {address}，MTU {client.mtu_size}")
+        await client.start_notify(FILE_DATA_UUID, session.on_notify)
+
+        status, files = await list_files(client, session, args.timeout)
+        print(f"文件列表 ({STATUS_TEXT.get(status, status)}):")
+        for name, size, flags in files:
+            print(f"  {name:32s} {size:10d}{'  (写入中)' if flags & 0x01 else ''}")
+
+        if not args.file:
+            return
+
+        rates = []
+        for i in range(args.repeat):
+            status, total, crc, data, elapsed = await read_file(
+                client, session, args.file, args.offset, args.length, args.timeout)
+            crc_ok = (zlib.crc32(data) & 0xFFFFFFFF) == crc and len(data) == total
+            rate = len(data) / elapsed if elapsed > 0 else 0
+            rates.append(rate)
+            print(f"[{i + 1}/{args.repeat}] {STATUS_TEXT.get(status, status)}: {len(data)} 字节, "
+                  f"{elapsed:.2f} s, {rate / 1024:.1f} KiB/s, "
+                  f"CRC {'通过' if crc_ok else '失败'}, 序号错误 {session.seq_errors}")
+            if args.out and i == 0:
+                with open(args.out, "wb") as f:
+                    f.write(data)
+
+        if len(rates) > 1:
+            print(f"平均 {sum(rates) / len(rates) / 1024:.1f} KiB/s, "
+                  f"最小 {min(rates) / 1024:.1f} KiB/s, 最大 {max(rates) / 1024:.1f} KiB/s")
+
+        await client.stop_notify(FILE_DATA_UUID)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
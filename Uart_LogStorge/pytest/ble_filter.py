@@ -0,0 +1,93 @@
+import sys
+import struct
+import asyncio
+import argparse
+from bleak import BleakScanner, BleakClient
+
+# 日志服务（0x00EE）下的实时流过滤特征，实时流本身仍走 0xFF01
+FILTER_UUID = "0000ee04-0000-1000-8000-00805f9b34fb"
+STREAM_UUID = "0000ff01-0000-1000-8000-00805f9b34fb"
+
+CMD_SET = 0x01
+CMD_CLEAR = 0x02
+CMD_RESET = 0x03
+FLAG_NOCASE = 0x01
+FLAG_UNLEVELED = 0x02
+LEVELS = "EWIDV"
+
+
+async def find_ble_device(device_name):
+    """扫描并查找指定名称的BLE设备"""
+    devices = await BleakScanner.discover()
+    for device in devices:
+        if device.name and device_name.lower() in device.name.lower():
+            return device.address
+    return None
+
+
+def pack_patterns(patterns):
+    out = bytes([len(patterns)])
+    for p in patterns:
+        pb = p.encode()
+        out += bytes([len(pb)]) + pb
+    return out
+
+
+def parse_stats(data, include, exclude):
+    active, flags, level_mask, n_inc, n_exc = struct.unpack_from("<BBBBB", data, 0)
+    if not active:
+        return "filter not active"
+    lines_in, lines_out, bytes_in, bytes_out, dropped = struct.unpack_from("<5I", data, 5)
+    level_hits = struct.unpack_from("<5I", data, 25)
+    inc_hits = struct.unpack_from(f"<{n_inc}I", data, 45)
+    exc_hits = struct.unpack_from(f"<{n_exc}I", data, 45 + 4 * n_inc)
+    text = [f"lines {lines_out}/{lines_in}, bytes {bytes_out}/{bytes_in}, dropped {dropped}",
+            "  level " + " ".join(f"{LEVELS[i]}={level_hits[i]}" for i in range(5))]
+    text += [f"  +{include[i] if i < len(include) else i}: {h}" for i, h in enumerate(inc_hits)]
+    text += [f"  -{exclude[i] if i < len(exclude) else i}: {h}" for i, h in enumerate(exc_hits)]
+    return "\n".join(text)
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="在设备端过滤实时日志流并查看命中计数")
+    parser.add_argument("--name", default="ESP32C3_UARTLOGGER", help="设备名称")
+    parser.add_argument("-I", "--include", action="append", default=[], help="包含模式，可多次指定")
+    parser.add_argument("-X", "--exclude", action="append", default=[], help="排除模式，可多次指定")
+    parser.add_argument("-l", "--levels", default="", help="保留的日志级别，如 EW")
+    parser.add_argument("--unleveled", action="store_true", help="设置级别时也保留没有级别标记的行")
+    parser.add_argument("-i", "--ignore-case", action="store_true")
+    parser.add_argument("--clear", action="store_true", help="取消过滤后退出")
+    parser.add_argument("--interval", type=float, default=5.0, help="读取计数器的间隔（秒）")
+    args = parser.parse_args()
+
+    address = await find_ble_device(args.name)
+    if not address:
+        print(f"未找到名称包含 '{args.name}' 的BLE设备")
+        sys.exit(1)
+
+    async with BleakClient(address) as client:
+        if args.clear:
+            await client.write_gatt_char(FILTER_UUID, bytes([CMD_CLEAR]), response=True)
+            return
+
+        flags = (FLAG_NOCASE if args.ignore_case else 0) | (FLAG_UNLEVELED if args.unleveled else 0)
+        level_mask = sum(1 << LEVELS.index(c) for c in args.levels.upper())
+        req = bytes([CMD_SET, flags, level_mask]) + pack_patterns(args.include) + pack_patterns(args.exclude)
+        await client.write_gatt_char(FILTER_UUID, req, response=True)
+
+        def on_stream(_sender, data):
+            sys.stdout.write(data.decode(errors="replace"))
+            sys.stdout.flush()
+
+        await client.start_notify(STREAM_UUID, on_stream)
+        try:
+            while True:
+                await asyncio.sleep(args.interval)
+                stats = await client.read_gatt_char(FILTER_UUID)
+                print("\n--- " + parse_stats(bytes(stats), args.include, args.exclude))
+        except (KeyboardInterrupt, asyncio.CancelledError):
+            pass
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
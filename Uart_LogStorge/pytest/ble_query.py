@@ -0,0 +1,95 @@
+import sys
+import time
+import struct
+import asyncio
+import argparse
+from bleak import BleakScanner, BleakClient
+
+# 日志服务（0x00EE）下的检索特征
+QUERY_UUID = "0000ee03-0000-1000-8000-00805f9b34fb"
+
+CMD_QUERY = 0x01
+CMD_ABORT = 0x02
+FLAG_NOCASE = 0x01
+
+PKT_MATCH = 0x91
+PKT_END = 0x92
+
+TS_NONE = 0xFFFFFFFF
+STATUS_TEXT = {0: "OK", 1: "NOT_FOUND", 2: "BAD_REQUEST", 3: "ABORTED", 4: "IO_ERROR"}
+
+
+async def find_ble_device(device_name):
+    """扫描并查找指定名称的BLE设备"""
+    devices = await BleakScanner.discover()
+    for device in devices:
+        if device.name and device_name.lower() in device.name.lower():
+            return device.address
+    return None
+
+
+def parse_time(text):
+    """hh:mm:ss[.mmm] 或毫秒数 -> 毫秒"""
+    if text is None:
+        return None
+    if ":" not in text:
+        return int(text)
+    hms, _, ms = text.partition(".")
+    h, m, s = (int(x) for x in hms.split(":"))
+    return ((h * 60 + m) * 60 + s) * 1000 + int(ms or 0)
+
+
+def build_query(patterns, t_start, t_end, name, nocase):
+    req = struct.pack("<BBII", CMD_QUERY, FLAG_NOCASE if nocase else 0, t_start, t_end)
+    name_b = name.encode()
+    req += bytes([len(name_b)]) + name_b + bytes([len(patterns)])
+    for p in patterns:
+        pb = p.encode()
+        req += bytes([len(pb)]) + pb
+    return req
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="在设备端检索已存储的日志，只回传命中行")
+    parser.add_argument("patterns", nargs="*", help="子串模式，以 ^ 开头表示只匹配行首（时间戳之后）")
+    parser.add_argument("--name", default="ESP32C3_UARTLOGGER", help="设备名称")
+    parser.add_argument("--file", default="", help="日志文件名，默认当前正在写入的文件")
+    parser.add_argument("--from", dest="t_from", help="起始时间 hh:mm:ss.mmm 或毫秒")
+    parser.add_argument("--to", dest="t_to", help="结束时间 hh:mm:ss.mmm 或毫秒")
+    parser.add_argument("-i", "--ignore-case", action="store_true")
+    parser.add_argument("--repeat", type=int, default=1, help="重复查询次数，观察会话索引的跳块效果")
+    parser.add_argument("--timeout", type=float, default=30.0)
+    args = parser.parse_args()
+
+    address = await find_ble_device(args.name)
+    if not address:
+        print(f"未找到名称包含 '{args.name}' 的BLE设备")
+        sys.exit(1)
+
+    t_start = parse_time(args.t_from) or 0
+    t_end = parse_time(args.t_to)
+    t_end = TS_NONE if t_end is None else t_end
+    queue = asyncio.Queue()
+
+    async with BleakClient(address) as client:
+        await client.start_notify(QUERY_UUID, lambda _s, d: queue.put_nowait(bytes(d)))
+        for i in range(args.repeat):
+            req = build_query(args.patterns, t_start, t_end, args.file, args.ignore_case)
+            t0 = time.perf_counter()
+            await client.write_gatt_char(QUERY_UUID, req, response=True)
+            while True:
+                pkt = await asyncio.wait_for(queue.get(), args.timeout)
+                if pkt[0] == PKT_MATCH:
+                    offset, ts = struct.unpack_from("<II", pkt, 3)
+                    if i == 0:
+                        print(f"{offset:10d}  {pkt[11:].decode(errors='replace')}")
+                elif pkt[0] == PKT_END:
+                    status, matched, scanned, skipped = struct.unpack_from("<BIII", pkt, 3)
+                    print(f"[{i + 1}/{args.repeat}] {STATUS_TEXT.get(status, status)}: {matched} 行, "
+                          f"扫描 {scanned} 字节, 跳过 {skipped} 字节, {time.perf_counter() - t0:.2f} s")
+                    break
+        await client.stop_notify(QUERY_UUID)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
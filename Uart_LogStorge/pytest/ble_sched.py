@@ -0,0 +1,76 @@
+import sys
+import struct
+import asyncio
+import argparse
+from bleak import BleakScanner, BleakClient
+
+# 调度报告特征（CONFIG_SCHED_PROFILE_ENABLE），格式见 main/core/log_sched.h
+SCHED_UUID = "0000ee07-0000-1000-8000-00805f9b34fb"
+HDR_FMT = "<BBBBII"
+ENTRY_FMT = "<12sBBHHHI"
+STATES = ["run", "ready", "blocked", "susp", "deleted"]
+
+
+async def find_ble_device(device_name):
+    """扫描并查找指定名称的BLE设备"""
+    devices = await BleakScanner.discover()
+    for device in devices:
+        if device.name and device_name.lower() in device.name.lower():
+            return device.address
+    return None
+
+
+def parse_report(data):
+    version, num, total, _, window_ms, samples = struct.unpack_from(HDR_FMT, data, 0)
+    tasks = []
+    pos = struct.calcsize(HDR_FMT)
+    for _ in range(num):
+        name, prio, state, stack_free, load, _, preempt = struct.unpack_from(ENTRY_FMT, data, pos)
+        pos += struct.calcsize(ENTRY_FMT)
+        tasks.append({"name": name.rstrip(b"\0").decode(errors="replace"), "prio": prio,
+                      "state": STATES[state] if state < len(STATES) else "?",
+                      "stack_free": stack_free, "load": load, "preempt": preempt})
+    return version, total, window_ms, samples, tasks
+
+
+def print_report(version, total, window_ms, samples, tasks, prev):
+    if version == 0 or window_ms == 0:
+        print("no scheduling stats yet (CONFIG_SCHED_PROFILE_ENABLE off, or first window not finished)")
+        return
+    print(f"v{version}, {total} tasks, load over {window_ms} ms, {samples} samples")
+    print(f"  {'task':<12} {'prio':>4} {'state':>7} {'cpu %':>6} {'stack free':>10} {'preempt':>8} {'+':>6}")
+    for t in sorted(tasks, key=lambda t: (-t["prio"], t["name"])):
+        delta = ""
+        if prev is not None and t["name"] in prev:
+            delta = f"{t['preempt'] - prev[t['name']]:+d}"
+        print(f"  {t['name']:<12} {t['prio']:>4} {t['state']:>7} {t['load'] / 10:>6.1f} {t['stack_free']:>10}"
+              f" {t['preempt']:>8} {delta:>6}")
+    if total > len(tasks):
+        print(f"  ... {total - len(tasks)} more tasks not reported")
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="读取设备任务调度报告")
+    parser.add_argument("--name", default="ESP32C3_UARTLOGGER", help="设备名称")
+    parser.add_argument("--interval", type=float, default=0, help="大于 0 时按间隔持续读取（秒）")
+    args = parser.parse_args()
+
+    address = await find_ble_device(args.name)
+    if not address:
+        print(f"未找到名称包含 '{args.name}' 的BLE设备")
+        sys.exit(1)
+
+    async with BleakClient(address) as client:
+        prev = None
+        while True:
+            data = bytes(await client.read_gatt_char(SCHED_UUID))
+            version, total, window_ms, samples, tasks = parse_report(data)
+            print_report(version, total, window_ms, samples, tasks, prev)
+            prev = {t["name"]: t["preempt"] for t in tasks}
+            if args.interval <= 0:
+                break
+            await asyncio.sleep(args.interval)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
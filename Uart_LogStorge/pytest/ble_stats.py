@@ -0,0 +1,113 @@
+import sys
+import struct
+import asyncio
+import argparse
+from bleak import BleakScanner, BleakClient
+
+# 原 0xFF01 特征，读取返回运行统计快照
+STATS_UUID = "0000ff01-0000-1000-8000-00805f9b34fb"
+
+# 与 main/core/log_stats.h 中 log_stats_t 的字段顺序一致，新字段只会追加在末尾
+FIELDS = [
+    "uptime_ms",
+    "uart_rx_bytes", "uart_rx_chunks", "uart_baud", "uart_fifo_ovf", "uart_buf_full",
+    "uart_frame_err", "uart_parity_err",
+    "card_in_bytes", "card_drop_bytes", "card_written_bytes", "card_write_errors", "card_fail_bytes",
+    "card_ring_hwm", "card_ring_size",
+    "ble_in_bytes", "ble_drop_bytes", "ble_notified_bytes", "ble_notify_errors",
+    "ble_ring_hwm", "ble_ring_size",
+    "battery_mv",
+]
+# 位于 card_write_lat 直方图之后的字段
+TAIL_FIELDS = ["card_syncs", "card_recovered_bytes", "uart_wakeups", "uart_wake_err",
+               "card_mounts", "card_removals", "card_spill_bytes", "card_spill_hwm",
+               "card_clk_khz", "card_clk_steps", "trig_captures", "trig_promoted_bytes", "trig_skipped_bytes",
+               "dedup_lines", "dedup_bytes", "uart_break", "cap_events",
+               "uart_read_len", "uart_read_tmo_ms", "uart_rx_rate", "ble_clients", "ble_lag_bytes"]
+FLAGS = {0x01: "card mounted", 0x02: "ble connected", 0x04: "ble filter"}
+HIST_BASE_US = 256
+
+
+async def find_ble_device(device_name):
+    """扫描并查找指定名称的BLE设备"""
+    devices = await BleakScanner.discover()
+    for device in devices:
+        if device.name and device_name.lower() in device.name.lower():
+            return device.address
+    return None
+
+
+def parse_snapshot(data):
+    version, flags, count, bins = struct.unpack_from("<BBBB", data, 0)
+    values = struct.unpack_from(f"<{count}I", data, 4)
+    named = len(FIELDS)
+    stats = dict(zip(FIELDS, values[:named]))
+    hist = list(values[named:named + bins])
+    stats.update(zip(TAIL_FIELDS, values[named + bins:]))
+    return version, flags, stats, hist
+
+
+def format_hist(hist):
+    lines = []
+    total = sum(hist) or 1
+    for i, n in enumerate(hist):
+        if n == 0:
+            continue
+        lo = 0 if i == 0 else HIST_BASE_US << (i - 1)
+        hi = "inf" if i == len(hist) - 1 else f"{(HIST_BASE_US << i) / 1000:g}"
+        lines.append(f"    {lo / 1000:>8g} - {hi:>6} ms: {n:8d} {'#' * max(1, n * 40 // total)}")
+    return "\n".join(lines)
+
+
+def print_stats(version, flags, s, hist, prev):
+    state = ", ".join(v for k, v in FLAGS.items() if flags & k) or "idle"
+    print(f"--- v{version} uptime {s['uptime_ms'] / 1000:.1f} s ({state})")
+    if prev is not None:
+        dt = (s["uptime_ms"] - prev["uptime_ms"]) / 1000 or 1
+        rate = lambda k: (s[k] - prev[k]) / dt / 1024
+        print(f"  rate   uart {rate('uart_rx_bytes'):.1f} KiB/s, card {rate('card_written_bytes'):.1f} KiB/s, "
+              f"ble {rate('ble_notified_bytes'):.1f} KiB/s")
+    print(f"  uart   {s['uart_rx_bytes']} B in {s['uart_rx_chunks']} reads @ {s['uart_baud']} baud, "
+          f"fifo_ovf {s['uart_fifo_ovf']}, buf_full {s['uart_buf_full']}, "
+          f"frame {s['uart_frame_err']}, parity {s['uart_parity_err']}")
+    print(f"  card   in {s['card_in_bytes']}, written {s['card_written_bytes']}, dropped {s['card_drop_bytes']}, "
+          f"failed {s['card_fail_bytes']} ({s['card_write_errors']} errors), "
+          f"ring hwm {s['card_ring_hwm']}/{s['card_ring_size']}")
+    if s.get("card_syncs") or s.get("card_recovered_bytes"):
+        print(f"  sync   {s['card_syncs']} fsyncs, recovered {s['card_recovered_bytes']} B at mount")
+    print(f"  ble    in {s['ble_in_bytes']}, notified {s['ble_notified_bytes']}, dropped {s['ble_drop_bytes']}, "
+          f"notify errors {s['ble_notify_errors']}, ring hwm {s['ble_ring_hwm']}/{s['ble_ring_size']}")
+    if "ble_clients" in s:
+        print(f"  ble    {s['ble_clients']} clients, {s['ble_lag_bytes']} B skipped by lagging clients")
+    if s["battery_mv"]:
+        print(f"  bat    {s['battery_mv']} mV")
+    if any(hist):
+        print("  card write latency:")
+        print(format_hist(hist))
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="读取设备运行统计")
+    parser.add_argument("--name", default="ESP32C3_UARTLOGGER", help="设备名称")
+    parser.add_argument("--interval", type=float, default=0, help="大于 0 时按间隔持续读取（秒）")
+    args = parser.parse_args()
+
+    address = await find_ble_device(args.name)
+    if not address:
+        print(f"未找到名称包含 '{args.name}' 的BLE设备")
+        sys.exit(1)
+
+    async with BleakClient(address) as client:
+        prev = None
+        while True:
+            data = bytes(await client.read_gatt_char(STATS_UUID))
+            version, flags, stats, hist = parse_snapshot(data)
+            print_stats(version, flags, stats, hist, prev)
+            prev = stats
+            if args.interval <= 0:
+                break
+            await asyncio.sleep(args.interval)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
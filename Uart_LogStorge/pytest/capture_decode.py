@@ -0,0 +1,111 @@
+import sys
+import struct
+import argparse
+
+# 二进制抓包文件（CONFIG_UART_CAPTURE_RAW，tfcard_log_data_<n>.cap）解析：记录格式见 main/core/log_capture.h
+#   python capture_decode.py tfcard_log_data_0.cap              # 按时间列出数据（十六进制）和线路事件
+#   python capture_decode.py tfcard_log_data_0.cap -o data.bin  # 只导出原始数据字节
+#   python capture_decode.py tfcard_log_data_0.cap --text       # 数据按文本打印
+MAGIC = 0xA5
+HDR_LEN = 9
+DATA = 0x01
+START = 0x02
+TYPES = {0x01: "DATA", 0x02: "START", 0x10: "FRAME_ERR", 0x11: "PARITY_ERR", 0x12: "BREAK",
+         0x13: "FIFO_OVF", 0x14: "BUFFER_FULL"}
+
+
+def records(buf):
+    """依次返回 (offset, type, time_ms, payload)；头校验失败的位置逐字节向后重新同步，跳过的字节以 type None 返回"""
+    pos = 0
+    skipped = 0
+    while pos + HDR_LEN <= len(buf):
+        hdr = buf[pos:pos + HDR_LEN]
+        x = 0
+        for b in hdr[:8]:
+            x ^= b
+        magic, rtype, length, time_ms, check = struct.unpack("<BBHIB", hdr)
+        if magic != MAGIC or check != x or rtype not in TYPES or pos + HDR_LEN + length > len(buf):
+            pos += 1
+            skipped += 1
+            continue
+        if skipped:
+            yield pos - skipped, None, None, buf[pos - skipped:pos]
+            skipped = 0
+        yield pos, rtype, time_ms, buf[pos + HDR_LEN:pos + HDR_LEN + length]
+        pos += HDR_LEN + length
+    if skipped or pos < len(buf):
+        # 结尾不完整的记录（断电时最后一次写入只落了一部分）
+        yield pos - skipped, None, None, buf[pos - skipped:]
+
+
+def fmt_time(ms):
+    return f"[{ms // 3600000:02d}:{ms // 60000 % 60:02d}:{ms // 1000 % 60:02d}.{ms % 1000:03d}]"
+
+
+def hexdump(data, offset):
+    lines = []
+    for i in range(0, len(data), 16):
+        chunk = data[i:i + 16]
+        text = "".join(chr(c) if 0x20 <= c < 0x7f else "." for c in chunk)
+        lines.append(f"{offset + i:08x}: {chunk.hex(' '):<47} |{text}|")
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description="解析二进制抓包文件")
+    parser.add_argument("file")
+    parser.add_argument("-o", "--output", help="把数据记录的原始字节依次写入该文件")
+    parser.add_argument("--text", action="store_true", help="数据按 UTF-8 文本打印（无法解码的字节替换）")
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as f:
+        buf = f.read()
+    out = open(args.output, "wb") if args.output else None
+    data_bytes = 0
+    events = {}
+    bad = 0
+    line_open = False  # --text 时上一条数据没有以换行结束
+    for pos, rtype, time_ms, payload in records(buf):
+        if rtype is None:
+            bad += len(payload)
+            if out is None:
+                if line_open:
+                    print()
+                    line_open = False
+                print(f"<{len(payload)} bytes unreadable at file offset {pos}>")
+            continue
+        if rtype == DATA:
+            if out is not None:
+                out.write(payload)
+            elif args.text:
+                print(f"{fmt_time(time_ms)} {payload.decode('utf-8', 'replace')}", end="")
+                line_open = not payload.endswith(b"\n")
+            else:
+                for line in hexdump(payload, data_bytes):
+                    print(f"{fmt_time(time_ms)} {line}")
+            data_bytes += len(payload)
+            continue
+        name = TYPES[rtype]
+        if rtype == START:
+            baud, bits, parity, stop2, _ = struct.unpack("<IBBBB", payload)
+            desc = f"{baud} {bits}{chr(parity)}{stop2 / 2:g}"
+        else:
+            events[name] = events.get(name, 0) + 1
+            (arg,) = struct.unpack("<I", payload)
+            desc = f"{arg} bytes discarded" if arg else ""
+        if out is None:
+            if line_open:
+                print()
+                line_open = False
+            print(f"{fmt_time(time_ms)} <{name}{' ' + desc if desc else ''}> at data offset {data_bytes}")
+    if out is not None:
+        out.close()
+    elif line_open:
+        print()
+    summary = ", ".join(f"{n} {k}" for k, n in events.items()) or "no line events"
+    print(f"{data_bytes} data bytes, {summary}, {bad} unreadable bytes", file=sys.stderr)
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
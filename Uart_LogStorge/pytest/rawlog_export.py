@@ -0,0 +1,126 @@
+import os
+import sys
+import struct
+import zlib
+import argparse
+
+# 裸扇区循环日志（CONFIG_TFCARD_STORAGE_RAW）导出：布局见 main/core/log_raw.h
+# 读卡镜像或读卡器上的块设备（如 /dev/sdb，需要读权限），按时间顺序把每次上电/插卡的数据写成一个文件：
+#   python rawlog_export.py /dev/sdb out_dir
+#   python rawlog_export.py card.img out_dir --info
+SECTOR = 512
+SB_MAGIC = 0x4253524C
+SEG_MAGIC = 0x4745534C
+VERSION = 1
+FLAG_SESSION = 0x1
+
+
+class RawLog:
+    def __init__(self, path):
+        self.f = open(path, "rb")
+        sb = self.read(0, 1)
+        magic, version, self.seg_sectors, self.seg_count, self.first_lba, self.volume, crc = struct.unpack_from("<7I", sb)
+        if magic != SB_MAGIC or crc != zlib.crc32(sb[:24]) or version != VERSION:
+            raise ValueError("no raw log superblock")
+
+    def read(self, lba, count):
+        self.f.seek(lba * SECTOR)
+        return self.f.read(count * SECTOR)
+
+    def seg_lba(self, idx):
+        return self.first_lba + idx * self.seg_sectors
+
+    def header(self, idx):
+        """返回段头字典，无效或属于其他卷时返回 None"""
+        h = self.read(self.seg_lba(idx), 1)
+        if len(h) < 40:
+            return None
+        magic, seq, flags, length, crc, t_lo, t_hi, session, volume, hcrc = struct.unpack_from("<10I", h)
+        if magic != SEG_MAGIC or hcrc != zlib.crc32(h[:36]) or volume != self.volume:
+            return None
+        return {"idx": idx, "seq": seq, "flags": flags, "len": length, "crc": crc,
+                "time": t_lo | (t_hi << 32), "session": session}
+
+    def head(self):
+        """与 log_raw_mount 相同的二分查找，返回最新段的段头，卡上没有数据时返回 None"""
+        h0 = self.header(0)
+        if h0 is None:
+            return self.header(self.seg_count - 1)
+        lo, hi = 0, self.seg_count
+        while hi - lo > 1:
+            mid = (lo + hi) // 2
+            h = self.header(mid)
+            if h is not None and h["seq"] == h0["seq"] + mid:
+                lo = mid
+            else:
+                hi = mid
+        return self.header(lo)
+
+    def segments(self):
+        """从最旧到最新依次返回段头，跳过不属于同一序列的段"""
+        head = self.head()
+        if head is None:
+            return
+        first_seq = max(head["seq"] - self.seg_count + 1, 1)
+        for seq in range(first_seq, head["seq"] + 1):
+            h = self.header((head["idx"] - (head["seq"] - seq)) % self.seg_count)
+            if h is not None and h["seq"] == seq:
+                yield h
+
+    def payload(self, h):
+        sectors = (h["len"] + SECTOR - 1) // SECTOR
+        return self.read(self.seg_lba(h["idx"]) + 1, sectors)[:h["len"]]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="导出 TF 卡裸扇区循环日志")
+    parser.add_argument("device", help="卡镜像文件或块设备")
+    parser.add_argument("out_dir", nargs="?", default="rawlog_out")
+    parser.add_argument("--info", action="store_true", help="只打印段信息，不导出")
+    args = parser.parse_args()
+
+    try:
+        log = RawLog(args.device)
+    except (OSError, ValueError) as e:
+        print(f"{args.device}: {e}")
+        return 1
+    print(f"{log.seg_count} segments of {log.seg_sectors * SECTOR // 1024} KB from LBA {log.first_lba}, "
+          f"volume {log.volume:08x}")
+
+    if not args.info:
+        os.makedirs(args.out_dir, exist_ok=True)
+    out = None
+    opened = set()
+    segs = bad = total = 0
+    for h in log.segments():
+        data = log.payload(h)
+        segs += 1
+        if zlib.crc32(data) != h["crc"]:
+            # 提交之后又被覆盖（最旧的一段正在被重写）或卡内容损坏
+            bad += 1
+            print(f"segment {h['idx']} seq {h['seq']}: CRC mismatch, skipped")
+            continue
+        if args.info:
+            if h["flags"] & FLAG_SESSION:
+                print(f"session {h['session']} starts at segment {h['idx']} seq {h['seq']}, t={h['time'] / 1e6:.3f} s")
+            total += len(data)
+            continue
+        if out is None or h["flags"] & FLAG_SESSION:
+            if out is not None:
+                out.close()
+            # 最旧的一段可能是某次会话的中间部分，文件名仍按会话号
+            name = os.path.join(args.out_dir, f"rawlog_session_{h['session']}.txt")
+            out = open(name, "ab" if name in opened else "wb")
+            if name not in opened:
+                print(f"session {h['session']} -> {name}")
+            opened.add(name)
+        out.write(data)
+        total += len(data)
+    if out is not None:
+        out.close()
+    print(f"{segs} segments, {bad} bad, {total} bytes")
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,187 @@
+import re
+import sys
+import struct
+import asyncio
+import argparse
+
+# 日志服务（0x00EE）下的跟踪特征
+TRACE_UUID = "0000ee05-0000-1000-8000-00805f9b34fb"
+
+CMD_DUMP = 0x01
+CMD_DUMP_SERIAL = 0x02
+CMD_RESET = 0x03
+
+PKT_HDR, PKT_EVT, PKT_HIST, PKT_END = 0xA1, 0xA2, 0xA3, 0xA4
+
+# 与 main/core/log_trace.h 中的枚举一致
+CHANNELS = ["uart", "card", "ble"]
+EVENTS = {1: "UART_READ", 2: "CARD_ENQ", 3: "CARD_ENQ_WAIT", 4: "BLE_ENQ", 5: "FANOUT_DONE",
+          6: "CARD_DEQ", 7: "CARD_WRITE_BEGIN", 8: "CARD_WRITE_END", 9: "BLE_TX_BEGIN", 10: "BLE_TX_END"}
+LATENCIES = ["ingest (uart read -> fan-out done)", "uart read -> on card", "uart read -> notified"]
+# 同一通道内成对出现的跟踪点，统计阶段耗时
+STAGES = [("UART_READ", "FANOUT_DONE"), ("CARD_WRITE_BEGIN", "CARD_WRITE_END"), ("BLE_TX_BEGIN", "BLE_TX_END")]
+
+
+class Dump:
+    def __init__(self):
+        self.cycles_per_us = 160
+        self.base_shift = 8
+        self.events = {}   # ch -> {seq: (t, id, arg)}
+        self.hist = {}     # lat -> [bins]
+        self.overflow = {}
+
+
+def parse_serial(path):
+    """从串口日志中提取 "TRACE " 记录，取最后一次完整导出"""
+    dump = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = re.search(r"TRACE (\w+)(.*)", line)
+            if not m:
+                continue
+            kind, fields = m.group(1), m.group(2).split()
+            if kind == "hdr":
+                dump = Dump()
+                dump.cycles_per_us = int(fields[0])
+                dump.base_shift = int(fields[4])
+            elif dump is None:
+                continue
+            elif kind == "ev":
+                ch, seq, t, ev_id, arg = (int(x) for x in fields)
+                dump.events.setdefault(ch, {})[seq] = (t, ev_id, arg)
+            elif kind == "lat":
+                lat, overflow, *bins = (int(x) for x in fields)
+                dump.overflow[lat] = overflow
+                dump.hist[lat] = bins
+    return dump
+
+
+async def fetch_ble(name, serial_only, reset):
+    from bleak import BleakScanner, BleakClient
+
+    devices = await BleakScanner.discover()
+    address = next((d.address for d in devices if d.name and name.lower() in d.name.lower()), None)
+    if not address:
+        print(f"未找到名称包含 '{name}' 的BLE设备")
+        sys.exit(1)
+
+    dump = Dump()
+    done = asyncio.Event()
+
+    def on_notify(_sender, data):
+        data = bytes(data)
+        body = data[3:]
+        if data[0] == PKT_HDR:
+            dump.cycles_per_us, _, _, _, dump.base_shift = struct.unpack_from("<HBBBB", body)
+        elif data[0] == PKT_EVT:
+            ch, first_seq, n = struct.unpack_from("<BIB", body)
+            for k in range(n):
+                dump.events.setdefault(ch, {})[first_seq + k] = struct.unpack_from("<IHH", body, 6 + 8 * k)
+        elif data[0] == PKT_HIST:
+            lat, overflow, first_bin, n = struct.unpack_from("<BIBB", body)
+            bins = dump.hist.setdefault(lat, [0] * 16)
+            bins[first_bin:first_bin + n] = struct.unpack_from(f"<{n}I", body, 7)
+            dump.overflow[lat] = overflow
+        elif data[0] == PKT_END:
+            if body[0] != 0:
+                print("设备端导出中断")
+            done.set()
+
+    async with BleakClient(address) as client:
+        if reset:
+            await client.write_gatt_char(TRACE_UUID, bytes([CMD_RESET]), response=True)
+            return None
+        if serial_only:
+            await client.write_gatt_char(TRACE_UUID, bytes([CMD_DUMP_SERIAL]), response=True)
+            return None
+        await client.start_notify(TRACE_UUID, on_notify)
+        await client.write_gatt_char(TRACE_UUID, bytes([CMD_DUMP]), response=True)
+        await asyncio.wait_for(done.wait(), 30)
+        await client.stop_notify(TRACE_UUID)
+    return dump
+
+
+def show_events(dump, limit):
+    for ch in sorted(dump.events):
+        evs = [dump.events[ch][s] for s in sorted(dump.events[ch])]
+        if not evs:
+            continue
+        print(f"== {CHANNELS[ch] if ch < len(CHANNELS) else ch}: {len(evs)} events")
+        t0 = evs[0][0]
+        prev = t0
+        for t, ev_id, arg in evs[-limit:]:
+            rel = ((t - t0) & 0xFFFFFFFF) / dump.cycles_per_us
+            delta = ((t - prev) & 0xFFFFFFFF) / dump.cycles_per_us
+            print(f"  {rel:12.1f} us  +{delta:10.1f}  {EVENTS.get(ev_id, ev_id):<18} {arg}")
+            prev = t
+
+
+def show_stages(dump):
+    print("== stage durations")
+    for begin, end in STAGES:
+        durations = []
+        for ch in dump.events:
+            start = None
+            for s in sorted(dump.events[ch]):
+                t, ev_id, _ = dump.events[ch][s]
+                name = EVENTS.get(ev_id)
+                if name == begin:
+                    start = t
+                elif name == end and start is not None:
+                    durations.append(((t - start) & 0xFFFFFFFF) / dump.cycles_per_us)
+                    start = None
+        if durations:
+            durations.sort()
+            print(f"  {begin} -> {end}: n={len(durations)}, p50 {durations[len(durations) // 2]:.0f} us, "
+                  f"max {durations[-1]:.0f} us")
+
+
+def hist_percentile(bins, base, q):
+    total = sum(bins)
+    acc = 0
+    for i, n in enumerate(bins):
+        acc += n
+        if acc >= q * total:
+            return base << i
+    return base << (len(bins) - 1)
+
+
+def show_hist(dump):
+    base = 1 << dump.base_shift
+    for lat in sorted(dump.hist):
+        bins = dump.hist[lat]
+        total = sum(bins)
+        name = LATENCIES[lat] if lat < len(LATENCIES) else str(lat)
+        print(f"== latency {name}: {total} samples, {dump.overflow.get(lat, 0)} untracked")
+        if total == 0:
+            continue
+        print(f"  p50 < {hist_percentile(bins, base, 0.5) / 1000:g} ms, p99 < {hist_percentile(bins, base, 0.99) / 1000:g} ms")
+        for i, n in enumerate(bins):
+            if n:
+                lo = 0 if i == 0 else (base << (i - 1)) / 1000
+                print(f"  {lo:>9g} ms+ {n:8d} {'#' * max(1, n * 40 // total)}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="查看设备端热路径跟踪数据")
+    parser.add_argument("--serial", help="包含 TRACE 记录的串口日志文件")
+    parser.add_argument("--name", default="ESP32C3_UARTLOGGER", help="设备名称（通过 BLE 导出）")
+    parser.add_argument("--to-serial", action="store_true", help="只让设备把跟踪数据输出到串口")
+    parser.add_argument("--reset", action="store_true", help="清空设备端延迟直方图")
+    parser.add_argument("--events", type=int, default=32, help="每个通道显示的最近事件数")
+    args = parser.parse_args()
+
+    if args.serial:
+        dump = parse_serial(args.serial)
+    else:
+        dump = asyncio.run(fetch_ble(args.name, args.to_serial, args.reset))
+    if dump is None:
+        return
+
+    show_events(dump, args.events)
+    show_stages(dump)
+    show_hist(dump)
+
+
+if __name__ == "__main__":
+    main()
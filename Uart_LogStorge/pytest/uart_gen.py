@@ -0,0 +1,245 @@
+import os
+import re
+import sys
+import pty
+import time
+import tty
+import zlib
+import random
+import argparse
+import subprocess
+
+# 生成的每一行：#<序号> <发送时刻ms> <负载> <CRC32>\n，CRC 覆盖最后一个空格之前的内容
+# 负载只用字母数字，不会与 uart_task 添加的 "[hh:mm:ss.mmm] " 前缀混淆
+LINE_RE = re.compile(rb"^#(\d{8}) (\d{9}) ([A-Za-z0-9]*) ([0-9A-F]{8})$")
+PREFIX_RE = re.compile(rb"(?m)^\[(\d+):(\d\d):(\d\d)\.(\d{3})\] ")
+ALPHABET = b"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789"
+
+HOST_BENCH = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "host", "build", "bench_pipeline")
+
+
+def make_line(seq, t_ms, seed, min_len, max_len):
+    rng = random.Random(seed * 1000003 + seq)
+    n = rng.randint(min_len, max_len)
+    payload = bytes(rng.choice(ALPHABET) for _ in range(n))
+    body = b"#%08d %09d %s" % (seq, t_ms % 1000000000, payload)
+    return body + b" %08X\n" % (zlib.crc32(body) & 0xFFFFFFFF)
+
+
+def generate(write, args):
+    """按 8N1 波特率节奏发送，burst 行一组，组间空闲 gap 毫秒"""
+    rate = args.baud / 10.0
+    start = time.monotonic()
+    due = 0.0     # 按波特率计算的下一行最早发送时刻（相对 start）
+    sent = 0
+    for seq in range(args.count):
+        if args.burst and seq and seq % args.burst == 0:
+            due += args.gap / 1000.0
+        delay = start + due - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        t_ms = int((time.monotonic() - start) * 1000)
+        line = make_line(seq, t_ms, args.seed, args.min_len, args.max_len)
+        write(line)
+        sent += len(line)
+        due = max(due, time.monotonic() - start) + len(line) / rate
+    elapsed = time.monotonic() - start
+    print(f"sent {args.count} lines, {sent} bytes in {elapsed:.2f} s ({sent / elapsed / 1024:.1f} KB/s)")
+
+
+def parse_text(data):
+    """tfcard 文本日志：每个 UART 数据块为 "[hh:mm:ss.mmm] " + 数据 + "\\n"，按块还原原始字节流"""
+    matches = list(PREFIX_RE.finditer(data))
+    for i, m in enumerate(matches):
+        h, mi, s, ms = (int(x) for x in m.groups())
+        end = matches[i + 1].start() if i + 1 < len(matches) else len(data)
+        chunk = data[m.end():end]
+        if chunk.endswith(b"\n"):
+            chunk = chunk[:-1]
+        yield chunk, ((h * 60 + mi) * 60 + s) * 1000 + ms
+
+
+# 日志格式 -> 解析函数，解析函数按顺序产出 (原始数据块, 设备时间戳 ms)
+PARSERS = {"text": parse_text}
+
+
+def wake_edge_report(gaps, fragments, total, args):
+    """分组发送时，组首的行紧跟在一段空闲之后，设备若在空闲时浅睡眠，这些行会落在唤醒沿上"""
+    bursts = (total + args.burst - 1) // args.burst
+    lost_lines = 0
+    lost_bytes = 0
+    hit = set()
+    for a, b in gaps:
+        if a % args.burst != 0:
+            continue
+        hit.add(a // args.burst)
+        # 只统计组首连续丢失的部分，组中间的丢失另算
+        end = min(b, a + args.burst - 1)
+        for seq in range(a, end + 1):
+            lost_lines += 1
+            lost_bytes += len(make_line(seq, 0, args.seed, args.min_len, args.max_len))
+    # 行首几个字节丢失时，剩余部分解析不出序号，按 foreign 片段出现在下一条有效行之前
+    salvaged = sum(fragments)
+    print(f"  wake edge: {len(hit)} of {bursts} bursts lost their first line(s), {lost_lines} lines / "
+          f"{lost_bytes} bytes, of which {salvaged} bytes survived as fragments "
+          f"(~{max(0, lost_bytes - salvaged) / max(1, len(hit)):.1f} bytes lost per wake)")
+
+
+def verify(path, fmt, expect, args=None):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    lines = []       # (seq, 发送时刻, 设备时间戳)
+    corrupt = 0
+    foreign = 0
+    fragments = []   # foreign 片段长度（含换行）
+    partial = b""
+    for chunk, ts in PARSERS[fmt](data):
+        partial += chunk
+        while b"\n" in partial:
+            raw, partial = partial.split(b"\n", 1)
+            m = LINE_RE.match(raw)
+            if not m:
+                if raw.startswith(b"#"):
+                    corrupt += 1
+                else:
+                    foreign += 1
+                    fragments.append(len(raw) + 1)
+                continue
+            body = raw[:raw.rfind(b" ")]
+            if zlib.crc32(body) & 0xFFFFFFFF != int(m.group(4), 16):
+                corrupt += 1
+                continue
+            lines.append((int(m.group(1)), int(m.group(2)), ts))
+
+    seen = set()
+    dups = 0
+    reordered = 0
+    max_seq = -1
+    for seq, _, _ in lines:
+        if seq in seen:
+            dups += 1
+            continue
+        if seq < max_seq:
+            reordered += 1
+        seen.add(seq)
+        max_seq = max(max_seq, seq)
+
+    total = expect if expect else max_seq + 1
+    gaps = []
+    missing = 0
+    seq = 0
+    while seq < total:
+        if seq in seen:
+            seq += 1
+            continue
+        start = seq
+        while seq < total and seq not in seen:
+            seq += 1
+        gaps.append((start, seq - 1))
+        missing += seq - start
+
+    print(f"{path}: {len(lines)} valid lines, {len(seen)} unique of {total} expected")
+    print(f"  missing {missing} in {len(gaps)} gaps, duplicates {dups}, reordered {reordered}, "
+          f"corrupt {corrupt}, foreign {foreign}, trailing partial {len(partial)} bytes")
+    for a, b in gaps[:20]:
+        print(f"    gap {a}" + (f"-{b} ({b - a + 1} lines)" if b != a else ""))
+    if len(gaps) > 20:
+        print(f"    ... {len(gaps) - 20} more gaps")
+    if args is not None and args.burst:
+        wake_edge_report(gaps, fragments, total, args)
+
+    # 时间戳精度：设备时间戳与发送时刻的基准不同，以最小差值为零点看抖动，线性拟合看时钟漂移
+    if len(lines) >= 2:
+        deltas = sorted(ts - t for _, t, ts in lines)
+        base = deltas[0]
+        n = len(deltas)
+        print(f"  timestamp lag (relative to best line): p50 {deltas[n // 2] - base} ms, "
+              f"p99 {deltas[n * 99 // 100] - base} ms, max {deltas[-1] - base} ms")
+        xs = [t for _, t, _ in lines]
+        ys = [ts for _, _, ts in lines]
+        mx, my = sum(xs) / n, sum(ys) / n
+        sxx = sum((x - mx) ** 2 for x in xs)
+        if sxx > 0:
+            slope = sum((x - mx) * (y - my) for x, y in zip(xs, ys)) / sxx
+            print(f"  clock drift {(slope - 1) * 1e6:+.0f} ppm over {(xs[-1] - xs[0]) / 1000:.1f} s")
+
+    return missing == 0 and dups == 0 and reordered == 0 and corrupt == 0
+
+
+def run_pty(args):
+    """在 pty 上跑主机端采集管线，发送生成数据后校验输出文件"""
+    master, slave = pty.openpty()
+    tty.setraw(slave)
+    slave_name = os.ttyname(slave)
+    cmd = [args.bench, "-p", slave_name, "-o", args.out] + args.bench_args
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, text=True)
+    print(proc.stdout.readline().rstrip())  # 管线打开 tty 后才打印第一行
+    os.close(slave)
+
+    def write(buf):
+        while buf:
+            n = os.write(master, buf)
+            buf = buf[n:]
+
+    generate(write, args)
+    time.sleep(0.5)  # 等管线读走 pty 中剩余数据，主端关闭后从端未读数据会被丢弃
+    os.close(master)
+    report, _ = proc.communicate(timeout=60)
+    print(report.rstrip())
+    return verify(args.out, "text", args.count, args)
+
+
+def run_serial(args):
+    import serial
+
+    with serial.Serial(args.port, args.baud) as ser:
+        generate(ser.write, args)
+        ser.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="UART 确定性数据生成与丢数校验")
+    sub = parser.add_subparsers(dest="mode", required=True)
+
+    def gen_opts(p):
+        p.add_argument("--baud", type=int, default=115200)
+        p.add_argument("--count", type=int, default=2000, help="发送行数")
+        p.add_argument("--min-len", type=int, default=16, help="负载最小长度")
+        p.add_argument("--max-len", type=int, default=120, help="负载最大长度")
+        p.add_argument("--burst", type=int, default=0, help="每组连续发送的行数，0 表示不分组")
+        p.add_argument("--gap", type=int, default=0, help="组间空闲时间 ms")
+        p.add_argument("--seed", type=int, default=1)
+
+    p = sub.add_parser("pty", help="通过 pty 对主机端管线做端到端测试")
+    gen_opts(p)
+    p.add_argument("--bench", default=HOST_BENCH, help="主机端 bench_pipeline 路径")
+    p.add_argument("--out", default="uart_gen_out.txt", help="模拟 TF 卡输出文件")
+    p.add_argument("bench_args", nargs="*", help="传给 bench_pipeline 的其他参数（放在 -- 之后）")
+
+    p = sub.add_parser("serial", help="向真实串口发送，之后从 TF 卡取回日志再 verify")
+    gen_opts(p)
+    p.add_argument("--port", required=True, help="如 /dev/ttyUSB0 或 COM7")
+
+    p = sub.add_parser("verify", help="校验日志文件")
+    p.add_argument("log")
+    p.add_argument("--format", choices=sorted(PARSERS), default="text")
+    p.add_argument("--count", type=int, default=0, help="发送的行数，0 表示按最大序号推算")
+    p.add_argument("--burst", type=int, default=0, help="发送时的分组行数，非 0 时统计组首（唤醒沿）丢失")
+    p.add_argument("--seed", type=int, default=1)
+    p.add_argument("--min-len", type=int, default=16)
+    p.add_argument("--max-len", type=int, default=120)
+
+    args = parser.parse_args()
+    if args.mode == "pty":
+        ok = run_pty(args)
+    elif args.mode == "serial":
+        run_serial(args)
+        return
+    else:
+        ok = verify(args.log, args.format, args.count, args)
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()